@@ -3,17 +3,20 @@
 //=================
 // Vertex Shader
 //=================
-Vertex VSMain(float3 position : POSITION, float2 uv : TEXCOORD, float3 normal : NORMAL, float4 color : COLOR)
+Vertex VSMain(VertexInput input, uint instanceID : SV_InstanceID)
 {
 	Vertex result;
 
+	DecodedVertex vertex = DecodeVertex(input);
+	float4x4 transform = Instances[g_InstanceOffset + instanceID].transform;
+
 	float4x4 mvpMatrix = mul(viewProjection, transform);
     
-	result.position = mul(mvpMatrix, float4(position, 1.0f));
-	result.pixelPos = mul(transform, float4(position, 1.0f));
-	result.normal = TransformDirection(transform, normal);
-	result.uv = uv;
-	result.color = color.rgb;
+	result.position = mul(mvpMatrix, float4(vertex.position, 1.0f));
+	result.pixelPos = mul(transform, float4(vertex.position, 1.0f));
+	result.normal = TransformDirection(transform, vertex.normal);
+	result.uv = vertex.uv;
+	result.color = g_Material.baseColor.rgb;
 	result.viewDir = normalize(viewPosition.xyz - result.pixelPos.xyz);
 
 	return result;
@@ -36,7 +39,7 @@ DeferredOutput PSMain(Vertex vertex)
 {
 	float4 albedoTexture = g_AlbedoMap.Sample(LinearWrap, vertex.uv);
 	// if there isn't any component that isn't 0, all the components are 0, 
-	// so it means that it is rendering the _black texture_ from MeshSource, so set it to the own vertex color
+	// so it means that it is rendering the _black texture_ from MeshSource, so set it to the material base color
 	if (!any(albedoTexture.rgba))
 		albedoTexture = float4(vertex.color, 1.0f);
 	//float alpha = albedoTexture.a;
@@ -8,17 +8,20 @@
 //=================
 // Vertex Shader
 //=================
-Vertex VSMain(float3 position : POSITION, float2 uv : TEXCOORD, float3 normal : NORMAL, float4 color : COLOR)
+Vertex VSMain(VertexInput input, uint instanceID : SV_InstanceID)
 {
     Vertex result;
 
+    DecodedVertex vertex = DecodeVertex(input);
+    float4x4 transform = Instances[g_InstanceOffset + instanceID].transform;
+
     float4x4 mvpMatrix = mul(viewProjection, transform);
     
-    result.position = mul(mvpMatrix, float4(position, 1.0f));
-    result.pixelPos = mul(transform, float4(position, 1.0f));
-    result.normal = TransformDirection(transform, normal);
-    result.uv = uv;
-    result.color = color.rgb;
+    result.position = mul(mvpMatrix, float4(vertex.position, 1.0f));
+    result.pixelPos = mul(transform, float4(vertex.position, 1.0f));
+    result.normal = TransformDirection(transform, vertex.normal);
+    result.uv = vertex.uv;
+    result.color = g_Material.baseColor.rgb;
     result.viewDir = normalize(viewPosition.xyz - result.pixelPos.xyz);
 
     return result;
@@ -31,7 +34,7 @@ float4 PSMain(Vertex vertex) : SV_TARGET
 {
 	float4 albedoTexture = g_AlbedoMap.Sample(LinearWrap, vertex.uv);
 	// if there isn't any component that isn't 0, all the components are 0, 
-	// so it means that it is rendering the _black texture_ from MeshSource, so set it to the own vertex color
+	// so it means that it is rendering the _black texture_ from MeshSource, so set it to the material base color
 	if (!any(albedoTexture.rgba)) 
 		albedoTexture = float4(vertex.color, 1.0f);
 	//float alpha = diffuseTexture.a;
@@ -43,7 +46,8 @@ float4 PSMain(Vertex vertex) : SV_TARGET
     
     float3 pixel_color = CalculateAllLights(vertex);
     
-    return float4(pixel_color, 1.0f);
+    // Alpha only matters for transparent materials, the opaque pipeline doesn't blend
+    return float4(pixel_color, albedoTexture.a);
 #else
 	// Note that the albedo textures that come from artists are generally 
 	// authored in sRGB space which is why we first convert them to 
@@ -54,6 +58,8 @@ float4 PSMain(Vertex vertex) : SV_TARGET
     float roughness  = g_MetallicRoughnessMap.Sample(LinearWrap, vertex.uv).g;
     float3 normalMap = g_NormalMap.Sample(LinearWrap, vertex.uv).rgb;
 
-	return PBR(vertex, albedo, normalMap, metallic, roughness, ao);
+	float4 color = PBR(vertex, albedo, normalMap, metallic, roughness, ao);
+	color.a = albedoTexture.a;
+	return color;
 #endif
 }
\ No newline at end of file
@@ -35,10 +35,97 @@ cbuffer SceneData
     float4 viewPosition;
 };
 
-cbuffer Transform
+// Written by the renderer for every draw of the render queue, an instanced draw reads
+// its instances from g_InstanceOffset onwards
+struct InstanceData
 {
     float4x4 transform;
+    uint objectId;
+    uint3 padding;
 };
+StructuredBuffer<InstanceData> Instances;
+
+cbuffer InstanceOffset
+{
+    uint g_InstanceOffset;
+};
+
+// Per material constants, bound with the textures of the material
+struct MaterialConstants
+{
+    float4 baseColor; // glTF baseColorFactor, used when the material has no albedo texture
+};
+
+cbuffer MaterialData
+{
+    MaterialConstants g_Material;
+};
+
+// Vertex buffer layout, pipelines created with VertexFormat::kCompact define COMPACT_VERTEX
+#ifdef COMPACT_VERTEX
+// 16 bytes, matches CompactVertexData in MeshSource.h
+struct VertexInput
+{
+    uint4 packed : PACKED; // x = position xy, y = position z, z = octahedral normal, w = half uv
+};
+
+// Compact positions are 16 bit unorm inside the bounds of their submesh, bound for every draw
+struct SubmeshConstants
+{
+    float4 positionMin;
+    float4 positionExtent;
+};
+
+cbuffer SubmeshData
+{
+    SubmeshConstants g_Submesh;
+};
+#else
+// 32 bytes, matches VertexData in MeshSource.h
+struct VertexInput
+{
+    float3 position : POSITION;
+    float2 uv : TEXCOORD;
+    float3 normal : NORMAL;
+};
+#endif
+
+struct DecodedVertex
+{
+    float3 position;
+    float2 uv;
+    float3 normal;
+};
+
+// https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+float3 OctahedronDecode(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float t = saturate(-normal.z);
+    normal.xy -= (step(0.0f, normal.xy) * 2.0f - 1.0f) * t;
+    return normalize(normal);
+}
+
+DecodedVertex DecodeVertex(VertexInput input)
+{
+    DecodedVertex vertex;
+#ifdef COMPACT_VERTEX
+    uint4 packed = input.packed;
+    float3 position = float3(packed.x & 0xFFFF, packed.x >> 16, packed.y & 0xFFFF) / 65535.0f;
+    vertex.position = g_Submesh.positionMin.xyz + position * g_Submesh.positionExtent.xyz;
+
+    // Sign extended 16 bit snorm, -32768 clamps to -1 like the hardware conversion
+    int2 normal = int2(packed.z << 16, packed.z) >> 16;
+    vertex.normal = OctahedronDecode(max(float2(normal) / 32767.0f, -1.0f));
+
+    vertex.uv = f16tof32(uint2(packed.w & 0xFFFF, packed.w >> 16));
+#else
+    vertex.position = input.position;
+    vertex.uv = input.uv;
+    vertex.normal = input.normal;
+#endif
+    return vertex;
+}
 
 cbuffer RenderingInfo
 {
@@ -8,6 +8,11 @@ cbuffer SceneData
 	float4x4 viewProjection;
 };
 
+cbuffer MaterialData
+{
+	float4 baseColor;
+};
+
 SamplerState LinearWrap : register(s0);
 
 Texture2D g_AlbedoMap 	         : register(t0);
@@ -23,7 +28,7 @@ struct Vertex
 //=================
 // Vertex Shader
 //=================
-Vertex VSMain(float3 position : POSITION, float2 uv : TEXCOORD, float3 normal : NORMAL, float4 color : COLOR)
+Vertex VSMain(float3 position : POSITION, float2 uv : TEXCOORD, float3 normal : NORMAL)
 {
 	Vertex result;
 
@@ -31,7 +36,7 @@ Vertex VSMain(float3 position : POSITION, float2 uv : TEXCOORD, float3 normal :
 
 	result.position = mul(mvpMatrix, float4(position, 1.0f));
 	result.uv = uv;
-	result.color = color.rgb;
+	result.color = baseColor.rgb;
 
 	return result;
 }
@@ -43,7 +48,7 @@ float4 PSMain(Vertex vertex) : SV_TARGET
 {
 	float4 albedoTexture = g_AlbedoMap.Sample(LinearWrap, vertex.uv);
 	// if there isn't any component that isn't 0, all the components are 0, 
-	// so it means that it is rendering the _black texture_ from MeshSource, so set it to the own vertex color
+	// so it means that it is rendering the _black texture_ from MeshSource, so set it to the material base color
 	if (!any(albedoTexture.rgba))
 		albedoTexture = float4(vertex.color, 1.0f);
 	//float alpha = diffuseTexture.a;
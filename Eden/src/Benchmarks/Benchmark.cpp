@@ -0,0 +1,66 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <utility>
+
+#include "Core/Log.h"
+#include "Core/JobSystem.h"
+#include "Profiling/Timer.h"
+
+namespace Eden::Benchmarks
+{
+	static const std::pair<const char*, void(*)()> s_Benchmarks[] =
+	{
+		{ "transforms", TransformHierarchy },
+		{ "simd_transforms", SIMDTransforms },
+		{ "culling", FrustumCulling },
+		{ "spatial_tree", SpatialTree },
+		{ "spatial_scene", SpatialScene },
+		{ "picking", Picking },
+		{ "render_queue", RenderQueueSort },
+		{ "mesh_submission", MeshSubmission },
+		{ "mesh_lods", MeshLODs },
+		{ "image_decode", ImageDecoding },
+		{ "gltf_accessors", GLTFAccessors },
+		{ "gltf_load_memory", GLTFLoadMemory },
+		{ "mesh_optimize", MeshOptimization },
+		{ "meshlets", Meshlets },
+		{ "offset_allocator", OffsetAllocation },
+		{ "geometry_churn", GeometryChurn },
+	};
+
+	bool Run(const std::string& name)
+	{
+		for (auto& [benchmarkName, benchmark] : s_Benchmarks)
+		{
+			if (name != benchmarkName)
+				continue;
+
+			ED_LOG_INFO("Running benchmark '{}' with {} job system workers", name, JobSystem::GetWorkerCount());
+			benchmark();
+			return true;
+		}
+
+		ED_LOG_WARN("Attempted running '{}' benchmark, but this isn't a valid benchmark!", name);
+		return false;
+	}
+
+	void Measure(const char* label, uint32_t iterationCount, const std::function<void()>& func)
+	{
+		float totalTime = 0.0f;
+		float minTime = FLT_MAX;
+		for (uint32_t i = 0; i < iterationCount; ++i)
+		{
+			Timer timer;
+			timer.Record();
+			func();
+			float elapsedTime = timer.ElapsedMilliseconds();
+
+			totalTime += elapsedTime;
+			minTime = std::min(minTime, elapsedTime);
+		}
+
+		ED_LOG_INFO("{}: avg {:.3f}ms, min {:.3f}ms ({} iterations)", label, totalTime / iterationCount, minTime, iterationCount);
+	}
+}
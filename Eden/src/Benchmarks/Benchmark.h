@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Eden::Benchmarks
+{
+	// Benchmarks run headless with -benchmark=<name>, results are written to the log
+	bool Run(const std::string& name);
+
+	// Runs func iterationCount times and logs the average and minimum time
+	void Measure(const char* label, uint32_t iterationCount, const std::function<void()>& func);
+
+	void TransformHierarchy();
+	void SIMDTransforms();
+	void FrustumCulling();
+	void SpatialTree();
+	void SpatialScene();
+	void Picking();
+	void RenderQueueSort();
+	void MeshSubmission();
+	void MeshLODs();
+	void ImageDecoding();
+	void GLTFAccessors();
+	void GLTFLoadMemory();
+	void MeshOptimization();
+	void Meshlets();
+	void OffsetAllocation();
+	void GeometryChurn();
+}
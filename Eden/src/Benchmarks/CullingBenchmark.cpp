@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/Log.h"
+#include "Math/Frustum.h"
+
+namespace Eden::Benchmarks
+{
+	static size_t CountMismatches(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+	{
+		size_t mismatches = 0;
+		for (size_t i = 0; i < a.size(); ++i)
+			mismatches += a[i] != b[i] ? 1 : 0;
+		return mismatches;
+	}
+
+	static size_t CountVisible(const std::vector<uint8_t>& visibility)
+	{
+		size_t visible = 0;
+		for (uint8_t v : visibility)
+			visible += v;
+		return visible;
+	}
+
+	// 1M random bounds around a camera with the same projection as the renderer, compares the SIMD tests with the scalar ones
+	void FrustumCulling()
+	{
+		constexpr size_t boundsCount = 1000000;
+		constexpr uint32_t iterationCount = 20;
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> size(0.1f, 10.0f);
+
+		std::vector<Math::AABB> boxes(boundsCount);
+		std::vector<Math::BoundingSphere> spheres(boundsCount);
+		for (size_t i = 0; i < boundsCount; ++i)
+		{
+			glm::vec3 center(position(generator), position(generator), position(generator));
+			glm::vec3 extents(size(generator), size(generator), size(generator));
+			boxes[i] = { center - extents, center + extents };
+			spheres[i] = Math::BoundingSphere::FromAABB(boxes[i]);
+		}
+
+		glm::mat4 view = glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspectiveFovLH(glm::radians(70.0f), 1920.0f, 1080.0f, 0.1f, 200.0f);
+		Math::Frustum frustum = Math::Frustum::FromViewProjection(projection * view);
+
+		std::vector<uint8_t> scalar(boundsCount);
+		std::vector<uint8_t> simd(boundsCount);
+
+		Measure("Spheres: scalar", iterationCount, [&]()
+		{
+			Math::CullSpheresScalar(frustum, spheres.data(), boundsCount, scalar.data());
+		});
+
+		Measure("Spheres: SIMD", iterationCount, [&]()
+		{
+			Math::CullSpheres(frustum, spheres.data(), boundsCount, simd.data());
+		});
+
+		ED_LOG_INFO("Spheres: {} visible, {} mismatches scalar/SIMD", CountVisible(simd), CountMismatches(scalar, simd));
+
+		Measure("AABBs: scalar", iterationCount, [&]()
+		{
+			Math::CullAABBsScalar(frustum, boxes.data(), boundsCount, scalar.data());
+		});
+
+		Measure("AABBs: SIMD", iterationCount, [&]()
+		{
+			Math::CullAABBs(frustum, boxes.data(), boundsCount, simd.data());
+		});
+
+		ED_LOG_INFO("AABBs: {} visible, {} mismatches scalar/SIMD", CountVisible(simd), CountMismatches(scalar, simd));
+	}
+}
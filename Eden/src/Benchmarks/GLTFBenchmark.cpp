@@ -0,0 +1,640 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Core/CommandLine.h"
+#include "Core/Log.h"
+#include "Core/Memory/Memory.h"
+#include "Profiling/Timer.h"
+#include "Renderer/MeshletCulling.h"
+#include "Scene/GLTFAccessor.h"
+#include "Scene/GLTFMappedModel.h"
+#include "Scene/MeshOptimizer.h"
+#include "Scene/MeshSource.h"
+#include "Utilities/Utils.h"
+
+#include <psapi.h>
+
+namespace Eden::Benchmarks
+{
+	// Appends an interleaved buffer view and returns its index
+	static int AddBufferView(tinygltf::Model& model, const void* data, size_t size, size_t stride)
+	{
+		tinygltf::Buffer& buffer = model.buffers[0];
+		tinygltf::BufferView bufferView;
+		bufferView.buffer = 0;
+		bufferView.byteOffset = buffer.data.size();
+		bufferView.byteLength = size;
+		bufferView.byteStride = stride;
+		buffer.data.insert(buffer.data.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+		model.bufferViews.emplace_back(bufferView);
+		return static_cast<int>(model.bufferViews.size()) - 1;
+	}
+
+	static int AddAccessor(tinygltf::Model& model, int bufferView, size_t byteOffset, int componentType, int type, size_t count, bool bNormalized = false)
+	{
+		tinygltf::Accessor accessor;
+		accessor.bufferView = bufferView;
+		accessor.byteOffset = byteOffset;
+		accessor.componentType = componentType;
+		accessor.type = type;
+		accessor.count = count;
+		accessor.normalized = bNormalized;
+		model.accessors.emplace_back(accessor);
+		return static_cast<int>(model.accessors.size()) - 1;
+	}
+
+	// 1M vertices with interleaved positions, normals and uvs and 3M 16 bit indices, the layout most exporters write
+	void GLTFAccessors()
+	{
+		constexpr size_t vertexCount = 1 << 20;
+		constexpr size_t indexCount = 3 * vertexCount;
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> randomFloat(-1.0f, 1.0f);
+
+		std::vector<float> interleaved(vertexCount * 8);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			float* vertex = &interleaved[v * 8];
+			glm::vec3 normal = glm::normalize(glm::vec3(randomFloat(generator), randomFloat(generator), randomFloat(generator)) + glm::vec3(0.0f, 0.0f, 2.0f));
+			vertex[0] = randomFloat(generator); vertex[1] = randomFloat(generator); vertex[2] = randomFloat(generator);
+			vertex[3] = normal.x; vertex[4] = normal.y; vertex[5] = normal.z;
+			vertex[6] = randomFloat(generator); vertex[7] = randomFloat(generator);
+		}
+		std::vector<uint16_t> indices16(indexCount);
+		for (auto& index : indices16)
+			index = static_cast<uint16_t>(generator());
+
+		tinygltf::Model model;
+		model.buffers.emplace_back();
+		int vertexView = AddBufferView(model, interleaved.data(), interleaved.size() * sizeof(float), 8 * sizeof(float));
+		int indexView = AddBufferView(model, indices16.data(), indices16.size() * sizeof(uint16_t), 0);
+		model.accessors.reserve(8);
+		const tinygltf::Accessor& positions = model.accessors[AddAccessor(model, vertexView, 0, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, vertexCount)];
+		const tinygltf::Accessor& normals = model.accessors[AddAccessor(model, vertexView, 12, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, vertexCount)];
+		const tinygltf::Accessor& uvs = model.accessors[AddAccessor(model, vertexView, 24, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2, vertexCount)];
+		const tinygltf::Accessor& indices = model.accessors[AddAccessor(model, indexView, 0, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_SCALAR, indexCount)];
+		GLTF::BufferSpans buffers = GLTF::GetBufferSpans(model);
+
+		// What MeshSource::LoadMesh did before: per vertex normalization, emplace_back
+		// into vectors that aren't reserved and an index copy through a temporary buffer
+		std::vector<VertexData> referenceVertices;
+		std::vector<uint32_t> referenceIndices;
+		Measure("glTF: per vertex reads", 5, [&]()
+		{
+			referenceVertices.clear();
+			referenceVertices.shrink_to_fit();
+			referenceIndices.clear();
+			referenceIndices.shrink_to_fit();
+
+			const float* vertexData = reinterpret_cast<const float*>(model.buffers[0].data.data());
+			for (size_t v = 0; v < vertexCount; ++v)
+			{
+				VertexData newVert = {};
+				newVert.position = glm::make_vec3(&vertexData[v * 8]);
+				newVert.normal = glm::normalize(glm::vec3(glm::make_vec3(&vertexData[v * 8 + 3])));
+				newVert.uv = glm::make_vec2(&vertexData[v * 8 + 6]);
+				referenceVertices.emplace_back(newVert);
+			}
+
+			const uint8_t* indexData = model.buffers[0].data.data() + model.bufferViews[indexView].byteOffset;
+			uint16_t* buffer = enew uint16_t[indexCount];
+			memcpy(buffer, indexData, indexCount * sizeof(uint16_t));
+			for (size_t i = 0; i < indexCount; ++i)
+				referenceIndices.emplace_back(buffer[i] + 7u);
+			edelete[] buffer;
+		});
+
+		std::vector<VertexData> vertices;
+		std::vector<uint32_t> outIndices;
+		Measure("glTF: accessor reader", 5, [&]()
+		{
+			vertices.clear();
+			vertices.shrink_to_fit();
+			outIndices.clear();
+			outIndices.shrink_to_fit();
+
+			vertices.resize(vertexCount);
+			GLTF::ReadFloats(model, buffers, positions, &vertices[0].position.x, sizeof(VertexData), 3);
+			GLTF::ReadFloats(model, buffers, normals, &vertices[0].normal.x, sizeof(VertexData), 3);
+			GLTF::ReadFloats(model, buffers, uvs, &vertices[0].uv.x, sizeof(VertexData), 2);
+
+			outIndices.resize(indexCount);
+			GLTF::ReadIndices(model, buffers, indices, 7, outIndices.data());
+		});
+
+		// Without the allocation and the page faults of the output, what's left is the conversion itself
+		Measure("glTF: accessor reader, output already allocated", 5, [&]()
+		{
+			GLTF::ReadFloats(model, buffers, positions, &vertices[0].position.x, sizeof(VertexData), 3);
+			GLTF::ReadFloats(model, buffers, normals, &vertices[0].normal.x, sizeof(VertexData), 3);
+			GLTF::ReadFloats(model, buffers, uvs, &vertices[0].uv.x, sizeof(VertexData), 2);
+			GLTF::ReadIndices(model, buffers, indices, 7, outIndices.data());
+		});
+
+		// Normals are unit length in the file, skipping the normalization only changes the last bits
+		uint32_t vertexMismatches = 0;
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			const VertexData& a = referenceVertices[v];
+			const VertexData& b = vertices[v];
+			bool bSame = a.position == b.position && a.uv == b.uv && glm::all(glm::lessThan(glm::abs(a.normal - b.normal), glm::vec3(1e-5f)));
+			vertexMismatches += bSame ? 0 : 1;
+		}
+		uint32_t indexMismatches = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+			indexMismatches += referenceIndices[i] != outIndices[i] ? 1 : 0;
+		ED_LOG_INFO("glTF: {} vertex and {} index mismatches against the per vertex reads", vertexMismatches, indexMismatches);
+
+		std::vector<uint32_t> scalarIndices(indexCount);
+		Measure("glTF: 16 bit indices, scalar", 10, [&]()
+		{
+			GLTF::ConvertIndicesScalar(indices16.data(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, indexCount, 7, scalarIndices.data());
+		});
+		Measure("glTF: 16 bit indices, SIMD", 10, [&]()
+		{
+			GLTF::ConvertIndices(indices16.data(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, indexCount, 7, outIndices.data());
+		});
+
+		// 8 and 32 bit indices, odd counts and a sparse normalized 16 bit accessor
+		std::vector<uint8_t> indices8(1001);
+		std::vector<uint32_t> indices32(1001);
+		for (size_t i = 0; i < indices8.size(); ++i)
+			indices32[i] = indices8[i] = static_cast<uint8_t>(generator());
+		std::vector<uint32_t> expected(1001), result(1001);
+		uint32_t conversionErrors = 0;
+		GLTF::ConvertIndicesScalar(indices8.data(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 1001, 3, expected.data());
+		GLTF::ConvertIndices(indices8.data(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, 1001, 3, result.data());
+		conversionErrors += expected != result ? 1 : 0;
+		GLTF::ConvertIndices(indices32.data(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, 1001, 3, result.data());
+		conversionErrors += expected != result ? 1 : 0;
+
+		uint16_t uvData[] = { 0, 65535, 32768, 16384 };
+		uint8_t sparseIndices[] = { 1 };
+		uint16_t sparseValues[] = { 65535, 0 };
+		int uvView = AddBufferView(model, uvData, sizeof(uvData), 0);
+		int sparseIndexView = AddBufferView(model, sparseIndices, sizeof(sparseIndices), 0);
+		int sparseValueView = AddBufferView(model, sparseValues, sizeof(sparseValues), 0);
+		tinygltf::Accessor& sparseUVs = model.accessors[AddAccessor(model, uvView, 0, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, TINYGLTF_TYPE_VEC2, 2, true)];
+		sparseUVs.sparse.isSparse = true;
+		sparseUVs.sparse.count = 1;
+		sparseUVs.sparse.indices = { 0, sparseIndexView, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE };
+		sparseUVs.sparse.values = { sparseValueView, 0 };
+		buffers = GLTF::GetBufferSpans(model);
+		glm::vec2 readUVs[2];
+		bool bRead = GLTF::ReadFloats(model, buffers, sparseUVs, &readUVs[0].x, sizeof(glm::vec2), 2);
+		conversionErrors += bRead && readUVs[0] == glm::vec2(0.0f, 1.0f) && readUVs[1] == glm::vec2(1.0f, 0.0f) ? 0 : 1;
+		ED_LOG_INFO("glTF: {} conversion errors with 8/32 bit indices and sparse normalized accessors", conversionErrors);
+	}
+
+	// Mapped pages are part of the working set but not of the commit, the OS can drop them without using the page file
+	struct ProcessMemory
+	{
+		size_t workingSet;
+		size_t peakWorkingSet;
+		size_t peakCommit;
+	};
+
+	static ProcessMemory GetProcessMemory()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return { counters.WorkingSetSize, counters.PeakWorkingSetSize, counters.PeakPagefileUsage };
+	}
+
+	// Geometry only, images are skipped
+	static bool SkipImage(tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*)
+	{
+		return true;
+	}
+
+	// What MeshSource::LoadMesh reads, every primitive of every mesh into one vertex and one index array
+	static void ConvertMeshes(const tinygltf::Model& model, const GLTF::BufferSpans& buffers, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
+	{
+		for (auto& mesh : model.meshes)
+		{
+			for (auto& primitive : mesh.primitives)
+			{
+				auto position = primitive.attributes.find("POSITION");
+				if (position == primitive.attributes.end())
+					continue;
+
+				uint32_t vertexStart = static_cast<uint32_t>(vertices.size());
+				vertices.resize(vertexStart + model.accessors[position->second].count);
+				GLTF::ReadFloats(model, buffers, model.accessors[position->second], &vertices[vertexStart].position.x, sizeof(VertexData), 3);
+				auto normal = primitive.attributes.find("NORMAL");
+				if (normal != primitive.attributes.end())
+					GLTF::ReadFloats(model, buffers, model.accessors[normal->second], &vertices[vertexStart].normal.x, sizeof(VertexData), 3);
+				auto uv = primitive.attributes.find("TEXCOORD_0");
+				if (uv != primitive.attributes.end())
+					GLTF::ReadFloats(model, buffers, model.accessors[uv->second], &vertices[vertexStart].uv.x, sizeof(VertexData), 2);
+
+				if (primitive.indices >= 0)
+				{
+					size_t indexStart = indices.size();
+					indices.resize(indexStart + model.accessors[primitive.indices].count);
+					GLTF::ReadIndices(model, buffers, model.accessors[primitive.indices], vertexStart, &indices[indexStart]);
+				}
+			}
+		}
+	}
+
+	// Peak working set of one glTF import, -gltf_file=<path> picks the file and -gltf_copy loads it like tinygltf does by
+	// default, every buffer copied into memory. The peak is per process, so each configuration needs its own run.
+	void GLTFLoadMemory()
+	{
+		std::string file;
+		CommandLine::Parse("gltf_file", file);
+		if (file.empty())
+			file = "assets/Models/FlightHelmet/FlightHelmet.gltf";
+		bool bCopyBuffers = CommandLine::HasArg("gltf_copy");
+
+		ProcessMemory before = GetProcessMemory();
+		Timer timer;
+		timer.Record();
+
+		tinygltf::Model model;
+		std::string err;
+		std::string warn;
+		std::vector<VertexData> vertices;
+		std::vector<uint32_t> indices;
+		size_t bufferSize = 0;
+		if (bCopyBuffers)
+		{
+			tinygltf::TinyGLTF loader;
+			loader.SetImageLoader(&SkipImage, nullptr);
+			bool bLoaded = std::filesystem::path(file).extension() == ".glb" ? loader.LoadBinaryFromFile(&model, &err, &warn, file) : loader.LoadASCIIFromFile(&model, &err, &warn, file);
+			if (!bLoaded)
+			{
+				ED_LOG_ERROR("glTF: failed to load {}: {}", file, err);
+				return;
+			}
+
+			GLTF::BufferSpans buffers = GLTF::GetBufferSpans(model);
+			ConvertMeshes(model, buffers, vertices, indices);
+			for (auto& buffer : model.buffers)
+			{
+				bufferSize += buffer.data.size();
+				buffer.data = {};
+			}
+		}
+		else
+		{
+			GLTF::MappedModel mappedModel;
+			if (!mappedModel.Load(file, model, err, warn, &SkipImage, nullptr))
+			{
+				ED_LOG_ERROR("glTF: failed to load {}: {}", file, err);
+				return;
+			}
+
+			ConvertMeshes(model, mappedModel.GetBuffers(), vertices, indices);
+			bufferSize = mappedModel.GetMappedSize();
+			mappedModel.Release();
+		}
+
+		// The converted arrays are what gets uploaded, they are alive in both cases
+		ProcessMemory after = GetProcessMemory();
+		ED_LOG_INFO("glTF: {} loaded {} in {:.2f}ms, {} vertices and {} indices", bCopyBuffers ? "copying" : "mapping", Utils::BytesToString(bufferSize), timer.ElapsedMilliseconds(), vertices.size(), indices.size());
+		ED_LOG_INFO("glTF: working set {} before, {} after the upload, peak working set grew by {}, peak commit by {}", Utils::BytesToString(before.workingSet), Utils::BytesToString(after.workingSet),
+			Utils::BytesToString(after.peakWorkingSet - before.peakWorkingSet), Utils::BytesToString(after.peakCommit - before.peakCommit));
+	}
+
+	// CPU version of DecodeVertex in Global.hlsli
+	static VertexData DecodeCompactVertex(const CompactVertexData& compactVertex, const Math::AABB& bounds)
+	{
+		VertexData vertex;
+		glm::vec2 positionXY = glm::unpackUnorm2x16(compactVertex.positionXY);
+		glm::vec2 positionZ = glm::unpackUnorm2x16(compactVertex.positionZ);
+		vertex.position = bounds.min + glm::vec3(positionXY, positionZ.x) * (bounds.max - bounds.min);
+
+		glm::vec2 octahedron = glm::unpackSnorm2x16(compactVertex.normal);
+		glm::vec3 normal(octahedron, 1.0f - glm::abs(octahedron.x) - glm::abs(octahedron.y));
+		if (normal.z < 0.0f)
+		{
+			glm::vec2 signs(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+			normal = glm::vec3((1.0f - glm::abs(glm::vec2(normal.y, normal.x))) * signs, normal.z);
+		}
+		vertex.normal = glm::normalize(normal);
+		vertex.uv = glm::unpackHalf2x16(compactVertex.uv);
+		return vertex;
+	}
+
+	// -gltf_file, or the models in the repository when it isn't given
+	static std::vector<std::string> GetModelFiles()
+	{
+		std::string file;
+		CommandLine::Parse("gltf_file", file);
+		if (!file.empty())
+			return { file };
+		return { "assets/Models/FlightHelmet/FlightHelmet.gltf", "assets/Models/DamagedHelmet/DamagedHelmet.glb", "assets/Models/Lantern/Lantern.gltf", "assets/Models/donut.glb", "assets/Models/Sponza/Sponza.gltf" };
+	}
+
+	// Reads a triangle list like MeshSource::LoadMesh does, with indices local to its vertices. False for the other primitives.
+	static bool ReadTriangles(const tinygltf::Model& model, const GLTF::BufferSpans& buffers, const tinygltf::Primitive& primitive, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
+	{
+		auto position = primitive.attributes.find("POSITION");
+		if (position == primitive.attributes.end() || primitive.mode != TINYGLTF_MODE_TRIANGLES)
+			return false;
+
+		vertices.assign(model.accessors[position->second].count, VertexData{});
+		GLTF::ReadFloats(model, buffers, model.accessors[position->second], &vertices[0].position.x, sizeof(VertexData), 3);
+		auto normal = primitive.attributes.find("NORMAL");
+		if (normal != primitive.attributes.end())
+			GLTF::ReadFloats(model, buffers, model.accessors[normal->second], &vertices[0].normal.x, sizeof(VertexData), 3);
+		auto uv = primitive.attributes.find("TEXCOORD_0");
+		if (uv != primitive.attributes.end())
+			GLTF::ReadFloats(model, buffers, model.accessors[uv->second], &vertices[0].uv.x, sizeof(VertexData), 2);
+
+		if (primitive.indices >= 0)
+		{
+			indices.resize(model.accessors[primitive.indices].count);
+			GLTF::ReadIndices(model, buffers, model.accessors[primitive.indices], 0, indices.data());
+		}
+		else
+		{
+			indices.resize(vertices.size());
+			for (size_t v = 0; v < vertices.size(); ++v)
+				indices[v] = static_cast<uint32_t>(v);
+		}
+		return !indices.empty();
+	}
+
+	// Import time optimization of every triangle list of the models
+	void MeshOptimization()
+	{
+		for (auto& path : GetModelFiles())
+		{
+			tinygltf::Model model;
+			std::string err;
+			std::string warn;
+			GLTF::MappedModel mappedModel;
+			if (!mappedModel.Load(path, model, err, warn, &SkipImage, nullptr))
+			{
+				ED_LOG_WARN("Mesh optimization: skipping {}: {}", path, err);
+				continue;
+			}
+			const GLTF::BufferSpans& buffers = mappedModel.GetBuffers();
+
+			MeshOptimizer::Stats stats;
+			uint32_t maxIndex = 0;
+			double optimizeTime = 0.0;
+			std::vector<VertexData> vertices;
+			std::vector<uint32_t> indices;
+			std::vector<CompactVertexData> compactVertices;
+			std::vector<float> splitPositions;
+			std::vector<VertexAttributes> splitAttributes;
+			uint32_t splitMismatches = 0;
+			// Triangles drawn at every level, primitives with fewer levels count their coarsest one
+			double lodTime = 0.0;
+			std::vector<uint32_t> lodIndices;
+			MeshOptimizer::LODLevel levels[MeshOptimizer::kMaxLODCount - 1];
+			size_t levelTriangles[MeshOptimizer::kMaxLODCount] = {};
+			float levelErrors[MeshOptimizer::kMaxLODCount] = {};
+			// Position errors relative to the largest side of the primitive bounds, normal errors in degrees
+			float maxPositionError = 0.0f;
+			float maxNormalError = 0.0f;
+			float maxUVError = 0.0f;
+			for (auto& mesh : model.meshes)
+			{
+				for (auto& primitive : mesh.primitives)
+				{
+					if (!ReadTriangles(model, buffers, primitive, vertices, indices))
+						continue;
+
+					Timer timer;
+					timer.Record();
+					uint32_t vertexCount = MeshOptimizer::Optimize(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), indices.size(), stats);
+					optimizeTime += timer.ElapsedMilliseconds();
+					if (vertexCount == 0)
+						continue;
+					maxIndex = std::max(maxIndex, vertexCount - 1);
+
+					lodIndices.clear();
+					timer.Record();
+					uint32_t levelCount = MeshOptimizer::GenerateLODs(vertices.data(), vertexCount, indices.data(), indices.size(), lodIndices, levels);
+					lodTime += timer.ElapsedMilliseconds();
+					levelTriangles[0] += indices.size() / 3;
+					for (uint32_t l = 1; l < MeshOptimizer::kMaxLODCount; ++l)
+					{
+						const MeshOptimizer::LODLevel* level = levelCount > 0 ? &levels[std::min(l, levelCount) - 1] : nullptr;
+						levelTriangles[l] += (level ? level->indexCount : indices.size()) / 3;
+						levelErrors[l] = std::max(levelErrors[l], level ? level->error : 0.0f);
+					}
+
+					Math::AABB bounds = Math::ComputeAABB(&vertices[0].position.x, vertexCount, sizeof(VertexData));
+					compactVertices.resize(vertexCount);
+					MeshOptimizer::EncodeCompactVertices(vertices.data(), vertexCount, bounds, compactVertices.data());
+
+					glm::vec3 extent = bounds.max - bounds.min;
+					float size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+					for (uint32_t v = 0; v < vertexCount; ++v)
+					{
+						const VertexData& vertex = vertices[v];
+						VertexData decoded = DecodeCompactVertex(compactVertices[v], bounds);
+						glm::vec3 positionError = glm::abs(decoded.position - vertex.position);
+						maxPositionError = std::max(maxPositionError, std::max(std::max(positionError.x, positionError.y), positionError.z) / size);
+						if (glm::dot(vertex.normal, vertex.normal) > 0.0f)
+						{
+							float cosAngle = glm::clamp(glm::dot(decoded.normal, glm::normalize(vertex.normal)), -1.0f, 1.0f);
+							maxNormalError = std::max(maxNormalError, glm::degrees(glm::acos(cosAngle)));
+						}
+						glm::vec2 uvError = glm::abs(decoded.uv - vertex.uv);
+						maxUVError = std::max(maxUVError, std::max(uvError.x, uvError.y));
+					}
+
+					splitPositions.resize(vertexCount * 3);
+					splitAttributes.resize(vertexCount);
+					MeshOptimizer::SplitVertexStreams(vertices.data(), vertexCount, splitPositions.data(), splitAttributes.data());
+					for (uint32_t v = 0; v < vertexCount; ++v)
+					{
+						const VertexData& vertex = vertices[v];
+						bool bSame = glm::make_vec3(&splitPositions[v * 3]) == vertex.position && splitAttributes[v].uv == vertex.uv && splitAttributes[v].normal == vertex.normal;
+						splitMismatches += bSame ? 0 : 1;
+					}
+				}
+			}
+
+			ED_LOG_INFO("Mesh optimization: {} in {:.2f}ms", path, optimizeTime);
+			ED_LOG_INFO("	{} vertices, {} after welding and dropping unused ones, {} indices, {} bit", stats.sourceVertexCount, stats.vertexCount, stats.indexCount, maxIndex <= UINT16_MAX ? 16 : 32);
+			ED_LOG_INFO("	ACMR {:.3f} as exported, {:.3f} optimized ({} entry FIFO cache)", stats.GetSourceACMR(), stats.GetACMR(), MeshOptimizer::kFIFOCacheSize);
+			ED_LOG_INFO("	Vertex buffer {:.2f}MB full, {:.2f}MB compact", stats.vertexCount * sizeof(VertexData) / (1024.0f * 1024.0f), stats.vertexCount * sizeof(CompactVertexData) / (1024.0f * 1024.0f));
+			ED_LOG_INFO("	Compact error: position {:.6f} of the bounds, normal {:.3f} degrees, uv {:.6f}", maxPositionError, maxNormalError, maxUVError);
+			ED_LOG_INFO("	Split streams: {:.2f}MB of positions, {} bytes per vertex for position only passes, {} mismatches", stats.vertexCount * sizeof(float) * 3 / (1024.0f * 1024.0f), sizeof(float) * 3, splitMismatches);
+			ED_LOG_INFO("	Levels of detail generated in {:.2f}ms", lodTime);
+			for (uint32_t l = 0; l < MeshOptimizer::kMaxLODCount; ++l)
+				ED_LOG_INFO("	LOD {}: {} triangles ({:.1f}%), largest error {:.4f} of the primitive bounds", l, levelTriangles[l], 100.0 * static_cast<double>(levelTriangles[l]) / static_cast<double>(std::max<size_t>(levelTriangles[0], 1)), levelErrors[l]);
+		}
+	}
+
+	// Meshlets of every triangle list of the models, culled on the CPU from cameras around each model. Every primitive
+	// is a submesh in its own vertex space, the node transforms don't matter for the culling. Culled meshlets are
+	// checked against their triangles: all of them must be out of one frustum plane or face away from the camera.
+	void Meshlets()
+	{
+		for (auto& path : GetModelFiles())
+		{
+			tinygltf::Model model;
+			std::string err;
+			std::string warn;
+			GLTF::MappedModel mappedModel;
+			if (!mappedModel.Load(path, model, err, warn, &SkipImage, nullptr))
+			{
+				ED_LOG_WARN("Meshlets: skipping {}: {}", path, err);
+				continue;
+			}
+			const GLTF::BufferSpans& buffers = mappedModel.GetBuffers();
+
+			// Laid out like an imported mesh source, without the GPU buffers
+			MeshSource meshSource;
+			std::vector<VertexData> meshVertices;
+			std::vector<uint32_t> meshIndices;
+			std::vector<VertexData> vertices;
+			std::vector<uint32_t> indices;
+			MeshOptimizer::Stats stats;
+			size_t meshletOrderCacheMisses = 0;
+			double buildTime = 0.0;
+			Math::AABB bounds;
+			for (auto& mesh : model.meshes)
+			{
+				for (auto& primitive : mesh.primitives)
+				{
+					if (!ReadTriangles(model, buffers, primitive, vertices, indices))
+						continue;
+
+					uint32_t vertexCount = MeshOptimizer::Optimize(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), indices.size(), stats);
+					if (vertexCount == 0)
+						continue;
+
+					MeshSource::Submesh submesh = {};
+					submesh.bounds = Math::ComputeAABB(&vertices[0].position.x, vertexCount, sizeof(VertexData));
+					submesh.vertexStart = static_cast<uint32_t>(meshVertices.size());
+					submesh.indexStart = static_cast<uint32_t>(meshIndices.size());
+					submesh.indexCount = static_cast<uint32_t>(indices.size());
+					submesh.firstMeshlet = static_cast<uint32_t>(meshSource.meshlets.size());
+
+					Timer timer;
+					timer.Record();
+					submesh.meshletCount = MeshOptimizer::BuildMeshlets(vertices.data(), vertexCount, indices.data(), indices.size(), meshSource.meshlets, meshSource.meshletVertices, meshSource.meshletTriangles);
+					buildTime += timer.ElapsedMilliseconds();
+					for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.meshletCount; ++m)
+						meshSource.meshlets[m].indexStart += submesh.indexStart;
+					meshletOrderCacheMisses += MeshOptimizer::CountCacheMisses(indices.data(), indices.size(), vertexCount);
+
+					bounds.Merge(submesh.bounds);
+					meshVertices.insert(meshVertices.end(), vertices.begin(), vertices.begin() + vertexCount);
+					meshIndices.insert(meshIndices.end(), indices.begin(), indices.end());
+					meshSource.submeshes.push_back(submesh);
+				}
+			}
+			if (meshSource.meshlets.empty())
+				continue;
+
+			size_t meshletCount = meshSource.meshlets.size();
+			size_t triangleCount = meshIndices.size() / 3;
+			size_t coneMeshlets = std::count_if(meshSource.meshlets.begin(), meshSource.meshlets.end(), [](const MeshOptimizer::Meshlet& meshlet) { return meshlet.coneCutoff < 1.0f; });
+			ED_LOG_INFO("Meshlets: {}: {} meshlets of {} triangles, {:.1f} vertices and {:.1f} triangles per meshlet, built in {:.2f}ms", path, meshletCount, triangleCount,
+				static_cast<double>(meshSource.meshletVertices.size()) / static_cast<double>(meshletCount), static_cast<double>(triangleCount) / static_cast<double>(meshletCount), buildTime);
+			ED_LOG_INFO("	ACMR {:.3f} in cache order, {:.3f} in meshlet order, {:.1f}% of the meshlets have a cone that can cull", stats.GetACMR(),
+				3.0 * static_cast<double>(meshletOrderCacheMisses) / static_cast<double>(meshIndices.size()), 100.0 * static_cast<double>(coneMeshlets) / static_cast<double>(meshletCount));
+
+			// Far views see the whole model, only the cones cull. Near views look at points of the model from inside its bounds.
+			constexpr uint32_t kViewCount = 64;
+			Math::BoundingSphere sphere = Math::BoundingSphere::FromAABB(bounds);
+			std::mt19937 generator(42);
+			std::uniform_real_distribution<float> randomFloat(-1.0f, 1.0f);
+			glm::mat4 projection = glm::perspectiveFovLH(glm::radians(70.0f), 1920.0f, 1080.0f, sphere.radius * 0.001f, sphere.radius * 10.0f);
+			std::vector<MeshletCulling::View> views;
+			for (uint32_t v = 0; v < kViewCount; ++v)
+			{
+				bool bIsNear = v >= kViewCount / 2;
+				glm::vec3 direction(randomFloat(generator), randomFloat(generator), randomFloat(generator));
+				direction = glm::length(direction) > 0.01f ? glm::normalize(direction) : glm::vec3(0.0f, 0.0f, 1.0f);
+				glm::vec3 position = sphere.center + direction * sphere.radius * (bIsNear ? 0.6f : 2.0f);
+				glm::vec3 target = bIsNear ? sphere.center + glm::vec3(randomFloat(generator), randomFloat(generator), randomFloat(generator)) * sphere.radius * 0.5f : sphere.center;
+				glm::vec3 up = std::abs(glm::normalize(target - position).y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+				Math::Frustum frustum = Math::Frustum::FromViewProjection(projection * glm::lookAtLH(position, target, up));
+				views.push_back(MeshletCulling::MakeLocalView(frustum, position, glm::mat4(1.0f)));
+			}
+
+			std::vector<MeshletCulling::IndexRange> ranges;
+			MeshletCulling::Stats cullingStats[2];
+			size_t visibleIndices[2] = {};
+			size_t rangeCounts[2] = {};
+			uint32_t mismatches = 0;
+			for (uint32_t v = 0; v < kViewCount; ++v)
+			{
+				const MeshletCulling::View& view = views[v];
+				uint32_t group = v >= kViewCount / 2 ? 1 : 0;
+				for (const MeshSource::Submesh& submesh : meshSource.submeshes)
+				{
+					ranges.clear();
+					rangeCounts[group] += MeshletCulling::Cull(meshSource, submesh, view, ranges, cullingStats[group]);
+
+					// Ranges are ordered, so the culled meshlets are the ones between them
+					size_t range = 0;
+					for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.meshletCount; ++m)
+					{
+						const MeshOptimizer::Meshlet& meshlet = meshSource.meshlets[m];
+						while (range < ranges.size() && ranges[range].indexStart + ranges[range].indexCount <= meshlet.indexStart)
+							range++;
+						if (range < ranges.size() && ranges[range].indexStart <= meshlet.indexStart)
+						{
+							visibleIndices[group] += meshlet.triangleCount * 3;
+							continue;
+						}
+
+						bool bIsOutside = std::any_of(std::begin(view.frustum.planes), std::end(view.frustum.planes), [&](const glm::vec4& plane)
+						{
+							for (uint32_t i = meshlet.indexStart; i < meshlet.indexStart + meshlet.triangleCount * 3; ++i)
+							{
+								if (glm::dot(glm::vec3(plane), meshVertices[submesh.vertexStart + meshIndices[i]].position) + plane.w >= 0.0f)
+									return false;
+							}
+							return true;
+						});
+						for (uint32_t i = meshlet.indexStart; !bIsOutside && i < meshlet.indexStart + meshlet.triangleCount * 3; i += 3)
+						{
+							const glm::vec3& p0 = meshVertices[submesh.vertexStart + meshIndices[i]].position;
+							glm::vec3 normal = glm::cross(meshVertices[submesh.vertexStart + meshIndices[i + 1]].position - p0, meshVertices[submesh.vertexStart + meshIndices[i + 2]].position - p0);
+							glm::vec3 toView = view.position - p0;
+							if (glm::dot(normal, toView) > 1e-4f * glm::length(normal) * glm::length(toView))
+								mismatches++;
+						}
+					}
+				}
+			}
+
+			for (uint32_t group = 0; group < 2; ++group)
+			{
+				const MeshletCulling::Stats& groupStats = cullingStats[group];
+				double meshlets = std::max(static_cast<double>(groupStats.meshlets), 1.0);
+				ED_LOG_INFO("	{} views: {:.1f}% of the triangles drawn, {:.1f}% of the meshlets culled by the frustum and {:.1f}% by their cone, {:.1f} index ranges per submesh",
+					group == 0 ? "Far" : "Near", 100.0 * static_cast<double>(visibleIndices[group]) / static_cast<double>(meshIndices.size() * kViewCount / 2),
+					100.0 * groupStats.frustumCulled / meshlets, 100.0 * groupStats.backfaceCulled / meshlets,
+					static_cast<double>(rangeCounts[group]) / static_cast<double>(meshSource.submeshes.size() * kViewCount / 2));
+			}
+			ED_LOG_INFO("	{} triangles of culled meshlets face the camera inside the frustum", mismatches);
+
+			std::string label = "Meshlets: culling " + std::to_string(meshletCount) + " meshlets from " + std::to_string(kViewCount) + " views";
+			Measure(label.c_str(), 20, [&]()
+			{
+				MeshletCulling::Stats measureStats;
+				for (const MeshletCulling::View& view : views)
+				{
+					ranges.clear();
+					for (const MeshSource::Submesh& submesh : meshSource.submeshes)
+						MeshletCulling::Cull(meshSource, submesh, view, ranges, measureStats);
+				}
+			});
+		}
+	}
+}
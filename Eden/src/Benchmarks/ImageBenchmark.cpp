@@ -0,0 +1,92 @@
+#include "Benchmark.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <stb/stb_image.h>
+#include <stb/stb_image_write.h>
+
+#include "Core/Log.h"
+#include "Core/JobSystem.h"
+#include "Renderer/ImageDecoder.h"
+
+namespace Eden::Benchmarks
+{
+	static void AppendBytes(void* context, void* data, int size)
+	{
+		auto* bytes = static_cast<std::vector<uint8_t>*>(context);
+		bytes->insert(bytes->end(), static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+	}
+
+	// 48 png files of 512x512 like the textures of a glTF scene, half RGB and half RGBA
+	void ImageDecoding()
+	{
+		constexpr uint32_t imageCount = 48;
+		constexpr uint32_t imageSize = 512;
+
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<int> randomNoise(0, 15);
+
+		std::vector<std::vector<uint8_t>> files(imageCount);
+		std::vector<uint8_t> pixels(imageSize * imageSize * 4);
+		for (uint32_t i = 0; i < imageCount; ++i)
+		{
+			int channelCount = i % 2 == 0 ? 3 : 4;
+			for (uint32_t p = 0; p < imageSize * imageSize * channelCount; ++p)
+				pixels[p] = static_cast<uint8_t>((p / channelCount) % imageSize / 2 + (p / channelCount) / imageSize / 4 + randomNoise(generator) + i);
+			stbi_write_png_to_func(AppendBytes, &files[i], imageSize, imageSize, channelCount, pixels.data(), imageSize * channelCount);
+		}
+
+		std::vector<DecodedImage> images(imageCount);
+		Measure("Images: decode one after the other", 5, [&]()
+		{
+			for (uint32_t i = 0; i < imageCount; ++i)
+				DecodeImageRGBA8(files[i].data(), files[i].size(), images[i]);
+		});
+
+		Measure("Images: decode in parallel", 5, [&]()
+		{
+			JobSystem::ParallelFor(imageCount, 1, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+					DecodeImageRGBA8(files[i].data(), files[i].size(), images[i]);
+			});
+		});
+
+		// stb expanding to RGBA itself is the reference
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < imageCount; ++i)
+		{
+			int width, height, channelCount;
+			stbi_uc* reference = stbi_load_from_memory(files[i].data(), static_cast<int>(files[i].size()), &width, &height, &channelCount, 4);
+			mismatches += memcmp(reference, images[i].pixels.data(), images[i].pixels.size()) != 0 ? 1 : 0;
+			stbi_image_free(reference);
+		}
+		ED_LOG_INFO("Images: {} images decoded, {} different from stb RGBA", imageCount, mismatches);
+
+		// 4k RGB image, the size of a big albedo map
+		constexpr size_t pixelCount = 4096 * 4096;
+		std::vector<uint8_t> rgb(pixelCount * 3 + 5);
+		for (auto& value : rgb)
+			value = static_cast<uint8_t>(generator());
+		std::vector<uint8_t> rgba(pixelCount * 4);
+		std::vector<uint8_t> referenceRGBA(pixelCount * 4);
+
+		Measure("Images: RGB to RGBA, scalar", 10, [&]()
+		{
+			ExpandToRGBAScalar(rgb.data(), 3, referenceRGBA.data(), pixelCount);
+		});
+
+		Measure("Images: RGB to RGBA, SIMD", 10, [&]()
+		{
+			ExpandToRGBA(rgb.data(), 3, rgba.data(), pixelCount);
+		});
+
+		// Odd pixel counts go through the scalar tail
+		ExpandToRGBA(rgb.data() + 3, 3, rgba.data(), pixelCount - 7);
+		ExpandToRGBAScalar(rgb.data() + 3, 3, referenceRGBA.data(), pixelCount - 7);
+		bool bSame = memcmp(rgba.data(), referenceRGBA.data(), (pixelCount - 7) * 4) == 0;
+		ED_LOG_INFO("Images: SIMD expansion {} the scalar one", bSame ? "matches" : "DOES NOT match");
+	}
+}
@@ -0,0 +1,122 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "Core/Log.h"
+#include "Math/BatchTransform.h"
+#include "Scene/Components.h"
+
+namespace Eden::Benchmarks
+{
+	static float MaxDifference(const glm::mat4* a, const glm::mat4* b, size_t count)
+	{
+		float maxDifference = 0.0f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				for (int r = 0; r < 4; ++r)
+					maxDifference = std::max(maxDifference, glm::abs(a[i][c][r] - b[i][c][r]));
+			}
+		}
+		return maxDifference;
+	}
+
+	static float MaxDifference(const Math::AABB* a, const Math::AABB* b, size_t count)
+	{
+		float maxDifference = 0.0f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			glm::vec3 minDifference = glm::abs(a[i].min - b[i].min);
+			glm::vec3 maxDifferences = glm::abs(a[i].max - b[i].max);
+			maxDifference = std::max({ maxDifference, minDifference.x, minDifference.y, minDifference.z, maxDifferences.x, maxDifferences.y, maxDifferences.z });
+		}
+		return maxDifference;
+	}
+
+	// 1M random transforms, compares the SIMD kernels with the scalar ones and with TransformComponent::GetTransform
+	void SIMDTransforms()
+	{
+		constexpr size_t transformCount = 1000000;
+		constexpr uint32_t iterationCount = 20;
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+		std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+
+		std::vector<TransformComponent> components(transformCount);
+		Math::TransformSoA transforms;
+		transforms.Reserve(transformCount);
+		for (auto& tc : components)
+		{
+			tc.translation = glm::vec3(position(generator), position(generator), position(generator));
+			tc.rotation = glm::vec3(angle(generator), angle(generator), angle(generator));
+			tc.scale = glm::vec3(scale(generator), scale(generator), scale(generator));
+			transforms.Add(tc.translation, tc.rotation, tc.scale);
+		}
+
+		std::vector<glm::mat4> reference(transformCount);
+		std::vector<glm::mat4> scalar(transformCount);
+		std::vector<glm::mat4> simd(transformCount);
+
+		Measure("Compose: TransformComponent::GetTransform", iterationCount, [&]()
+		{
+			for (size_t i = 0; i < transformCount; ++i)
+				reference[i] = components[i].GetTransform();
+		});
+
+		Measure("Compose: scalar", iterationCount, [&]()
+		{
+			Math::ComposeTransformsScalar(transforms, scalar.data());
+		});
+
+		Measure("Compose: SIMD", iterationCount, [&]()
+		{
+			Math::ComposeTransforms(transforms, simd.data());
+		});
+
+		ED_LOG_INFO("Compose: max difference scalar/SIMD {}, GetTransform/SIMD {}", MaxDifference(scalar.data(), simd.data(), transformCount), MaxDifference(reference.data(), simd.data(), transformCount));
+
+		// Every matrix is the parent of the next one
+		std::vector<glm::mat4> worldScalar(transformCount);
+		std::vector<glm::mat4> worldSIMD(transformCount);
+
+		Measure("Multiply: scalar", iterationCount, [&]()
+		{
+			Math::MultiplyTransformsScalar(reference.data(), reference.data() + 1, worldScalar.data(), transformCount - 1);
+		});
+
+		Measure("Multiply: SIMD", iterationCount, [&]()
+		{
+			Math::MultiplyTransforms(reference.data(), reference.data() + 1, worldSIMD.data(), transformCount - 1);
+		});
+
+		ED_LOG_INFO("Multiply: max difference scalar/SIMD {}", MaxDifference(worldScalar.data(), worldSIMD.data(), transformCount - 1));
+
+		std::vector<Math::AABB> boxes(transformCount);
+		for (auto& box : boxes)
+		{
+			glm::vec3 a(position(generator), position(generator), position(generator));
+			glm::vec3 b(position(generator), position(generator), position(generator));
+			box = { glm::min(a, b), glm::max(a, b) };
+		}
+
+		std::vector<Math::AABB> boxesScalar(transformCount);
+		std::vector<Math::AABB> boxesSIMD(transformCount);
+
+		Measure("AABB: scalar", iterationCount, [&]()
+		{
+			Math::TransformAABBsScalar(boxes.data(), reference.data(), boxesScalar.data(), transformCount);
+		});
+
+		Measure("AABB: SIMD", iterationCount, [&]()
+		{
+			Math::TransformAABBs(boxes.data(), reference.data(), boxesSIMD.data(), transformCount);
+		});
+
+		ED_LOG_INFO("AABB: max difference scalar/SIMD {}", MaxDifference(boxesScalar.data(), boxesSIMD.data(), transformCount));
+	}
+}
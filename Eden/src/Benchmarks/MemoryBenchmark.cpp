@@ -0,0 +1,391 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Core/Log.h"
+#include "Core/Memory/OffsetAllocator.h"
+#include "Profiling/Timer.h"
+#include "Renderer/GeometryBuffers.h"
+#include "Scene/MeshSource.h"
+#include "Utilities/Utils.h"
+
+namespace Eden::Benchmarks
+{
+	struct ReferenceAllocation
+	{
+		Memory::OffsetAllocator::Allocation allocation;
+		uint32_t size;
+		uint32_t id;
+	};
+
+	// Compares the allocator with the owner of every unit of its range, -1 for free units. Returns the errors found.
+	static uint32_t CheckOffsetAllocator(const Memory::OffsetAllocator& allocator, const std::vector<int32_t>& owners, const std::vector<ReferenceAllocation>& allocations)
+	{
+		uint32_t errors = 0;
+
+		// Free ranges are always merged, so the allocator has exactly the runs of free units
+		uint32_t freeSize = 0;
+		uint32_t freeRanges = 0;
+		uint32_t largestFreeRange = 0;
+		uint32_t run = 0;
+		for (size_t i = 0; i <= owners.size(); ++i)
+		{
+			if (i < owners.size() && owners[i] < 0)
+			{
+				run++;
+				continue;
+			}
+			if (run > 0)
+			{
+				freeSize += run;
+				freeRanges++;
+				largestFreeRange = std::max(largestFreeRange, run);
+			}
+			run = 0;
+		}
+
+		Memory::OffsetAllocator::Stats stats = allocator.GetStats();
+		errors += stats.freeSize != freeSize || allocator.GetFreeSize() != freeSize ? 1 : 0;
+		errors += stats.freeRanges != freeRanges ? 1 : 0;
+		errors += stats.largestFreeRange != largestFreeRange ? 1 : 0;
+		errors += stats.allocations != allocations.size() ? 1 : 0;
+		for (const ReferenceAllocation& reference : allocations)
+			errors += allocator.GetAllocationSize(reference.allocation) != reference.size ? 1 : 0;
+		return errors;
+	}
+
+	// Random allocations and frees of sizes up to maxSize in a range of rangeSize units, every operation is checked
+	// against the owner of every unit. Every 1000 operations the allocations are compacted and checked in place.
+	static void ValidateOffsetAllocator(uint32_t rangeSize, uint32_t maxSize, uint32_t operationCount, uint32_t seed)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_int_distribution<uint32_t> randomSize(1, maxSize);
+		std::uniform_int_distribution<uint32_t> randomOperation(0, 99);
+
+		Memory::OffsetAllocator allocator(rangeSize);
+		std::vector<int32_t> owners(rangeSize, -1);
+		std::vector<ReferenceAllocation> allocations;
+		uint32_t nextId = 0;
+		uint32_t errors = 0;
+		uint32_t failedAllocations = 0;
+		uint32_t compactions = 0;
+
+		for (uint32_t operation = 0; operation < operationCount; ++operation)
+		{
+			// Allocations are more likely until the range is half full
+			uint32_t allocateChance = allocator.GetFreeSize() > rangeSize / 2 ? 70 : 40;
+			if (allocations.empty() || randomOperation(generator) < allocateChance)
+			{
+				uint32_t size = randomSize(generator);
+				Memory::OffsetAllocator::Allocation allocation = allocator.Allocate(size);
+				if (!allocation.IsValid())
+				{
+					// A free range of the size rounded up to its bin always fits
+					uint32_t largestFreeRange = allocator.GetStats().largestFreeRange;
+					errors += largestFreeRange >= size + (size >> 3) ? 1 : 0;
+					failedAllocations++;
+					continue;
+				}
+
+				bool bIsInRange = allocation.offset + static_cast<uint64_t>(size) <= rangeSize;
+				errors += bIsInRange ? 0 : 1;
+				for (uint32_t i = allocation.offset; bIsInRange && i < allocation.offset + size; ++i)
+				{
+					errors += owners[i] >= 0 ? 1 : 0;
+					owners[i] = static_cast<int32_t>(nextId);
+				}
+				allocations.push_back({ allocation, size, nextId++ });
+			}
+			else
+			{
+				std::uniform_int_distribution<size_t> randomAllocation(0, allocations.size() - 1);
+				size_t index = randomAllocation(generator);
+				ReferenceAllocation reference = allocations[index];
+				allocations[index] = allocations.back();
+				allocations.pop_back();
+
+				allocator.Free(reference.allocation);
+				for (uint32_t i = reference.allocation.offset; i < reference.allocation.offset + reference.size; ++i)
+				{
+					errors += owners[i] != static_cast<int32_t>(reference.id) ? 1 : 0;
+					owners[i] = -1;
+				}
+			}
+			errors += CheckOffsetAllocator(allocator, owners, allocations);
+
+			// The owners are moved like the data of a geometry buffers page, then every allocation must still own its units
+			if (operation % 1000 == 999)
+			{
+				std::vector<int32_t> ownerOfHandle(owners.size(), -1);
+				for (const ReferenceAllocation& reference : allocations)
+					ownerOfHandle[reference.allocation.offset] = static_cast<int32_t>(&reference - allocations.data());
+
+				uint32_t previousOffset = 0;
+				uint32_t packedOffset = 0;
+				std::vector<Memory::OffsetAllocator::Allocation> newAllocations(allocations.size());
+				allocator.Compact([&](Memory::OffsetAllocator::Allocation from, Memory::OffsetAllocator::Allocation to)
+				{
+					errors += from.offset < previousOffset || to.offset != packedOffset || to.offset > from.offset ? 1 : 0;
+					int32_t index = ownerOfHandle[from.offset];
+					if (index < 0 || allocations[index].allocation.node != from.node)
+					{
+						errors++;
+						return;
+					}
+
+					uint32_t size = allocations[index].size;
+					std::move(owners.begin() + from.offset, owners.begin() + from.offset + size, owners.begin() + to.offset);
+					newAllocations[index] = to;
+					previousOffset = from.offset;
+					packedOffset += size;
+				});
+				std::fill(owners.begin() + packedOffset, owners.end(), -1);
+
+				for (size_t i = 0; i < allocations.size(); ++i)
+				{
+					allocations[i].allocation = newAllocations[i];
+					for (uint32_t u = newAllocations[i].offset; u < newAllocations[i].offset + allocations[i].size; ++u)
+						errors += owners[u] != static_cast<int32_t>(allocations[i].id) ? 1 : 0;
+				}
+				errors += CheckOffsetAllocator(allocator, owners, allocations);
+				errors += allocator.GetStats().freeRanges > 1 ? 1 : 0;
+				compactions++;
+			}
+		}
+
+		// Everything freed merges back into the whole range, which fits in one allocation again
+		for (const ReferenceAllocation& reference : allocations)
+			allocator.Free(reference.allocation);
+		Memory::OffsetAllocator::Stats stats = allocator.GetStats();
+		errors += stats.freeRanges != 1 || stats.largestFreeRange != rangeSize || stats.allocations != 0 ? 1 : 0;
+		errors += allocator.Allocate(rangeSize).offset != 0 ? 1 : 0;
+
+		ED_LOG_INFO("Offset allocator: {} operations on {} units, sizes up to {}, {} failed allocations, {} compactions, {} errors",
+			operationCount, rangeSize, maxSize, failedAllocations, compactions, errors);
+	}
+
+	// Exhaustive checks of every operation against the owner of every unit, then the cost of the operations in a large range
+	void OffsetAllocation()
+	{
+		ValidateOffsetAllocator(64, 8, 20000, 1);
+		ValidateOffsetAllocator(4096, 64, 50000, 2);
+		ValidateOffsetAllocator(4096, 1024, 50000, 3);
+		ValidateOffsetAllocator(65536, 20000, 5000, 4);
+
+		// Exact fits that the rounded up search misses, the range of the size itself is used
+		{
+			uint32_t errors = 0;
+			for (uint32_t size = 1; size <= 4096; ++size)
+			{
+				Memory::OffsetAllocator allocator(size);
+				Memory::OffsetAllocator::Allocation whole = allocator.Allocate(size);
+				errors += whole.offset != 0 ? 1 : 0;
+				allocator.Free(whole);
+
+				Memory::OffsetAllocator::Allocation first = allocator.Allocate(size - size / 2);
+				Memory::OffsetAllocator::Allocation second = allocator.Allocate(size / 2);
+				errors += !first.IsValid() || (size > 1 && second.offset != size - size / 2) || allocator.GetFreeSize() != 0 ? 1 : 0;
+				allocator.Free(first);
+				allocator.Free(second);
+				errors += allocator.GetStats().largestFreeRange != size ? 1 : 0;
+			}
+			ED_LOG_INFO("Offset allocator: exact fits of every size up to 4096, {} errors", errors);
+		}
+
+		constexpr uint32_t allocationCount = 100000;
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<uint32_t> randomSize(1, 4096);
+		std::vector<uint32_t> sizes(allocationCount);
+		for (uint32_t& size : sizes)
+			size = randomSize(generator);
+		std::vector<uint32_t> freeOrder(allocationCount);
+		for (uint32_t i = 0; i < allocationCount; ++i)
+			freeOrder[i] = i;
+		std::shuffle(freeOrder.begin(), freeOrder.end(), generator);
+
+		Memory::OffsetAllocator allocator(1u << 30);
+		std::vector<Memory::OffsetAllocator::Allocation> allocations(allocationCount);
+		Measure("Offset allocator: 100k allocations and 100k frees in random order", 20, [&]()
+		{
+			for (uint32_t i = 0; i < allocationCount; ++i)
+				allocations[i] = allocator.Allocate(sizes[i]);
+			for (uint32_t i : freeOrder)
+				allocator.Free(allocations[i]);
+		});
+
+		// Half of the allocations freed leave holes, the next ones reuse them
+		for (uint32_t i = 0; i < allocationCount; ++i)
+			allocations[i] = allocator.Allocate(sizes[i]);
+		for (uint32_t i = 0; i < allocationCount / 2; ++i)
+			allocator.Free(allocations[freeOrder[i]]);
+		Memory::OffsetAllocator::Stats stats = allocator.GetStats();
+		ED_LOG_INFO("Offset allocator: {} free ranges after freeing half of the allocations, fragmentation {:.3f}", stats.freeRanges, stats.GetFragmentation());
+		Measure("Offset allocator: 50k allocations and 50k frees in a fragmented range", 20, [&]()
+		{
+			for (uint32_t i = 0; i < allocationCount / 2; ++i)
+				allocations[freeOrder[i]] = allocator.Allocate(sizes[freeOrder[i]]);
+			for (uint32_t i = 0; i < allocationCount / 2; ++i)
+				allocator.Free(allocations[freeOrder[i]]);
+		});
+
+		Timer timer;
+		timer.Record();
+		uint32_t movedSize = allocator.Compact([](Memory::OffsetAllocator::Allocation, Memory::OffsetAllocator::Allocation) {});
+		ED_LOG_INFO("Offset allocator: compacted {} allocations in {:.3f}ms, {} units moved", allocator.GetAllocationCount(), timer.ElapsedMilliseconds(), movedSize);
+	}
+
+	// Pages of the vertex pool of GeometryBuffers, without their buffers: the first page with room takes an upload, a new
+	// page is created otherwise, and empty pages are released like GeometryBuffers::Free does
+	struct ChurnPages
+	{
+		std::vector<Memory::OffsetAllocator> pages;
+		uint32_t pageSize;
+		uint32_t livePages = 0;
+		uint32_t peakPages = 0;
+		uint64_t movedSize = 0;
+
+		uint32_t Allocate(uint32_t size, Memory::OffsetAllocator::Allocation& outAllocation)
+		{
+			for (uint32_t i = 0; i < pages.size(); ++i)
+			{
+				if (pages[i].GetSize() == 0)
+					continue;
+				outAllocation = pages[i].Allocate(size);
+				if (outAllocation.IsValid())
+					return i;
+			}
+
+			uint32_t page = static_cast<uint32_t>(std::find_if(pages.begin(), pages.end(), [](const Memory::OffsetAllocator& allocator) { return allocator.GetSize() == 0; }) - pages.begin());
+			if (page == pages.size())
+				pages.emplace_back();
+			pages[page].Reset(std::max(pageSize, size));
+			outAllocation = pages[page].Allocate(size);
+			livePages++;
+			peakPages = std::max(peakPages, livePages);
+			return page;
+		}
+
+		void Free(uint32_t page, Memory::OffsetAllocator::Allocation allocation)
+		{
+			pages[page].Free(allocation);
+			if (pages[page].GetAllocationCount() == 0 && (pages[page].GetSize() > pageSize || livePages > 1))
+			{
+				pages[page].Reset(0);
+				livePages--;
+			}
+		}
+
+		float GetFragmentation() const
+		{
+			uint64_t freeSize = 0;
+			uint64_t largestFreeRanges = 0;
+			for (const Memory::OffsetAllocator& allocator : pages)
+			{
+				Memory::OffsetAllocator::Stats stats = allocator.GetStats();
+				freeSize += stats.freeSize;
+				largestFreeRanges += stats.largestFreeRange;
+			}
+			return freeSize > 0 ? 1.0f - static_cast<float>(largestFreeRanges) / static_cast<float>(freeSize) : 0.0f;
+		}
+	};
+
+	// Streaming of mesh vertices in and out of the pages: every frame unloads some resident meshes and loads new ones,
+	// around a resident set of 256MB. The meshes have between 1k and 300k full vertices, log uniform.
+	static void MeasureGeometryChurn(const char* label, uint32_t defragmentInterval, float minFragmentation)
+	{
+		constexpr uint32_t frameCount = 5000;
+		constexpr uint64_t residentTarget = 256ull * 1024 * 1024 / sizeof(VertexData);
+		struct ResidentMesh
+		{
+			uint32_t page;
+			uint32_t size;
+			Memory::OffsetAllocator::Allocation allocation;
+		};
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> randomLogSize(std::log(1000.0f), std::log(300000.0f));
+		std::uniform_int_distribution<uint32_t> randomCount(0, 4);
+
+		ChurnPages pages;
+		pages.pageSize = GeometryBuffers::kPageSize / sizeof(VertexData);
+		std::vector<ResidentMesh> resident;
+		uint64_t residentSize = 0;
+		uint64_t loads = 0;
+		float fragmentationSum = 0.0f;
+		float maxFragmentation = 0.0f;
+
+		Timer timer;
+		timer.Record();
+		for (uint32_t frame = 0; frame < frameCount; ++frame)
+		{
+			uint32_t unloadCount = std::min(static_cast<uint32_t>(resident.size()), randomCount(generator));
+			for (uint32_t i = 0; i < unloadCount; ++i)
+			{
+				std::uniform_int_distribution<size_t> randomMesh(0, resident.size() - 1);
+				size_t index = randomMesh(generator);
+				pages.Free(resident[index].page, resident[index].allocation);
+				residentSize -= resident[index].size;
+				resident[index] = resident.back();
+				resident.pop_back();
+			}
+
+			while (residentSize < residentTarget)
+			{
+				ResidentMesh mesh;
+				mesh.size = static_cast<uint32_t>(std::exp(randomLogSize(generator)));
+				mesh.page = pages.Allocate(mesh.size, mesh.allocation);
+				residentSize += mesh.size;
+				resident.push_back(mesh);
+				loads++;
+			}
+
+			// Compacts the fragmented pages, the resident meshes get their new allocations
+			if (defragmentInterval > 0 && frame % defragmentInterval == defragmentInterval - 1)
+			{
+				for (uint32_t p = 0; p < pages.pages.size(); ++p)
+				{
+					Memory::OffsetAllocator& allocator = pages.pages[p];
+					Memory::OffsetAllocator::Stats stats = allocator.GetStats();
+					if (allocator.GetSize() == 0 || stats.freeRanges < 2 || stats.GetFragmentation() < minFragmentation)
+						continue;
+
+					std::vector<ResidentMesh*> byNode;
+					for (ResidentMesh& mesh : resident)
+					{
+						if (mesh.page != p)
+							continue;
+						byNode.resize(std::max<size_t>(byNode.size(), mesh.allocation.node + 1), nullptr);
+						byNode[mesh.allocation.node] = &mesh;
+					}
+					pages.movedSize += allocator.Compact([&](Memory::OffsetAllocator::Allocation from, Memory::OffsetAllocator::Allocation to)
+					{
+						byNode[from.node]->allocation = to;
+					});
+				}
+			}
+
+			float fragmentation = pages.GetFragmentation();
+			fragmentationSum += fragmentation;
+			maxFragmentation = std::max(maxFragmentation, fragmentation);
+		}
+		float elapsedTime = timer.ElapsedMilliseconds();
+
+		uint64_t pageBytes = 0;
+		for (const Memory::OffsetAllocator& allocator : pages.pages)
+			pageBytes += static_cast<uint64_t>(allocator.GetSize()) * sizeof(VertexData);
+		ED_LOG_INFO("{}: {} loads in {} frames, {:.3f}ms, {} resident meshes in {} pages ({} peak) instead of a buffer each", label, loads, frameCount, elapsedTime,
+			resident.size(), pages.livePages, pages.peakPages);
+		ED_LOG_INFO("{}: {} resident in {} of pages, fragmentation {:.3f} average, {:.3f} max, {} moved", label, Utils::BytesToString(residentSize * sizeof(VertexData)),
+			Utils::BytesToString(pageBytes), fragmentationSum / frameCount, maxFragmentation, Utils::BytesToString(pages.movedSize * sizeof(VertexData)));
+	}
+
+	void GeometryChurn()
+	{
+		MeasureGeometryChurn("Geometry churn", 0, 0.0f);
+		MeasureGeometryChurn("Geometry churn, pages above 0.1 defragmented every 60 frames", 60, 0.1f);
+		MeasureGeometryChurn("Geometry churn, pages above 0.5 defragmented every 60 frames", 60, 0.5f);
+	}
+}
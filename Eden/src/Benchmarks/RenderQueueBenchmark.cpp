@@ -0,0 +1,556 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/Log.h"
+#include "Math/BatchTransform.h"
+#include "Math/Frustum.h"
+#include "Profiling/Timer.h"
+#include "Renderer/MeshLOD.h"
+#include "Renderer/RenderQueue.h"
+#include "Renderer/StaticGeometry.h"
+#include "Scene/MeshOptimizer.h"
+#include "Scene/MeshSource.h"
+#include "Utilities/Utils.h"
+
+namespace Eden::Benchmarks
+{
+	// Mesh and material changes when drawing the packets in order, what the renderer would bind
+	static void CountStateChanges(const std::vector<DrawPacket>& packets, const std::vector<uint32_t>& meshes, const std::vector<uint32_t>& materials, uint32_t& outMeshChanges, uint32_t& outMaterialChanges)
+	{
+		outMeshChanges = outMaterialChanges = 0;
+		uint32_t boundMesh = UINT32_MAX;
+		uint32_t boundMaterial = UINT32_MAX;
+		for (auto& packet : packets)
+		{
+			uint32_t draw = packet.visibleMeshIndex;
+			if (meshes[draw] != boundMesh)
+			{
+				boundMesh = meshes[draw];
+				outMeshChanges++;
+			}
+			if (materials[draw] != boundMaterial)
+			{
+				boundMaterial = materials[draw];
+				outMaterialChanges++;
+			}
+		}
+	}
+
+	// 100k submesh draws with 64 mesh sources and 1000 materials, 10% of them transparent
+	void RenderQueueSort()
+	{
+		constexpr uint32_t drawCount = 100000;
+		constexpr uint32_t meshCount = 64;
+		constexpr uint32_t materialCount = 1000;
+
+		std::mt19937 generator(42);
+		std::uniform_int_distribution<uint32_t> randomMesh(0, meshCount - 1);
+		std::uniform_int_distribution<uint32_t> randomMaterial(0, materialCount - 1);
+		std::uniform_real_distribution<float> randomDepth(0.0f, 1.0f);
+
+		// Every mesh source uses its own materials, like loaded glTF files
+		std::vector<uint32_t> meshes(drawCount);
+		std::vector<uint32_t> materials(drawCount);
+		std::vector<float> depths(drawCount);
+		std::vector<RenderLayer> layers(drawCount);
+		for (uint32_t i = 0; i < drawCount; ++i)
+		{
+			meshes[i] = randomMesh(generator);
+			materials[i] = meshes[i] * materialCount / meshCount + randomMaterial(generator) % (materialCount / meshCount);
+			depths[i] = randomDepth(generator);
+			layers[i] = materials[i] % 10 == 0 ? kRenderLayer_Transparent : kRenderLayer_Opaque;
+		}
+
+		RenderQueue queue;
+		auto buildQueue = [&]()
+		{
+			queue.Clear();
+			for (uint32_t i = 0; i < drawCount; ++i)
+			{
+				uint32_t pipeline = layers[i] == kRenderLayer_Transparent ? 1 : 0;
+				// One submesh per material in this test, the ids are already dense ranks
+				queue.Add(RenderQueue::MakeSortKey(0, layers[i], pipeline, materials[i], materials[i], depths[i]), i, 0);
+			}
+		};
+
+		buildQueue();
+		uint32_t meshChanges, materialChanges;
+		CountStateChanges(queue.GetPackets(), meshes, materials, meshChanges, materialChanges);
+		ED_LOG_INFO("Render queue: unsorted, {} mesh changes and {} material changes for {} draws", meshChanges, materialChanges, drawCount);
+
+		Measure("Render queue: build and radix sort", 20, [&]()
+		{
+			buildQueue();
+			queue.Sort();
+		});
+
+		std::vector<DrawPacket> reference;
+		Measure("Render queue: build and std::stable_sort", 20, [&]()
+		{
+			buildQueue();
+			reference = queue.GetPackets();
+			std::stable_sort(reference.begin(), reference.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; });
+		});
+
+		buildQueue();
+		queue.Sort();
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < drawCount; ++i)
+			mismatches += queue.GetPackets()[i].visibleMeshIndex != reference[i].visibleMeshIndex ? 1 : 0;
+		CountStateChanges(queue.GetPackets(), meshes, materials, meshChanges, materialChanges);
+		ED_LOG_INFO("Render queue: sorted, {} mesh changes and {} material changes, {} mismatches against std::stable_sort", meshChanges, materialChanges, mismatches);
+
+		// Draws of the same mesh and material become one instanced draw
+		Measure("Render queue: build batches", 20, [&]()
+		{
+			queue.BuildBatches([&](const DrawPacket& previous, const DrawPacket& packet)
+			{
+				return meshes[previous.visibleMeshIndex] == meshes[packet.visibleMeshIndex] && materials[previous.visibleMeshIndex] == materials[packet.visibleMeshIndex];
+			});
+		});
+
+		uint32_t batchErrors = 0;
+		for (auto& batch : queue.GetBatches())
+		{
+			for (uint32_t i = batch.firstPacket + 1; i < batch.firstPacket + batch.packetCount; ++i)
+				batchErrors += materials[queue.GetPackets()[i].visibleMeshIndex] != materials[queue.GetPackets()[batch.firstPacket].visibleMeshIndex] ? 1 : 0;
+		}
+		size_t opaqueBatches = queue.GetBatchesEnd(0, kRenderLayer_Opaque) - queue.GetBatchesBegin(0, kRenderLayer_Opaque);
+		size_t transparentBatches = queue.GetBatchesEnd(0, kRenderLayer_Transparent) - queue.GetBatchesBegin(0, kRenderLayer_Transparent);
+		ED_LOG_INFO("Render queue: {} instanced draws ({} opaque, {} transparent) for {} draws, {} wrongly batched packets", queue.GetBatches().size(), opaqueBatches, transparentBatches, drawCount, batchErrors);
+
+		// Transparent draws have to go back to front
+		uint32_t orderErrors = 0;
+		const DrawPacket* end = queue.GetEnd(0, kRenderLayer_Transparent);
+		for (const DrawPacket* packet = queue.GetBegin(0, kRenderLayer_Transparent); packet + 1 < end; ++packet)
+			orderErrors += depths[packet[0].visibleMeshIndex] < depths[packet[1].visibleMeshIndex] - 1e-6f ? 1 : 0;
+		ED_LOG_INFO("Render queue: {} transparent draws, {} out of back to front order", end - queue.GetBegin(0, kRenderLayer_Transparent), orderErrors);
+	}
+
+	struct SubmissionEntity
+	{
+		MeshSource* meshSource;
+		glm::mat4 transform;
+	};
+
+	// Same as RendererData::VisibleMesh
+	struct SubmissionVisibleMesh
+	{
+		MeshSource* meshSource;
+		uint32_t firstSubmesh;
+		uint32_t submeshCount;
+		uint32_t lod;
+		glm::mat4 transform;
+	};
+
+	// Slice of a described buffer without GPU memory. The geometry buffers are never created headless, so freeing it only clears it.
+	static void DescribeSubmissionSlice(GeometrySlice& slice, const BufferRef& buffer, uint32_t offset, uint32_t count)
+	{
+		slice.buffers[0] = buffer;
+		slice.offset = offset;
+		slice.count = count;
+		slice.streamCount = 1;
+		slice.pool = 0;
+	}
+
+	static BufferRef MakeSubmissionBuffer(uint32_t stride, uint32_t elementCount)
+	{
+		BufferRef buffer = MakeShared<Buffer>();
+		buffer->desc = { stride, elementCount, BufferDesc::Vertex_Index };
+		return buffer;
+	}
+
+	// Only the tables the passes read are filled, nothing is uploaded to the GPU: the slices are only described, for the
+	// static geometry layout. Every mesh source has buffers of its own. 10% of the materials are transparent.
+	static SharedPtr<MeshSource> MakeSubmissionMeshSource(uint32_t meshCount, uint32_t submeshesPerMesh, uint32_t materialCount, std::mt19937& generator, uint32_t& nextId)
+	{
+		std::uniform_real_distribution<float> randomPosition(-50.0f, 50.0f);
+		std::uniform_int_distribution<uint32_t> randomMaterial(0, materialCount - 1);
+
+		SharedPtr<MeshSource> meshSource = MakeShared<MeshSource>();
+		meshSource->id = nextId++;
+		for (uint32_t m = 0; m < materialCount; ++m)
+		{
+			PBRMaterial& material = meshSource->materials.emplace_back();
+			material.id = nextId++;
+			material.bIsTransparent = m % 10 == 9;
+		}
+
+		uint32_t vertexStart = 0;
+		uint32_t indexStart = 0;
+		for (uint32_t m = 0; m < meshCount; ++m)
+		{
+			MeshSource::Mesh mesh = { {}, static_cast<uint32_t>(meshSource->submeshes.size()), submeshesPerMesh };
+			for (uint32_t s = 0; s < submeshesPerMesh; ++s)
+			{
+				glm::vec3 center = glm::vec3(randomPosition(generator), randomPosition(generator), randomPosition(generator));
+				MeshSource::Submesh submesh = { { center - 1.0f, center + 1.0f }, vertexStart, indexStart, 3000, randomMaterial(generator) };
+				vertexStart += 600;
+				indexStart += submesh.indexCount;
+				mesh.bounds.Merge(submesh.bounds);
+				meshSource->submeshes.emplace_back(submesh);
+			}
+			meshSource->meshes.emplace_back(mesh);
+
+			MeshSource::MeshInstance instance;
+			instance.modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(randomPosition(generator), 0.0f, randomPosition(generator)));
+			instance.bounds = Math::TransformAABB(mesh.bounds, instance.modelMatrix);
+			instance.mesh = m;
+			meshSource->instances.emplace_back(instance);
+			meshSource->instanceNames.emplace_back();
+		}
+		meshSource->vertexCount = vertexStart;
+		meshSource->indexCount = indexStart;
+		DescribeSubmissionSlice(meshSource->vertexSlice, MakeSubmissionBuffer(sizeof(VertexData), vertexStart), 0, vertexStart);
+		DescribeSubmissionSlice(meshSource->indexSlice, MakeSubmissionBuffer(sizeof(uint16_t), indexStart), 0, indexStart);
+		meshSource->bHasMesh = true;
+
+		return meshSource;
+	}
+
+	// The CPU side of the forward pass every frame, from the visible entities to the draws: the visible meshes of
+	// Renderer::CullScene without culling, Renderer::BuildRenderQueue, then the state DrawRenderQueue would bind.
+	// The sort is left out, it doesn't depend on the mesh layout, see RenderQueueSort. Mesh sources in the same geometry
+	// buffers page, or in the same buffer set of a static geometry layout, share their binds.
+	static void MeasureSubmission(const char* label, const std::vector<SubmissionEntity>& entities, const StaticGeometry* staticGeometry = nullptr)
+	{
+		constexpr uint32_t frameCount = 10;
+		const glm::vec3 cameraPosition = glm::vec3(0.0f, 10.0f, -100.0f);
+		const float inverseFarPlane = 1.0f / 1000.0f;
+
+		std::vector<SubmissionVisibleMesh> visibleMeshes;
+		RenderQueue queue;
+		uint64_t drawnIndices = 0;
+		uint32_t materialBinds = 0;
+		uint32_t meshBinds = 0;
+		auto buildQueue = [&]()
+		{
+			visibleMeshes.clear();
+			for (auto& entity : entities)
+			{
+				MeshSource* ms = entity.meshSource;
+				for (auto& instance : ms->instances)
+				{
+					const MeshSource::Mesh& mesh = ms->meshes[instance.mesh];
+					visibleMeshes.push_back({ ms, mesh.firstSubmesh, mesh.submeshCount, 0, Math::MultiplyTransform(entity.transform, instance.modelMatrix) });
+				}
+			}
+
+			queue.Clear();
+			for (uint32_t m = 0; m < visibleMeshes.size(); ++m)
+			{
+				const auto& visibleMesh = visibleMeshes[m];
+				const MeshSource* ms = visibleMesh.meshSource;
+				RenderQueue::SortRanks ranks = queue.GetSortRanks(ms->id, static_cast<uint32_t>(ms->materials.size()), static_cast<uint32_t>(ms->submeshes.size()));
+				for (uint32_t s = visibleMesh.firstSubmesh; s < visibleMesh.firstSubmesh + visibleMesh.submeshCount; ++s)
+				{
+					const MeshSource::Submesh& submesh = ms->submeshes[s];
+					const PBRMaterial& material = ms->materials[submesh.material];
+					RenderLayer layer = material.bIsTransparent ? kRenderLayer_Transparent : kRenderLayer_Opaque;
+					glm::vec3 center = glm::vec3(visibleMesh.transform * glm::vec4(submesh.bounds.GetCenter(), 1.0f));
+					float depth = glm::min(glm::distance(cameraPosition, center) * inverseFarPlane, 1.0f);
+					queue.Add(RenderQueue::MakeSortKey(0, layer, material.bIsTransparent ? 1 : 0, ranks.material + submesh.material, ranks.submesh + s, depth), m, s);
+				}
+			}
+		};
+
+		auto drawQueue = [&]()
+		{
+			auto getSubmesh = [&](const DrawPacket& packet) { return &visibleMeshes[packet.visibleMeshIndex].meshSource->submeshes[packet.submeshIndex]; };
+			auto getIndexStart = [&](const DrawPacket& packet)
+			{
+				const auto& visibleMesh = visibleMeshes[packet.visibleMeshIndex];
+				return visibleMesh.meshSource->GetLOD(visibleMesh.meshSource->submeshes[packet.submeshIndex], visibleMesh.lod).indexStart;
+			};
+			queue.BuildBatches([&](const DrawPacket& previous, const DrawPacket& packet) { return getSubmesh(previous) == getSubmesh(packet) && getIndexStart(previous) == getIndexStart(packet); });
+
+			drawnIndices = 0;
+			materialBinds = 0;
+			meshBinds = 0;
+			const MeshSource* boundMeshSource = nullptr;
+			uint32_t boundBufferSet = UINT32_MAX;
+			const Buffer* boundVertexBuffer = nullptr;
+			const Buffer* boundIndexBuffer = nullptr;
+			uint32_t boundMaterial = UINT32_MAX;
+			const auto& packets = queue.GetPackets();
+			for (auto& batch : queue.GetBatches())
+			{
+				const DrawPacket& packet = packets[batch.firstPacket];
+				const auto& visibleMesh = visibleMeshes[packet.visibleMeshIndex];
+				const MeshSource* ms = visibleMesh.meshSource;
+				const MeshSource::Submesh& submesh = ms->submeshes[packet.submeshIndex];
+				if (ms != boundMeshSource)
+				{
+					// A layout has no buffers, its sets are compared instead
+					const StaticGeometry::Placement* placement = staticGeometry ? staticGeometry->Find(*ms) : nullptr;
+					uint32_t bufferSet = placement ? placement->bufferSet : UINT32_MAX;
+					const Buffer* vertexBuffer = placement ? nullptr : ms->vertexSlice.buffers[0].Get();
+					const Buffer* indexBuffer = placement ? nullptr : ms->indexSlice.buffers[0].Get();
+					if (bufferSet != boundBufferSet || vertexBuffer != boundVertexBuffer || indexBuffer != boundIndexBuffer)
+						meshBinds++;
+					boundBufferSet = bufferSet;
+					boundVertexBuffer = vertexBuffer;
+					boundIndexBuffer = indexBuffer;
+					boundMeshSource = ms;
+				}
+				const PBRMaterial& material = ms->materials[submesh.material];
+				if (material.id != boundMaterial)
+				{
+					boundMaterial = material.id;
+					materialBinds++;
+				}
+				drawnIndices += static_cast<uint64_t>(ms->GetLOD(submesh, visibleMesh.lod).indexCount) * batch.packetCount;
+			}
+		};
+
+		std::string buildLabel = std::string(label) + ", " + std::to_string(frameCount) + " frames of visible meshes and sort keys";
+		Measure(buildLabel.c_str(), 20, [&]()
+		{
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+				buildQueue();
+		});
+		queue.Sort();
+
+		std::string drawLabel = std::string(label) + ", " + std::to_string(frameCount) + " frames of batches and draws";
+		Measure(drawLabel.c_str(), 20, [&]()
+		{
+			for (uint32_t frame = 0; frame < frameCount; ++frame)
+				drawQueue();
+		});
+		ED_LOG_INFO("{}: {} visible meshes, {} draws in {} instanced draws, {} mesh binds, {} material binds, {} indices per frame",
+			label, visibleMeshes.size(), queue.GetPackets().size(), queue.GetBatches().size(), meshBinds, materialBinds, drawnIndices);
+	}
+
+	void MeshSubmission()
+	{
+		std::mt19937 generator(42);
+		uint32_t nextId = 1;
+
+		// Sponza as the importer loads it: one node with 103 primitives using 25 materials
+		SharedPtr<MeshSource> sponza = MakeSubmissionMeshSource(1, 103, 25, generator, nextId);
+		MeasureSubmission("Mesh submission: Sponza layout", { { sponza.Get(), glm::mat4(1.0f) } });
+
+		// 10k instances: 2500 entities placing 64 props of 4 nodes, every node has its own mesh of 3 submeshes
+		std::vector<SharedPtr<MeshSource>> props;
+		for (uint32_t i = 0; i < 64; ++i)
+			props.emplace_back(MakeSubmissionMeshSource(4, 3, 8, generator, nextId));
+
+		std::uniform_real_distribution<float> randomPosition(-500.0f, 500.0f);
+		std::vector<SubmissionEntity> entities;
+		for (uint32_t i = 0; i < 2500; ++i)
+			entities.push_back({ props[i % props.size()].Get(), glm::translate(glm::mat4(1.0f), glm::vec3(randomPosition(generator), 0.0f, randomPosition(generator))) });
+		MeasureSubmission("Mesh submission: 10k instances", entities);
+
+		// The same scene with the props in shared buffers, only the layout is computed headless
+		std::vector<const MeshSource*> meshSources;
+		for (auto& entity : entities)
+			meshSources.push_back(entity.meshSource);
+		StaticGeometry staticGeometry;
+		Measure("Mesh submission: static geometry layout of the 10k instances", 20, [&]()
+		{
+			staticGeometry.Layout(meshSources);
+		});
+		const StaticGeometry::Stats& bakeStats = staticGeometry.GetStats();
+		ED_LOG_INFO("Mesh submission: {} mesh sources in {} buffer sets, {} of vertices and {} of indices", bakeStats.meshSources, bakeStats.bufferSets,
+			Utils::BytesToString(bakeStats.vertexBytes), Utils::BytesToString(bakeStats.indexBytes));
+		MeasureSubmission("Mesh submission: 10k instances, static geometry", entities, &staticGeometry);
+
+		// The props sub-allocated from one geometry buffers page, like MeshSource loads them, without a bake
+		uint32_t pageVertexCount = 0;
+		uint32_t pageIndexCount = 0;
+		for (auto& prop : props)
+		{
+			pageVertexCount += prop->vertexCount;
+			pageIndexCount += prop->indexCount;
+		}
+		BufferRef pageVertices = MakeSubmissionBuffer(sizeof(VertexData), pageVertexCount);
+		BufferRef pageIndices = MakeSubmissionBuffer(sizeof(uint16_t), pageIndexCount);
+		uint32_t vertexOffset = 0;
+		uint32_t indexOffset = 0;
+		for (auto& prop : props)
+		{
+			DescribeSubmissionSlice(prop->vertexSlice, pageVertices, vertexOffset, prop->vertexCount);
+			DescribeSubmissionSlice(prop->indexSlice, pageIndices, indexOffset, prop->indexCount);
+			vertexOffset += prop->vertexCount;
+			indexOffset += prop->indexCount;
+		}
+		MeasureSubmission("Mesh submission: 10k instances, geometry buffers page", entities);
+	}
+
+	// A sphere displaced by a few waves, with a uv seam and poles like an exported model
+	static void MakeRock(uint32_t segments, uint32_t rings, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
+	{
+		for (uint32_t r = 0; r <= rings; ++r)
+		{
+			for (uint32_t s = 0; s <= segments; ++s)
+			{
+				// The last column is at the same position as the first one, only its uv differs
+				float theta = glm::pi<float>() * static_cast<float>(r) / static_cast<float>(rings);
+				float phi = glm::two_pi<float>() * static_cast<float>(s % segments) / static_cast<float>(segments);
+				glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				float radius = 1.0f + 0.15f * std::sin(3.0f * phi) * std::sin(2.0f * theta) + 0.05f * std::sin(11.0f * phi + 1.0f) * std::sin(7.0f * theta);
+				glm::vec2 uv(static_cast<float>(s) / static_cast<float>(segments), static_cast<float>(r) / static_cast<float>(rings));
+				vertices.push_back({ direction * radius, uv, glm::vec3(0.0f) });
+			}
+		}
+
+		for (uint32_t r = 0; r < rings; ++r)
+		{
+			for (uint32_t s = 0; s < segments; ++s)
+			{
+				uint32_t a = r * (segments + 1) + s;
+				uint32_t b = a + segments + 1;
+				indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			glm::vec3 p0 = vertices[indices[i]].position;
+			glm::vec3 normal = glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+			for (size_t k = 0; k < 3; ++k)
+				vertices[indices[i + k]].normal += normal;
+		}
+		for (auto& vertex : vertices)
+			vertex.normal = glm::length(vertex.normal) > 0.0f ? glm::normalize(vertex.normal) : glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+
+	// 10k scattered rocks of 16k triangles over 2km, the CPU side of a frame with the levels of detail off and on:
+	// the instance bounds are culled like Renderer::CullScene does, then the levels are picked and the triangles the draws
+	// would submit are counted. The GPU isn't measured headless, the triangle counts are the vertex work the levels save.
+	void MeshLODs()
+	{
+		std::vector<VertexData> vertices;
+		std::vector<uint32_t> indices;
+		MakeRock(128, 64, vertices, indices);
+
+		MeshOptimizer::Stats stats;
+		uint32_t vertexCount = MeshOptimizer::Optimize(vertices.data(), static_cast<uint32_t>(vertices.size()), indices.data(), indices.size(), stats);
+
+		Timer timer;
+		timer.Record();
+		std::vector<uint32_t> lodIndices;
+		MeshOptimizer::LODLevel levels[MeshOptimizer::kMaxLODCount - 1];
+		uint32_t levelCount = MeshOptimizer::GenerateLODs(vertices.data(), vertexCount, indices.data(), indices.size(), lodIndices, levels);
+		ED_LOG_INFO("Mesh LODs: {} levels of a {} triangle rock generated in {:.2f}ms", levelCount, indices.size() / 3, timer.ElapsedMilliseconds());
+
+		// The tables MeshSource::LoadMesh fills, nothing is uploaded to the GPU
+		Math::AABB bounds = Math::ComputeAABB(&vertices[0].position.x, vertexCount, sizeof(VertexData));
+		glm::vec3 extent = bounds.max - bounds.min;
+		float size = std::max(std::max(extent.x, extent.y), extent.z);
+		SharedPtr<MeshSource> rock = MakeShared<MeshSource>();
+		MeshSource::Submesh submesh = { bounds, 0, 0, static_cast<uint32_t>(indices.size()), 0, 0, levelCount };
+		MeshSource::Mesh mesh = { bounds, 0, 1, levelCount + 1 };
+		for (uint32_t l = 0; l < levelCount; ++l)
+		{
+			rock->lods.push_back({ static_cast<uint32_t>(indices.size()) + levels[l].indexStart, levels[l].indexCount });
+			mesh.lodErrors[l + 1] = levels[l].error * size;
+			ED_LOG_INFO("Mesh LODs: level {}: {} triangles, error {:.4f} of the bounds", l + 1, levels[l].indexCount / 3, levels[l].error);
+		}
+
+		constexpr uint32_t instanceCount = 10000;
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> randomPosition(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> randomScale(0.5f, 3.0f);
+		std::uniform_real_distribution<float> randomAngle(0.0f, glm::two_pi<float>());
+		std::vector<glm::mat4> transforms(instanceCount);
+		std::vector<Math::AABB> worldBounds(instanceCount);
+		for (uint32_t i = 0; i < instanceCount; ++i)
+		{
+			glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(randomPosition(generator), 0.0f, randomPosition(generator)));
+			transform = glm::rotate(transform, randomAngle(generator), glm::vec3(0.0f, 1.0f, 0.0f));
+			transforms[i] = glm::scale(transform, glm::vec3(randomScale(generator)));
+			worldBounds[i] = Math::TransformAABB(bounds, transforms[i]);
+		}
+
+		// Same projection as the renderer, with the far plane past the scene
+		const float viewportHeight = 1080.0f;
+		glm::mat4 projection = glm::perspectiveFovLH(glm::radians(70.0f), 1920.0f, viewportHeight, 0.1f, 3000.0f);
+		std::vector<uint8_t> visibility(instanceCount);
+		std::vector<uint8_t> instanceLODs(instanceCount);
+
+		struct FrameStats
+		{
+			uint64_t triangles = 0;
+			uint32_t visibleMeshes = 0;
+			uint32_t switches = 0;
+			uint32_t levelMeshes[MeshOptimizer::kMaxLODCount] = {};
+		};
+		auto drawFrame = [&](const glm::vec3& cameraPosition, bool bLODs, FrameStats& frameStats)
+		{
+			glm::mat4 view = glm::lookAtLH(cameraPosition, cameraPosition + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+			Math::CullAABBs(Math::Frustum::FromViewProjection(projection * view), worldBounds.data(), instanceCount, visibility.data());
+
+			MeshLOD::View lodView;
+			lodView.position = cameraPosition;
+			lodView.screenScale = MeshLOD::GetScreenScale(projection, viewportHeight);
+			frameStats = {};
+			for (uint32_t i = 0; i < instanceCount; ++i)
+			{
+				if (!visibility[i])
+					continue;
+
+				uint32_t lod = bLODs ? MeshLOD::Select(mesh, transforms[i], lodView, instanceLODs[i]) : 0;
+				frameStats.switches += lod != instanceLODs[i] ? 1 : 0;
+				instanceLODs[i] = static_cast<uint8_t>(lod);
+				frameStats.visibleMeshes++;
+				frameStats.levelMeshes[lod]++;
+				frameStats.triangles += rock->GetLOD(submesh, lod).indexCount / 3;
+			}
+		};
+
+		// The camera walks through the scene, then moves back and forth around one spot for the hysteresis
+		constexpr uint32_t walkFrameCount = 500;
+		constexpr uint32_t jitterFrameCount = 100;
+		const glm::vec3 start(0.0f, 2.0f, -1000.0f);
+		const glm::vec3 step(0.0f, 0.0f, 2.0f);
+		for (bool bLODs : { false, true })
+		{
+			const char* mode = bLODs ? "LODs on" : "LODs off";
+			std::fill(instanceLODs.begin(), instanceLODs.end(), static_cast<uint8_t>(0));
+
+			FrameStats frameStats;
+			std::string label = std::string("Mesh LODs: ") + mode + ", 10 frames of culling, level selection and triangle counts";
+			uint32_t frame = 0;
+			Measure(label.c_str(), 20, [&]()
+			{
+				for (uint32_t f = 0; f < 10; ++f, ++frame)
+					drawFrame(start + step * static_cast<float>(frame % walkFrameCount), bLODs, frameStats);
+			});
+
+			std::fill(instanceLODs.begin(), instanceLODs.end(), static_cast<uint8_t>(0));
+			uint64_t walkTriangles = 0;
+			uint64_t walkVisibleMeshes = 0;
+			uint64_t walkSwitches = 0;
+			for (uint32_t f = 0; f < walkFrameCount; ++f)
+			{
+				drawFrame(start + step * static_cast<float>(f), bLODs, frameStats);
+				walkTriangles += frameStats.triangles;
+				walkVisibleMeshes += frameStats.visibleMeshes;
+				walkSwitches += f > 0 ? frameStats.switches : 0;
+			}
+			ED_LOG_INFO("Mesh LODs: {}, {} visible meshes and {:.2f}M triangles per frame, {:.1f} level switches per frame over a {} frame walk",
+				mode, walkVisibleMeshes / walkFrameCount, static_cast<double>(walkTriangles) / (walkFrameCount * 1e6), static_cast<float>(walkSwitches) / static_cast<float>(walkFrameCount - 1), walkFrameCount);
+
+			uint64_t jitterSwitches = 0;
+			glm::vec3 spot = start + step * static_cast<float>(walkFrameCount);
+			for (uint32_t f = 0; f < jitterFrameCount; ++f)
+			{
+				drawFrame(spot + glm::vec3(0.0f, 0.0f, f % 2 == 0 ? 0.5f : -0.5f), bLODs, frameStats);
+				jitterSwitches += frameStats.switches;
+			}
+			std::string levelMeshes;
+			for (uint32_t l = 0; l < MeshOptimizer::kMaxLODCount; ++l)
+				levelMeshes += (l > 0 ? ", " : "") + std::to_string(frameStats.levelMeshes[l]);
+			ED_LOG_INFO("Mesh LODs: {}, meshes per level {}, {} level switches over {} frames of the camera moving back and forth by 1 unit",
+				mode, levelMeshes, jitterSwitches, jitterFrameCount);
+		}
+	}
+}
@@ -0,0 +1,439 @@
+#include "Benchmark.h"
+
+#include <random>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Core/Log.h"
+#include "Math/DynamicAABBTree.h"
+#include "Math/Frustum.h"
+#include "Math/Math.h"
+#include "Math/TriangleBVH.h"
+#include "Profiling/Timer.h"
+#include "Scene/Scene.h"
+#include "Scene/Entity.h"
+#include "Scene/Components.h"
+
+namespace Eden::Benchmarks
+{
+	// 1M random proxies with 1% of them moving every frame, queries are compared with linear scans over the same bounds
+	void SpatialTree()
+	{
+		constexpr uint32_t proxyCount = 1000000;
+		constexpr uint32_t movingCount = proxyCount / 100;
+		constexpr uint32_t frameCount = 100;
+		constexpr uint32_t queryCount = 1000;
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> size(0.1f, 2.0f);
+		std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+		std::uniform_int_distribution<uint32_t> randomProxy(0, proxyCount - 1);
+
+		std::vector<Math::AABB> boxes(proxyCount);
+		for (auto& box : boxes)
+		{
+			glm::vec3 center(position(generator), position(generator), position(generator));
+			glm::vec3 extents(size(generator), size(generator), size(generator));
+			box = { center - extents, center + extents };
+		}
+
+		Math::DynamicAABBTree tree(0.1f);
+		std::vector<int32_t> proxies(proxyCount);
+
+		Timer timer;
+		timer.Record();
+		for (uint32_t i = 0; i < proxyCount; ++i)
+			proxies[i] = tree.CreateProxy(boxes[i], i);
+		ED_LOG_INFO("Spatial tree: inserted {} proxies one by one in {:.3f}ms, height {}, area ratio {:.1f}", proxyCount, timer.ElapsedMilliseconds(), tree.GetHeight(), tree.GetAreaRatio());
+
+		std::vector<uint32_t> userData(proxyCount);
+		for (uint32_t i = 0; i < proxyCount; ++i)
+			userData[i] = i;
+
+		tree.Clear();
+		timer.Record();
+		tree.CreateProxies(boxes.data(), userData.data(), proxyCount, proxies.data());
+		ED_LOG_INFO("Spatial tree: inserted {} proxies at once in {:.3f}ms, height {}, area ratio {:.1f}", proxyCount, timer.ElapsedMilliseconds(), tree.GetHeight(), tree.GetAreaRatio());
+
+		std::vector<uint32_t> movingProxies(movingCount);
+		for (auto& proxy : movingProxies)
+			proxy = randomProxy(generator);
+
+		uint32_t reinsertCount = 0;
+		Measure("Spatial tree: move 1% of the proxies", frameCount, [&]()
+		{
+			for (uint32_t proxy : movingProxies)
+			{
+				glm::vec3 displacement(velocity(generator), velocity(generator), velocity(generator));
+				boxes[proxy].min += displacement * 0.1f;
+				boxes[proxy].max += displacement * 0.1f;
+				reinsertCount += tree.MoveProxy(proxies[proxy], boxes[proxy]) ? 1 : 0;
+			}
+		});
+		ED_LOG_INFO("Spatial tree: {} of {} moves reinserted a proxy, height {}, area ratio {:.1f}", reinsertCount, movingCount * frameCount, tree.GetHeight(), tree.GetAreaRatio());
+
+		// Frustum
+		glm::mat4 view = glm::lookAtLH(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspectiveFovLH(glm::radians(70.0f), 1920.0f, 1080.0f, 0.1f, 200.0f);
+		Math::Frustum frustum = Math::Frustum::FromViewProjection(projection * view);
+
+		std::vector<uint8_t> visibility(proxyCount);
+		size_t linearVisible = 0;
+		Measure("Frustum: linear SIMD scan", 20, [&]()
+		{
+			Math::CullAABBs(frustum, boxes.data(), proxyCount, visibility.data());
+			linearVisible = 0;
+			for (uint8_t visible : visibility)
+				linearVisible += visible;
+		});
+
+		size_t treeVisible = 0;
+		Measure("Frustum: tree query + exact test", 20, [&]()
+		{
+			treeVisible = 0;
+			tree.Query(frustum, [&](uint32_t index)
+			{
+				treeVisible += frustum.Intersects(boxes[index]) ? 1 : 0;
+				return true;
+			});
+		});
+		ED_LOG_INFO("Frustum: {} visible with the linear scan, {} with the tree", linearVisible, treeVisible);
+
+		// Boxes and rays, averaged over many queries
+		std::vector<Math::AABB> queryBoxes(queryCount);
+		std::vector<glm::vec3> rayOrigins(queryCount);
+		std::vector<glm::vec3> rayDirections(queryCount);
+		for (uint32_t i = 0; i < queryCount; ++i)
+		{
+			glm::vec3 center(position(generator), position(generator), position(generator));
+			queryBoxes[i] = { center - glm::vec3(10.0f), center + glm::vec3(10.0f) };
+			rayOrigins[i] = glm::vec3(position(generator), position(generator), position(generator));
+			rayDirections[i] = glm::normalize(glm::vec3(velocity(generator), velocity(generator), velocity(generator)));
+		}
+
+		size_t linearHits = 0;
+		Measure("Box: linear scan, 10 queries", 5, [&]()
+		{
+			linearHits = 0;
+			for (uint32_t q = 0; q < 10; ++q)
+			{
+				for (auto& box : boxes)
+					linearHits += Math::DynamicAABBTree::Overlaps(box, queryBoxes[q]) ? 1 : 0;
+			}
+		});
+
+		size_t treeHits = 0;
+		Measure("Box: tree, 10 queries", 5, [&]()
+		{
+			treeHits = 0;
+			for (uint32_t q = 0; q < 10; ++q)
+			{
+				tree.Query(queryBoxes[q], [&](uint32_t index)
+				{
+					treeHits += Math::DynamicAABBTree::Overlaps(boxes[index], queryBoxes[q]) ? 1 : 0;
+					return true;
+				});
+			}
+		});
+		ED_LOG_INFO("Box: {} hits with the linear scan, {} with the tree", linearHits, treeHits);
+
+		Measure("Box: tree, 1000 queries", 5, [&]()
+		{
+			for (auto& queryBox : queryBoxes)
+				tree.Query(queryBox, [](uint32_t) { return true; });
+		});
+
+		// Closest hit, every confirmed hit clips the ray
+		float closestSum = 0.0f;
+		Measure("Ray: linear scan, 10 rays", 5, [&]()
+		{
+			closestSum = 0.0f;
+			for (uint32_t q = 0; q < 10; ++q)
+			{
+				glm::vec3 inverseDirection = 1.0f / rayDirections[q];
+				float closest = 1000.0f;
+				for (auto& box : boxes)
+				{
+					float distance;
+					if (Math::DynamicAABBTree::RayIntersects(box, rayOrigins[q], inverseDirection, closest, distance))
+						closest = distance;
+				}
+				closestSum += closest;
+			}
+		});
+
+		float treeClosestSum = 0.0f;
+		Measure("Ray: tree, 10 rays", 5, [&]()
+		{
+			treeClosestSum = 0.0f;
+			for (uint32_t q = 0; q < 10; ++q)
+			{
+				glm::vec3 inverseDirection = 1.0f / rayDirections[q];
+				float closest = 1000.0f;
+				tree.RayCast(rayOrigins[q], rayDirections[q], closest, [&](uint32_t index)
+				{
+					float distance;
+					if (Math::DynamicAABBTree::RayIntersects(boxes[index], rayOrigins[q], inverseDirection, closest, distance))
+						closest = distance;
+					return closest;
+				});
+				treeClosestSum += closest;
+			}
+		});
+		ED_LOG_INFO("Ray: sum of the closest hits {} with the linear scan, {} with the tree", closestSum, treeClosestSum);
+
+		Measure("Ray: tree, 1000 rays", 5, [&]()
+		{
+			for (uint32_t q = 0; q < queryCount; ++q)
+			{
+				glm::vec3 inverseDirection = 1.0f / rayDirections[q];
+				float closest = 1000.0f;
+				tree.RayCast(rayOrigins[q], rayDirections[q], closest, [&](uint32_t index)
+				{
+					float distance;
+					if (Math::DynamicAABBTree::RayIntersects(boxes[index], rayOrigins[q], inverseDirection, closest, distance))
+						closest = distance;
+					return closest;
+				});
+			}
+		});
+	}
+
+	// 1M mesh entities in a scene, 1% of them moving every frame, measures the systems that keep the tree in sync
+	void SpatialScene()
+	{
+		constexpr uint32_t entityCount = 1000000;
+		constexpr uint32_t movingCount = entityCount / 100;
+		constexpr uint32_t frameCount = 50;
+
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+		std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+
+		// Every entity shares a unit cube mesh source, nothing is uploaded to the GPU
+		SharedPtr<MeshSource> meshSource = MakeShared<MeshSource>();
+		meshSource->bounds = { glm::vec3(-0.5f), glm::vec3(0.5f) };
+		meshSource->boundingSphere = Math::BoundingSphere::FromAABB(meshSource->bounds);
+
+		Scene scene;
+		std::vector<Entity> entities;
+		entities.reserve(entityCount);
+		for (uint32_t i = 0; i < entityCount; ++i)
+		{
+			Entity entity = scene.CreateEntity("Mesh");
+			entity.GetComponent<TransformComponent>().translation = glm::vec3(position(generator), position(generator), position(generator));
+			entity.AddComponent<MeshComponent>().meshSource = meshSource;
+			entities.emplace_back(entity);
+		}
+
+		Timer timer;
+		timer.Record();
+		scene.UpdateSystems();
+		ED_LOG_INFO("Spatial scene: first update with {} entities took {:.3f}ms, {} proxies", entityCount, timer.ElapsedMilliseconds(), scene.GetSpatialTree().GetProxyCount());
+
+		// Average time of every system over the measured frames
+		std::vector<float> systemTimes;
+		auto recordSystemTimes = [&]()
+		{
+			auto& systems = scene.GetSystems();
+			systemTimes.resize(systems.size());
+			for (size_t i = 0; i < systems.size(); ++i)
+				systemTimes[i] += systems[i].lastExecutionTime;
+		};
+		auto logSystemTimes = [&]()
+		{
+			auto& systems = scene.GetSystems();
+			for (size_t i = 0; i < systems.size(); ++i)
+				ED_LOG_INFO("    {}: avg {:.3f}ms", systems[i].name, systemTimes[i] / frameCount);
+			systemTimes.assign(systemTimes.size(), 0.0f);
+		};
+
+		Measure("Spatial scene: update systems, nothing moving", frameCount, [&]()
+		{
+			scene.UpdateSystems();
+			recordSystemTimes();
+		});
+		logSystemTimes();
+
+		std::uniform_int_distribution<uint32_t> randomEntity(0, entityCount - 1);
+		std::vector<Entity> movingEntities(movingCount);
+		for (auto& entity : movingEntities)
+			entity = entities[randomEntity(generator)];
+
+		Measure("Spatial scene: update systems, 1% moving", frameCount, [&]()
+		{
+			for (auto& entity : movingEntities)
+			{
+				auto& tc = entity.GetComponent<TransformComponent>();
+				tc.translation += glm::vec3(velocity(generator), velocity(generator), velocity(generator)) * 0.1f;
+				tc.bDirty = true;
+			}
+			scene.UpdateSystems();
+			recordSystemTimes();
+		});
+		logSystemTimes();
+	}
+
+	// Closest hit of a ray against every triangle, used to check the triangle BVH
+	static bool RayCastTriangles(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const glm::vec3& origin, const glm::vec3& direction, float& outDistance)
+	{
+		Math::TriangleBVH single;
+		bool bHit = false;
+		float closest = FLT_MAX;
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			single.Build(&positions[0].x, sizeof(glm::vec3), &indices[i], 3);
+			float distance;
+			if (single.RayCast(origin, direction, closest, distance))
+			{
+				closest = distance;
+				bHit = true;
+			}
+		}
+		outDistance = closest;
+		return bHit;
+	}
+
+	// Editor picking: rays through random pixels against a grid of sphere meshes, nothing is uploaded to the GPU
+	void Picking()
+	{
+		constexpr uint32_t rings = 64;
+		constexpr uint32_t segments = 128;
+		constexpr uint32_t gridSize = 40;
+		constexpr uint32_t rayCount = 1000;
+
+		std::vector<glm::vec3> positions;
+		for (uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			float phi = glm::pi<float>() * ring / rings;
+			for (uint32_t segment = 0; segment <= segments; ++segment)
+			{
+				float theta = glm::two_pi<float>() * segment / segments;
+				positions.emplace_back(glm::sin(phi) * glm::cos(theta), glm::cos(phi), glm::sin(phi) * glm::sin(theta));
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		for (uint32_t ring = 0; ring < rings; ++ring)
+		{
+			for (uint32_t segment = 0; segment < segments; ++segment)
+			{
+				uint32_t current = ring * (segments + 1) + segment;
+				uint32_t next = current + segments + 1;
+				indices.insert(indices.end(), { current, next, current + 1, current + 1, next, next + 1 });
+			}
+		}
+
+		SharedPtr<MeshSource> meshSource = MakeShared<MeshSource>();
+		MeshSource::Mesh mesh = { Math::ComputeAABB(&positions[0].x, positions.size()), 0, 0 };
+		Math::TriangleBVH& triangleBVH = meshSource->triangleBVHs.emplace_back();
+
+		Timer timer;
+		timer.Record();
+		triangleBVH.Build(&positions[0].x, sizeof(glm::vec3), indices.data(), indices.size());
+		ED_LOG_INFO("Picking: built the BVH of {} triangles in {:.3f}ms, {} nodes", triangleBVH.GetTriangleCount(), timer.ElapsedMilliseconds(), triangleBVH.GetNodeCount());
+
+		meshSource->meshes.emplace_back(mesh);
+		MeshSource::MeshInstance instance;
+		instance.bounds = mesh.bounds;
+		meshSource->instances.emplace_back(instance);
+		meshSource->instanceNames.emplace_back();
+		meshSource->bounds = mesh.bounds;
+		meshSource->boundingSphere = Math::BoundingSphere::FromAABB(mesh.bounds);
+		meshSource->bHasMesh = true;
+
+		// BVH against every triangle, rays start outside the sphere and aim around it
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<glm::vec3> origins(rayCount);
+		std::vector<glm::vec3> directions(rayCount);
+		for (uint32_t i = 0; i < rayCount; ++i)
+		{
+			origins[i] = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator))) * 3.0f;
+			directions[i] = glm::normalize(glm::vec3(unit(generator), unit(generator), unit(generator)) * 1.5f - origins[i]);
+		}
+
+		uint32_t bruteForceCount = 100;
+		uint32_t mismatches = 0;
+		uint32_t hits = 0;
+		for (uint32_t i = 0; i < bruteForceCount; ++i)
+		{
+			float bvhDistance = 0.0f, bruteForceDistance = 0.0f;
+			bool bBVHHit = triangleBVH.RayCast(origins[i], directions[i], FLT_MAX, bvhDistance);
+			bool bBruteForceHit = RayCastTriangles(positions, indices, origins[i], directions[i], bruteForceDistance);
+			hits += bBVHHit ? 1 : 0;
+			if (bBVHHit != bBruteForceHit || (bBVHHit && glm::abs(bvhDistance - bruteForceDistance) > 1e-4f))
+				mismatches++;
+		}
+		ED_LOG_INFO("Picking: {} of {} rays hit, {} mismatches against the brute force test", hits, bruteForceCount, mismatches);
+
+		Measure("Picking: triangle BVH, 1000 rays", 10, [&]()
+		{
+			float distance;
+			for (uint32_t i = 0; i < rayCount; ++i)
+				triangleBVH.RayCast(origins[i], directions[i], FLT_MAX, distance);
+		});
+
+		// A grid of spheres seen from above, like clicking in the editor viewport
+		Scene scene;
+		for (uint32_t x = 0; x < gridSize; ++x)
+		{
+			for (uint32_t z = 0; z < gridSize; ++z)
+			{
+				Entity entity = scene.CreateEntity("Sphere");
+				entity.GetComponent<TransformComponent>().translation = glm::vec3(x * 3.0f, 0.0f, z * 3.0f);
+				entity.AddComponent<MeshComponent>().meshSource = meshSource;
+			}
+		}
+		scene.UpdateSystems();
+
+		glm::vec3 center = glm::vec3(gridSize * 1.5f, 0.0f, gridSize * 1.5f);
+		glm::vec3 eye = center + glm::vec3(0.0f, 60.0f, -60.0f);
+		glm::mat4 view = glm::lookAtLH(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspectiveFovLH(glm::radians(70.0f), 1920.0f, 1080.0f, 0.1f, 200.0f);
+
+		std::uniform_real_distribution<float> pixelX(0.0f, 1920.0f);
+		std::uniform_real_distribution<float> pixelY(0.0f, 1080.0f);
+		for (uint32_t i = 0; i < rayCount; ++i)
+		{
+			float length;
+			Math::ScreenPointToRay(glm::vec2(pixelX(generator), pixelY(generator)), glm::vec2(1920.0f, 1080.0f), projection * view, origins[i], directions[i], length);
+		}
+
+		// Scene ray casts against every entity, checks the spatial tree broadphase
+		mismatches = 0;
+		for (uint32_t i = 0; i < bruteForceCount; ++i)
+		{
+			float closest = 200.0f;
+			entt::entity closestEntity = entt::null;
+			for (auto entity : scene.GetAllEntitiesWith<MeshComponent>())
+			{
+				glm::mat4 inverseTransform = glm::inverse(Entity(entity, &scene).GetComponent<WorldTransformComponent>().transform);
+				glm::vec3 origin = glm::vec3(inverseTransform * glm::vec4(origins[i], 1.0f));
+				glm::vec3 direction = glm::vec3(inverseTransform * glm::vec4(directions[i], 0.0f));
+				float distance;
+				if (triangleBVH.RayCast(origin, direction, closest, distance))
+				{
+					closest = distance;
+					closestEntity = entity;
+				}
+			}
+
+			if (!(scene.RayCast(origins[i], directions[i], 200.0f) == Entity(closestEntity, &scene)))
+				mismatches++;
+		}
+		ED_LOG_INFO("Picking: {} mismatches against ray casts on every entity", mismatches);
+
+		uint32_t pickedCount = 0;
+		Measure("Picking: scene ray casts, 1000 clicks", 10, [&]()
+		{
+			pickedCount = 0;
+			for (uint32_t i = 0; i < rayCount; ++i)
+				pickedCount += scene.RayCast(origins[i], directions[i], 200.0f) ? 1 : 0;
+		});
+		ED_LOG_INFO("Picking: {} of {} clicks picked an entity out of {}", pickedCount, rayCount, gridSize * gridSize);
+	}
+}
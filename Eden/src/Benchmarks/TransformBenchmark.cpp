@@ -0,0 +1,70 @@
+#include "Benchmark.h"
+
+#include <vector>
+
+#include "Core/Log.h"
+#include "Scene/Scene.h"
+#include "Scene/Entity.h"
+#include "Scene/Components.h"
+
+namespace Eden::Benchmarks
+{
+	// 100k static entities (10k roots with 9 children each) plus 1k moving root entities
+	void TransformHierarchy()
+	{
+		constexpr uint32_t staticRootCount = 10000;
+		constexpr uint32_t childrenPerRoot = 9;
+		constexpr uint32_t movingCount = 1000;
+		constexpr uint32_t frameCount = 100;
+
+		Scene scene;
+		for (uint32_t i = 0; i < staticRootCount; ++i)
+		{
+			Entity root = scene.CreateEntity("Static Root");
+			root.GetComponent<TransformComponent>().translation = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+			for (uint32_t c = 0; c < childrenPerRoot; ++c)
+			{
+				Entity child = scene.CreateEntity("Static Child");
+				child.GetComponent<TransformComponent>().translation = glm::vec3(0.0f, static_cast<float>(c), 0.0f);
+				scene.SetParent(child, root, false);
+			}
+		}
+
+		std::vector<Entity> movingEntities;
+		movingEntities.reserve(movingCount);
+		for (uint32_t i = 0; i < movingCount; ++i)
+			movingEntities.emplace_back(scene.CreateEntity("Moving"));
+
+		scene.UpdateWorldTransforms();
+
+		auto transforms = scene.GetAllEntitiesWith<TransformComponent>();
+		float sink = 0.0f;
+
+		// What the renderer did before, rebuild every transform from scratch every frame
+		Measure("Transforms: recompute every local transform", frameCount, [&]()
+		{
+			for (auto entity : transforms)
+				sink += transforms.get<TransformComponent>(entity).GetTransform()[3][0];
+		});
+
+		Measure("Transforms: cached world transforms, nothing moving", frameCount, [&]()
+		{
+			scene.UpdateWorldTransforms();
+		});
+
+		float time = 0.0f;
+		Measure("Transforms: cached world transforms, 1k moving", frameCount, [&]()
+		{
+			time += 0.016f;
+			for (auto& entity : movingEntities)
+			{
+				auto& tc = entity.GetComponent<TransformComponent>();
+				tc.translation.y = glm::sin(time);
+				tc.bDirty = true;
+			}
+			scene.UpdateWorldTransforms();
+		});
+
+		ED_LOG_INFO("Transforms: {} entities (checksum {})", scene.Size(), sink);
+	}
+}
@@ -3,6 +3,7 @@
 #include "Window.h"
 #include "Renderer/Renderer.h"
 #include "Memory.h"
+#include "JobSystem.h"
 #include "Utilities/Utils.h"
 
 namespace Eden
@@ -12,6 +13,7 @@ namespace Eden
 	Application::Application(const ApplicationDescription& description)
 	{
 		Log::Init();
+		JobSystem::Init();
 
 		m_Window = enew Window(description.Title.c_str(), description.Width, description.Height);
 
@@ -23,6 +25,7 @@ namespace Eden
 	{
 		edelete m_Window;
 
+		JobSystem::Shutdown();
 		Log::Shutdown();
 	}
 
@@ -0,0 +1,166 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Core/Memory/Memory.h"
+#include "Core/Log.h"
+
+namespace Eden
+{
+	struct JobSystemData
+	{
+		struct Job
+		{
+			std::function<void()> func;
+			JobCounter* counter;
+		};
+
+		std::vector<std::thread> workers;
+		std::deque<Job> queue;
+		std::mutex queueMutex;
+		std::condition_variable wakeCondition;
+		bool bIsRunning = true;
+	};
+
+	void JobSystem::Init(uint32_t workerCount /*= 0*/)
+	{
+		if (s_Data)
+			return;
+
+		if (workerCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		s_Data = enew JobSystemData();
+		for (uint32_t i = 0; i < workerCount; ++i)
+			s_Data->workers.emplace_back(&JobSystem::WorkerLoop);
+
+		ED_LOG_INFO("Job system initialized with {} workers", workerCount);
+	}
+
+	void JobSystem::Shutdown()
+	{
+		if (!s_Data)
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(s_Data->queueMutex);
+			s_Data->bIsRunning = false;
+		}
+		s_Data->wakeCondition.notify_all();
+
+		for (auto& worker : s_Data->workers)
+			worker.join();
+
+		edelete s_Data;
+		s_Data = nullptr;
+	}
+
+	void JobSystem::Execute(std::function<void()> job, JobCounter* counter /*= nullptr*/)
+	{
+		if (!s_Data)
+		{
+			job();
+			return;
+		}
+
+		if (counter)
+			counter->value.fetch_add(1);
+
+		{
+			std::lock_guard<std::mutex> lock(s_Data->queueMutex);
+			s_Data->queue.push_back({ std::move(job), counter });
+		}
+		s_Data->wakeCondition.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter* counter)
+	{
+		if (!counter)
+			return;
+
+		while (counter->value.load() > 0)
+		{
+			if (!ExecuteNextJob())
+				std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t begin, uint32_t end)>& job)
+	{
+		if (count == 0)
+			return;
+
+		uint32_t threadCount = GetWorkerCount() + 1;
+		uint32_t batchSize = std::max((count + threadCount - 1) / threadCount, std::max(minBatchSize, 1u));
+		if (!s_Data || batchSize >= count)
+		{
+			job(0, count);
+			return;
+		}
+
+		JobCounter counter;
+		for (uint32_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			uint32_t end = std::min(begin + batchSize, count);
+			Execute([&job, begin, end]() { job(begin, end); }, &counter);
+		}
+
+		// The calling thread takes the first batch
+		job(0, batchSize);
+		Wait(&counter);
+	}
+
+	uint32_t JobSystem::GetWorkerCount()
+	{
+		return s_Data ? static_cast<uint32_t>(s_Data->workers.size()) : 0;
+	}
+
+	bool JobSystem::ExecuteNextJob()
+	{
+		JobSystemData::Job job;
+		{
+			std::lock_guard<std::mutex> lock(s_Data->queueMutex);
+			if (s_Data->queue.empty())
+				return false;
+
+			job = std::move(s_Data->queue.front());
+			s_Data->queue.pop_front();
+		}
+
+		job.func();
+		if (job.counter)
+			job.counter->value.fetch_sub(1);
+
+		return true;
+	}
+
+	void JobSystem::WorkerLoop()
+	{
+		while (true)
+		{
+			JobSystemData::Job job;
+			{
+				std::unique_lock<std::mutex> lock(s_Data->queueMutex);
+				s_Data->wakeCondition.wait(lock, []() { return !s_Data->queue.empty() || !s_Data->bIsRunning; });
+
+				if (!s_Data->bIsRunning && s_Data->queue.empty())
+					return;
+
+				job = std::move(s_Data->queue.front());
+				s_Data->queue.pop_front();
+			}
+
+			job.func();
+			if (job.counter)
+				job.counter->value.fetch_sub(1);
+		}
+	}
+}
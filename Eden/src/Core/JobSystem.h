@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace Eden
+{
+	// Every job executed with a counter increments it when queued and decrements it when done,
+	// JobSystem::Wait returns when the counter reaches zero
+	struct JobCounter
+	{
+		std::atomic<uint32_t> value{ 0 };
+	};
+
+	struct JobSystemData;
+
+	/*
+	 * Simple job system with a shared queue and a fixed pool of workers.
+	 * Threads waiting on a counter help executing pending jobs, this way a job can spawn
+	 * other jobs and wait on them without deadlocking the pool.
+	 * If the job system was not initialized every job runs inline on the calling thread.
+	 */
+	class JobSystem
+	{
+	public:
+		// workerCount = 0 means one worker per hardware thread minus the main thread
+		static void Init(uint32_t workerCount = 0);
+		static void Shutdown();
+
+		static void Execute(std::function<void()> job, JobCounter* counter = nullptr);
+		static void Wait(JobCounter* counter);
+
+		// Splits [0, count) in batches of at least minBatchSize and blocks until every batch is done
+		static void ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t begin, uint32_t end)>& job);
+
+		static uint32_t GetWorkerCount();
+
+	private:
+		static bool ExecuteNextJob();
+		static void WorkerLoop();
+
+	private:
+		inline static JobSystemData* s_Data = nullptr;
+	};
+}
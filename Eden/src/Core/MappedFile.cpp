@@ -0,0 +1,76 @@
+#include "MappedFile.h"
+
+#include <utility>
+#include <windows.h>
+
+#include "Core/Log.h"
+#include "Utilities/Utils.h"
+
+namespace Eden
+{
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+		: m_Data(std::exchange(other.m_Data, nullptr))
+		, m_Size(std::exchange(other.m_Size, 0))
+	{
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			m_Data = std::exchange(other.m_Data, nullptr);
+			m_Size = std::exchange(other.m_Size, 0);
+		}
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::filesystem::path& path)
+	{
+		Close();
+
+		HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			ED_LOG_ERROR("Failed to open {}: {}", path, Utils::GetLastErrorMessage());
+			return false;
+		}
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		// The view keeps the mapping and the file alive, both handles can be closed right away
+		HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (!mapping)
+		{
+			ED_LOG_ERROR("Failed to map {}: {}", path, Utils::GetLastErrorMessage());
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!view)
+		{
+			ED_LOG_ERROR("Failed to map {}: {}", path, Utils::GetLastErrorMessage());
+			return false;
+		}
+
+		m_Data = static_cast<const uint8_t*>(view);
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+}
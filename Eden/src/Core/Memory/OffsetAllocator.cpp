@@ -0,0 +1,309 @@
+#include "OffsetAllocator.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Core/Assertions.h"
+
+namespace Eden::Memory
+{
+	// Bin sizes are floats, a 5 bit exponent and a 3 bit mantissa, exact up to 8
+	static constexpr uint32_t kMantissaBits = 3;
+	static constexpr uint32_t kMantissaValue = 1 << kMantissaBits;
+	static constexpr uint32_t kMantissaMask = kMantissaValue - 1;
+
+	// value can't be 0
+	static uint32_t GetLowestBit(uint32_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, value);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(value));
+#endif
+	}
+
+	// value can't be 0
+	static uint32_t GetHighestBit(uint32_t value)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, value);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(31 - __builtin_clz(value));
+#endif
+	}
+
+	// Lowest set bit of the mask from the start bit, kNoSpace when there is none
+	static uint32_t GetLowestBitFrom(uint32_t mask, uint32_t start)
+	{
+		if (start >= 32)
+			return OffsetAllocator::kNoSpace;
+		uint32_t maskFromStart = mask & ~((1u << start) - 1);
+		return maskFromStart != 0 ? GetLowestBit(maskFromStart) : OffsetAllocator::kNoSpace;
+	}
+
+	// Bin of the size rounded down, where a free range of this size is stored
+	static uint32_t GetBinRoundDown(uint32_t size)
+	{
+		if (size < kMantissaValue)
+			return size;
+
+		uint32_t mantissaStart = GetHighestBit(size) - kMantissaBits;
+		uint32_t exponent = mantissaStart + 1;
+		uint32_t mantissa = (size >> mantissaStart) & kMantissaMask;
+		return (exponent << kMantissaBits) | mantissa;
+	}
+
+	// Bin of the size rounded up, every free range from this bin on is large enough
+	static uint32_t GetBinRoundUp(uint32_t size)
+	{
+		if (size < kMantissaValue)
+			return size;
+
+		uint32_t mantissaStart = GetHighestBit(size) - kMantissaBits;
+		uint32_t exponent = mantissaStart + 1;
+		uint32_t mantissa = (size >> mantissaStart) & kMantissaMask;
+		if ((size & ((1u << mantissaStart) - 1)) != 0)
+			mantissa++; // a carry goes to the exponent
+		return (exponent << kMantissaBits) + mantissa;
+	}
+
+	OffsetAllocator::OffsetAllocator(uint32_t size)
+	{
+		Reset(size);
+	}
+
+	OffsetAllocator::Allocation OffsetAllocator::Allocate(uint32_t size)
+	{
+		if (size == 0 || size > m_FreeSize)
+			return {};
+
+		// The bin of the rounded up size first, then the first larger top bin with a free range
+		uint32_t minBin = GetBinRoundUp(size);
+		uint32_t topBin = minBin >> kMantissaBits;
+		uint32_t leafBin = kNoSpace;
+		if (m_UsedTopBins & (1u << topBin))
+			leafBin = GetLowestBitFrom(m_UsedLeafBins[topBin], minBin & kMantissaMask);
+		if (leafBin == kNoSpace)
+			topBin = GetLowestBitFrom(m_UsedTopBins, topBin + 1);
+
+		uint32_t node = kNullNode;
+		if (topBin != kNoSpace)
+		{
+			leafBin = leafBin != kNoSpace ? leafBin : GetLowestBit(m_UsedLeafBins[topBin]);
+			node = m_BinHeads[(topBin << kMantissaBits) | leafBin];
+		}
+		else
+		{
+			// The bin of the size itself holds ranges that may be large enough, like a range freed with this exact size
+			uint32_t sizeBin = GetBinRoundDown(size);
+			uint32_t head = m_BinHeads[sizeBin];
+			if (sizeBin == minBin || head == kNullNode || m_Nodes[head].size < size)
+				return {};
+			node = head;
+		}
+
+		RemoveFromBin(node);
+		uint32_t remainder = m_Nodes[node].size - size;
+		m_Nodes[node].size = size;
+		m_Nodes[node].bIsUsed = true;
+
+		// The rest of the range stays free, right after the allocation
+		if (remainder > 0)
+		{
+			uint32_t next = m_Nodes[node].neighborNext;
+			uint32_t rest = CreateNode();
+			m_Nodes[rest] = { m_Nodes[node].offset + size, remainder, kNullNode, kNullNode, node, next, false };
+			if (next != kNullNode)
+				m_Nodes[next].neighborPrevious = rest;
+			m_Nodes[node].neighborNext = rest;
+			AddToBin(rest);
+		}
+
+		m_AllocationCount++;
+		return { m_Nodes[node].offset, node };
+	}
+
+	void OffsetAllocator::Free(Allocation allocation)
+	{
+		if (!allocation.IsValid())
+			return;
+
+		uint32_t node = allocation.node;
+		ensureMsg(node < m_Nodes.size() && m_Nodes[node].bIsUsed && m_Nodes[node].offset == allocation.offset, "Freeing an allocation that isn't live!");
+
+		// Free neighbors are merged into the node, their nodes are released
+		uint32_t previous = m_Nodes[node].neighborPrevious;
+		if (previous != kNullNode && !m_Nodes[previous].bIsUsed)
+		{
+			RemoveFromBin(previous);
+			m_Nodes[node].offset = m_Nodes[previous].offset;
+			m_Nodes[node].size += m_Nodes[previous].size;
+			m_Nodes[node].neighborPrevious = m_Nodes[previous].neighborPrevious;
+			if (m_Nodes[node].neighborPrevious != kNullNode)
+				m_Nodes[m_Nodes[node].neighborPrevious].neighborNext = node;
+			m_FreeNodes.push_back(previous);
+		}
+
+		uint32_t next = m_Nodes[node].neighborNext;
+		if (next != kNullNode && !m_Nodes[next].bIsUsed)
+		{
+			RemoveFromBin(next);
+			m_Nodes[node].size += m_Nodes[next].size;
+			m_Nodes[node].neighborNext = m_Nodes[next].neighborNext;
+			if (m_Nodes[node].neighborNext != kNullNode)
+				m_Nodes[m_Nodes[node].neighborNext].neighborPrevious = node;
+			m_FreeNodes.push_back(next);
+		}
+
+		if (m_Nodes[node].neighborPrevious == kNullNode)
+			m_FirstNode = node;
+		m_Nodes[node].bIsUsed = false;
+		AddToBin(node);
+		m_AllocationCount--;
+	}
+
+	void OffsetAllocator::Reset(uint32_t size)
+	{
+		ClearNodes();
+		m_Size = size;
+		if (size == 0)
+			return;
+
+		m_FirstNode = CreateNode();
+		m_Nodes[m_FirstNode] = { 0, size, kNullNode, kNullNode, kNullNode, kNullNode, false };
+		AddToBin(m_FirstNode);
+	}
+
+	OffsetAllocator::Stats OffsetAllocator::GetStats() const
+	{
+		Stats stats;
+		stats.freeSize = m_FreeSize;
+		stats.allocations = m_AllocationCount;
+		for (uint32_t bin = 0; bin < kBinCount; ++bin)
+		{
+			for (uint32_t node = m_BinHeads[bin]; node != kNullNode; node = m_Nodes[node].binNext)
+			{
+				stats.largestFreeRange = std::max(stats.largestFreeRange, m_Nodes[node].size);
+				stats.freeRanges++;
+			}
+		}
+		return stats;
+	}
+
+	void OffsetAllocator::ClearNodes()
+	{
+		m_FreeSize = 0;
+		m_AllocationCount = 0;
+		m_UsedTopBins = 0;
+		std::fill(std::begin(m_UsedLeafBins), std::end(m_UsedLeafBins), static_cast<uint8_t>(0));
+		std::fill(std::begin(m_BinHeads), std::end(m_BinHeads), kNullNode);
+		m_FirstNode = kNullNode;
+		m_Nodes.clear();
+		m_FreeNodes.clear();
+	}
+
+	uint32_t OffsetAllocator::CreateNode()
+	{
+		if (!m_FreeNodes.empty())
+		{
+			uint32_t node = m_FreeNodes.back();
+			m_FreeNodes.pop_back();
+			return node;
+		}
+
+		m_Nodes.emplace_back();
+		return static_cast<uint32_t>(m_Nodes.size() - 1);
+	}
+
+	void OffsetAllocator::AddToBin(uint32_t node)
+	{
+		uint32_t bin = GetBinRoundDown(m_Nodes[node].size);
+		uint32_t topBin = bin >> kMantissaBits;
+		m_UsedTopBins |= 1u << topBin;
+		m_UsedLeafBins[topBin] |= static_cast<uint8_t>(1u << (bin & kMantissaMask));
+
+		uint32_t head = m_BinHeads[bin];
+		m_Nodes[node].binPrevious = kNullNode;
+		m_Nodes[node].binNext = head;
+		if (head != kNullNode)
+			m_Nodes[head].binPrevious = node;
+		m_BinHeads[bin] = node;
+		m_FreeSize += m_Nodes[node].size;
+	}
+
+	void OffsetAllocator::RemoveFromBin(uint32_t node)
+	{
+		const Node& freeNode = m_Nodes[node];
+		if (freeNode.binPrevious != kNullNode)
+		{
+			m_Nodes[freeNode.binPrevious].binNext = freeNode.binNext;
+		}
+		else
+		{
+			// The node is the head of its bin, the bin bits are cleared when it was the last one
+			uint32_t bin = GetBinRoundDown(freeNode.size);
+			uint32_t topBin = bin >> kMantissaBits;
+			m_BinHeads[bin] = freeNode.binNext;
+			if (freeNode.binNext == kNullNode)
+			{
+				m_UsedLeafBins[topBin] &= static_cast<uint8_t>(~(1u << (bin & kMantissaMask)));
+				if (m_UsedLeafBins[topBin] == 0)
+					m_UsedTopBins &= ~(1u << topBin);
+			}
+		}
+		if (freeNode.binNext != kNullNode)
+			m_Nodes[freeNode.binNext].binPrevious = freeNode.binPrevious;
+		m_FreeSize -= freeNode.size;
+	}
+
+	void OffsetAllocator::Pack(std::vector<Allocation>& outFrom, std::vector<Allocation>& outTo)
+	{
+		outFrom.clear();
+		outTo.clear();
+		for (uint32_t node = m_FirstNode; node != kNullNode; node = m_Nodes[node].neighborNext)
+		{
+			if (m_Nodes[node].bIsUsed)
+				outFrom.push_back({ m_Nodes[node].offset, node });
+		}
+
+		// The allocations are rebuilt back to back, the search of Allocate could skip an exact fit for the last ones
+		std::vector<uint32_t> sizes(outFrom.size());
+		for (size_t i = 0; i < outFrom.size(); ++i)
+			sizes[i] = m_Nodes[outFrom[i].node].size;
+		ClearNodes();
+
+		uint32_t offset = 0;
+		uint32_t previous = kNullNode;
+		for (uint32_t size : sizes)
+		{
+			uint32_t node = CreateNode();
+			m_Nodes[node] = { offset, size, kNullNode, kNullNode, previous, kNullNode, true };
+			if (previous != kNullNode)
+				m_Nodes[previous].neighborNext = node;
+			else
+				m_FirstNode = node;
+			outTo.push_back({ offset, node });
+			offset += size;
+			previous = node;
+		}
+		m_AllocationCount = static_cast<uint32_t>(sizes.size());
+
+		if (offset < m_Size)
+		{
+			uint32_t node = CreateNode();
+			m_Nodes[node] = { offset, m_Size - offset, kNullNode, kNullNode, previous, kNullNode, false };
+			if (previous != kNullNode)
+				m_Nodes[previous].neighborNext = node;
+			else
+				m_FirstNode = node;
+			AddToBin(node);
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Eden::Memory
+{
+	/*
+	 * Range allocator for memory it doesn't own, like the pages of a GPU buffer: it hands out offsets in [0, size) in any
+	 * unit. Free ranges are kept in bins of a two level segregated fit (TLSF), the bin sizes are floats with 3 mantissa
+	 * bits so every power of two is split in 8 bins. Allocations search the first bin that surely fits with two bit scans
+	 * and freed ranges are merged with their free neighbors, both in O(1). Allocations are exact, only the search rounds up:
+	 * when no larger bin has a range, the first range of the bin of the size itself is used if it's large enough.
+	 */
+	class OffsetAllocator
+	{
+	public:
+		static constexpr uint32_t kNoSpace = UINT32_MAX;
+
+		struct Allocation
+		{
+			uint32_t offset = kNoSpace;
+			uint32_t node = kNoSpace; // internal, identifies the allocation when it's freed
+
+			bool IsValid() const { return offset != kNoSpace; }
+		};
+
+		struct Stats
+		{
+			uint32_t freeSize = 0;
+			uint32_t largestFreeRange = 0;
+			uint32_t freeRanges = 0;
+			uint32_t allocations = 0;
+
+			// 0 when the free space is a single range, close to 1 when it's split in many small ones
+			float GetFragmentation() const { return freeSize > 0 ? 1.0f - static_cast<float>(largestFreeRange) / static_cast<float>(freeSize) : 0.0f; }
+		};
+
+		explicit OffsetAllocator(uint32_t size = 0);
+
+		// Invalid allocation when size is 0 or no free range is large enough
+		Allocation Allocate(uint32_t size);
+		void Free(Allocation allocation);
+		// Frees every allocation
+		void Reset(uint32_t size);
+
+		uint32_t GetSize() const { return m_Size; }
+		uint32_t GetAllocationSize(Allocation allocation) const { return allocation.IsValid() ? m_Nodes[allocation.node].size : 0; }
+		uint32_t GetFreeSize() const { return m_FreeSize; }
+		uint32_t GetAllocationCount() const { return m_AllocationCount; }
+		// Walks the free ranges, O(free ranges)
+		Stats GetStats() const;
+
+		// Packs every allocation at the start of the range, keeping their order. move(from, to) is called for every
+		// allocation in increasing offset order, to.offset <= from.offset, so the owner can move its data with memmove
+		// in that order. Every allocation gets a new handle, the ones it replaces are invalid. Returns the moved size.
+		template<typename MoveFunc> uint32_t Compact(MoveFunc&& move)
+		{
+			std::vector<Allocation> from;
+			std::vector<Allocation> to;
+			Pack(from, to);
+
+			uint32_t movedSize = 0;
+			for (size_t i = 0; i < from.size(); ++i)
+			{
+				movedSize += to[i].offset != from[i].offset ? GetAllocationSize(to[i]) : 0;
+				move(from[i], to[i]);
+			}
+			return movedSize;
+		}
+
+	private:
+		static constexpr uint32_t kTopBinCount = 32;
+		static constexpr uint32_t kLeafBinCount = 8;
+		static constexpr uint32_t kBinCount = kTopBinCount * kLeafBinCount;
+		static constexpr uint32_t kNullNode = UINT32_MAX;
+
+		// Every range of [0, size) is a node, free or allocated, linked to the ranges next to it
+		struct Node
+		{
+			uint32_t offset;
+			uint32_t size;
+			uint32_t binPrevious; // free nodes of the same bin
+			uint32_t binNext;
+			uint32_t neighborPrevious; // ranges before and after it
+			uint32_t neighborNext;
+			bool bIsUsed;
+		};
+
+		uint32_t m_Size = 0;
+		uint32_t m_FreeSize = 0;
+		uint32_t m_AllocationCount = 0;
+		uint32_t m_UsedTopBins = 0; // bit per top bin with a free node
+		uint8_t m_UsedLeafBins[kTopBinCount] = {}; // bit per leaf bin with a free node
+		uint32_t m_BinHeads[kBinCount];
+		uint32_t m_FirstNode = kNullNode; // the range at offset 0
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_FreeNodes; // unused entries of m_Nodes
+
+	private:
+		void ClearNodes();
+		uint32_t CreateNode();
+		// Free nodes are in the bin of their size rounded down
+		void AddToBin(uint32_t node);
+		void RemoveFromBin(uint32_t node);
+		// Rebuilds the nodes with the allocations next to each other, outFrom and outTo are the handles before and after, in offset order
+		void Pack(std::vector<Allocation>& outFrom, std::vector<Allocation>& outTo);
+	};
+}
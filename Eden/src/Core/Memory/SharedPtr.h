@@ -190,6 +190,12 @@ namespace Eden
 			return m_Instance != nullptr;
 		}
 
+		// Number of SharedPtr pointing to the instance, 0 if there is none
+		uint32_t GetRefCount() const
+		{
+			return m_Instance ? *m_RefCount : 0;
+		}
+
 	private:
 		void IncRef() const
 		{
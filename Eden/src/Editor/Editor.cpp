@@ -10,6 +10,8 @@
 #include "Scene/SceneSerializer.h"
 #include "Scene/Components.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/TextureCache.h"
+#include "Renderer/GeometryBuffers.h"
 #include "Scene/Entity.h"
 #include "stdio.h"
 #include "RHI/DynamicRHI.h"
@@ -102,6 +104,9 @@ namespace Eden
 					}
 				}
 
+				// Small props stay a single entity, large models are easier to edit and cull with an entity per node
+				ImGui::MenuItem("Expand Imported Models", NULL, &m_bExpandImportedModels);
+
 				ImGui::EndMenu();
 			}
 
@@ -159,8 +164,17 @@ namespace Eden
 		ImGui::Begin(ICON_FA_TV " Scene Properties##sceneProperties", &m_bOpenSceneProperties, ImGuiWindowFlags_NoCollapse);
 		ImGui::Checkbox("Enable Skybox", &Renderer::IsSkyboxEnabled());
 		ImGui::Checkbox("Deferred Rendering", &Renderer::IsDeferredRenderingEnabled());
+		ImGui::Checkbox("Frustum Culling", &Renderer::IsFrustumCullingEnabled());
+		ImGui::Checkbox("Mesh LODs", &Renderer::IsMeshLODEnabled());
+		ImGui::Checkbox("Meshlet Culling", &Renderer::IsMeshletCullingEnabled());
+		bool bIsStaticGeometryBaked = Renderer::IsStaticGeometryBaked();
+		if (ImGui::Checkbox("Bake Static Geometry", &bIsStaticGeometryBaked))
+			Renderer::SetStaticGeometryBaked(bIsStaticGeometryBaked);
+		if (ImGui::Button("Defragment Geometry"))
+			Renderer::GetCurrentScene()->AddPreparation([]() { GeometryBuffers::Defragment(); });
 		ImGui::Separator();
 		UI::DrawProperty("Exposure", Renderer::GetSceneSettings().exposure, 0.1f, 0.1f, 5.0f);
+		UI::DrawProperty("LOD Pixel Error", Renderer::GetLODPixelThreshold(), 0.1f, 0.1f, 16.0f);
 		ImGui::End();
 	}
 
@@ -169,6 +183,29 @@ namespace Eden
 		ImGui::Begin(ICON_FA_CHART_PIE " Statistcs##statistics", &m_bOpenStatisticsWindow, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize);
 		ImGui::Text("CPU frame time: %.3fms(%.1fFPS)", Application::Get()->GetDeltaTime() * 1000.0f, (1000.0f / Application::Get()->GetDeltaTime()) / 1000.0f);
 		ImGui::Text("GPU frame time: %.3fms", Renderer::GetRenderTimer()->elapsedTime);
+		ImGui::Separator();
+		const RendererData::CullingStats& cullingStats = Renderer::GetCullingStats();
+		ImGui::Text("Visible entities: %u (%u culled)", cullingStats.visibleEntities, cullingStats.culledEntities);
+		ImGui::Text("Visible meshes: %u (%u culled by node bounds)", cullingStats.visibleMeshes, cullingStats.culledMeshes);
+		ImGui::Text("Simplified meshes: %u", cullingStats.simplifiedMeshes);
+		ImGui::Text("Culling: %.3fms", cullingStats.cullingTime);
+		const RendererData::RenderQueueStats& queueStats = Renderer::GetRenderQueueStats();
+		ImGui::Text("Draw calls: %u (%u instances)", queueStats.drawCalls, queueStats.instances);
+		ImGui::Text("Triangles: %u (%u at full detail)", queueStats.triangles, queueStats.fullDetailTriangles);
+		ImGui::Text("Meshlets: %u (%u culled)", queueStats.meshlets, queueStats.culledMeshlets);
+		ImGui::Text("Binds: %u pipelines, %u meshes, %u materials", queueStats.pipelineBinds, queueStats.meshBinds, queueStats.materialBinds);
+		ImGui::Text("Render queue: %.3fms", queueStats.buildTime);
+		const StaticGeometry::Stats& bakeStats = Renderer::GetStaticGeometry().GetStats();
+		ImGui::Text("Static geometry: %u mesh sources in %u buffer sets, %s, baked in %.2fms", bakeStats.meshSources, bakeStats.bufferSets,
+			Utils::BytesToString(bakeStats.vertexBytes + bakeStats.indexBytes).c_str(), bakeStats.bakeTime);
+		GeometryBuffersStats geometryStats = GeometryBuffers::GetStats();
+		ImGui::Text("Geometry buffers: %u slices in %u pages, %s used of %s, fragmentation %.2f", geometryStats.slices, geometryStats.pages,
+			Utils::BytesToString(geometryStats.usedBytes).c_str(), Utils::BytesToString(geometryStats.pageBytes).c_str(), geometryStats.GetFragmentation());
+		const TextureCacheStats& textureStats = TextureCache::GetStats();
+		ImGui::Text("Cached textures: %u (%u hits, %u misses)", TextureCache::GetTextureCount(), textureStats.hits, textureStats.misses);
+		ImGui::Separator();
+		for (auto& system : Renderer::GetCurrentScene()->GetSystems())
+			ImGui::Text("%s: %.3fms", system.name.c_str(), system.lastExecutionTime);
 		ImGui::End();
 	}
 
@@ -181,21 +218,13 @@ namespace Eden
 		float windowY = m_ViewportPos.y;
 		ImGuizmo::SetRect(windowX, windowY, Renderer::GetViewportSize().x, Renderer::GetViewportSize().y);
 
-		auto& transform_component = Renderer::GetCurrentScene()->GetSelectedEntity().GetComponent<TransformComponent>();
-		glm::mat4 transform = transform_component.GetTransform();
+		Entity selectedEntity = Renderer::GetCurrentScene()->GetSelectedEntity();
+		glm::mat4 transform = selectedEntity.GetComponent<WorldTransformComponent>().transform;
 
 		ImGuizmo::Manipulate(glm::value_ptr(Renderer::GetViewMatrix()), glm::value_ptr(Renderer::GetProjectionMatrix()), static_cast<ImGuizmo::OPERATION>(m_GizmoType), ImGuizmo::LOCAL, glm::value_ptr(transform));
 
 		if (ImGuizmo::IsUsing())
-		{
-			glm::vec3 translation, rotation, scale;
-			Math::DecomposeTransform(transform, translation, rotation, scale);
-
-			glm::vec3 deltaRotation = rotation - transform_component.rotation;
-			transform_component.translation = translation;
-			transform_component.rotation = rotation;
-			transform_component.scale = scale;
-		}
+			Renderer::GetCurrentScene()->SetWorldTransform(selectedEntity, transform);
 	}
 
 	void EdenEd::UI_PipelinesPanel()
@@ -263,11 +292,14 @@ namespace Eden
 					break;
 				case EdenExtension::kModel:
 				{
-					auto e = Renderer::GetCurrentScene()->CreateEntity(path.stem().string());
-					auto& mc = e.AddComponent<MeshComponent>();
-					mc.meshPath = path.string();
-					Renderer::GetCurrentScene()->AddPreparation([&]() {
-						mc.LoadMeshSource();
+					Scene* scene = Renderer::GetCurrentScene();
+					auto e = scene->CreateEntity(path.stem().string());
+					e.AddComponent<MeshComponent>().meshPath = path.string();
+					bool bExpand = m_bExpandImportedModels;
+					scene->AddPreparation([scene, e, bExpand]() mutable {
+						e.GetComponent<MeshComponent>().LoadMeshSource();
+						if (bExpand)
+							scene->ExpandMeshInstances(e);
 					});
 				}
 				break;
@@ -384,22 +416,19 @@ namespace Eden
 		{
 			if (m_bIsViewportHovered && !ImGuizmo::IsOver())
 			{
+				// Picking is done on the CPU against the mesh triangles, there's no need to wait for the GPU
 				auto mousePos = GetViewportMousePos();
-				glm::vec4 pixel_color;
-				if (mousePos.first >= 1 && mousePos.first <= Renderer::GetViewportSize().x && mousePos.second >= 1 && mousePos.second <= Renderer::GetViewportSize().y)
-					Renderer::GetPixel(mousePos.first, mousePos.second, pixel_color);
-				if (pixel_color.x >= 0)
-				{
-					entt::entity entityId = static_cast<entt::entity>(std::round(pixel_color.x));
-					Entity entity = { entityId, Renderer::GetCurrentScene() };
-					Renderer::GetCurrentScene()->SetSelectedEntity(entity);
-				}
-				else
+				glm::vec2 viewportSize = Renderer::GetViewportSize();
+				Entity entity = { entt::null, Renderer::GetCurrentScene() };
+				if (mousePos.first < viewportSize.x && mousePos.second < viewportSize.y)
 				{
-					entt::entity entityId = static_cast<entt::entity>(-1);
-					Entity entity = { entityId, Renderer::GetCurrentScene() };
-					Renderer::GetCurrentScene()->SetSelectedEntity(entity);
+					glm::vec3 origin, direction;
+					float length;
+					glm::vec2 point = glm::vec2(static_cast<float>(mousePos.first), static_cast<float>(mousePos.second)) + 0.5f;
+					Math::ScreenPointToRay(point, viewportSize, Renderer::GetProjectionMatrix() * Renderer::GetViewMatrix(), origin, direction, length);
+					entity = Renderer::GetCurrentScene()->RayCast(origin, direction, length);
 				}
+				Renderer::GetCurrentScene()->SetSelectedEntity(entity);
 			}
 		}
 
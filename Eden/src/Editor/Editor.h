@@ -21,6 +21,7 @@ namespace Eden
 		bool m_bOpenPipelinesPanel = true;
 		bool m_bOpenMemoryPanel = true;
 		bool m_bOpenOutputLog = true;
+		bool m_bExpandImportedModels = false; // models dropped in the viewport get a child entity per node
 		int m_GizmoType = ImGuizmo::OPERATION::TRANSLATE;
 		glm::vec2 m_ViewportPos;
 		bool m_bIsViewportFocused = false;
@@ -21,6 +21,79 @@ namespace Eden
 	{
 	}
 
+	void SceneHierarchy::DrawEntityNode(Entity entity)
+	{
+		Scene* scene = Renderer::GetCurrentScene();
+		auto& relationship = entity.GetComponent<RelationshipComponent>();
+		auto& tag = entity.GetComponent<TagComponent>();
+		if (tag.tag.length() == 0) tag.tag = " "; // If the tag is empty add a space to it doesnt crash
+
+		ImGui::PushID(entity.GetID());
+
+		ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth;
+		if (scene->GetSelectedEntity() == entity)
+			flags |= ImGuiTreeNodeFlags_Selected;
+		if (relationship.children.empty())
+			flags |= ImGuiTreeNodeFlags_Leaf;
+
+		bool bOpen = ImGui::TreeNodeEx("##entity", flags, "%s", tag.tag.c_str());
+		if (ImGui::IsItemClicked())
+			scene->SetSelectedEntity(entity);
+
+		// Drag an entity into another one to make it a child
+		if (ImGui::BeginDragDropSource())
+		{
+			entt::entity entityHandle = entity;
+			ImGui::SetDragDropPayload("HIERARCHY_ENTITY", &entityHandle, sizeof(entt::entity));
+			ImGui::Text("%s", tag.tag.c_str());
+			ImGui::EndDragDropSource();
+		}
+
+		if (ImGui::BeginDragDropTarget())
+		{
+			if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("HIERARCHY_ENTITY"))
+			{
+				Entity child = { *static_cast<entt::entity*>(payload->Data), scene };
+				scene->AddPreparation([scene, child, entity]()
+				{
+					scene->SetParent(child, entity);
+				});
+			}
+			ImGui::EndDragDropTarget();
+		}
+
+		if (ImGui::BeginPopupContextItem())
+		{
+			scene->SetSelectedEntity(entity);
+
+			if (ImGui::MenuItem("Duplicate", "Ctrl-D"))
+				DuplicateSelectedEntity();
+			if (ImGui::MenuItem("Delete", "Del"))
+				DeleteSelectedEntity();
+			if (ImGui::MenuItem("Unparent", nullptr, false, relationship.parent != entt::null))
+			{
+				scene->AddPreparation([scene, entity]()
+				{
+					scene->SetParent(entity, {});
+				});
+			}
+
+			ImGui::Separator();
+			EntityMenu();
+
+			ImGui::EndPopup();
+		}
+
+		if (bOpen)
+		{
+			for (auto child : relationship.children)
+				DrawEntityNode({ child, scene });
+			ImGui::TreePop();
+		}
+
+		ImGui::PopID();
+	}
+
 	void SceneHierarchy::DrawHierarchy()
 	{
 		ImGui::Begin(ICON_FA_BARS_STAGGERED  " Scene Hierarchy##hierarchy", &bOpenHierarchy, ImGuiWindowFlags_NoCollapse);
@@ -31,30 +104,29 @@ namespace Eden
 		int num_entities = static_cast<int>(entities.size() - 1);
 		for (int i = num_entities; i >= 0; --i)
 		{
-
 			Entity e = { entities[i], Renderer::GetCurrentScene() };
-			ImGui::PushID(e.GetID());
-			auto& tag = e.GetComponent<TagComponent>();
-			if (tag.tag.length() == 0) tag.tag = " "; // If the tag is empty add a space to it doesnt crash
-			if (ImGui::Selectable(tag.tag.c_str(), Renderer::GetCurrentScene()->GetSelectedEntity() == e))
-				Renderer::GetCurrentScene()->SetSelectedEntity(e);
-
-			if (ImGui::BeginPopupContextItem())
-			{
-				Renderer::GetCurrentScene()->SetSelectedEntity(e);
-				
-				if (ImGui::MenuItem("Duplicate", "Ctrl-D"))
-					DuplicateSelectedEntity();
-				if (ImGui::MenuItem("Delete", "Del"))
-					DeleteSelectedEntity();
+			// Children are drawn by their parent node
+			if (e.GetComponent<RelationshipComponent>().parent != entt::null)
+				continue;
 
-				ImGui::Separator();
-				EntityMenu();
+			DrawEntityNode(e);
+		}
 
-				ImGui::EndPopup();
+		// Dropping an entity in the empty space of the window makes it a root entity
+		ImVec2 emptySpace = ImGui::GetContentRegionAvail();
+		ImGui::Dummy(ImVec2(emptySpace.x, std::max(emptySpace.y, 1.0f)));
+		if (ImGui::BeginDragDropTarget())
+		{
+			if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("HIERARCHY_ENTITY"))
+			{
+				Scene* scene = Renderer::GetCurrentScene();
+				Entity child = { *static_cast<entt::entity*>(payload->Data), scene };
+				scene->AddPreparation([scene, child]()
+				{
+					scene->SetParent(child, {});
+				});
 			}
-
-			ImGui::PopID();
+			ImGui::EndDragDropTarget();
 		}
 
 		// Scene hierarchy popup to create new entities
@@ -237,11 +309,22 @@ namespace Eden
 
 		DrawComponentProperty<TransformComponent>(selectedEntity, "Transform", [&]() {
 			auto& transform = selectedEntity.GetComponent<TransformComponent>();
-			UI::DrawVec3("Translation", transform.translation);
+			glm::vec3 translation = transform.translation;
 			glm::vec3 rotation = glm::degrees(transform.rotation);
+			glm::vec3 scale = transform.scale;
+
+			UI::DrawVec3("Translation", translation);
 			UI::DrawVec3("Rotation", rotation);
-			transform.rotation = glm::radians(rotation);
-			UI::DrawVec3("Scale", transform.scale, 1.0f);
+			UI::DrawVec3("Scale", scale, 1.0f);
+
+			// Only touch the transform when it was edited, converting the rotation back and forth would mark it dirty every frame
+			if (translation != transform.translation || rotation != glm::degrees(transform.rotation) || scale != transform.scale)
+			{
+				transform.translation = translation;
+				transform.rotation = glm::radians(rotation);
+				transform.scale = scale;
+				transform.bDirty = true;
+			}
 		});
 
 		ImGui::Spacing();
@@ -266,11 +349,27 @@ namespace Eden
 				if (!newPath.empty())
 				{
 					mc.meshPath = newPath;
+					mc.instance = MeshComponent::kAllInstances;
 					Renderer::GetCurrentScene()->AddPreparation([&]() {
 						mc.LoadMeshSource();
 					});
 				}
 			}
+
+			if (mc.instance != MeshComponent::kAllInstances)
+			{
+				const char* name = mc.GetInstance() ? mc.meshSource->instanceNames[mc.instance].c_str() : "missing from the model";
+				ImGui::Text("Node: %s", name);
+			}
+			else if (mc.meshSource->instances.size() > 1 && ImGui::Button("Expand Nodes"))
+			{
+				Scene* scene = Renderer::GetCurrentScene();
+				Entity entity = selectedEntity;
+				scene->AddPreparation([scene, entity]()
+				{
+					scene->ExpandMeshInstances(entity);
+				});
+			}
 		});
 
 		ImGui::Spacing();
@@ -278,9 +377,6 @@ namespace Eden
 
 		DrawComponentProperty<PointLightComponent>(selectedEntity, "Point Light", [&]() {
 			auto& pl = selectedEntity.GetComponent<PointLightComponent>();
-			auto& transform = selectedEntity.GetComponent<TransformComponent>();
-
-			pl.position = glm::vec4(transform.translation, 1.0f);
 
 			UI::DrawColor("Color", pl.color);
 			UI::DrawProperty("Intensity", pl.intensity, 0.5f, 0.01f, 0.0f);
@@ -291,9 +387,6 @@ namespace Eden
 
 		DrawComponentProperty<DirectionalLightComponent>(selectedEntity, "Directional Light", [&]() {
 			auto& dl = selectedEntity.GetComponent<DirectionalLightComponent>();
-			auto& transform = selectedEntity.GetComponent<TransformComponent>();
-
-			dl.direction = glm::vec4(transform.rotation, 1.0f);
 
 			UI::DrawProperty("Intensity", dl.intensity, 0.1f, 0.01f, 0.0f);
 		});
@@ -305,13 +398,8 @@ namespace Eden
 	void SceneHierarchy::DuplicateSelectedEntity()
 	{
 		Renderer::GetCurrentScene()->AddPreparation([&]() {
+			// The copied mesh component shares the mesh source, there's nothing to load
 			auto newEntity = Renderer::GetCurrentScene()->DuplicateEntity(Renderer::GetCurrentScene()->GetSelectedEntity());
-			if (newEntity.HasComponent<MeshComponent>())
-			{
-				auto& mc = newEntity.GetComponent<MeshComponent>();
-				mc.LoadMeshSource();
-			}
-
 			Renderer::GetCurrentScene()->SetSelectedEntity(newEntity);
 		});
 	}
@@ -4,6 +4,7 @@
 namespace Eden
 {
 	class Scene;
+	class Entity;
 	class SceneHierarchy
 	{
 	public:
@@ -19,6 +20,7 @@ namespace Eden
 
 	private:
 		void DrawHierarchy();
+		void DrawEntityNode(Entity entity);
 		void EntityProperties();
 		void DuplicateSelectedEntity();
 		void DeleteSelectedEntity();
@@ -2,6 +2,8 @@
 #include "Core/Application.h"
 #include "Core/Memory/Memory.h"
 #include "Core/CommandLine.h"
+#include "Core/JobSystem.h"
+#include "Core/Log.h"
 
 #include "Scene/MeshSource.h"
 #include "Renderer/Renderer.h"
@@ -11,12 +13,28 @@
 #include "RHI/Tests/RHITriangleTest.h"
 #include "RHI/Tests/RHIMeshTest.h"
 
+#include "Benchmarks/Benchmark.h"
+
 using namespace Eden;
 
 int EdenMain()
 {
 	CommandLine::Init(cmdLine);
 
+	// Benchmarks don't need a window or the renderer, they run and exit
+	std::string benchmarkName;
+	CommandLine::Parse("benchmark", benchmarkName);
+	if (benchmarkName.size() > 0)
+	{
+		Log::Init();
+		JobSystem::Init();
+		Benchmarks::Run(benchmarkName);
+		JobSystem::Shutdown();
+		Log::Shutdown();
+
+		return 0;
+	}
+
 	ApplicationDescription appDescription = {};
 	appDescription.Width  = 1600;
 	appDescription.Height = 900;
@@ -0,0 +1,221 @@
+#include "BatchTransform.h"
+
+#include <algorithm>
+
+#include <glm/gtc/matrix_transform.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+
+#include "SIMD.h"
+
+namespace Eden::Math
+{
+	using namespace SIMD;
+
+	void TransformSoA::Clear()
+	{
+		translationX.clear(); translationY.clear(); translationZ.clear();
+		rotationX.clear(); rotationY.clear(); rotationZ.clear();
+		scaleX.clear(); scaleY.clear(); scaleZ.clear();
+	}
+
+	void TransformSoA::Reserve(size_t count)
+	{
+		translationX.reserve(count); translationY.reserve(count); translationZ.reserve(count);
+		rotationX.reserve(count); rotationY.reserve(count); rotationZ.reserve(count);
+		scaleX.reserve(count); scaleY.reserve(count); scaleZ.reserve(count);
+	}
+
+	void TransformSoA::Add(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
+	{
+		translationX.emplace_back(translation.x); translationY.emplace_back(translation.y); translationZ.emplace_back(translation.z);
+		rotationX.emplace_back(rotation.x); rotationY.emplace_back(rotation.y); rotationZ.emplace_back(rotation.z);
+		scaleX.emplace_back(scale.x); scaleY.emplace_back(scale.y); scaleZ.emplace_back(scale.z);
+	}
+
+	static glm::mat4 ComposeTransform(const TransformSoA& transforms, size_t index)
+	{
+		glm::vec3 translation(transforms.translationX[index], transforms.translationY[index], transforms.translationZ[index]);
+		glm::vec3 rotation(transforms.rotationX[index], transforms.rotationY[index], transforms.rotationZ[index]);
+		glm::vec3 scale(transforms.scaleX[index], transforms.scaleY[index], transforms.scaleZ[index]);
+
+		glm::mat4 t = glm::translate(glm::mat4(1.0f), translation);
+		glm::mat4 r = glm::toMat4(glm::quat(rotation));
+		glm::mat4 s = glm::scale(glm::mat4(1.0f), scale);
+
+		return t * r * s;
+	}
+
+	void ComposeTransformsScalar(const TransformSoA& transforms, glm::mat4* outMatrices)
+	{
+		for (size_t i = 0; i < transforms.Size(); ++i)
+			outMatrices[i] = ComposeTransform(transforms, i);
+	}
+
+	void ComposeTransforms(const TransformSoA& transforms, glm::mat4* outMatrices)
+	{
+		const Float4 half = Splat(0.5f);
+		const Float4 one = Splat(1.0f);
+		const Float4 two = Splat(2.0f);
+		const Float4 zero = Splat(0.0f);
+
+		size_t count = transforms.Size();
+		size_t i = 0;
+
+		// Every lane is a different transform, same math as glm::quat(euler) followed by glm::toMat4
+		for (; i + 4 <= count; i += 4)
+		{
+			Float4 sinX, cosX, sinY, cosY, sinZ, cosZ;
+			SinCos(Load(&transforms.rotationX[i]) * half, sinX, cosX);
+			SinCos(Load(&transforms.rotationY[i]) * half, sinY, cosY);
+			SinCos(Load(&transforms.rotationZ[i]) * half, sinZ, cosZ);
+
+			Float4 qw = cosX * cosY * cosZ + sinX * sinY * sinZ;
+			Float4 qx = sinX * cosY * cosZ - cosX * sinY * sinZ;
+			Float4 qy = cosX * sinY * cosZ + sinX * cosY * sinZ;
+			Float4 qz = cosX * cosY * sinZ - sinX * sinY * cosZ;
+
+			Float4 xx = qx * qx, yy = qy * qy, zz = qz * qz;
+			Float4 xy = qx * qy, xz = qx * qz, yz = qy * qz;
+			Float4 wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+			Float4 scaleX = Load(&transforms.scaleX[i]);
+			Float4 scaleY = Load(&transforms.scaleY[i]);
+			Float4 scaleZ = Load(&transforms.scaleZ[i]);
+
+			// Column 0
+			Float4 c0x = (one - two * (yy + zz)) * scaleX;
+			Float4 c0y = two * (xy + wz) * scaleX;
+			Float4 c0z = two * (xz - wy) * scaleX;
+			Float4 c0w = zero;
+			// Column 1
+			Float4 c1x = two * (xy - wz) * scaleY;
+			Float4 c1y = (one - two * (xx + zz)) * scaleY;
+			Float4 c1z = two * (yz + wx) * scaleY;
+			Float4 c1w = zero;
+			// Column 2
+			Float4 c2x = two * (xz + wy) * scaleZ;
+			Float4 c2y = two * (yz - wx) * scaleZ;
+			Float4 c2z = (one - two * (xx + yy)) * scaleZ;
+			Float4 c2w = zero;
+			// Column 3
+			Float4 c3x = Load(&transforms.translationX[i]);
+			Float4 c3y = Load(&transforms.translationY[i]);
+			Float4 c3z = Load(&transforms.translationZ[i]);
+			Float4 c3w = one;
+
+			// Transposing turns every group of 4 lanes into the same column of 4 matrices
+			Transpose(c0x, c0y, c0z, c0w);
+			Transpose(c1x, c1y, c1z, c1w);
+			Transpose(c2x, c2y, c2z, c2w);
+			Transpose(c3x, c3y, c3z, c3w);
+
+			Float4 columns[4][4] =
+			{
+				{ c0x, c1x, c2x, c3x },
+				{ c0y, c1y, c2y, c3y },
+				{ c0z, c1z, c2z, c3z },
+				{ c0w, c1w, c2w, c3w },
+			};
+
+			for (size_t m = 0; m < 4; ++m)
+			{
+				glm::mat4& matrix = outMatrices[i + m];
+				for (int c = 0; c < 4; ++c)
+					Store(&matrix[c][0], columns[m][c]);
+			}
+		}
+
+		for (; i < count; ++i)
+			outMatrices[i] = ComposeTransform(transforms, i);
+	}
+
+	glm::mat4 MultiplyTransform(const glm::mat4& parent, const glm::mat4& local)
+	{
+		Float4 p0 = Load(&parent[0][0]);
+		Float4 p1 = Load(&parent[1][0]);
+		Float4 p2 = Load(&parent[2][0]);
+		Float4 p3 = Load(&parent[3][0]);
+
+		glm::mat4 result;
+		for (int c = 0; c < 4; ++c)
+		{
+			Float4 column = Load(&local[c][0]);
+			Float4 r = p0 * SplatLane<0>(column);
+			r = MultiplyAdd(p1, SplatLane<1>(column), r);
+			r = MultiplyAdd(p2, SplatLane<2>(column), r);
+			r = MultiplyAdd(p3, SplatLane<3>(column), r);
+			Store(&result[c][0], r);
+		}
+
+		return result;
+	}
+
+	void MultiplyTransforms(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* outMatrices, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			outMatrices[i] = MultiplyTransform(parents[i], locals[i]);
+	}
+
+	void MultiplyTransformsScalar(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* outMatrices, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			outMatrices[i] = parents[i] * locals[i];
+	}
+
+	AABB TransformAABB(const AABB& box, const glm::mat4& matrix)
+	{
+		// Transform the center and project the extents on every axis, same result as Arvo's method
+		Float4 center = Set(box.min.x + box.max.x, box.min.y + box.max.y, box.min.z + box.max.z, 0.0f) * Splat(0.5f);
+		Float4 extents = Set(box.max.x - box.min.x, box.max.y - box.min.y, box.max.z - box.min.z, 0.0f) * Splat(0.5f);
+
+		Float4 m0 = Load(&matrix[0][0]);
+		Float4 m1 = Load(&matrix[1][0]);
+		Float4 m2 = Load(&matrix[2][0]);
+		Float4 m3 = Load(&matrix[3][0]);
+
+		Float4 newCenter = MultiplyAdd(m0, SplatLane<0>(center), m3);
+		newCenter = MultiplyAdd(m1, SplatLane<1>(center), newCenter);
+		newCenter = MultiplyAdd(m2, SplatLane<2>(center), newCenter);
+
+		Float4 newExtents = Abs(m0) * SplatLane<0>(extents);
+		newExtents = MultiplyAdd(Abs(m1), SplatLane<1>(extents), newExtents);
+		newExtents = MultiplyAdd(Abs(m2), SplatLane<2>(extents), newExtents);
+
+		float min[4], max[4];
+		Store(min, newCenter - newExtents);
+		Store(max, newCenter + newExtents);
+
+		return { glm::vec3(min[0], min[1], min[2]), glm::vec3(max[0], max[1], max[2]) };
+	}
+
+	void TransformAABBs(const AABB* boxes, const glm::mat4* matrices, AABB* outBoxes, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			outBoxes[i] = TransformAABB(boxes[i], matrices[i]);
+	}
+
+	void TransformAABBsScalar(const AABB* boxes, const glm::mat4* matrices, AABB* outBoxes, size_t count)
+	{
+		// Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990
+		for (size_t b = 0; b < count; ++b)
+		{
+			const glm::mat4& matrix = matrices[b];
+			glm::vec3 newMin = glm::vec3(matrix[3]);
+			glm::vec3 newMax = newMin;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				for (int j = 0; j < 3; ++j)
+				{
+					float e = matrix[j][i] * boxes[b].min[j];
+					float f = matrix[j][i] * boxes[b].max[j];
+					newMin[i] += std::min(e, f);
+					newMax[i] += std::max(e, f);
+				}
+			}
+
+			outBoxes[b] = { newMin, newMax };
+		}
+	}
+}
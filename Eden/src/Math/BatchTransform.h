@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+/*
+ * Batched transform kernels, built on top of SIMD.h.
+ * Every kernel has a scalar version that is kept as the reference implementation for correctness checks.
+ */
+namespace Eden::Math
+{
+	// Structure of arrays transform data, rotation is in euler angles(radians) like in TransformComponent
+	struct TransformSoA
+	{
+		std::vector<float> translationX, translationY, translationZ;
+		std::vector<float> rotationX, rotationY, rotationZ;
+		std::vector<float> scaleX, scaleY, scaleZ;
+
+		void Clear();
+		void Reserve(size_t count);
+		void Add(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
+		size_t Size() const { return translationX.size(); }
+	};
+
+	// translate * quat(euler) * scale for every transform, same result as TransformComponent::GetTransform
+	void ComposeTransforms(const TransformSoA& transforms, glm::mat4* outMatrices);
+	void ComposeTransformsScalar(const TransformSoA& transforms, glm::mat4* outMatrices);
+
+	// outMatrices[i] = parents[i] * locals[i]
+	glm::mat4 MultiplyTransform(const glm::mat4& parent, const glm::mat4& local);
+	void MultiplyTransforms(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* outMatrices, size_t count);
+	void MultiplyTransformsScalar(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* outMatrices, size_t count);
+
+	// Smallest AABB that contains the transformed box
+	AABB TransformAABB(const AABB& box, const glm::mat4& matrix);
+	void TransformAABBs(const AABB* boxes, const glm::mat4* matrices, AABB* outBoxes, size_t count);
+	void TransformAABBsScalar(const AABB* boxes, const glm::mat4* matrices, AABB* outBoxes, size_t count);
+}
@@ -0,0 +1,40 @@
+#include "Bounds.h"
+
+#include "SIMD.h"
+
+namespace Eden::Math
+{
+	using namespace SIMD;
+
+	AABB ComputeAABB(const float* positions, size_t count, size_t stride /*= sizeof(glm::vec3)*/)
+	{
+		AABB bounds;
+		if (count == 0)
+			return bounds;
+
+		const uint8_t* data = reinterpret_cast<const uint8_t*>(positions);
+		Float4 min = Splat(FLT_MAX);
+		Float4 max = Splat(-FLT_MAX);
+
+		// Loading 4 floats reads one past the position, so the last position is loaded separately
+		for (size_t i = 0; i + 1 < count; ++i)
+		{
+			Float4 position = Load(reinterpret_cast<const float*>(data + i * stride));
+			min = Min(min, position);
+			max = Max(max, position);
+		}
+
+		const float* last = reinterpret_cast<const float*>(data + (count - 1) * stride);
+		Float4 position = Set(last[0], last[1], last[2], 0.0f);
+		min = Min(min, position);
+		max = Max(max, position);
+
+		float minValues[4], maxValues[4];
+		Store(minValues, min);
+		Store(maxValues, max);
+		bounds.min = glm::vec3(minValues[0], minValues[1], minValues[2]);
+		bounds.max = glm::vec3(maxValues[0], maxValues[1], maxValues[2]);
+
+		return bounds;
+	}
+}
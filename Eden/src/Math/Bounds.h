@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cfloat>
+
+#include <glm/glm.hpp>
+
+namespace Eden::Math
+{
+	struct AABB
+	{
+		// Default constructed boxes are empty, merging anything into them gives the other bounds
+		glm::vec3 min = glm::vec3(FLT_MAX);
+		glm::vec3 max = glm::vec3(-FLT_MAX);
+
+		bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+		glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+		glm::vec3 GetExtents() const { return (max - min) * 0.5f; }
+
+		void Merge(const AABB& other)
+		{
+			min = glm::min(min, other.min);
+			max = glm::max(max, other.max);
+		}
+
+		bool operator==(const AABB& other) const { return min == other.min && max == other.max; }
+		bool operator!=(const AABB& other) const { return !(*this == other); }
+	};
+
+	struct BoundingSphere
+	{
+		glm::vec3 center = glm::vec3(0.0f);
+		float radius = 0.0f;
+
+		static BoundingSphere FromAABB(const AABB& box)
+		{
+			if (!box.IsValid())
+				return {};
+			return { box.GetCenter(), glm::length(box.GetExtents()) };
+		}
+	};
+
+	// Bounds of the positions, stride is the distance between two positions in bytes
+	AABB ComputeAABB(const float* positions, size_t count, size_t stride = sizeof(glm::vec3));
+}
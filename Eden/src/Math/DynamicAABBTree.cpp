@@ -0,0 +1,586 @@
+#include "DynamicAABBTree.h"
+
+#include <algorithm>
+
+namespace Eden::Math
+{
+	// Half the surface area, only used to compare costs
+	static float Area(const AABB& box)
+	{
+		glm::vec3 size = box.max - box.min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	static AABB Union(const AABB& a, const AABB& b)
+	{
+		return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+	}
+
+	DynamicAABBTree::DynamicAABBTree(float margin /*= 0.1f*/)
+		: m_Margin(margin)
+	{
+	}
+
+	int32_t DynamicAABBTree::CreateProxy(const AABB& bounds, uint32_t userData)
+	{
+		int32_t proxyId = AllocateNode();
+		Node& node = m_Nodes[proxyId];
+		node.bounds = Fatten(bounds);
+		node.userData = userData;
+		node.height = 0;
+
+		InsertLeaf(proxyId);
+		m_ProxyCount++;
+
+		return proxyId;
+	}
+
+	void DynamicAABBTree::DestroyProxy(int32_t proxyId)
+	{
+		RemoveLeaf(proxyId);
+		FreeNode(proxyId);
+		m_ProxyCount--;
+	}
+
+	bool DynamicAABBTree::MoveProxy(int32_t proxyId, const AABB& bounds)
+	{
+		AABB fatBounds = Fatten(bounds);
+		const AABB& treeBounds = m_Nodes[proxyId].bounds;
+
+		// Also reinsert when the proxy shrank a lot, so the fat bounds don't stay much bigger than the proxy
+		if (Contains(treeBounds, bounds))
+		{
+			glm::vec3 hugeMargin = glm::vec3(4.0f * m_Margin);
+			AABB hugeBounds = { fatBounds.min - hugeMargin, fatBounds.max + hugeMargin };
+			if (Contains(hugeBounds, treeBounds))
+				return false;
+		}
+
+		RemoveLeaf(proxyId);
+		m_Nodes[proxyId].bounds = fatBounds;
+		InsertLeaf(proxyId);
+
+		return true;
+	}
+
+	void DynamicAABBTree::CreateProxies(const AABB* bounds, const uint32_t* userData, size_t count, int32_t* outProxyIds)
+	{
+		if (count < 64 || count < m_ProxyCount)
+		{
+			for (size_t i = 0; i < count; ++i)
+				outProxyIds[i] = CreateProxy(bounds[i], userData[i]);
+			return;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			int32_t proxyId = AllocateNode();
+			Node& node = m_Nodes[proxyId];
+			node.bounds = Fatten(bounds[i]);
+			node.userData = userData[i];
+			node.height = 0;
+			outProxyIds[i] = proxyId;
+		}
+		m_ProxyCount += static_cast<uint32_t>(count);
+
+		Rebuild();
+	}
+
+	void DynamicAABBTree::Rebuild()
+	{
+		// Leaves keep their ids, internal nodes are freed and built again.
+		// The build works on a copy of the leaf bounds, so partitioning them doesn't jump around the node array
+		std::vector<BuildLeaf> leaves;
+		leaves.reserve(m_ProxyCount);
+		for (int32_t nodeId = 0; nodeId < static_cast<int32_t>(m_Nodes.size()); ++nodeId)
+		{
+			const AABB& bounds = m_Nodes[nodeId].bounds;
+			if (m_Nodes[nodeId].height == 0)
+				leaves.push_back({ bounds, bounds.GetCenter(), nodeId });
+			else if (m_Nodes[nodeId].height > 0)
+				FreeNode(nodeId);
+		}
+
+		m_Root = leaves.empty() ? kNullNode : BuildTopDown(leaves.data(), leaves.size(), 0);
+		if (m_Root != kNullNode)
+			m_Nodes[m_Root].parent = kNullNode;
+	}
+
+	void DynamicAABBTree::Clear()
+	{
+		m_Nodes.clear();
+		m_Root = kNullNode;
+		m_FreeList = kNullNode;
+		m_ProxyCount = 0;
+	}
+
+	float DynamicAABBTree::GetAreaRatio() const
+	{
+		if (m_Root == kNullNode)
+			return 0.0f;
+
+		float rootArea = Area(m_Nodes[m_Root].bounds);
+		if (rootArea <= 0.0f)
+			return 0.0f;
+
+		float totalArea = 0.0f;
+		for (auto& node : m_Nodes)
+		{
+			if (node.height > 0)
+				totalArea += Area(node.bounds);
+		}
+
+		return totalArea / rootArea;
+	}
+
+	int32_t DynamicAABBTree::AllocateNode()
+	{
+		if (m_FreeList == kNullNode)
+		{
+			m_Nodes.emplace_back();
+			return static_cast<int32_t>(m_Nodes.size() - 1);
+		}
+
+		int32_t nodeId = m_FreeList;
+		m_FreeList = m_Nodes[nodeId].parent;
+		m_Nodes[nodeId] = Node();
+
+		return nodeId;
+	}
+
+	void DynamicAABBTree::FreeNode(int32_t nodeId)
+	{
+		m_Nodes[nodeId].parent = m_FreeList;
+		m_Nodes[nodeId].height = -1;
+		m_FreeList = nodeId;
+	}
+
+	void DynamicAABBTree::InsertLeaf(int32_t leaf)
+	{
+		if (m_Root == kNullNode)
+		{
+			m_Root = leaf;
+			m_Nodes[leaf].parent = kNullNode;
+			return;
+		}
+
+		// Descend to the sibling with the lowest cost, the cost of a node is the area of the new parent
+		// plus the area increase of every ancestor
+		AABB leafBounds = m_Nodes[leaf].bounds;
+		int32_t index = m_Root;
+		while (!m_Nodes[index].IsLeaf())
+		{
+			const Node& node = m_Nodes[index];
+			float area = Area(node.bounds);
+			float combinedArea = Area(Union(node.bounds, leafBounds));
+
+			float cost = 2.0f * combinedArea;
+			float inheritanceCost = 2.0f * (combinedArea - area);
+
+			auto childCost = [&](int32_t childId)
+			{
+				const Node& child = m_Nodes[childId];
+				float newArea = Area(Union(child.bounds, leafBounds));
+				return (child.IsLeaf() ? newArea : newArea - Area(child.bounds)) + inheritanceCost;
+			};
+			float cost1 = childCost(node.child1);
+			float cost2 = childCost(node.child2);
+
+			if (cost < cost1 && cost < cost2)
+				break;
+
+			index = cost1 < cost2 ? node.child1 : node.child2;
+		}
+
+		int32_t sibling = index;
+		int32_t oldParent = m_Nodes[sibling].parent;
+		int32_t newParent = AllocateNode();
+
+		Node& parentNode = m_Nodes[newParent];
+		parentNode.parent = oldParent;
+		parentNode.bounds = Union(leafBounds, m_Nodes[sibling].bounds);
+		parentNode.height = m_Nodes[sibling].height + 1;
+		parentNode.child1 = sibling;
+		parentNode.child2 = leaf;
+		m_Nodes[sibling].parent = newParent;
+		m_Nodes[leaf].parent = newParent;
+
+		if (oldParent != kNullNode)
+		{
+			if (m_Nodes[oldParent].child1 == sibling)
+				m_Nodes[oldParent].child1 = newParent;
+			else
+				m_Nodes[oldParent].child2 = newParent;
+		}
+		else
+		{
+			m_Root = newParent;
+		}
+
+		RefitAncestors(newParent);
+	}
+
+	void DynamicAABBTree::RemoveLeaf(int32_t leaf)
+	{
+		if (leaf == m_Root)
+		{
+			m_Root = kNullNode;
+			return;
+		}
+
+		int32_t parent = m_Nodes[leaf].parent;
+		int32_t grandParent = m_Nodes[parent].parent;
+		int32_t sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+		if (grandParent != kNullNode)
+		{
+			if (m_Nodes[grandParent].child1 == parent)
+				m_Nodes[grandParent].child1 = sibling;
+			else
+				m_Nodes[grandParent].child2 = sibling;
+			m_Nodes[sibling].parent = grandParent;
+			FreeNode(parent);
+
+			RefitAncestors(grandParent);
+		}
+		else
+		{
+			m_Root = sibling;
+			m_Nodes[sibling].parent = kNullNode;
+			FreeNode(parent);
+		}
+	}
+
+	void DynamicAABBTree::RefitAncestors(int32_t nodeId)
+	{
+		// The first node always changed, above it the walk stops at the first node that keeps its bounds and height,
+		// small changes usually stop a few levels up instead of reaching the root
+		bool bFirstNode = true;
+		while (nodeId != kNullNode)
+		{
+			Node& node = m_Nodes[nodeId];
+			AABB oldBounds = node.bounds;
+			int32_t oldHeight = node.height;
+
+			const Node& child1 = m_Nodes[node.child1];
+			const Node& child2 = m_Nodes[node.child2];
+			node.bounds = Union(child1.bounds, child2.bounds);
+			node.height = 1 + std::max(child1.height, child2.height);
+
+			RotateNodes(nodeId);
+
+			if (!bFirstNode && node.bounds == oldBounds && node.height == oldHeight)
+				break;
+
+			bFirstNode = false;
+			nodeId = node.parent;
+		}
+	}
+
+	/*
+	 * Tree rotations from "Dynamic Bounding Volume Hierarchies", Erin Catto, GDC 2019.
+	 * A child of A is swapped with a grandchild when that reduces the area of the internal nodes below A.
+	 *
+	 *         A
+	 *       /   \
+	 *      B     C
+	 *     / \   / \
+	 *    D   E F   G
+	 */
+	void DynamicAABBTree::RotateNodes(int32_t nodeA)
+	{
+		Node& A = m_Nodes[nodeA];
+		if (A.height < 2)
+			return;
+
+		int32_t nodeB = A.child1;
+		int32_t nodeC = A.child2;
+		Node& B = m_Nodes[nodeB];
+		Node& C = m_Nodes[nodeC];
+
+		if (B.height == 0)
+		{
+			// B is a leaf, so C is internal: swap B with one of C's children
+			int32_t nodeF = C.child1;
+			int32_t nodeG = C.child2;
+			Node& F = m_Nodes[nodeF];
+			Node& G = m_Nodes[nodeG];
+
+			float costBase = Area(C.bounds);
+			AABB boundsBG = Union(B.bounds, G.bounds);
+			AABB boundsBF = Union(B.bounds, F.bounds);
+			float costBF = Area(boundsBG);
+			float costBG = Area(boundsBF);
+
+			if (costBase <= costBF && costBase <= costBG)
+				return;
+
+			if (costBF <= costBG)
+			{
+				A.child1 = nodeF;
+				C.child1 = nodeB;
+				B.parent = nodeC;
+				F.parent = nodeA;
+				C.bounds = boundsBG;
+				C.height = 1 + std::max(B.height, G.height);
+				A.height = 1 + std::max(C.height, F.height);
+			}
+			else
+			{
+				A.child1 = nodeG;
+				C.child2 = nodeB;
+				B.parent = nodeC;
+				G.parent = nodeA;
+				C.bounds = boundsBF;
+				C.height = 1 + std::max(B.height, F.height);
+				A.height = 1 + std::max(C.height, G.height);
+			}
+			return;
+		}
+
+		if (C.height == 0)
+		{
+			// C is a leaf, so B is internal: swap C with one of B's children
+			int32_t nodeD = B.child1;
+			int32_t nodeE = B.child2;
+			Node& D = m_Nodes[nodeD];
+			Node& E = m_Nodes[nodeE];
+
+			float costBase = Area(B.bounds);
+			AABB boundsCE = Union(C.bounds, E.bounds);
+			AABB boundsCD = Union(C.bounds, D.bounds);
+			float costCD = Area(boundsCE);
+			float costCE = Area(boundsCD);
+
+			if (costBase <= costCD && costBase <= costCE)
+				return;
+
+			if (costCD <= costCE)
+			{
+				A.child2 = nodeD;
+				B.child1 = nodeC;
+				C.parent = nodeB;
+				D.parent = nodeA;
+				B.bounds = boundsCE;
+				B.height = 1 + std::max(C.height, E.height);
+				A.height = 1 + std::max(B.height, D.height);
+			}
+			else
+			{
+				A.child2 = nodeE;
+				B.child2 = nodeC;
+				C.parent = nodeB;
+				E.parent = nodeA;
+				B.bounds = boundsCD;
+				B.height = 1 + std::max(C.height, D.height);
+				A.height = 1 + std::max(B.height, E.height);
+			}
+			return;
+		}
+
+		int32_t nodeD = B.child1;
+		int32_t nodeE = B.child2;
+		int32_t nodeF = C.child1;
+		int32_t nodeG = C.child2;
+		Node& D = m_Nodes[nodeD];
+		Node& E = m_Nodes[nodeE];
+		Node& F = m_Nodes[nodeF];
+		Node& G = m_Nodes[nodeG];
+
+		float areaB = Area(B.bounds);
+		float areaC = Area(C.bounds);
+		float costBase = areaB + areaC;
+
+		enum class Rotation { None, BF, BG, CD, CE, DF, DG };
+		Rotation bestRotation = Rotation::None;
+		float bestCost = costBase;
+
+		auto consider = [&](Rotation rotation, float cost)
+		{
+			if (cost < bestCost)
+			{
+				bestRotation = rotation;
+				bestCost = cost;
+			}
+		};
+
+		consider(Rotation::BF, areaB + Area(Union(B.bounds, G.bounds)));
+		consider(Rotation::BG, areaB + Area(Union(B.bounds, F.bounds)));
+		consider(Rotation::CD, areaC + Area(Union(C.bounds, E.bounds)));
+		consider(Rotation::CE, areaC + Area(Union(C.bounds, D.bounds)));
+		// Swapping E with F or G gives the same trees as swapping D with G or F
+		consider(Rotation::DF, Area(Union(F.bounds, E.bounds)) + Area(Union(D.bounds, G.bounds)));
+		consider(Rotation::DG, Area(Union(G.bounds, E.bounds)) + Area(Union(F.bounds, D.bounds)));
+
+		switch (bestRotation)
+		{
+		case Rotation::None:
+			break;
+
+		case Rotation::BF:
+			A.child1 = nodeF;
+			C.child1 = nodeB;
+			B.parent = nodeC;
+			F.parent = nodeA;
+			C.bounds = Union(B.bounds, G.bounds);
+			C.height = 1 + std::max(B.height, G.height);
+			A.height = 1 + std::max(C.height, F.height);
+			break;
+
+		case Rotation::BG:
+			A.child1 = nodeG;
+			C.child2 = nodeB;
+			B.parent = nodeC;
+			G.parent = nodeA;
+			C.bounds = Union(B.bounds, F.bounds);
+			C.height = 1 + std::max(B.height, F.height);
+			A.height = 1 + std::max(C.height, G.height);
+			break;
+
+		case Rotation::CD:
+			A.child2 = nodeD;
+			B.child1 = nodeC;
+			C.parent = nodeB;
+			D.parent = nodeA;
+			B.bounds = Union(C.bounds, E.bounds);
+			B.height = 1 + std::max(C.height, E.height);
+			A.height = 1 + std::max(B.height, D.height);
+			break;
+
+		case Rotation::CE:
+			A.child2 = nodeE;
+			B.child2 = nodeC;
+			C.parent = nodeB;
+			E.parent = nodeA;
+			B.bounds = Union(C.bounds, D.bounds);
+			B.height = 1 + std::max(C.height, D.height);
+			A.height = 1 + std::max(B.height, E.height);
+			break;
+
+		case Rotation::DF:
+			B.child1 = nodeF;
+			C.child1 = nodeD;
+			D.parent = nodeC;
+			F.parent = nodeB;
+			B.bounds = Union(F.bounds, E.bounds);
+			C.bounds = Union(D.bounds, G.bounds);
+			B.height = 1 + std::max(F.height, E.height);
+			C.height = 1 + std::max(D.height, G.height);
+			A.height = 1 + std::max(B.height, C.height);
+			break;
+
+		case Rotation::DG:
+			B.child1 = nodeG;
+			C.child2 = nodeD;
+			D.parent = nodeC;
+			G.parent = nodeB;
+			B.bounds = Union(G.bounds, E.bounds);
+			C.bounds = Union(F.bounds, D.bounds);
+			B.height = 1 + std::max(G.height, E.height);
+			C.height = 1 + std::max(F.height, D.height);
+			A.height = 1 + std::max(B.height, C.height);
+			break;
+		}
+	}
+
+	int32_t DynamicAABBTree::BuildTopDown(BuildLeaf* leaves, size_t count, uint32_t depth)
+	{
+		if (count == 1)
+			return leaves[0].nodeId;
+
+		// Split along the longest axis of the leaf centers
+		AABB centerBounds;
+		for (size_t i = 0; i < count; ++i)
+			centerBounds.Merge({ leaves[i].center, leaves[i].center });
+
+		glm::vec3 extents = centerBounds.max - centerBounds.min;
+		int axis = extents.x > extents.y ? (extents.x > extents.z ? 0 : 2) : (extents.y > extents.z ? 1 : 2);
+		float axisMin = centerBounds.min[axis];
+		float axisExtent = extents[axis];
+
+		size_t splitIndex = 0;
+		constexpr uint32_t kMaxSAHDepth = 64;
+		if (axisExtent > 0.0f && depth < kMaxSAHDepth)
+		{
+			// Binned SAH, the split between two bins with the lowest count * area on both sides wins
+			constexpr int kBinCount = 16;
+			float binScale = kBinCount / axisExtent;
+			auto getBin = [&](const BuildLeaf& leaf)
+			{
+				int bin = static_cast<int>((leaf.center[axis] - axisMin) * binScale);
+				return std::min(bin, kBinCount - 1);
+			};
+
+			AABB binBounds[kBinCount];
+			size_t binCounts[kBinCount] = {};
+			for (size_t i = 0; i < count; ++i)
+			{
+				int bin = getBin(leaves[i]);
+				binBounds[bin].Merge(leaves[i].bounds);
+				binCounts[bin]++;
+			}
+
+			float rightCosts[kBinCount] = {};
+			AABB rightBounds;
+			size_t rightCount = 0;
+			for (int bin = kBinCount - 1; bin > 0; --bin)
+			{
+				rightBounds.Merge(binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightCosts[bin] = rightCount > 0 ? rightCount * Area(rightBounds) : 0.0f;
+			}
+
+			float bestCost = FLT_MAX;
+			int bestSplit = 0;
+			AABB leftBounds;
+			size_t leftCount = 0;
+			for (int bin = 1; bin < kBinCount; ++bin)
+			{
+				leftBounds.Merge(binBounds[bin - 1]);
+				leftCount += binCounts[bin - 1];
+				if (leftCount == 0 || leftCount == count)
+					continue;
+
+				float cost = leftCount * Area(leftBounds) + rightCosts[bin];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = bin;
+				}
+			}
+
+			if (bestSplit > 0)
+				splitIndex = std::partition(leaves, leaves + count, [&](const BuildLeaf& leaf) { return getBin(leaf) < bestSplit; }) - leaves;
+		}
+
+		// Every center in the same place, or a degenerate tree: split in half
+		if (splitIndex == 0 || splitIndex == count)
+		{
+			splitIndex = count / 2;
+			std::nth_element(leaves, leaves + splitIndex, leaves + count, [axis](const BuildLeaf& a, const BuildLeaf& b)
+			{
+				return a.center[axis] < b.center[axis];
+			});
+		}
+
+		int32_t child1 = BuildTopDown(leaves, splitIndex, depth + 1);
+		int32_t child2 = BuildTopDown(leaves + splitIndex, count - splitIndex, depth + 1);
+
+		int32_t nodeId = AllocateNode();
+		Node& node = m_Nodes[nodeId];
+		node.child1 = child1;
+		node.child2 = child2;
+		node.bounds = Union(m_Nodes[child1].bounds, m_Nodes[child2].bounds);
+		node.height = 1 + std::max(m_Nodes[child1].height, m_Nodes[child2].height);
+		m_Nodes[child1].parent = nodeId;
+		m_Nodes[child2].parent = nodeId;
+
+		return nodeId;
+	}
+
+	AABB DynamicAABBTree::Fatten(const AABB& bounds) const
+	{
+		glm::vec3 margin = glm::vec3(m_Margin);
+		return { bounds.min - margin, bounds.max + margin };
+	}
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "Frustum.h"
+
+namespace Eden::Math
+{
+	/*
+	 * Dynamic bounding volume hierarchy, based on the Box2D dynamic tree.
+	 * Every proxy is stored in a leaf with its bounds fattened by a margin, so small movements don't touch the tree.
+	 * Leaves are inserted next to the sibling that increases the surface area the least (SAH), and the
+	 * ancestors of every modified node are rotated when it reduces the total surface area of the tree.
+	 * Queries call back with the user data of every proxy whose fat bounds pass the test, so callers refine the results.
+	 */
+	class DynamicAABBTree
+	{
+	public:
+		static constexpr int32_t kNullNode = -1;
+
+		explicit DynamicAABBTree(float margin = 0.1f);
+
+		int32_t CreateProxy(const AABB& bounds, uint32_t userData);
+		void DestroyProxy(int32_t proxyId);
+		// Returns true if the proxy was reinserted, false if its fat bounds still contain the new bounds
+		bool MoveProxy(int32_t proxyId, const AABB& bounds);
+		// When the new proxies outnumber the ones in the tree, the whole tree is rebuilt instead of inserting them one by one
+		void CreateProxies(const AABB* bounds, const uint32_t* userData, size_t count, int32_t* outProxyIds);
+		// Top-down rebuild with a binned SAH, gives a better tree than incremental insertion but touches every node
+		void Rebuild();
+		void Clear();
+
+		uint32_t GetUserData(int32_t proxyId) const { return m_Nodes[proxyId].userData; }
+		const AABB& GetFatBounds(int32_t proxyId) const { return m_Nodes[proxyId].bounds; }
+		uint32_t GetProxyCount() const { return m_ProxyCount; }
+		int32_t GetHeight() const { return m_Root == kNullNode ? 0 : m_Nodes[m_Root].height; }
+		// Sum of the internal node areas divided by the root area, lower is better
+		float GetAreaRatio() const;
+
+		// The callbacks return false to stop the query
+		template<typename Callback> void Query(const AABB& box, Callback&& callback) const
+		{
+			Traverse([&box](const AABB& bounds) { return Overlaps(bounds, box); }, callback);
+		}
+
+		template<typename Callback> void Query(const BoundingSphere& sphere, Callback&& callback) const
+		{
+			float radiusSquared = sphere.radius * sphere.radius;
+			Traverse([&sphere, radiusSquared](const AABB& bounds)
+			{
+				glm::vec3 closestPoint = glm::clamp(sphere.center, bounds.min, bounds.max);
+				glm::vec3 difference = closestPoint - sphere.center;
+				return glm::dot(difference, difference) <= radiusSquared;
+			}, callback);
+		}
+
+		template<typename Callback> void Query(const Frustum& frustum, Callback&& callback) const
+		{
+			Traverse([&frustum](const AABB& bounds) { return frustum.Intersects(bounds); }, callback);
+		}
+
+		/*
+		 * Visits the proxies hit by the ray in [0, maxDistance], in no particular order.
+		 * The callback receives the user data and returns the new max distance: the distance of a confirmed hit
+		 * clips the ray, maxDistance keeps it unchanged and 0 stops the ray cast.
+		 */
+		template<typename Callback> void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Callback&& callback) const
+		{
+			if (m_Root == kNullNode)
+				return;
+
+			glm::vec3 inverseDirection = 1.0f / direction;
+
+			NodeStack stack;
+			stack.Push(m_Root);
+			while (!stack.IsEmpty())
+			{
+				const Node& node = m_Nodes[stack.Pop()];
+				float distance;
+				if (!RayIntersects(node.bounds, origin, inverseDirection, maxDistance, distance))
+					continue;
+
+				if (node.IsLeaf())
+				{
+					float newMaxDistance = callback(node.userData);
+					if (newMaxDistance <= 0.0f)
+						return;
+					maxDistance = glm::min(maxDistance, newMaxDistance);
+				}
+				else
+				{
+					stack.Push(node.child1);
+					stack.Push(node.child2);
+				}
+			}
+		}
+
+		static bool Overlaps(const AABB& a, const AABB& b)
+		{
+			return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+				   a.min.y <= b.max.y && a.max.y >= b.min.y &&
+				   a.min.z <= b.max.z && a.max.z >= b.min.z;
+		}
+
+		static bool Contains(const AABB& outer, const AABB& inner)
+		{
+			return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+				   outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+		}
+
+		// Slab test, outDistance is where the ray enters the box
+		static bool RayIntersects(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& outDistance)
+		{
+			glm::vec3 t1 = (box.min - origin) * inverseDirection;
+			glm::vec3 t2 = (box.max - origin) * inverseDirection;
+			glm::vec3 tMin = glm::min(t1, t2);
+			glm::vec3 tMax = glm::max(t1, t2);
+
+			float enter = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+			float exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+			outDistance = enter;
+			return enter <= exit;
+		}
+
+	private:
+		struct Node
+		{
+			AABB bounds;
+			uint32_t userData = 0;
+			int32_t parent = kNullNode; // next free node when the node is in the free list
+			int32_t child1 = kNullNode;
+			int32_t child2 = kNullNode;
+			int32_t height = 0; // leaves are 0, free nodes are -1
+
+			bool IsLeaf() const { return child1 == kNullNode; }
+		};
+
+		// Query stack that only allocates for very deep trees
+		class NodeStack
+		{
+			int32_t m_Inline[256];
+			std::vector<int32_t> m_Overflow;
+			uint32_t m_Count = 0;
+
+		public:
+			void Push(int32_t node)
+			{
+				if (m_Count < 256)
+					m_Inline[m_Count] = node;
+				else
+					m_Overflow.emplace_back(node);
+				m_Count++;
+			}
+
+			int32_t Pop()
+			{
+				m_Count--;
+				if (m_Count < 256)
+					return m_Inline[m_Count];
+
+				int32_t node = m_Overflow.back();
+				m_Overflow.pop_back();
+				return node;
+			}
+
+			bool IsEmpty() const { return m_Count == 0; }
+		};
+
+		std::vector<Node> m_Nodes;
+		int32_t m_Root = kNullNode;
+		int32_t m_FreeList = kNullNode;
+		uint32_t m_ProxyCount = 0;
+		float m_Margin;
+
+	private:
+		int32_t AllocateNode();
+		void FreeNode(int32_t nodeId);
+		void InsertLeaf(int32_t leaf);
+		void RemoveLeaf(int32_t leaf);
+		void RefitAncestors(int32_t nodeId);
+		void RotateNodes(int32_t nodeId);
+		struct BuildLeaf
+		{
+			AABB bounds;
+			glm::vec3 center;
+			int32_t nodeId;
+		};
+		int32_t BuildTopDown(BuildLeaf* leaves, size_t count, uint32_t depth);
+		AABB Fatten(const AABB& bounds) const;
+
+		template<typename Test, typename Callback> void Traverse(Test&& test, Callback& callback) const
+		{
+			if (m_Root == kNullNode)
+				return;
+
+			NodeStack stack;
+			stack.Push(m_Root);
+			while (!stack.IsEmpty())
+			{
+				const Node& node = m_Nodes[stack.Pop()];
+				if (!test(node.bounds))
+					continue;
+
+				if (node.IsLeaf())
+				{
+					if (!callback(node.userData))
+						return;
+				}
+				else
+				{
+					stack.Push(node.child1);
+					stack.Push(node.child2);
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,157 @@
+#include "Frustum.h"
+
+#include "SIMD.h"
+
+namespace Eden::Math
+{
+	using namespace SIMD;
+
+	Frustum Frustum::FromViewProjection(const glm::mat4& viewProjection)
+	{
+		// glm is column major, so the rows of the matrix are strided
+		glm::vec4 rows[4];
+		for (int i = 0; i < 4; ++i)
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+		Frustum frustum;
+		frustum.planes[kLeft]	= rows[3] + rows[0];
+		frustum.planes[kRight]	= rows[3] - rows[0];
+		frustum.planes[kBottom] = rows[3] + rows[1];
+		frustum.planes[kTop]	= rows[3] - rows[1];
+		frustum.planes[kNear]	= rows[2];
+		frustum.planes[kFar]	= rows[3] - rows[2];
+
+		for (auto& plane : frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return frustum;
+	}
+
+	bool Frustum::Intersects(const BoundingSphere& sphere) const
+	{
+		for (auto& plane : planes)
+		{
+			if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool Frustum::Intersects(const AABB& box) const
+	{
+		glm::vec3 center = box.GetCenter();
+		glm::vec3 extents = box.GetExtents();
+		for (auto& plane : planes)
+		{
+			glm::vec3 normal = glm::vec3(plane);
+			float radius = glm::dot(glm::abs(normal), extents);
+			if (glm::dot(normal, center) + plane.w < -radius)
+				return false;
+		}
+
+		return true;
+	}
+
+	void CullSpheresScalar(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint8_t* outVisible)
+	{
+		for (size_t i = 0; i < count; ++i)
+			outVisible[i] = frustum.Intersects(spheres[i]) ? 1 : 0;
+	}
+
+	void CullAABBsScalar(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* outVisible)
+	{
+		for (size_t i = 0; i < count; ++i)
+			outVisible[i] = frustum.Intersects(boxes[i]) ? 1 : 0;
+	}
+
+	static void WriteVisibility(int outsideMask, uint8_t* outVisible)
+	{
+		for (int lane = 0; lane < 4; ++lane)
+			outVisible[lane] = (outsideMask >> lane) & 1 ? 0 : 1;
+	}
+
+	void CullSpheres(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint8_t* outVisible)
+	{
+		static_assert(sizeof(BoundingSphere) == sizeof(float) * 4, "Spheres are loaded as a single Float4");
+
+		Float4 planeX[Frustum::kPlaneCount], planeY[Frustum::kPlaneCount], planeZ[Frustum::kPlaneCount], planeW[Frustum::kPlaneCount];
+		for (int p = 0; p < Frustum::kPlaneCount; ++p)
+		{
+			planeX[p] = Splat(frustum.planes[p].x);
+			planeY[p] = Splat(frustum.planes[p].y);
+			planeZ[p] = Splat(frustum.planes[p].z);
+			planeW[p] = Splat(frustum.planes[p].w);
+		}
+
+		// Four spheres per iteration, transposed so every lane is a different sphere
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			Float4 x = Load(&spheres[i + 0].center.x);
+			Float4 y = Load(&spheres[i + 1].center.x);
+			Float4 z = Load(&spheres[i + 2].center.x);
+			Float4 radius = Load(&spheres[i + 3].center.x);
+			Transpose(x, y, z, radius);
+
+			Float4 negativeRadius = Splat(0.0f) - radius;
+			Float4 outside = Splat(0.0f);
+			for (int p = 0; p < Frustum::kPlaneCount; ++p)
+			{
+				Float4 distance = MultiplyAdd(planeX[p], x, MultiplyAdd(planeY[p], y, MultiplyAdd(planeZ[p], z, planeW[p])));
+				outside = Or(outside, CompareLess(distance, negativeRadius));
+			}
+
+			WriteVisibility(MoveMask(outside), outVisible + i);
+		}
+
+		CullSpheresScalar(frustum, spheres + i, count - i, outVisible + i);
+	}
+
+	void CullAABBs(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* outVisible)
+	{
+		Float4 planeX[Frustum::kPlaneCount], planeY[Frustum::kPlaneCount], planeZ[Frustum::kPlaneCount], planeW[Frustum::kPlaneCount];
+		Float4 absPlaneX[Frustum::kPlaneCount], absPlaneY[Frustum::kPlaneCount], absPlaneZ[Frustum::kPlaneCount];
+		for (int p = 0; p < Frustum::kPlaneCount; ++p)
+		{
+			planeX[p] = Splat(frustum.planes[p].x);
+			planeY[p] = Splat(frustum.planes[p].y);
+			planeZ[p] = Splat(frustum.planes[p].z);
+			planeW[p] = Splat(frustum.planes[p].w);
+			absPlaneX[p] = Abs(planeX[p]);
+			absPlaneY[p] = Abs(planeY[p]);
+			absPlaneZ[p] = Abs(planeZ[p]);
+		}
+
+		const Float4 half = Splat(0.5f);
+		const Float4 zero = Splat(0.0f);
+
+		// Center/extents test, the box is outside a plane when the center is further than the projected extents
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const AABB* b = boxes + i;
+			Float4 minX = Set(b[0].min.x, b[1].min.x, b[2].min.x, b[3].min.x);
+			Float4 minY = Set(b[0].min.y, b[1].min.y, b[2].min.y, b[3].min.y);
+			Float4 minZ = Set(b[0].min.z, b[1].min.z, b[2].min.z, b[3].min.z);
+			Float4 maxX = Set(b[0].max.x, b[1].max.x, b[2].max.x, b[3].max.x);
+			Float4 maxY = Set(b[0].max.y, b[1].max.y, b[2].max.y, b[3].max.y);
+			Float4 maxZ = Set(b[0].max.z, b[1].max.z, b[2].max.z, b[3].max.z);
+
+			Float4 centerX = (minX + maxX) * half, centerY = (minY + maxY) * half, centerZ = (minZ + maxZ) * half;
+			Float4 extentX = (maxX - minX) * half, extentY = (maxY - minY) * half, extentZ = (maxZ - minZ) * half;
+
+			Float4 outside = zero;
+			for (int p = 0; p < Frustum::kPlaneCount; ++p)
+			{
+				Float4 distance = MultiplyAdd(planeX[p], centerX, MultiplyAdd(planeY[p], centerY, MultiplyAdd(planeZ[p], centerZ, planeW[p])));
+				Float4 radius = MultiplyAdd(absPlaneX[p], extentX, MultiplyAdd(absPlaneY[p], extentY, absPlaneZ[p] * extentZ));
+				outside = Or(outside, CompareLess(distance, zero - radius));
+			}
+
+			WriteVisibility(MoveMask(outside), outVisible + i);
+		}
+
+		CullAABBsScalar(frustum, boxes + i, count - i, outVisible + i);
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+namespace Eden::Math
+{
+	/*
+	 * View frustum as 6 planes pointing inwards, a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+	 * The tests are conservative: bounds that intersect a corner of the frustum from outside can be reported as visible.
+	 */
+	struct Frustum
+	{
+		enum Plane { kLeft = 0, kRight, kBottom, kTop, kNear, kFar, kPlaneCount };
+		glm::vec4 planes[kPlaneCount];
+
+		// Gribb/Hartmann plane extraction, expects a [0, 1] depth range projection
+		static Frustum FromViewProjection(const glm::mat4& viewProjection);
+
+		bool Intersects(const BoundingSphere& sphere) const;
+		bool Intersects(const AABB& box) const;
+	};
+
+	// outVisible[i] is set to 1 when the bounds intersect the frustum and 0 otherwise
+	void CullSpheres(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint8_t* outVisible);
+	void CullSpheresScalar(const Frustum& frustum, const BoundingSphere* spheres, size_t count, uint8_t* outVisible);
+	void CullAABBs(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* outVisible);
+	void CullAABBsScalar(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* outVisible);
+}
@@ -78,4 +78,17 @@ namespace Eden::Math
 		return true;
 	}
 
-}
\ No newline at end of file
+	void ScreenPointToRay(const glm::vec2& point, const glm::vec2& viewportSize, const glm::mat4& viewProjection, glm::vec3& outOrigin, glm::vec3& outDirection, float& outLength)
+	{
+		// Clip space y points up and the depth goes from 0 to 1
+		glm::vec2 ndc = glm::vec2(point.x / viewportSize.x * 2.0f - 1.0f, 1.0f - point.y / viewportSize.y * 2.0f);
+		glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+		glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, 0.0f, 1.0f);
+		glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+
+		outOrigin = glm::vec3(nearPoint) / nearPoint.w;
+		glm::vec3 ray = glm::vec3(farPoint) / farPoint.w - outOrigin;
+		outLength = glm::length(ray);
+		outDirection = ray / outLength;
+	}
+}
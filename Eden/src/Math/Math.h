@@ -5,4 +5,6 @@
 namespace Eden::Math
 {
 	bool DecomposeTransform(const glm::mat4& transform, glm::vec3& translation, glm::vec3& rotation, glm::vec3& scale);
+	// Ray from the near plane to the far plane through a pixel, point is in pixels from the top left of the viewport
+	void ScreenPointToRay(const glm::vec2& point, const glm::vec2& viewportSize, const glm::mat4& viewProjection, glm::vec3& outOrigin, glm::vec3& outDirection, float& outLength);
 }
@@ -0,0 +1,522 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Thin 4-wide SIMD abstraction used by the batched math kernels.
+ * SSE2 is the baseline on x64, NEON is used on ARM64 and everything else falls back to scalar code.
+ * Define ED_SIMD_FORCE_SCALAR to force the scalar implementation, useful to compare results.
+ */
+#if !defined(ED_SIMD_FORCE_SCALAR) && (defined(_M_X64) || defined(__SSE2__))
+	#define ED_SIMD_SSE 1
+	#include <emmintrin.h>
+#elif !defined(ED_SIMD_FORCE_SCALAR) && (defined(_M_ARM64) || defined(__ARM_NEON))
+	#define ED_SIMD_NEON 1
+	#include <arm_neon.h>
+#else
+	#define ED_SIMD_SCALAR 1
+	#include <cmath>
+#endif
+
+namespace Eden::SIMD
+{
+#if ED_SIMD_SSE
+	struct Float4 { __m128 v; };
+	struct Int4 { __m128i v; };
+#elif ED_SIMD_NEON
+	struct Float4 { float32x4_t v; };
+	struct Int4 { int32x4_t v; };
+#else
+	struct Float4 { float v[4]; };
+	struct Int4 { int32_t v[4]; };
+#endif
+
+	//
+	// Load/Store, pointers don't need to be aligned
+	//
+	inline Float4 Load(const float* data)
+	{
+#if ED_SIMD_SSE
+		return { _mm_loadu_ps(data) };
+#elif ED_SIMD_NEON
+		return { vld1q_f32(data) };
+#else
+		return { { data[0], data[1], data[2], data[3] } };
+#endif
+	}
+
+	inline void Store(float* data, Float4 a)
+	{
+#if ED_SIMD_SSE
+		_mm_storeu_ps(data, a.v);
+#elif ED_SIMD_NEON
+		vst1q_f32(data, a.v);
+#else
+		for (int i = 0; i < 4; ++i) data[i] = a.v[i];
+#endif
+	}
+
+	inline Float4 Set(float x, float y, float z, float w)
+	{
+#if ED_SIMD_SSE
+		return { _mm_set_ps(w, z, y, x) };
+#elif ED_SIMD_NEON
+		float data[4] = { x, y, z, w };
+		return { vld1q_f32(data) };
+#else
+		return { { x, y, z, w } };
+#endif
+	}
+
+	inline Float4 Splat(float value)
+	{
+#if ED_SIMD_SSE
+		return { _mm_set1_ps(value) };
+#elif ED_SIMD_NEON
+		return { vdupq_n_f32(value) };
+#else
+		return { { value, value, value, value } };
+#endif
+	}
+
+	inline Int4 SplatInt(int32_t value)
+	{
+#if ED_SIMD_SSE
+		return { _mm_set1_epi32(value) };
+#elif ED_SIMD_NEON
+		return { vdupq_n_s32(value) };
+#else
+		return { { value, value, value, value } };
+#endif
+	}
+
+	// Broadcasts one lane of a to every lane
+	template<int Lane>
+	inline Float4 SplatLane(Float4 a)
+	{
+		static_assert(Lane >= 0 && Lane < 4, "Invalid lane");
+#if ED_SIMD_SSE
+		return { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(Lane, Lane, Lane, Lane)) };
+#elif ED_SIMD_NEON
+		return { vdupq_n_f32(vgetq_lane_f32(a.v, Lane)) };
+#else
+		return Splat(a.v[Lane]);
+#endif
+	}
+
+	inline float GetX(Float4 a)
+	{
+#if ED_SIMD_SSE
+		return _mm_cvtss_f32(a.v);
+#elif ED_SIMD_NEON
+		return vgetq_lane_f32(a.v, 0);
+#else
+		return a.v[0];
+#endif
+	}
+
+	//
+	// Arithmetic
+	//
+	inline Float4 operator+(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_add_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vaddq_f32(a.v, b.v) };
+#else
+		return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+	}
+
+	inline Float4 operator-(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_sub_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vsubq_f32(a.v, b.v) };
+#else
+		return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+	}
+
+	inline Float4 operator*(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_mul_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vmulq_f32(a.v, b.v) };
+#else
+		return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+	}
+
+	inline Float4 operator/(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_div_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vdivq_f32(a.v, b.v) };
+#else
+		return { { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } };
+#endif
+	}
+
+	// a * b + c
+	inline Float4 MultiplyAdd(Float4 a, Float4 b, Float4 c)
+	{
+#if ED_SIMD_NEON
+		return { vmlaq_f32(c.v, a.v, b.v) };
+#else
+		return a * b + c;
+#endif
+	}
+
+	inline Float4 Min(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_min_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vminq_f32(a.v, b.v) };
+#else
+		Float4 result;
+		for (int i = 0; i < 4; ++i) result.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+		return result;
+#endif
+	}
+
+	inline Float4 Max(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_max_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vmaxq_f32(a.v, b.v) };
+#else
+		Float4 result;
+		for (int i = 0; i < 4; ++i) result.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+		return result;
+#endif
+	}
+
+	inline Float4 Abs(Float4 a)
+	{
+#if ED_SIMD_SSE
+		return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) };
+#elif ED_SIMD_NEON
+		return { vabsq_f32(a.v) };
+#else
+		return { { std::fabs(a.v[0]), std::fabs(a.v[1]), std::fabs(a.v[2]), std::fabs(a.v[3]) } };
+#endif
+	}
+
+	//
+	// Comparisons and bitwise operations, masks have all bits set in the lanes where the comparison is true
+	//
+	inline Float4 CompareLess(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_cmplt_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_f32_u32(vcltq_f32(a.v, b.v)) };
+#else
+		Float4 result;
+		for (int i = 0; i < 4; ++i)
+		{
+			uint32_t mask = a.v[i] < b.v[i] ? 0xFFFFFFFF : 0;
+			std::memcpy(&result.v[i], &mask, sizeof(float));
+		}
+		return result;
+#endif
+	}
+
+	inline Float4 CompareGreater(Float4 a, Float4 b)
+	{
+		return CompareLess(b, a);
+	}
+
+#if ED_SIMD_SCALAR
+	namespace Detail
+	{
+		template<typename Func>
+		inline Float4 Bitwise(Float4 a, Float4 b, Func func)
+		{
+			Float4 result;
+			for (int i = 0; i < 4; ++i)
+			{
+				uint32_t x, y;
+				std::memcpy(&x, &a.v[i], sizeof(float));
+				std::memcpy(&y, &b.v[i], sizeof(float));
+				uint32_t r = func(x, y);
+				std::memcpy(&result.v[i], &r, sizeof(float));
+			}
+			return result;
+		}
+	}
+#endif
+
+	inline Float4 And(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_and_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) };
+#else
+		return Detail::Bitwise(a, b, [](uint32_t x, uint32_t y) { return x & y; });
+#endif
+	}
+
+	// ~a & b
+	inline Float4 AndNot(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_andnot_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(b.v), vreinterpretq_u32_f32(a.v))) };
+#else
+		return Detail::Bitwise(a, b, [](uint32_t x, uint32_t y) { return ~x & y; });
+#endif
+	}
+
+	inline Float4 Or(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_or_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) };
+#else
+		return Detail::Bitwise(a, b, [](uint32_t x, uint32_t y) { return x | y; });
+#endif
+	}
+
+	inline Float4 Xor(Float4 a, Float4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_xor_ps(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))) };
+#else
+		return Detail::Bitwise(a, b, [](uint32_t x, uint32_t y) { return x ^ y; });
+#endif
+	}
+
+	// Picks b where the mask is set and a everywhere else
+	inline Float4 Select(Float4 mask, Float4 a, Float4 b)
+	{
+		return Or(AndNot(mask, a), And(mask, b));
+	}
+
+	// Bit mask with the sign of every lane, bit 0 is lane 0
+	inline int MoveMask(Float4 a)
+	{
+#if ED_SIMD_SSE
+		return _mm_movemask_ps(a.v);
+#elif ED_SIMD_NEON
+		uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(a.v), 31);
+		return static_cast<int>(vgetq_lane_u32(signs, 0) | (vgetq_lane_u32(signs, 1) << 1) | (vgetq_lane_u32(signs, 2) << 2) | (vgetq_lane_u32(signs, 3) << 3));
+#else
+		int mask = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &a.v[i], sizeof(float));
+			mask |= static_cast<int>(bits >> 31) << i;
+		}
+		return mask;
+#endif
+	}
+
+	//
+	// Integer lanes
+	//
+	inline Int4 LoadInt(const int32_t* data)
+	{
+#if ED_SIMD_SSE
+		return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)) };
+#elif ED_SIMD_NEON
+		return { vld1q_s32(data) };
+#else
+		return { { data[0], data[1], data[2], data[3] } };
+#endif
+	}
+
+	inline void StoreInt(int32_t* data, Int4 a)
+	{
+#if ED_SIMD_SSE
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(data), a.v);
+#elif ED_SIMD_NEON
+		vst1q_s32(data, a.v);
+#else
+		for (int i = 0; i < 4; ++i) data[i] = a.v[i];
+#endif
+	}
+
+	// Zero extends 4 consecutive 16 bit values
+	inline Int4 LoadUInt16(const uint16_t* data)
+	{
+#if ED_SIMD_SSE
+		return { _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)), _mm_setzero_si128()) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_s32_u32(vmovl_u16(vld1_u16(data))) };
+#else
+		return { { data[0], data[1], data[2], data[3] } };
+#endif
+	}
+
+	// Zero extends 4 consecutive 8 bit values
+	inline Int4 LoadUInt8(const uint8_t* data)
+	{
+#if ED_SIMD_SSE
+		int32_t packed;
+		std::memcpy(&packed, data, sizeof(int32_t));
+		__m128i zero = _mm_setzero_si128();
+		return { _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero) };
+#elif ED_SIMD_NEON
+		uint32_t packed;
+		std::memcpy(&packed, data, sizeof(uint32_t));
+		uint16x8_t widened = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(packed)));
+		return { vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(widened))) };
+#else
+		return { { data[0], data[1], data[2], data[3] } };
+#endif
+	}
+
+	inline Int4 ConvertToIntTruncate(Float4 a)
+	{
+#if ED_SIMD_SSE
+		return { _mm_cvttps_epi32(a.v) };
+#elif ED_SIMD_NEON
+		return { vcvtq_s32_f32(a.v) };
+#else
+		return { { static_cast<int32_t>(a.v[0]), static_cast<int32_t>(a.v[1]), static_cast<int32_t>(a.v[2]), static_cast<int32_t>(a.v[3]) } };
+#endif
+	}
+
+	inline Float4 ConvertToFloat(Int4 a)
+	{
+#if ED_SIMD_SSE
+		return { _mm_cvtepi32_ps(a.v) };
+#elif ED_SIMD_NEON
+		return { vcvtq_f32_s32(a.v) };
+#else
+		return { { static_cast<float>(a.v[0]), static_cast<float>(a.v[1]), static_cast<float>(a.v[2]), static_cast<float>(a.v[3]) } };
+#endif
+	}
+
+	inline Int4 operator+(Int4 a, Int4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_add_epi32(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vaddq_s32(a.v, b.v) };
+#else
+		return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+	}
+
+	inline Int4 operator&(Int4 a, Int4 b)
+	{
+#if ED_SIMD_SSE
+		return { _mm_and_si128(a.v, b.v) };
+#elif ED_SIMD_NEON
+		return { vandq_s32(a.v, b.v) };
+#else
+		return { { a.v[0] & b.v[0], a.v[1] & b.v[1], a.v[2] & b.v[2], a.v[3] & b.v[3] } };
+#endif
+	}
+
+	// Lanes equal to zero get all bits set
+	inline Float4 CompareEqualZero(Int4 a)
+	{
+#if ED_SIMD_SSE
+		return { _mm_castsi128_ps(_mm_cmpeq_epi32(a.v, _mm_setzero_si128())) };
+#elif ED_SIMD_NEON
+		return { vreinterpretq_f32_u32(vceqq_s32(a.v, vdupq_n_s32(0))) };
+#else
+		Float4 result;
+		for (int i = 0; i < 4; ++i)
+		{
+			uint32_t mask = a.v[i] == 0 ? 0xFFFFFFFF : 0;
+			std::memcpy(&result.v[i], &mask, sizeof(float));
+		}
+		return result;
+#endif
+	}
+
+	//
+	// Shuffles
+	//
+	inline void Transpose(Float4& a, Float4& b, Float4& c, Float4& d)
+	{
+#if ED_SIMD_SSE
+		_MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+#elif ED_SIMD_NEON
+		float32x4x2_t ab = vtrnq_f32(a.v, b.v);
+		float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+		a.v = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+		b.v = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+		c.v = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+		d.v = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+#else
+		float m[4][4];
+		for (int i = 0; i < 4; ++i)
+		{
+			m[0][i] = a.v[i];
+			m[1][i] = b.v[i];
+			m[2][i] = c.v[i];
+			m[3][i] = d.v[i];
+		}
+		for (int i = 0; i < 4; ++i)
+		{
+			a.v[i] = m[i][0];
+			b.v[i] = m[i][1];
+			c.v[i] = m[i][2];
+			d.v[i] = m[i][3];
+		}
+#endif
+	}
+
+	/*
+	 * Sine and cosine of every lane, based on the single precision cephes implementation.
+	 * The input is reduced to [-pi/4, pi/4] so the error stays around 1e-7 for reasonable angles.
+	 */
+	inline void SinCos(Float4 x, Float4& outSin, Float4& outCos)
+	{
+		const Float4 signMask = Splat(-0.0f);
+
+		// Work with |x| and restore the sine sign at the end
+		Float4 sinSign = And(x, signMask);
+		x = Abs(x);
+
+		// j = (int)(x * 4/pi), rounded up to an even number
+		Int4 j = ConvertToIntTruncate(x * Splat(1.27323954473516f));
+		j = (j + SplatInt(1)) & SplatInt(~1);
+		Float4 y = ConvertToFloat(j);
+
+		// Octant flags, the sine polynomial is used for the sine in octants 0 and 3 (mod 4) and for the cosine in the others
+		Float4 useSinPolynomial = CompareEqualZero(j & SplatInt(2));
+		Float4 sinFlip = AndNot(CompareEqualZero(j & SplatInt(4)), signMask);
+		Float4 cosFlip = AndNot(CompareEqualZero((j + SplatInt(2)) & SplatInt(4)), signMask);
+
+		// Extended precision modular arithmetic, x - y * pi/4
+		x = MultiplyAdd(y, Splat(-0.78515625f), x);
+		x = MultiplyAdd(y, Splat(-2.4187564849853515625e-4f), x);
+		x = MultiplyAdd(y, Splat(-3.77489497744594108e-8f), x);
+
+		Float4 z = x * x;
+
+		Float4 cosPolynomial = Splat(2.443315711809948e-5f);
+		cosPolynomial = MultiplyAdd(cosPolynomial, z, Splat(-1.388731625493765e-3f));
+		cosPolynomial = MultiplyAdd(cosPolynomial, z, Splat(4.166664568298827e-2f));
+		cosPolynomial = cosPolynomial * z * z;
+		cosPolynomial = MultiplyAdd(z, Splat(-0.5f), cosPolynomial) + Splat(1.0f);
+
+		Float4 sinPolynomial = Splat(-1.9515295891e-4f);
+		sinPolynomial = MultiplyAdd(sinPolynomial, z, Splat(8.3321608736e-3f));
+		sinPolynomial = MultiplyAdd(sinPolynomial, z, Splat(-1.6666654611e-1f));
+		sinPolynomial = MultiplyAdd(sinPolynomial * z, x, x);
+
+		outSin = Xor(Select(useSinPolynomial, cosPolynomial, sinPolynomial), Xor(sinFlip, sinSign));
+		outCos = Xor(Select(useSinPolynomial, sinPolynomial, cosPolynomial), cosFlip);
+	}
+}
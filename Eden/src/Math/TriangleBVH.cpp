@@ -0,0 +1,276 @@
+#include "TriangleBVH.h"
+
+#include <algorithm>
+
+namespace Eden::Math
+{
+	static constexpr uint32_t kMaxLeafTriangles = 4;
+	static constexpr uint32_t kMaxDepth = 64;
+
+	// Half the surface area, only used to compare costs
+	static float Area(const AABB& box)
+	{
+		glm::vec3 size = box.max - box.min;
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	static glm::vec3 ReadPosition(const float* positions, size_t stride, uint32_t index)
+	{
+		const float* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * stride);
+		return glm::vec3(position[0], position[1], position[2]);
+	}
+
+	// Slab test against a node, returns the entry distance or FLT_MAX on a miss
+	static float IntersectBounds(const AABB& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+	{
+		glm::vec3 t1 = (box.min - origin) * inverseDirection;
+		glm::vec3 t2 = (box.max - origin) * inverseDirection;
+		glm::vec3 tMin = glm::min(t1, t2);
+		glm::vec3 tMax = glm::max(t1, t2);
+
+		float enter = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+		float exit = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, maxDistance));
+		return enter <= exit ? enter : FLT_MAX;
+	}
+
+	void TriangleBVH::Build(const float* positions, size_t stride, const uint32_t* indices, size_t indexCount)
+	{
+		Clear();
+
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return;
+
+		std::vector<BuildTriangle> buildTriangles(triangleCount);
+		for (size_t i = 0; i < triangleCount; ++i)
+		{
+			BuildTriangle& triangle = buildTriangles[i];
+			for (size_t v = 0; v < 3; ++v)
+			{
+				glm::vec3 position = ReadPosition(positions, stride, indices[i * 3 + v]);
+				triangle.bounds.Merge({ position, position });
+			}
+			triangle.center = triangle.bounds.GetCenter();
+			triangle.index = static_cast<uint32_t>(i);
+		}
+
+		// A binary tree with one triangle per leaf has 2n - 1 nodes, reserving keeps the node indices stable
+		m_Nodes.reserve(triangleCount * 2);
+		Node& root = m_Nodes.emplace_back();
+		root.first = 0;
+		root.count = static_cast<uint32_t>(triangleCount);
+		Subdivide(0, buildTriangles, 0);
+
+		m_Triangles.resize(triangleCount);
+		for (size_t i = 0; i < triangleCount; ++i)
+		{
+			const uint32_t* triangleIndices = &indices[buildTriangles[i].index * 3];
+			glm::vec3 v0 = ReadPosition(positions, stride, triangleIndices[0]);
+			glm::vec3 v1 = ReadPosition(positions, stride, triangleIndices[1]);
+			glm::vec3 v2 = ReadPosition(positions, stride, triangleIndices[2]);
+			m_Triangles[i] = { v0, v1 - v0, v2 - v0 };
+		}
+	}
+
+	void TriangleBVH::Clear()
+	{
+		m_Nodes.clear();
+		m_Triangles.clear();
+	}
+
+	void TriangleBVH::Assign(const Node* nodes, size_t nodeCount, const Triangle* triangles, size_t triangleCount)
+	{
+		m_Nodes.assign(nodes, nodes + nodeCount);
+		m_Triangles.assign(triangles, triangles + triangleCount);
+	}
+
+	void TriangleBVH::Subdivide(uint32_t nodeId, std::vector<BuildTriangle>& triangles, uint32_t depth)
+	{
+		uint32_t first = m_Nodes[nodeId].first;
+		uint32_t count = m_Nodes[nodeId].count;
+		BuildTriangle* begin = triangles.data() + first;
+
+		AABB bounds;
+		AABB centerBounds;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			bounds.Merge(begin[i].bounds);
+			centerBounds.Merge({ begin[i].center, begin[i].center });
+		}
+		m_Nodes[nodeId].bounds = bounds;
+
+		if (count <= kMaxLeafTriangles)
+			return;
+
+		glm::vec3 extents = centerBounds.max - centerBounds.min;
+		int axis = extents.x > extents.y ? (extents.x > extents.z ? 0 : 2) : (extents.y > extents.z ? 1 : 2);
+		float axisMin = centerBounds.min[axis];
+		float axisExtent = extents[axis];
+
+		uint32_t splitIndex = 0;
+		if (axisExtent > 0.0f && depth < kMaxDepth)
+		{
+			// Binned SAH, the split between two bins with the lowest count * area on both sides wins
+			constexpr int kBinCount = 12;
+			float binScale = kBinCount / axisExtent;
+			auto getBin = [&](const BuildTriangle& triangle)
+			{
+				int bin = static_cast<int>((triangle.center[axis] - axisMin) * binScale);
+				return std::min(bin, kBinCount - 1);
+			};
+
+			AABB binBounds[kBinCount];
+			uint32_t binCounts[kBinCount] = {};
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				int bin = getBin(begin[i]);
+				binBounds[bin].Merge(begin[i].bounds);
+				binCounts[bin]++;
+			}
+
+			float rightCosts[kBinCount] = {};
+			AABB rightBounds;
+			uint32_t rightCount = 0;
+			for (int bin = kBinCount - 1; bin > 0; --bin)
+			{
+				rightBounds.Merge(binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightCosts[bin] = rightCount > 0 ? rightCount * Area(rightBounds) : 0.0f;
+			}
+
+			// Leaves that are already small stay leaves when no split is cheaper than testing every triangle
+			float bestCost = count * Area(bounds);
+			int bestSplit = 0;
+			AABB leftBounds;
+			uint32_t leftCount = 0;
+			for (int bin = 1; bin < kBinCount; ++bin)
+			{
+				leftBounds.Merge(binBounds[bin - 1]);
+				leftCount += binCounts[bin - 1];
+				if (leftCount == 0 || leftCount == count)
+					continue;
+
+				float cost = leftCount * Area(leftBounds) + rightCosts[bin];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = bin;
+				}
+			}
+
+			if (bestSplit > 0)
+				splitIndex = static_cast<uint32_t>(std::partition(begin, begin + count, [&](const BuildTriangle& triangle) { return getBin(triangle) < bestSplit; }) - begin);
+			else if (count <= kMaxLeafTriangles * 4)
+				return;
+		}
+
+		// Every center in the same place, or a degenerate tree: split in half
+		if (splitIndex == 0 || splitIndex == count)
+		{
+			splitIndex = count / 2;
+			std::nth_element(begin, begin + splitIndex, begin + count, [axis](const BuildTriangle& a, const BuildTriangle& b)
+			{
+				return a.center[axis] < b.center[axis];
+			});
+		}
+
+		uint32_t leftChild = static_cast<uint32_t>(m_Nodes.size());
+		m_Nodes.push_back({ AABB(), first, splitIndex });
+		m_Nodes.push_back({ AABB(), first + splitIndex, count - splitIndex });
+		m_Nodes[nodeId].first = leftChild;
+		m_Nodes[nodeId].count = 0;
+
+		Subdivide(leftChild, triangles, depth + 1);
+		Subdivide(leftChild + 1, triangles, depth + 1);
+	}
+
+	bool TriangleBVH::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& outDistance) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		glm::vec3 inverseDirection = 1.0f / direction;
+		if (IntersectBounds(m_Nodes[0].bounds, origin, inverseDirection, maxDistance) == FLT_MAX)
+			return false;
+
+		bool bHit = false;
+		// The SAH stops at kMaxDepth, the median splits after it add at most 32 levels
+		uint32_t stack[kMaxDepth + 32];
+		uint32_t stackSize = 0;
+		uint32_t nodeId = 0;
+		while (true)
+		{
+			const Node& node = m_Nodes[nodeId];
+			if (node.count > 0)
+			{
+				for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				{
+					// Moller-Trumbore
+					const Triangle& triangle = m_Triangles[i];
+					glm::vec3 p = glm::cross(direction, triangle.edge2);
+					float determinant = glm::dot(triangle.edge1, p);
+					if (glm::abs(determinant) < 1e-12f)
+						continue;
+
+					float inverseDeterminant = 1.0f / determinant;
+					glm::vec3 s = origin - triangle.v0;
+					float u = glm::dot(s, p) * inverseDeterminant;
+					if (u < 0.0f || u > 1.0f)
+						continue;
+
+					glm::vec3 q = glm::cross(s, triangle.edge1);
+					float v = glm::dot(direction, q) * inverseDeterminant;
+					if (v < 0.0f || u + v > 1.0f)
+						continue;
+
+					float distance = glm::dot(triangle.edge2, q) * inverseDeterminant;
+					if (distance >= 0.0f && distance < maxDistance)
+					{
+						maxDistance = distance;
+						bHit = true;
+					}
+				}
+			}
+			else
+			{
+				// Visit the closest child first, so hits clip the ray early
+				uint32_t nearChild = node.first;
+				uint32_t farChild = node.first + 1;
+				float nearDistance = IntersectBounds(m_Nodes[nearChild].bounds, origin, inverseDirection, maxDistance);
+				float farDistance = IntersectBounds(m_Nodes[farChild].bounds, origin, inverseDirection, maxDistance);
+				if (farDistance < nearDistance)
+				{
+					std::swap(nearChild, farChild);
+					std::swap(nearDistance, farDistance);
+				}
+
+				if (nearDistance != FLT_MAX)
+				{
+					if (farDistance != FLT_MAX)
+						stack[stackSize++] = farChild;
+					nodeId = nearChild;
+					continue;
+				}
+			}
+
+			// Pop until a node is still in front of the closest hit
+			bool bFoundNode = false;
+			while (stackSize > 0)
+			{
+				nodeId = stack[--stackSize];
+				if (IntersectBounds(m_Nodes[nodeId].bounds, origin, inverseDirection, maxDistance) != FLT_MAX)
+				{
+					bFoundNode = true;
+					break;
+				}
+			}
+
+			if (!bFoundNode)
+				break;
+		}
+
+		if (bHit)
+			outDistance = maxDistance;
+		return bHit;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+namespace Eden::Math
+{
+	/*
+	 * Static bounding volume hierarchy over the triangles of a mesh, built once at load time with a binned SAH.
+	 * Triangles are copied in leaf order, so a ray only touches the nodes and triangles along its path.
+	 * Used for exact ray casts against mesh geometry, like the editor picking.
+	 */
+	class TriangleBVH
+	{
+	public:
+		struct Node
+		{
+			AABB bounds;
+			uint32_t first; // first triangle of a leaf, or the first of the two children
+			uint32_t count; // 0 for internal nodes
+		};
+
+		// Edges are precomputed for the Moller-Trumbore test
+		struct Triangle
+		{
+			glm::vec3 v0;
+			glm::vec3 edge1;
+			glm::vec3 edge2;
+		};
+
+		// Positions are read with the given stride in bytes, every 3 indices make a triangle
+		void Build(const float* positions, size_t stride, const uint32_t* indices, size_t indexCount);
+		void Clear();
+
+		// Closest hit in [0, maxDistance], both faces of the triangles are hit
+		bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& outDistance) const;
+
+		bool IsEmpty() const { return m_Nodes.empty(); }
+		size_t GetTriangleCount() const { return m_Triangles.size(); }
+		size_t GetNodeCount() const { return m_Nodes.size(); }
+		const AABB& GetBounds() const { return m_Nodes[0].bounds; }
+
+		// The built tree, cooked meshes store it so it isn't built again on every load
+		const std::vector<Node>& GetNodes() const { return m_Nodes; }
+		const std::vector<Triangle>& GetTriangles() const { return m_Triangles; }
+		void Assign(const Node* nodes, size_t nodeCount, const Triangle* triangles, size_t triangleCount);
+
+	private:
+		struct BuildTriangle
+		{
+			AABB bounds;
+			glm::vec3 center;
+			uint32_t index;
+		};
+
+		std::vector<Node> m_Nodes;
+		std::vector<Triangle> m_Triangles;
+
+	private:
+		void Subdivide(uint32_t nodeId, std::vector<BuildTriangle>& triangles, uint32_t depth);
+	};
+}
@@ -1,6 +1,7 @@
 #include "D3D12DynamicRHI.h"
 
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -107,7 +108,7 @@ namespace Eden
 		edelete m_Device;
 	}
 
-	D3D12DynamicRHI::ShaderResult D3D12DynamicRHI::CompileShader(std::filesystem::path filePath, ShaderStage stage)
+	D3D12DynamicRHI::ShaderResult D3D12DynamicRHI::CompileShader(std::filesystem::path filePath, ShaderStage stage, const std::vector<const wchar_t*>& defines /*= {}*/)
 	{
 		std::wstring entryPoint = L"";
 		std::wstring stageStr = L"";
@@ -138,6 +139,11 @@ namespace Eden
 			L"-Zi",
 			L"-Fd", wpdbName.c_str()
 		};
+		for (const wchar_t* define : defines)
+		{
+			arguments.push_back(L"-D");
+			arguments.push_back(define);
+		}
 
 		ComPtr<IDxcBlobEncoding> source = nullptr;
 		m_DxcUtils->LoadFile(filePath.c_str(), nullptr, &source);
@@ -723,9 +729,14 @@ namespace Eden
 		shaderPath.append(L".hlsl");
 
 		D3D12Pipeline* dxPipeline = static_cast<D3D12Pipeline*>(pipeline.Get());
-		auto vertexShader = CompileShader(shaderPath, ShaderStage::kVS);
+		// Compact vertices are decoded in the vertex shader, the input layout then reads them as raw uints
+		std::vector<const wchar_t*> defines;
+		if (desc->vertexFormat == VertexFormat::kCompact)
+			defines.push_back(L"COMPACT_VERTEX");
+
+		auto vertexShader = CompileShader(shaderPath, ShaderStage::kVS, defines);
 		dxPipeline->vertexReflection = vertexShader.reflection;
-		auto pixel_shader = CompileShader(shaderPath, ShaderStage::kPS);
+		auto pixel_shader = CompileShader(shaderPath, ShaderStage::kPS, defines);
 		dxPipeline->pixel_reflection = pixel_shader.reflection;
 
 		ED_LOG_INFO("Compiled program '{}' successfully!", desc->programName);
@@ -735,6 +746,7 @@ namespace Eden
 
 		// Get input elements from vertex shader reflection
 		std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+		bool bSplitStreams = desc->vertexFormat == VertexFormat::kSplit;
 		D3D12_SHADER_DESC shaderDesc;
 		dxPipeline->vertexReflection->GetDesc(&shaderDesc);
 		for (uint32_t i = 0; i < shaderDesc.InputParameters; ++i)
@@ -742,6 +754,10 @@ namespace Eden
 			D3D12_SIGNATURE_PARAMETER_DESC desc = {};
 			dxPipeline->vertexReflection->GetInputParameterDesc(i, &desc);
 
+			// System values like SV_InstanceID are generated by the input assembler, they aren't in the vertex buffer
+			if (desc.SystemValueType != D3D_NAME_UNDEFINED)
+				continue;
+
 			uint32_t componentCount = 0;
 			while (desc.Mask)
 			{
@@ -778,7 +794,8 @@ namespace Eden
 			inputElement.SemanticName = desc.SemanticName;
 			inputElement.SemanticIndex = desc.SemanticIndex;
 			inputElement.Format = componentFormat;
-			inputElement.InputSlot = 0;
+			// Only positions are in the first stream of split layouts
+			inputElement.InputSlot = bSplitStreams && strcmp(desc.SemanticName, "POSITION") != 0 ? 1 : 0;
 			inputElement.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
 			inputElement.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
 			inputElement.InstanceDataStepRate = 0;
@@ -1248,17 +1265,21 @@ namespace Eden
 		m_BoundPipeline = pipeline;
 	}
 
-	void D3D12DynamicRHI::BindVertexBuffer(BufferRef vertexBuffer)
+	void D3D12DynamicRHI::BindVertexBuffer(BufferRef vertexBuffer, uint32_t stream)
 	{
 		ensure(vertexBuffer);
+		ensureMsg(stream < GMaxVertexStreams, "Vertex stream out of range!");
+		ensureMsg(stream <= m_BoundVertexStreamCount, "Vertex streams have to be bound in order!");
 
 		D3D12Buffer* dxBuffer = static_cast<D3D12Buffer*>(vertexBuffer.Get());
 		ensureMsg(dxBuffer->resource != nullptr, "Can't bind a empty vertex buffer!");
 		ensureMsg(m_BoundPipeline->desc.type == kPipelineType_Graphics, "Can't bind a vertex buffer on a compute pipeline!");
 
-		m_BoundVertexBuffer.BufferLocation	= dxBuffer->resource->GetGPUVirtualAddress();
-		m_BoundVertexBuffer.SizeInBytes		= vertexBuffer->size;
-		m_BoundVertexBuffer.StrideInBytes	= vertexBuffer->desc.stride;
+		D3D12_VERTEX_BUFFER_VIEW& view = m_BoundVertexBuffers[stream];
+		view.BufferLocation	= dxBuffer->resource->GetGPUVirtualAddress();
+		view.SizeInBytes	= vertexBuffer->size;
+		view.StrideInBytes	= vertexBuffer->desc.stride;
+		m_BoundVertexStreamCount = stream + 1;
 	}
 
 	void D3D12DynamicRHI::BindIndexBuffer(BufferRef indexBuffer)
@@ -1268,10 +1289,12 @@ namespace Eden
 		D3D12Buffer* dxBuffer = static_cast<D3D12Buffer*>(indexBuffer.Get());
 		ensureMsg(dxBuffer->resource != nullptr, "Can't bind a empty index buffer!");
 		ensureMsg(m_BoundPipeline->desc.type == kPipelineType_Graphics, "Can't bind a index buffer on a compute pipeline!");
+		ensureMsg(indexBuffer->desc.stride == sizeof(uint16_t) || indexBuffer->desc.stride == sizeof(uint32_t), "Index buffers need a 2 or 4 bytes stride!");
 
+		// The stride picks the index format
 		m_BoundIndexBuffer.BufferLocation	= dxBuffer->resource->GetGPUVirtualAddress();
 		m_BoundIndexBuffer.SizeInBytes		= indexBuffer->size;
-		m_BoundIndexBuffer.Format			= DXGI_FORMAT_R32_UINT;
+		m_BoundIndexBuffer.Format			= indexBuffer->desc.stride == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 	}
 
 	void D3D12DynamicRHI::BindParameter(const std::string& parameterName, BufferRef buffer)
@@ -1515,7 +1538,7 @@ namespace Eden
 	{
 		PrepareDraw();
 
-		m_CommandList->IASetVertexBuffers(0, 1, &m_BoundVertexBuffer);
+		m_CommandList->IASetVertexBuffers(0, m_BoundVertexStreamCount, m_BoundVertexBuffers);
 		m_CommandList->DrawInstanced(vertexCount, instanceCount, startVertexLocation, startInstanceLocation);
 	}
 
@@ -1523,7 +1546,7 @@ namespace Eden
 	{
 		PrepareDraw();
 
-		m_CommandList->IASetVertexBuffers(0, 1, &m_BoundVertexBuffer);
+		m_CommandList->IASetVertexBuffers(0, m_BoundVertexStreamCount, m_BoundVertexBuffers);
 		m_CommandList->IASetIndexBuffer(&m_BoundIndexBuffer);
 		m_CommandList->DrawIndexedInstanced(indexCount, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
 	}
@@ -74,7 +74,7 @@ namespace Eden
 		ComPtr<ID3D12GraphicsCommandList4> m_CommandList;
 		CD3DX12_RECT m_Scissor;
 
-		// Buffer used to get the pixel from the "ObjectPicker" color attachment
+		// Buffer used by ReadPixelFromTexture
 		D3D12Resource pixelReadStagingBuffer;
 
 		bool m_bIsImguiInitialized = false;
@@ -86,7 +86,8 @@ namespace Eden
 		HANDLE m_FenceEvent;
 		uint64_t m_FenceValues[GFrameCount] = { 0, 0 };
 
-		D3D12_VERTEX_BUFFER_VIEW m_BoundVertexBuffer;
+		D3D12_VERTEX_BUFFER_VIEW m_BoundVertexBuffers[GMaxVertexStreams];
+		uint32_t m_BoundVertexStreamCount = 0;
 		D3D12_INDEX_BUFFER_VIEW m_BoundIndexBuffer;
 		PipelineRef m_BoundPipeline;
 
@@ -129,7 +130,7 @@ namespace Eden
 		virtual void ImGuiNewFrame() override;
 
 		virtual void BindPipeline(PipelineRef pipeline) override;
-		virtual void BindVertexBuffer(BufferRef vertexBuffer) override;
+		virtual void BindVertexBuffer(BufferRef vertexBuffer, uint32_t stream = 0) override;
 		virtual void BindIndexBuffer(BufferRef indexBuffer) override;
 		virtual void BindParameter(const std::string& parameterName, BufferRef buffer) override;
 		virtual void BindParameter(const std::string& parameterName, TextureRef texture, TextureUsage usage = kReadOnly) override;
@@ -156,7 +157,7 @@ namespace Eden
 		void CreateAttachments(RenderPassRef renderPass);
 		uint32_t GetRootParameterIndex(const std::string& parameterName);
 		void CreateRootSignature(PipelineRef pipeline);
-		ShaderResult CompileShader(std::filesystem::path filePath, ShaderStage stage);
+		ShaderResult CompileShader(std::filesystem::path filePath, ShaderStage stage, const std::vector<const wchar_t*>& defines = {});
 		D3D12_STATIC_SAMPLER_DESC CreateSamplerDesc(uint32_t shaderRegister, uint32_t registerSpace, D3D12_SHADER_VISIBILITY shaderVisibility, D3D12_TEXTURE_ADDRESS_MODE addressMode);
 
 		void CreateGraphicsPipeline(PipelineRef pipeline, PipelineDesc* desc);
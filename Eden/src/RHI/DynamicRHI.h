@@ -47,8 +47,8 @@ namespace Eden
 		virtual void EnableImGui() = 0;
 
 		virtual void BindPipeline(PipelineRef pipeline) = 0;
-		virtual void BindVertexBuffer(BufferRef vertexBuffer) = 0;
-		virtual void BindIndexBuffer(BufferRef indexBuffer) = 0;
+		virtual void BindVertexBuffer(BufferRef vertexBuffer, uint32_t stream = 0) = 0;
+		virtual void BindIndexBuffer(BufferRef indexBuffer) = 0; // 16 or 32 bit indices, from the buffer stride
 		virtual void BindParameter(const std::string& parameterName, BufferRef buffer) = 0;
 		virtual void BindParameter(const std::string& parameterName, TextureRef texture, TextureUsage usage = kReadOnly) = 0;
 		virtual void BindParameter(const std::string& parameterName, void* data, size_t size) = 0; // Use only for constants
@@ -181,9 +181,10 @@ protected:
 		GRHI->BindPipeline(pipeline);
 	}
 
-	inline void RHIBindVertexBuffer(BufferRef vertexBuffer)
+	// Binding stream 0 unbinds the other streams, split layouts bind their attributes to stream 1 after it
+	inline void RHIBindVertexBuffer(BufferRef vertexBuffer, uint32_t stream = 0)
 	{
-		GRHI->BindVertexBuffer(vertexBuffer);
+		GRHI->BindVertexBuffer(vertexBuffer, stream);
 	}
 
 	inline void RHIBindIndexBuffer(BufferRef indexBuffer)
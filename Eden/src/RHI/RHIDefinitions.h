@@ -18,6 +18,18 @@ namespace Eden
 		kCount // Don't use this
 	};
 
+	// Layout of the vertex buffers a graphics pipeline reads, compact pipelines are compiled with COMPACT_VERTEX defined.
+	// Split pipelines read POSITION from stream 0 and the other attributes from stream 1. Shaders that only read
+	// POSITION work with the full and the split layouts, they only need the first stream bound.
+	enum class VertexFormat : uint8_t
+	{
+		kFull,
+		kCompact,
+		kSplit,
+		kCount // Don't use this
+	};
+	constexpr uint32_t GMaxVertexStreams = 2;
+
 	enum class ComparisonFunc
 	{
 		kNever,
@@ -111,6 +111,7 @@ namespace Eden
 		CullMode		cull_mode = CullMode::kBack;
 		ComparisonFunc	depthFunc = ComparisonFunc::kLess;
 		PipelineType	type = kPipelineType_Graphics;
+		VertexFormat	vertexFormat = VertexFormat::kFull;
 		RenderPassRef		renderPass;
 	};
 
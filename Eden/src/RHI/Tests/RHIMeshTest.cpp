@@ -1,6 +1,7 @@
 #include "RHIMeshTest.h"
 #include "imgui.h"
 #include "Core/Application.h"
+#include "Renderer/GeometryBuffers.h"
 
 namespace Eden::Gfx::Tests 
 {
@@ -39,24 +40,29 @@ namespace Eden::Gfx::Tests
 		
 		// Draw mesh
 		RHIBindPipeline(m_MainPipeline);
-		RHIBindVertexBuffer(m_MeshSource->meshVb);
-		RHIBindIndexBuffer(m_MeshSource->meshIb);
-		for (auto& mesh : m_MeshSource->meshes)
+		RHIBindVertexBuffer(m_MeshSource->vertexSlice.buffers[0]);
+		RHIBindIndexBuffer(m_MeshSource->indexSlice.buffers[0]);
+		for (auto& instance : m_MeshSource->instances)
 		{
+			const auto& mesh = m_MeshSource->meshes[instance.mesh];
 			m_Camera.Update(Application::Get()->GetDeltaTime());
 			glm::mat4 viewMatrix = glm::lookAtLH(m_Camera.position, m_Camera.position + m_Camera.front, m_Camera.up);
 			glm::mat4 projectionMatrix = glm::perspectiveFovLH(glm::radians(70.0f), 1600.0f, 900.0f, 0.1f, 200.0f);
 			glm::mat4 viewProjection = projectionMatrix * viewMatrix;
 			RHIBindParameter("SceneData", &viewProjection, sizeof(glm::mat4));
 
-			RHIBindParameter("Transform", &mesh->modelMatrix, sizeof(glm::mat4));
+			RHIBindParameter("Transform", &instance.modelMatrix, sizeof(glm::mat4));
 
-			for (auto& submesh : mesh->submeshes) 
+			for (uint32_t s = mesh.firstSubmesh; s < mesh.firstSubmesh + mesh.submeshCount; ++s)
 			{
-				RHIBindParameter("g_AlbedoMap", submesh->material.albedoMap);
-				RHIBindParameter("g_EmissiveMap", submesh->material.emissiveMap);
-
-				RHIDrawIndexed(submesh->indexCount, 1, submesh->indexStart);
+				const auto& submesh = m_MeshSource->submeshes[s];
+				const auto& material = m_MeshSource->materials[submesh.material];
+				RHIBindParameter("g_AlbedoMap", material.albedoMap);
+				RHIBindParameter("g_EmissiveMap", material.emissiveMap);
+				glm::vec4 baseColor = material.baseColor;
+				RHIBindParameter("MaterialData", &baseColor, sizeof(glm::vec4));
+
+				RHIDrawIndexed(submesh.indexCount, 1, submesh.indexStart + m_MeshSource->indexSlice.offset, submesh.vertexStart + m_MeshSource->vertexSlice.offset);
 			}
 		}
 		
@@ -77,6 +83,7 @@ namespace Eden::Gfx::Tests
 		m_VertexBuffer.Reset();
 
 		m_MeshSource.Reset();
+		GeometryBuffers::Shutdown();
 
 		RHIShutdown();
 	}
@@ -0,0 +1,250 @@
+#include "GeometryBuffers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "Core/Assertions.h"
+#include "Core/Log.h"
+#include "Core/Memory/Memory.h"
+#include "Profiling/Timer.h"
+#include "Utilities/Utils.h"
+
+namespace Eden
+{
+	struct GeometryPage
+	{
+		Memory::OffsetAllocator allocator;
+		BufferRef buffers[GMaxVertexStreams]; // empty once the page is released, the entry is reused by the next page
+		std::vector<GeometrySlice*> slices; // owner of every allocation, indexed by allocation node
+
+		bool IsLive() const { return buffers[0] != nullptr; }
+	};
+
+	struct GeometryPool
+	{
+		uint32_t strides[GMaxVertexStreams] = {};
+		uint32_t streamCount = 0;
+		std::vector<GeometryPage> pages;
+	};
+
+	struct GeometryBuffersData
+	{
+		std::vector<GeometryPool> pools;
+		uint64_t movedBytes = 0;
+	};
+
+	// Bytes of an element in every stream of the pool
+	static uint32_t GetElementSize(const GeometryPool& pool)
+	{
+		uint32_t elementSize = 0;
+		for (uint32_t s = 0; s < pool.streamCount; ++s)
+			elementSize += pool.strides[s];
+		return elementSize;
+	}
+
+	GeometryBuffersData& GeometryBuffers::GetData()
+	{
+		if (!s_Data)
+			s_Data = enew GeometryBuffersData();
+		return *s_Data;
+	}
+
+	void GeometryBuffers::Allocate(const GeometryStream* streams, uint32_t streamCount, uint32_t count, GeometrySlice& outSlice)
+	{
+		ensureMsg(!outSlice.IsValid(), "Geometry slice already holds an allocation!");
+		ensureMsg(streamCount > 0 && streamCount <= GMaxVertexStreams, "Geometry stream count out of range!");
+		if (count == 0)
+			return;
+
+		auto& data = GetData();
+
+		// Pool of the stream strides
+		uint32_t poolIndex = UINT32_MAX;
+		for (uint32_t i = 0; i < data.pools.size(); ++i)
+		{
+			const GeometryPool& pool = data.pools[i];
+			bool bMatches = pool.streamCount == streamCount;
+			for (uint32_t s = 0; bMatches && s < streamCount; ++s)
+				bMatches = pool.strides[s] == streams[s].stride;
+			if (bMatches)
+			{
+				poolIndex = i;
+				break;
+			}
+		}
+		if (poolIndex == UINT32_MAX)
+		{
+			poolIndex = static_cast<uint32_t>(data.pools.size());
+			GeometryPool& pool = data.pools.emplace_back();
+			pool.streamCount = streamCount;
+			for (uint32_t s = 0; s < streamCount; ++s)
+				pool.strides[s] = streams[s].stride;
+		}
+		GeometryPool& pool = data.pools[poolIndex];
+
+		// First live page with room, a new page otherwise
+		uint32_t pageIndex = UINT32_MAX;
+		Memory::OffsetAllocator::Allocation allocation;
+		for (uint32_t i = 0; i < pool.pages.size() && !allocation.IsValid(); ++i)
+		{
+			if (!pool.pages[i].IsLive())
+				continue;
+			allocation = pool.pages[i].allocator.Allocate(count);
+			pageIndex = i;
+		}
+		if (!allocation.IsValid())
+		{
+			pageIndex = static_cast<uint32_t>(std::find_if(pool.pages.begin(), pool.pages.end(), [](const GeometryPage& page) { return !page.IsLive(); }) - pool.pages.begin());
+			if (pageIndex == pool.pages.size())
+				pool.pages.emplace_back();
+
+			GeometryPage& page = pool.pages[pageIndex];
+			uint32_t elementCount = std::max(kPageSize / GetElementSize(pool), count);
+			page.allocator.Reset(elementCount);
+			for (uint32_t s = 0; s < streamCount; ++s)
+			{
+				BufferDesc desc;
+				desc.usage = BufferDesc::Vertex_Index;
+				desc.elementCount = elementCount;
+				desc.stride = pool.strides[s];
+				desc.debugName = "Geometry Page";
+				page.buffers[s] = RHICreateBuffer(&desc, nullptr);
+			}
+			allocation = page.allocator.Allocate(count);
+		}
+
+		GeometryPage& page = pool.pages[pageIndex];
+		for (uint32_t s = 0; s < streamCount; ++s)
+		{
+			outSlice.buffers[s] = page.buffers[s];
+			std::memcpy(static_cast<uint8_t*>(page.buffers[s]->mappedData) + static_cast<size_t>(allocation.offset) * pool.strides[s], streams[s].data, static_cast<size_t>(count) * pool.strides[s]);
+		}
+		if (page.slices.size() <= allocation.node)
+			page.slices.resize(allocation.node + 1, nullptr);
+		page.slices[allocation.node] = &outSlice;
+
+		outSlice.offset = allocation.offset;
+		outSlice.count = count;
+		outSlice.streamCount = streamCount;
+		outSlice.pool = poolIndex;
+		outSlice.page = pageIndex;
+		outSlice.allocation = allocation;
+	}
+
+	void GeometryBuffers::Free(GeometrySlice& slice)
+	{
+		if (slice.IsValid() && s_Data)
+		{
+			GeometryPool& pool = s_Data->pools[slice.pool];
+			GeometryPage& page = pool.pages[slice.page];
+			page.slices[slice.allocation.node] = nullptr;
+			page.allocator.Free(slice.allocation);
+
+			// An empty page is kept while it's the only one of its pool, unless a large slice made it larger than a page
+			if (page.allocator.GetAllocationCount() == 0)
+			{
+				bool bIsOversized = page.allocator.GetSize() > kPageSize / GetElementSize(pool);
+				bool bHasOtherPage = std::any_of(pool.pages.begin(), pool.pages.end(), [&page](const GeometryPage& other) { return &other != &page && other.IsLive(); });
+				if (bIsOversized || bHasOtherPage)
+				{
+					page.allocator.Reset(0);
+					page.slices.clear();
+					for (BufferRef& buffer : page.buffers)
+						buffer = nullptr;
+				}
+			}
+		}
+
+		for (BufferRef& buffer : slice.buffers)
+			buffer = nullptr;
+		slice.offset = 0;
+		slice.count = 0;
+		slice.streamCount = 0;
+		slice.pool = UINT32_MAX;
+		slice.page = 0;
+		slice.allocation = {};
+	}
+
+	uint64_t GeometryBuffers::Defragment(float minFragmentation)
+	{
+		if (!s_Data)
+			return 0;
+
+		Timer timer;
+		timer.Record();
+
+		uint32_t pageCount = 0;
+		uint64_t movedBytes = 0;
+		for (GeometryPool& pool : s_Data->pools)
+		{
+			uint32_t elementSize = GetElementSize(pool);
+			for (GeometryPage& page : pool.pages)
+			{
+				Memory::OffsetAllocator::Stats stats = page.allocator.GetStats();
+				if (!page.IsLive() || stats.freeRanges < 2 || stats.GetFragmentation() < minFragmentation)
+					continue;
+
+				// Allocations move toward the start in offset order, so a slice never overwrites one that hasn't moved yet
+				std::vector<GeometrySlice*> slices;
+				uint32_t movedCount = page.allocator.Compact([&](Memory::OffsetAllocator::Allocation from, Memory::OffsetAllocator::Allocation to)
+				{
+					GeometrySlice* slice = page.slices[from.node];
+					if (to.offset != from.offset)
+					{
+						for (uint32_t s = 0; s < pool.streamCount; ++s)
+						{
+							uint8_t* mappedData = static_cast<uint8_t*>(page.buffers[s]->mappedData);
+							std::memmove(mappedData + static_cast<size_t>(to.offset) * pool.strides[s], mappedData + static_cast<size_t>(from.offset) * pool.strides[s], static_cast<size_t>(slice->count) * pool.strides[s]);
+						}
+					}
+					slice->offset = to.offset;
+					slice->allocation = to;
+					if (slices.size() <= to.node)
+						slices.resize(to.node + 1, nullptr);
+					slices[to.node] = slice;
+				});
+				page.slices = std::move(slices);
+				movedBytes += static_cast<uint64_t>(movedCount) * elementSize;
+				pageCount++;
+			}
+		}
+
+		s_Data->movedBytes += movedBytes;
+		ED_LOG_INFO("Defragmented {} geometry buffers pages in {:.2f}ms, {} moved", pageCount, timer.ElapsedMilliseconds(), Utils::BytesToString(movedBytes));
+		return movedBytes;
+	}
+
+	GeometryBuffersStats GeometryBuffers::GetStats()
+	{
+		GeometryBuffersStats stats;
+		if (!s_Data)
+			return stats;
+
+		stats.pools = static_cast<uint32_t>(s_Data->pools.size());
+		stats.movedBytes = s_Data->movedBytes;
+		for (const GeometryPool& pool : s_Data->pools)
+		{
+			uint32_t elementSize = GetElementSize(pool);
+			for (const GeometryPage& page : pool.pages)
+			{
+				if (!page.IsLive())
+					continue;
+
+				Memory::OffsetAllocator::Stats pageStats = page.allocator.GetStats();
+				stats.pages++;
+				stats.slices += pageStats.allocations;
+				stats.pageBytes += static_cast<uint64_t>(page.allocator.GetSize()) * elementSize;
+				stats.usedBytes += static_cast<uint64_t>(page.allocator.GetSize() - pageStats.freeSize) * elementSize;
+				stats.largestFreeBytes += static_cast<uint64_t>(pageStats.largestFreeRange) * elementSize;
+			}
+		}
+		return stats;
+	}
+
+	void GeometryBuffers::Shutdown()
+	{
+		edelete s_Data;
+		s_Data = nullptr;
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Core/Memory/OffsetAllocator.h"
+#include "RHI/DynamicRHI.h"
+
+namespace Eden
+{
+	struct GeometryBuffersData;
+
+	// Elements of one vertex stream, or of the indices
+	struct GeometryStream
+	{
+		uint32_t stride;
+		const void* data; // count * stride bytes
+	};
+
+	// Range of a geometry buffer page, owned by what uploaded it. Draws bind the page buffers and add the offset to their
+	// base vertex or start index. Slices can't be copied, the geometry buffers update them when a defragmentation moves them.
+	struct GeometrySlice
+	{
+		BufferRef buffers[GMaxVertexStreams]; // a buffer per stream, shared with the other slices of the page
+		uint32_t offset = 0; // in elements
+		uint32_t count = 0;
+		uint32_t streamCount = 0;
+
+		// Allocation in the pool of the page
+		uint32_t pool = UINT32_MAX;
+		uint32_t page = 0;
+		Memory::OffsetAllocator::Allocation allocation;
+
+		GeometrySlice() = default;
+		GeometrySlice(const GeometrySlice&) = delete;
+		GeometrySlice& operator=(const GeometrySlice&) = delete;
+
+		bool IsValid() const { return pool != UINT32_MAX; }
+		uint32_t GetStride(uint32_t stream = 0) const { return buffers[stream]->desc.stride; }
+		// Mapped elements of a stream, from the first one of the slice
+		const uint8_t* GetData(uint32_t stream = 0) const { return static_cast<const uint8_t*>(buffers[stream]->mappedData) + static_cast<size_t>(offset) * GetStride(stream); }
+	};
+
+	struct GeometryBuffersStats
+	{
+		uint32_t pools = 0; // one per stream layout
+		uint32_t pages = 0;
+		uint32_t slices = 0;
+		uint64_t pageBytes = 0; // size of every page buffer
+		uint64_t usedBytes = 0;
+		uint64_t largestFreeBytes = 0; // of each page, summed
+		uint64_t movedBytes = 0; // by the defragmentations so far
+
+		uint64_t GetFreeBytes() const { return pageBytes - usedBytes; }
+		float GetFragmentation() const { return pageBytes > usedBytes ? 1.0f - static_cast<float>(largestFreeBytes) / static_cast<float>(pageBytes - usedBytes) : 0.0f; }
+	};
+
+	/*
+	 * Large vertex and index buffers that mesh geometry is sub-allocated from, instead of a buffer per upload.
+	 * Slices with the same stream strides share pools of pages, each page is a buffer per stream with an OffsetAllocator
+	 * in elements, so every stream of a slice is at the same offset and a single base vertex draws all of them.
+	 * Pages are persistently mapped upload buffers, slices are written and moved through the mapping, while the GPU is
+	 * idle between frames. Only used from the main thread.
+	 */
+	class GeometryBuffers
+	{
+	public:
+		// Bytes of a page, its streams together, a larger slice gets a page of its own
+		static constexpr uint32_t kPageSize = 32 * 1024 * 1024;
+
+		// Copies count elements of every stream into a new slice, outSlice must not hold one
+		static void Allocate(const GeometryStream* streams, uint32_t streamCount, uint32_t count, GeometrySlice& outSlice);
+		static void Free(GeometrySlice& slice);
+		// Packs the slices of every page whose free space is fragmented above minFragmentation, returns the moved bytes
+		static uint64_t Defragment(float minFragmentation = 0.1f);
+
+		static GeometryBuffersStats GetStats();
+		static void Shutdown();
+
+	private:
+		static GeometryBuffersData& GetData();
+
+	private:
+		inline static GeometryBuffersData* s_Data = nullptr;
+	};
+}
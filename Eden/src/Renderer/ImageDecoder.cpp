@@ -0,0 +1,109 @@
+#include "ImageDecoder.h"
+
+#include <cstring>
+
+#include <stb/stb_image.h>
+
+// RGB to RGBA is a byte shuffle, SSSE3 is assumed on x64 since every CPU that runs D3D12 has it
+#if !defined(ED_SIMD_FORCE_SCALAR) && (defined(_M_X64) || defined(__SSSE3__))
+	#define ED_IMAGE_SSSE3 1
+	#include <tmmintrin.h>
+#elif !defined(ED_SIMD_FORCE_SCALAR) && (defined(_M_ARM64) || defined(__ARM_NEON))
+	#define ED_IMAGE_NEON 1
+	#include <arm_neon.h>
+#endif
+
+namespace Eden
+{
+	bool DecodeImageRGBA8(const uint8_t* data, size_t size, DecodedImage& outImage)
+	{
+		// The file channel count is kept so the expansion to RGBA runs in ExpandToRGBA instead of stb's scalar loop.
+		// 16 bit images are converted to 8 bit by stb.
+		int width = 0, height = 0, channelCount = 0;
+		stbi_uc* pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channelCount, 0);
+		if (!pixels)
+			return false;
+
+		size_t pixelCount = static_cast<size_t>(width) * static_cast<size_t>(height);
+		outImage.width = static_cast<uint32_t>(width);
+		outImage.height = static_cast<uint32_t>(height);
+		outImage.pixels.resize(pixelCount * 4);
+		ExpandToRGBA(pixels, static_cast<uint32_t>(channelCount), outImage.pixels.data(), pixelCount);
+
+		stbi_image_free(pixels);
+		return true;
+	}
+
+	void ExpandToRGBA(const uint8_t* source, uint32_t channelCount, uint8_t* outRGBA, size_t pixelCount)
+	{
+		if (channelCount == 4)
+		{
+			memcpy(outRGBA, source, pixelCount * 4);
+			return;
+		}
+
+		if (channelCount != 3)
+		{
+			ExpandToRGBAScalar(source, channelCount, outRGBA, pixelCount);
+			return;
+		}
+
+		size_t i = 0;
+#if ED_IMAGE_SSSE3
+		// 16 pixels per iteration, 48 bytes in 3 loads, the 4 groups of 4 pixels are aligned to the start of a register and shuffled
+		const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+		const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+		for (; i + 16 <= pixelCount; i += 16)
+		{
+			const uint8_t* rgb = source + i * 3;
+			__m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb));
+			__m128i in1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + 16));
+			__m128i in2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + 32));
+
+			__m128i* rgba = reinterpret_cast<__m128i*>(outRGBA + i * 4);
+			_mm_storeu_si128(rgba + 0, _mm_or_si128(_mm_shuffle_epi8(in0, shuffle), alpha));
+			_mm_storeu_si128(rgba + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), shuffle), alpha));
+			_mm_storeu_si128(rgba + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(in2, in1, 8), shuffle), alpha));
+			_mm_storeu_si128(rgba + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(in2, 4), shuffle), alpha));
+		}
+#elif ED_IMAGE_NEON
+		for (; i + 16 <= pixelCount; i += 16)
+		{
+			uint8x16x3_t rgb = vld3q_u8(source + i * 3);
+			uint8x16x4_t rgba = { { rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255) } };
+			vst4q_u8(outRGBA + i * 4, rgba);
+		}
+#endif
+
+		ExpandToRGBAScalar(source + i * 3, 3, outRGBA + i * 4, pixelCount - i);
+	}
+
+	void ExpandToRGBAScalar(const uint8_t* source, uint32_t channelCount, uint8_t* outRGBA, size_t pixelCount)
+	{
+		for (size_t i = 0; i < pixelCount; ++i)
+		{
+			const uint8_t* pixel = source + i * channelCount;
+			uint8_t* rgba = outRGBA + i * 4;
+			switch (channelCount)
+			{
+				case 1:
+					rgba[0] = rgba[1] = rgba[2] = pixel[0];
+					rgba[3] = 255;
+					break;
+				case 2:
+					rgba[0] = rgba[1] = rgba[2] = pixel[0];
+					rgba[3] = pixel[1];
+					break;
+				case 3:
+					rgba[0] = pixel[0];
+					rgba[1] = pixel[1];
+					rgba[2] = pixel[2];
+					rgba[3] = 255;
+					break;
+				default:
+					memcpy(rgba, pixel, 4);
+					break;
+			}
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Eden
+{
+	struct DecodedImage
+	{
+		std::vector<uint8_t> pixels; // 8 bit RGBA
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	// Decodes an image file in memory (png, jpg, ...) to 8 bit RGBA, safe to call from several threads at once
+	bool DecodeImageRGBA8(const uint8_t* data, size_t size, DecodedImage& outImage);
+
+	// Expands 1 (grey), 2 (grey, alpha), 3 (RGB) or 4 channel pixels to RGBA, alpha is 255 when the source has none
+	void ExpandToRGBA(const uint8_t* source, uint32_t channelCount, uint8_t* outRGBA, size_t pixelCount);
+	void ExpandToRGBAScalar(const uint8_t* source, uint32_t channelCount, uint8_t* outRGBA, size_t pixelCount);
+}
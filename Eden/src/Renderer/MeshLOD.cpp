@@ -0,0 +1,31 @@
+#include "MeshLOD.h"
+
+#include <algorithm>
+
+namespace Eden::MeshLOD
+{
+	uint32_t Select(const MeshSource::Mesh& mesh, const glm::mat4& transform, const View& view, uint32_t previousLOD)
+	{
+		if (mesh.lodCount <= 1)
+			return 0;
+
+		// Errors are in vertex space, the largest axis scale of the transform is the worst case
+		float scale = std::max(std::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))), glm::length(glm::vec3(transform[2])));
+		glm::vec3 center = glm::vec3(transform * glm::vec4(mesh.bounds.GetCenter(), 1.0f));
+		float radius = glm::length(mesh.bounds.GetExtents()) * scale;
+
+		// The closest point of the bounding sphere, the camera inside of it always gets the full detail
+		float distance = glm::distance(view.position, center) - radius;
+		if (distance <= 0.0f)
+			return 0;
+
+		float pixelsPerUnit = view.screenScale * scale / distance;
+		uint32_t lod = std::min(previousLOD, mesh.lodCount - 1);
+		while (lod > 0 && mesh.lodErrors[lod] * pixelsPerUnit > view.pixelThreshold)
+			lod--;
+		while (lod + 1 < mesh.lodCount && mesh.lodErrors[lod + 1] * pixelsPerUnit <= view.pixelThreshold * kHysteresis)
+			lod++;
+
+		return lod;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Scene/MeshSource.h"
+
+/*
+ * Level of detail selection of the mesh instances. A level is drawn while its error, projected on the screen at the
+ * distance of the instance bounds, stays under a pixel threshold. The coarser level is only picked once its error is
+ * under kHysteresis of the threshold, so instances around a switch distance keep their level from frame to frame.
+ */
+namespace Eden::MeshLOD
+{
+	constexpr float kHysteresis = 0.75f;
+	constexpr float kDefaultPixelThreshold = 1.0f;
+
+	struct View
+	{
+		glm::vec3 position = glm::vec3(0.0f);
+		float screenScale = 0.0f; // pixels covered by one unit at a distance of one unit, see GetScreenScale
+		float pixelThreshold = kDefaultPixelThreshold;
+	};
+
+	// From the vertical scale of a perspective projection and the viewport height in pixels
+	inline float GetScreenScale(const glm::mat4& projection, float viewportHeight)
+	{
+		return projection[1][1] * viewportHeight * 0.5f;
+	}
+
+	// Level of the mesh drawn with transform, previousLOD is the level it had the last frame
+	uint32_t Select(const MeshSource::Mesh& mesh, const glm::mat4& transform, const View& view, uint32_t previousLOD);
+}
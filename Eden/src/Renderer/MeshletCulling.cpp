@@ -0,0 +1,46 @@
+#include "MeshletCulling.h"
+
+namespace Eden::MeshletCulling
+{
+	View MakeLocalView(const Math::Frustum& frustum, const glm::vec3& position, const glm::mat4& transform)
+	{
+		// A world plane is dot(plane, transform * p) in vertex space, so it transforms by the transpose
+		View view;
+		glm::mat4 transposed = glm::transpose(transform);
+		for (int p = 0; p < Math::Frustum::kPlaneCount; ++p)
+		{
+			glm::vec4 plane = transposed * frustum.planes[p];
+			float length = glm::length(glm::vec3(plane));
+			view.frustum.planes[p] = length > 0.0f ? plane / length : plane;
+		}
+		view.position = glm::vec3(glm::inverse(transform) * glm::vec4(position, 1.0f));
+		return view;
+	}
+
+	uint32_t Cull(const MeshSource& meshSource, const MeshSource::Submesh& submesh, const View& view, std::vector<IndexRange>& outRanges, Stats& stats)
+	{
+		size_t firstRange = outRanges.size();
+		for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.meshletCount; ++m)
+		{
+			const MeshOptimizer::Meshlet& meshlet = meshSource.meshlets[m];
+			if (!view.frustum.Intersects(Math::BoundingSphere{ meshlet.center, meshlet.radius }))
+			{
+				stats.frustumCulled++;
+				continue;
+			}
+			if (MeshOptimizer::IsBackfacing(meshlet, view.position))
+			{
+				stats.backfaceCulled++;
+				continue;
+			}
+
+			uint32_t indexCount = meshlet.triangleCount * 3;
+			if (outRanges.size() > firstRange && outRanges.back().indexStart + outRanges.back().indexCount == meshlet.indexStart)
+				outRanges.back().indexCount += indexCount;
+			else
+				outRanges.push_back({ meshlet.indexStart, indexCount });
+		}
+		stats.meshlets += submesh.meshletCount;
+		return static_cast<uint32_t>(outRanges.size() - firstRange);
+	}
+}
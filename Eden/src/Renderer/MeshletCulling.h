@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Math/Frustum.h"
+#include "Scene/MeshSource.h"
+
+/*
+ * CPU culling of the meshlets of a full detail submesh, against the frustum and the backface cones of the meshlets.
+ * The meshlets are contiguous in the index buffer, so the visible ones are drawn as index ranges of the submesh.
+ * The tests run in the vertex space of the instance, where the meshlet bounds are, so they hold for any affine transform.
+ */
+namespace Eden::MeshletCulling
+{
+	// Camera of the frame in the vertex space of an instance
+	struct View
+	{
+		Math::Frustum frustum;
+		glm::vec3 position;
+	};
+
+	View MakeLocalView(const Math::Frustum& frustum, const glm::vec3& position, const glm::mat4& transform);
+
+	// Indices of consecutive visible meshlets, drawn with the vertexStart of their submesh
+	struct IndexRange
+	{
+		uint32_t indexStart;
+		uint32_t indexCount;
+	};
+
+	struct Stats
+	{
+		uint32_t meshlets = 0;
+		uint32_t frustumCulled = 0;
+		uint32_t backfaceCulled = 0;
+	};
+
+	// Appends the ranges of the visible meshlets of the submesh to outRanges, returns how many were appended
+	uint32_t Cull(const MeshSource& meshSource, const MeshSource::Submesh& submesh, const View& view, std::vector<IndexRange>& outRanges, Stats& stats);
+}
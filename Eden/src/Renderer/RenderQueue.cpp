@@ -0,0 +1,145 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+namespace Eden
+{
+	static uint64_t QuantizeDepth(float depth, uint32_t bits)
+	{
+		uint64_t maxValue = (1ull << bits) - 1;
+		return static_cast<uint64_t>(glm::clamp(depth, 0.0f, 1.0f) * static_cast<float>(maxValue));
+	}
+
+	uint64_t RenderQueue::MakeSortKey(uint32_t pass, RenderLayer layer, uint32_t pipeline, uint32_t material, uint32_t submesh, float depth)
+	{
+		uint64_t key = (static_cast<uint64_t>(pass & 0xF) << 60) |
+					   (static_cast<uint64_t>(layer & 0x3) << 58) |
+					   (static_cast<uint64_t>(pipeline & 0xFF) << 50);
+
+		if (layer == kRenderLayer_Transparent)
+		{
+			uint64_t invertedDepth = QuantizeDepth(1.0f - depth, 24);
+			key |= (invertedDepth << 26) | (static_cast<uint64_t>(material & 0xFFFF) << 10) | (submesh & 0x3FF);
+		}
+		else
+		{
+			key |= (static_cast<uint64_t>(material & 0xFFFF) << 34) | (static_cast<uint64_t>(submesh & 0x3FFFFF) << 12) | QuantizeDepth(depth, 12);
+		}
+
+		return key;
+	}
+
+	RenderQueue::SortRanks RenderQueue::GetSortRanks(uint32_t meshSourceId, uint32_t materialCount, uint32_t submeshCount)
+	{
+		// The submeshes of a mesh source are queued together, so most lookups hit the last mesh source
+		if (meshSourceId == m_LastMeshSourceId && !m_SortRanks.empty())
+			return m_LastSortRanks;
+
+		auto [it, bInserted] = m_SortRanks.try_emplace(meshSourceId, m_NextSortRanks);
+		if (bInserted)
+		{
+			m_NextSortRanks.material += materialCount;
+			m_NextSortRanks.submesh += submeshCount;
+		}
+		m_LastMeshSourceId = meshSourceId;
+		m_LastSortRanks = it->second;
+		return m_LastSortRanks;
+	}
+
+	void RenderQueue::Clear()
+	{
+		m_Packets.clear();
+		m_Batches.clear();
+		m_SortRanks.clear();
+		m_NextSortRanks = {};
+	}
+
+	// LSD radix sort with 8 bit digits, digits that are the same for every key are skipped
+	void RenderQueue::Sort()
+	{
+		size_t count = m_Packets.size();
+		if (count < 2)
+			return;
+
+		m_SortScratch.resize(count);
+		DrawPacket* source = m_Packets.data();
+		DrawPacket* destination = m_SortScratch.data();
+
+		// Every histogram in one read of the keys
+		uint32_t histograms[8][256] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint64_t key = source[i].sortKey;
+			for (uint32_t digit = 0; digit < 8; ++digit)
+				histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+
+		for (uint32_t digit = 0; digit < 8; ++digit)
+		{
+			uint32_t* histogram = histograms[digit];
+			uint32_t shift = digit * 8;
+			if (histogram[(source[0].sortKey >> shift) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < 256; ++bucket)
+			{
+				uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+				destination[histogram[(source[i].sortKey >> shift) & 0xFF]++] = source[i];
+
+			std::swap(source, destination);
+		}
+
+		if (source != m_Packets.data())
+			m_Packets.swap(m_SortScratch);
+	}
+
+	// Pass and layer are the top 6 bits of the key
+	static uint32_t GetBucket(uint64_t sortKey)
+	{
+		return static_cast<uint32_t>(sortKey >> 58);
+	}
+
+	const DrawPacket* RenderQueue::GetBegin(uint32_t pass, RenderLayer layer) const
+	{
+		uint32_t bucket = (pass << 2) | layer;
+		return std::lower_bound(m_Packets.data(), m_Packets.data() + m_Packets.size(), bucket, [](const DrawPacket& packet, uint32_t value)
+		{
+			return GetBucket(packet.sortKey) < value;
+		});
+	}
+
+	const DrawPacket* RenderQueue::GetEnd(uint32_t pass, RenderLayer layer) const
+	{
+		uint32_t bucket = (pass << 2) | layer;
+		return std::upper_bound(m_Packets.data(), m_Packets.data() + m_Packets.size(), bucket, [](uint32_t value, const DrawPacket& packet)
+		{
+			return value < GetBucket(packet.sortKey);
+		});
+	}
+
+	const DrawBatch* RenderQueue::GetBatchesBegin(uint32_t pass, RenderLayer layer) const
+	{
+		uint32_t bucket = (pass << 2) | layer;
+		return std::lower_bound(m_Batches.data(), m_Batches.data() + m_Batches.size(), bucket, [this](const DrawBatch& batch, uint32_t value)
+		{
+			return GetBucket(m_Packets[batch.firstPacket].sortKey) < value;
+		});
+	}
+
+	const DrawBatch* RenderQueue::GetBatchesEnd(uint32_t pass, RenderLayer layer) const
+	{
+		uint32_t bucket = (pass << 2) | layer;
+		return std::upper_bound(m_Batches.data(), m_Batches.data() + m_Batches.size(), bucket, [this](uint32_t value, const DrawBatch& batch)
+		{
+			return value < GetBucket(m_Packets[batch.firstPacket].sortKey);
+		});
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Eden
+{
+	// Draws are sorted by layer first, opaque geometry is drawn before transparent geometry
+	enum RenderLayer : uint8_t
+	{
+		kRenderLayer_Opaque,
+		kRenderLayer_Transparent,
+	};
+
+	// One submesh draw, the payload indexes the renderer visible meshes and the submeshes of their mesh source
+	struct DrawPacket
+	{
+		uint64_t sortKey;
+		uint32_t visibleMeshIndex;
+		uint32_t submeshIndex;
+	};
+
+	// Consecutive packets drawn with one instanced draw, the instance data of a packet is at the packet index
+	struct DrawBatch
+	{
+		uint32_t firstPacket;
+		uint32_t packetCount;
+	};
+
+	/*
+	 * Draw packets of a frame, radix sorted by their 64 bit key.
+	 * Key layout, from the most significant bit:
+	 *   pass (4) | layer (2) | pipeline (8) | opaque:      material (16) | submesh (22) | depth (12)
+	 *                                       | transparent: inverted depth (24) | material (16) | submesh (10)
+	 * Opaque draws of the same submesh end up next to each other, ordered front to back, so they batch into
+	 * one instanced draw. Transparent draws go back to front and only batch when they are already consecutive.
+	 * Material and submesh are the dense ranks of GetSortRanks, not the global ids: at most 65536 materials and
+	 * 4M submeshes of the mesh sources queued in a frame fit the key, the transparent key keeps the low 10 bits of
+	 * the submesh. Ranks past the limits only alias in the key, the draws stay correct but may batch less.
+	 */
+	class RenderQueue
+	{
+	public:
+		// Ranks of the first material and submesh of a mesh source
+		struct SortRanks
+		{
+			uint32_t material;
+			uint32_t submesh;
+		};
+
+		// Depth is the normalized view distance, in [0, 1]
+		static uint64_t MakeSortKey(uint32_t pass, RenderLayer layer, uint32_t pipeline, uint32_t material, uint32_t submesh, float depth);
+		static uint32_t GetPass(uint64_t sortKey) { return static_cast<uint32_t>(sortKey >> 60); }
+		static uint32_t GetPipeline(uint64_t sortKey) { return static_cast<uint32_t>(sortKey >> 50) & 0xFF; }
+
+		// A mesh source gets the next ranks the first time it's queued in the frame, its material and submesh indices
+		// are added to them, so the ranks stay small however many mesh sources were loaded since the start
+		SortRanks GetSortRanks(uint32_t meshSourceId, uint32_t materialCount, uint32_t submeshCount);
+
+		void Clear();
+		void Add(uint64_t sortKey, uint32_t visibleMeshIndex, uint32_t submeshIndex) { m_Packets.push_back({ sortKey, visibleMeshIndex, submeshIndex }); }
+		void Sort();
+
+		// Merges consecutive sorted packets of the same pass, layer and pipeline that sameBatch(previous, packet) accepts
+		template<typename SameBatch> void BuildBatches(SameBatch&& sameBatch)
+		{
+			m_Batches.clear();
+			for (uint32_t i = 0; i < m_Packets.size(); ++i)
+			{
+				if (i > 0 && (m_Packets[i - 1].sortKey >> 50) == (m_Packets[i].sortKey >> 50) && sameBatch(m_Packets[i - 1], m_Packets[i]))
+					m_Batches.back().packetCount++;
+				else
+					m_Batches.push_back({ i, 1 });
+			}
+		}
+
+		// Packets of one layer of a pass, they are contiguous once sorted
+		const DrawPacket* GetBegin(uint32_t pass, RenderLayer layer) const;
+		const DrawPacket* GetEnd(uint32_t pass, RenderLayer layer) const;
+		const DrawBatch* GetBatchesBegin(uint32_t pass, RenderLayer layer) const;
+		const DrawBatch* GetBatchesEnd(uint32_t pass, RenderLayer layer) const;
+		const std::vector<DrawPacket>& GetPackets() const { return m_Packets; }
+		const std::vector<DrawBatch>& GetBatches() const { return m_Batches; }
+
+	private:
+		std::vector<DrawPacket> m_Packets;
+		std::vector<DrawPacket> m_SortScratch;
+		std::vector<DrawBatch> m_Batches;
+		std::unordered_map<uint32_t, SortRanks> m_SortRanks; // by mesh source id
+		SortRanks m_NextSortRanks = {};
+		uint32_t m_LastMeshSourceId = 0;
+		SortRanks m_LastSortRanks = {};
+	};
+}
@@ -5,6 +5,11 @@
 #include "Scene/Entity.h"
 #include "Core/Application.h"
 #include "Core/CommandLine.h"
+#include "Math/BatchTransform.h"
+#include "Math/Frustum.h"
+#include "Renderer/TextureCache.h"
+#include "Renderer/GeometryBuffers.h"
+#include "Profiling/Timer.h"
 
 namespace Eden
 {
@@ -21,9 +26,11 @@ namespace Eden
 
 		m_Data->window = window;
 		m_Data->camera = Camera(window->GetWidth(), window->GetHeight());
+		// -bake_static_geometry bakes the geometry of every scene when it's loaded
+		m_Data->bIsStaticGeometryBaked = CommandLine::HasArg("bake_static_geometry");
 
 		m_Data->viewMatrix = glm::lookAtLH(m_Data->camera.position, m_Data->camera.position + m_Data->camera.front, m_Data->camera.up);
-		m_Data->projectionMatrix = glm::perspectiveFovLH_ZO(glm::radians(70.0f), (float)window->GetWidth(), (float)window->GetHeight(), 0.1f, 200.0f);
+		m_Data->projectionMatrix = glm::perspectiveFovLH_ZO(glm::radians(70.0f), (float)window->GetWidth(), (float)window->GetHeight(), m_Data->nearPlane, m_Data->farPlane);
 		m_Data->sceneData.view = m_Data->viewMatrix;
 		m_Data->sceneData.viewProjection = m_Data->projectionMatrix * m_Data->viewMatrix;
 		m_Data->sceneData.viewPosition = glm::vec4(m_Data->camera.position, 1.0f);
@@ -55,22 +62,6 @@ namespace Eden
 		UpdateDirectionalLights();
 		UpdatePointLights();
 
-		// Object Picker
-		{
-			RenderPassDesc desc = {};
-			desc.debugName = "ObjectPicker";
-			desc.attachmentsFormats = { Format::kRGBA32_FLOAT, Format::Depth };
-			desc.width = static_cast<uint32_t>(m_Data->viewportSize.x);
-			desc.height = static_cast<uint32_t>(m_Data->viewportSize.y);
-			desc.clearColor = glm::vec4(-1);
-			m_Data->objectPickerPass = RHICreateRenderPass(&desc);
-
-			PipelineDesc pipelineDesc = {};
-			pipelineDesc.programName  = "ObjectPicker";
-			pipelineDesc.renderPass   = m_Data->objectPickerPass;
-			m_Data->pipelines["Object Picker"] = RHICreatePipeline(&pipelineDesc);
-		}
-
 		// Forward Pass
 		{
 			RenderPassDesc desc = {};
@@ -81,10 +72,21 @@ namespace Eden
 			m_Data->forwardPass = RHICreateRenderPass(&desc);
 
 			PipelineDesc forwardDesc    = {};
-			forwardDesc.bEnableBlending = true;
 			forwardDesc.programName     = "ForwardPass";
 			forwardDesc.renderPass      = m_Data->forwardPass;
-			m_Data->pipelines["Forward Rendering"] = RHICreatePipeline(&forwardDesc);
+
+			// Only transparent materials blend, they are drawn back to front after the opaque geometry
+			PipelineDesc transparentDesc    = forwardDesc;
+			transparentDesc.bEnableBlending = true;
+
+			for (uint32_t format = 0; format < static_cast<uint32_t>(VertexFormat::kCount); ++format)
+			{
+				VertexFormat vertexFormat = static_cast<VertexFormat>(format);
+				forwardDesc.vertexFormat = vertexFormat;
+				m_Data->pipelines[RendererData::queuePipelineNames[RendererData::GetQueuePipeline(RendererData::kQueuePipeline_ForwardOpaque, vertexFormat)]] = RHICreatePipeline(&forwardDesc);
+				transparentDesc.vertexFormat = vertexFormat;
+				m_Data->pipelines[RendererData::queuePipelineNames[RendererData::GetQueuePipeline(RendererData::kQueuePipeline_ForwardTransparent, vertexFormat)]] = RHICreatePipeline(&transparentDesc);
+			}
 
 			PipelineDesc skyboxDesc = {};
 			skyboxDesc.cull_mode    = CullMode::kNone;
@@ -109,7 +111,11 @@ namespace Eden
 			deferredBaseDesc.bEnableBlending = true;
 			deferredBaseDesc.programName = "DeferredBasePass";
 			deferredBaseDesc.renderPass = m_Data->deferredBasePass;
-			m_Data->pipelines["Deferred Base Pass"] = RHICreatePipeline(&deferredBaseDesc);
+			for (uint32_t format = 0; format < static_cast<uint32_t>(VertexFormat::kCount); ++format)
+			{
+				deferredBaseDesc.vertexFormat = static_cast<VertexFormat>(format);
+				m_Data->pipelines[RendererData::queuePipelineNames[RendererData::GetQueuePipeline(RendererData::kQueuePipeline_DeferredBase, deferredBaseDesc.vertexFormat)]] = RHICreatePipeline(&deferredBaseDesc);
+			}
 
 			RenderPassDesc lightingDesc = {};
 			desc.debugName = "DeferredLightingPass";
@@ -180,11 +186,12 @@ namespace Eden
 	void Renderer::BeginRender()
 	{
 		PrepareScene();
+		m_Data->currentScene->UpdateSystems();
 
 		// Update camera and scene data
 		m_Data->camera.Update(Application::Get()->GetDeltaTime());
 		m_Data->viewMatrix = glm::lookAtLH(m_Data->camera.position, m_Data->camera.position + m_Data->camera.front, m_Data->camera.up);
-		m_Data->projectionMatrix = glm::perspectiveFovLH(glm::radians(70.0f), m_Data->viewportSize.x, m_Data->viewportSize.y, 0.1f, 200.0f);
+		m_Data->projectionMatrix = glm::perspectiveFovLH(glm::radians(70.0f), m_Data->viewportSize.x, m_Data->viewportSize.y, m_Data->nearPlane, m_Data->farPlane);
 		m_Data->sceneData.view = m_Data->viewMatrix;
 		m_Data->sceneData.viewProjection = m_Data->projectionMatrix * m_Data->viewMatrix;
 		m_Data->sceneData.viewPosition = glm::vec4(m_Data->camera.position, 1.0f);
@@ -192,6 +199,8 @@ namespace Eden
 
 		UpdateDirectionalLights();
 		UpdatePointLights();
+		CullScene();
+		BuildRenderQueue();
 
 		RHIBeginRender();
 	}
@@ -200,9 +209,6 @@ namespace Eden
 	{
 		RHIBeginGPUTimer(m_Data->renderTimer);
 
-#if WITH_EDITOR
-		ObjectPickerPass();
-#endif
 		if (m_Data->bIsDeferredEnabled)
 			DeferredRenderingPass();
 		else
@@ -221,6 +227,9 @@ namespace Eden
 	{
 		edelete m_Data->currentScene;
 		edelete m_Data;
+		MeshAssetRegistry::Shutdown();
+		TextureCache::Shutdown();
+		GeometryBuffers::Shutdown();
 
 		RHIShutdown();
 	}
@@ -239,7 +248,7 @@ namespace Eden
 		pointLightComponents.fill(emptyPl);
 
 		auto pointLights = m_Data->currentScene->GetAllEntitiesWith<PointLightComponent>();
-		for (int i = 0; i < pointLights.size(); ++i)
+		for (int i = 0; i < pointLights.size() && i < m_Data->MAX_POINT_LIGHTS; ++i)
 		{
 			Entity e = { pointLights[i], m_Data->currentScene };
 			PointLightComponent& pl = e.GetComponent<PointLightComponent>();
@@ -259,7 +268,7 @@ namespace Eden
 		directional_lightComponents.fill(emptyDl);
 
 		auto directional_lights = m_Data->currentScene->GetAllEntitiesWith<DirectionalLightComponent>();
-		for (int i = 0; i < directional_lights.size(); ++i)
+		for (int i = 0; i < directional_lights.size() && i < m_Data->MAX_DIRECTIONAL_LIGHTS; ++i)
 		{
 			Entity e = { directional_lights[i], m_Data->currentScene };
 			DirectionalLightComponent& pl = e.GetComponent<DirectionalLightComponent>();
@@ -273,75 +282,382 @@ namespace Eden
 		RHIUpdateBufferData(m_Data->directionalLightsBuffer, data);
 	}
 	
-	void Renderer::ObjectPickerPass()
+	void Renderer::CullScene()
 	{
-		auto entitiesToRender = m_Data->currentScene->GetAllEntitiesWith<MeshComponent>();
+		Timer timer;
+		timer.Record();
+
+		auto& stats = m_Data->cullingStats;
+		stats = {};
+		m_Data->visibleMeshes.clear();
+
+		Math::Frustum frustum = Math::Frustum::FromViewProjection(m_Data->sceneData.viewProjection);
+		bool bCull = m_Data->bIsFrustumCullingEnabled;
+
+		// Entity level, the spatial tree gives the entities whose fat bounds intersect the frustum and they are
+		// refined with their world AABB, point lights are also in the tree so they are skipped here
+		auto view = m_Data->currentScene->GetAllEntitiesWith<MeshComponent, WorldTransformComponent, BoundsComponent>();
+		auto& entities = m_Data->cullingEntities;
+		entities.clear();
+		if (bCull)
+		{
+			m_Data->currentScene->GetSpatialTree().Query(frustum, [&](uint32_t userData)
+			{
+				entt::entity entity = static_cast<entt::entity>(userData);
+				if (view.contains(entity) && frustum.Intersects(view.get<BoundsComponent>(entity).worldBounds))
+					entities.emplace_back(entity);
+				return true;
+			});
+
+			// The entities with valid bounds that the frustum rejected
+			uint32_t boundedCount = 0;
+			for (auto entity : view)
+				boundedCount += view.get<BoundsComponent>(entity).worldBounds.IsValid() ? 1 : 0;
+			stats.culledEntities = boundedCount - static_cast<uint32_t>(entities.size());
+		}
+		else
+		{
+			for (auto entity : view)
+			{
+				if (view.get<BoundsComponent>(entity).worldBounds.IsValid())
+					entities.emplace_back(entity);
+			}
+		}
 
-		RHIBeginRenderPass(m_Data->objectPickerPass);
-		RHIBindPipeline(m_Data->pipelines["Object Picker"]);
-		for (auto entity : entitiesToRender)
+		// Levels of detail are picked from the projected size of the mesh bounds, each instance keeps its level for the hysteresis
+		MeshLOD::View lodView;
+		lodView.position = m_Data->camera.position;
+		lodView.screenScale = MeshLOD::GetScreenScale(m_Data->projectionMatrix, m_Data->viewportSize.y);
+		lodView.pixelThreshold = m_Data->lodPixelThreshold;
+		bool bSelectLODs = m_Data->bIsMeshLODEnabled;
+		auto selectLOD = [&](MeshComponent& mc, size_t instanceIndex, const MeshSource::Mesh& mesh, const glm::mat4& transform)
 		{
-			Entity e = { entity, m_Data->currentScene };
-			MeshSource* ms = e.GetComponent<MeshComponent>().meshSource.Get();
+			uint8_t& lod = mc.instanceLODs[instanceIndex];
+			lod = bSelectLODs ? static_cast<uint8_t>(MeshLOD::Select(mesh, transform, lodView, lod)) : 0;
+			stats.simplifiedMeshes += lod > 0 ? 1 : 0;
+			return lod;
+		};
+
+		// Mesh instance level, only needed when the mesh source has more than one instance
+		auto& meshBounds = m_Data->cullingMeshBounds;
+		auto& meshVisibility = m_Data->cullingMeshVisibility;
+		for (entt::entity entity : entities)
+		{
+			MeshComponent& mc = view.get<MeshComponent>(entity);
+			MeshSource* ms = mc.meshSource.Get();
 			if (!ms->bHasMesh)
 				continue;
-			TransformComponent tc = e.GetComponent<TransformComponent>();
+			stats.visibleEntities++;
+
+			const glm::mat4& worldTransform = view.get<WorldTransformComponent>(entity).transform;
+			mc.instanceLODs.resize(ms->instances.size());
 
-			RHIBindVertexBuffer(ms->meshVb);
-			RHIBindIndexBuffer(ms->meshIb);
-			for (auto& mesh : ms->meshes)
+			// Entities of an expanded model draw one instance, it was culled with the entity and its node transform is the world transform
+			if (mc.instance != MeshComponent::kAllInstances)
 			{
-				auto transform = tc.GetTransform();
-				transform *= mesh->modelMatrix;
+				if (const MeshSource::MeshInstance* instance = mc.GetInstance())
+				{
+					const MeshSource::Mesh& mesh = ms->meshes[instance->mesh];
+					uint32_t lod = selectLOD(mc, static_cast<size_t>(mc.instance), mesh, worldTransform);
+					m_Data->visibleMeshes.push_back({ entity, ms, mesh.firstSubmesh, mesh.submeshCount, lod, worldTransform });
+					stats.visibleMeshes++;
+				}
+				continue;
+			}
 
-				RHIBindParameter("SceneData", m_Data->sceneDataCB);
-				RHIBindParameter("Transform", &transform, sizeof(glm::mat4));
-				RHIBindParameter("ObjectID", &entity, sizeof(uint32_t));
+			size_t meshCount = ms->instances.size();
+			bool bCullMeshes = bCull && meshCount > 1;
+			if (bCullMeshes)
+			{
+				meshBounds.resize(meshCount);
+				for (size_t m = 0; m < meshCount; ++m)
+					meshBounds[m] = Math::TransformAABB(ms->instances[m].bounds, worldTransform);
 
-				for (auto& submesh : mesh->submeshes)
-					RHIDrawIndexed(submesh->indexCount, 1, submesh->indexStart);
+				meshVisibility.resize(meshCount);
+				Math::CullAABBs(frustum, meshBounds.data(), meshCount, meshVisibility.data());
+			}
+
+			for (size_t m = 0; m < meshCount; ++m)
+			{
+				if (bCullMeshes && !meshVisibility[m])
+				{
+					stats.culledMeshes++;
+					continue;
+				}
+
+				const MeshSource::MeshInstance& instance = ms->instances[m];
+				const MeshSource::Mesh& mesh = ms->meshes[instance.mesh];
+				glm::mat4 transform = Math::MultiplyTransform(worldTransform, instance.modelMatrix);
+				uint32_t lod = selectLOD(mc, m, mesh, transform);
+				m_Data->visibleMeshes.push_back({ entity, ms, mesh.firstSubmesh, mesh.submeshCount, lod, transform });
+				stats.visibleMeshes++;
 			}
 		}
-		RHIEndRenderPass(m_Data->objectPickerPass);
+
+		stats.cullingTime = timer.ElapsedMilliseconds();
 	}
 
-	void Renderer::DeferredRenderingPass()
+	void Renderer::BuildRenderQueue()
 	{
-		auto entitiesToRender = m_Data->currentScene->GetAllEntitiesWith<MeshComponent>();
+		Timer timer;
+		timer.Record();
 
-		// Deferred Base Pass
-		RHIBeginRenderPass(m_Data->deferredBasePass);
-		RHIBindPipeline(m_Data->pipelines["Deferred Base Pass"]);
-		for (auto entity : entitiesToRender)
+		auto& queue = m_Data->renderQueue;
+		queue.Clear();
+
+		bool bDeferred = m_Data->bIsDeferredEnabled;
+		uint32_t pass = bDeferred ? RendererData::kQueuePass_DeferredBase : RendererData::kQueuePass_Forward;
+		glm::vec3 cameraPosition = m_Data->camera.position;
+		float inverseFarPlane = 1.0f / m_Data->farPlane;
+		uint32_t triangles = 0;
+		uint32_t fullDetailTriangles = 0;
+
+		// The G-buffer can't blend, so the deferred pass only gets the back to front order of transparent materials
+		for (uint32_t m = 0; m < m_Data->visibleMeshes.size(); ++m)
 		{
-			Entity e = { entity, m_Data->currentScene };
-			MeshSource* ms = e.GetComponent<MeshComponent>().meshSource.Get();
-			if (!ms->bHasMesh)
-				continue;
-			TransformComponent tc = e.GetComponent<TransformComponent>();
+			const auto& visibleMesh = m_Data->visibleMeshes[m];
+			const MeshSource* ms = visibleMesh.meshSource;
+			RenderQueue::SortRanks ranks = queue.GetSortRanks(ms->id, static_cast<uint32_t>(ms->materials.size()), static_cast<uint32_t>(ms->submeshes.size()));
+			for (uint32_t s = visibleMesh.firstSubmesh; s < visibleMesh.firstSubmesh + visibleMesh.submeshCount; ++s)
+			{
+				const MeshSource::Submesh& submesh = ms->submeshes[s];
+				const PBRMaterial& material = ms->materials[submesh.material];
+				RenderLayer layer = material.bIsTransparent ? kRenderLayer_Transparent : kRenderLayer_Opaque;
+				RendererData::QueuePipeline queuePipeline = bDeferred ? RendererData::kQueuePipeline_DeferredBase :
+					(material.bIsTransparent ? RendererData::kQueuePipeline_ForwardTransparent : RendererData::kQueuePipeline_ForwardOpaque);
+				uint32_t pipeline = RendererData::GetQueuePipeline(queuePipeline, ms->vertexFormat);
+
+				glm::vec3 center = glm::vec3(visibleMesh.transform * glm::vec4(submesh.bounds.GetCenter(), 1.0f));
+				float depth = glm::distance(cameraPosition, center) * inverseFarPlane;
+
+				uint64_t sortKey = RenderQueue::MakeSortKey(pass, layer, pipeline, ranks.material + submesh.material, ranks.submesh + s, depth);
+				queue.Add(sortKey, m, s);
+				triangles += ms->GetLOD(submesh, visibleMesh.lod).indexCount / 3;
+				fullDetailTriangles += submesh.indexCount / 3;
+			}
+		}
+		queue.Sort();
+
+		// Meshlets are culled in the space of each instance, the instance transform is in the visible mesh
+		const auto& packets = queue.GetPackets();
+		auto& packetMeshlets = m_Data->packetMeshlets;
+		auto& meshletRanges = m_Data->meshletRanges;
+		packetMeshlets.clear();
+		meshletRanges.clear();
+		MeshletCulling::Stats meshletStats;
+		if (m_Data->bIsMeshletCullingEnabled)
+		{
+			Math::Frustum frustum = Math::Frustum::FromViewProjection(m_Data->sceneData.viewProjection);
+			MeshletCulling::View meshletView;
+			uint32_t meshletViewMesh = UINT32_MAX;
+			packetMeshlets.assign(packets.size(), { UINT32_MAX, 0 });
+			for (size_t i = 0; i < packets.size(); ++i)
+			{
+				const auto& visibleMesh = m_Data->visibleMeshes[packets[i].visibleMeshIndex];
+				const MeshSource::Submesh& submesh = visibleMesh.meshSource->submeshes[packets[i].submeshIndex];
+				if (visibleMesh.lod != 0 || submesh.meshletCount == 0)
+					continue;
 
-			RHIBindVertexBuffer(ms->meshVb);
-			RHIBindIndexBuffer(ms->meshIb);
-			for (auto& mesh : ms->meshes)
+				if (packets[i].visibleMeshIndex != meshletViewMesh)
+				{
+					meshletView = MeshletCulling::MakeLocalView(frustum, cameraPosition, visibleMesh.transform);
+					meshletViewMesh = packets[i].visibleMeshIndex;
+				}
+
+				uint32_t firstRange = static_cast<uint32_t>(meshletRanges.size());
+				uint32_t rangeCount = MeshletCulling::Cull(*visibleMesh.meshSource, submesh, meshletView, meshletRanges, meshletStats);
+				packetMeshlets[i] = { firstRange, rangeCount };
+
+				uint32_t visibleIndices = 0;
+				for (uint32_t r = firstRange; r < firstRange + rangeCount; ++r)
+					visibleIndices += meshletRanges[r].indexCount;
+				triangles -= (submesh.indexCount - visibleIndices) / 3;
+			}
+		}
+		auto hasMeshletRanges = [&](const DrawPacket& packet) { return !packetMeshlets.empty() && packetMeshlets[static_cast<size_t>(&packet - packets.data())].firstRange != UINT32_MAX; };
+
+		// Every run of the same submesh at the same level of detail becomes one instanced draw. The levels of a
+		// submesh follow the depth order, so its instances at one level are mostly next to each other.
+		auto getSubmesh = [](const DrawPacket& packet)
+		{
+			return &m_Data->visibleMeshes[packet.visibleMeshIndex].meshSource->submeshes[packet.submeshIndex];
+		};
+		auto getIndexStart = [](const DrawPacket& packet)
+		{
+			const auto& visibleMesh = m_Data->visibleMeshes[packet.visibleMeshIndex];
+			return visibleMesh.meshSource->GetLOD(visibleMesh.meshSource->submeshes[packet.submeshIndex], visibleMesh.lod).indexStart;
+		};
+		queue.BuildBatches([&](const DrawPacket& previous, const DrawPacket& packet)
+		{
+			return getSubmesh(previous) == getSubmesh(packet) && getIndexStart(previous) == getIndexStart(packet) && !hasMeshletRanges(previous) && !hasMeshletRanges(packet);
+		});
+
+		// Instance data goes in packet order, a batch reads its instances from its first packet onwards
+		auto& instances = m_Data->instances;
+		instances.resize(packets.size());
+		for (size_t i = 0; i < packets.size(); ++i)
+		{
+			const auto& visibleMesh = m_Data->visibleMeshes[packets[i].visibleMeshIndex];
+			instances[i].transform = visibleMesh.transform;
+			instances[i].objectId = entt::to_integral(visibleMesh.entity);
+		}
+
+		uint32_t instanceCount = static_cast<uint32_t>(instances.size());
+		if (instanceCount > m_Data->instanceBufferCapacity)
+		{
+			// The GPU is idle between frames, so the old buffer can be released right away
+			uint32_t capacity = glm::max(m_Data->instanceBufferCapacity, 1024u);
+			while (capacity < instanceCount)
+				capacity *= 2;
+
+			BufferDesc desc = {};
+			desc.elementCount = capacity;
+			desc.stride = sizeof(RendererData::InstanceData);
+			desc.usage = BufferDesc::Storage;
+			m_Data->instanceBuffer = RHICreateBuffer(&desc, nullptr);
+			m_Data->instanceBufferCapacity = capacity;
+		}
+		if (instanceCount > 0)
+			RHIUpdateBufferData(m_Data->instanceBuffer, instances.data(), instanceCount);
+
+		// The draw counters are filled when the queue is drawn
+		m_Data->renderQueueStats = {};
+		m_Data->renderQueueStats.instances = instanceCount;
+		m_Data->renderQueueStats.triangles = triangles;
+		m_Data->renderQueueStats.fullDetailTriangles = fullDetailTriangles;
+		m_Data->renderQueueStats.meshlets = meshletStats.meshlets;
+		m_Data->renderQueueStats.culledMeshlets = meshletStats.frustumCulled + meshletStats.backfaceCulled;
+		m_Data->renderQueueStats.buildTime = timer.ElapsedMilliseconds();
+	}
+
+	void Renderer::DrawRenderQueue(RendererData::QueuePass pass, RenderLayer layer)
+	{
+		auto& stats = m_Data->renderQueueStats;
+		const auto& packets = m_Data->renderQueue.GetPackets();
+
+		// Only the state that changes between two batches is bound
+		uint32_t boundPipeline = UINT32_MAX;
+		MeshSource* boundMeshSource = nullptr;
+		const Buffer* boundVertexBuffer = nullptr;
+		const Buffer* boundIndexBuffer = nullptr;
+		uint32_t boundMaterial = UINT32_MAX;
+		uint32_t vertexOffset = 0;
+		uint32_t indexOffset = 0;
+
+		// Only the last stream is compared, the position stream of kSplit is in the same page or buffer set
+		auto bindGeometry = [&](VertexFormat vertexFormat, const BufferRef& positionBuffer, const BufferRef& vertexBuffer, const BufferRef& indexBuffer)
+		{
+			if (vertexBuffer.Get() == boundVertexBuffer && indexBuffer.Get() == boundIndexBuffer)
+				return;
+
+			if (vertexFormat == VertexFormat::kSplit)
 			{
-				glm::mat4 transform = tc.GetTransform();
-				transform *= mesh->modelMatrix;
+				RHIBindVertexBuffer(positionBuffer, 0);
+				RHIBindVertexBuffer(vertexBuffer, 1);
+			}
+			else
+			{
+				RHIBindVertexBuffer(vertexBuffer);
+			}
+			RHIBindIndexBuffer(indexBuffer);
+			boundVertexBuffer = vertexBuffer.Get();
+			boundIndexBuffer = indexBuffer.Get();
+			stats.meshBinds++;
+		};
 
+		const DrawBatch* end = m_Data->renderQueue.GetBatchesEnd(pass, layer);
+		for (const DrawBatch* batch = m_Data->renderQueue.GetBatchesBegin(pass, layer); batch != end; ++batch)
+		{
+			const DrawPacket& packet = packets[batch->firstPacket];
+			auto& visibleMesh = m_Data->visibleMeshes[packet.visibleMeshIndex];
+			const MeshSource::Submesh& submesh = visibleMesh.meshSource->submeshes[packet.submeshIndex];
+
+			uint32_t pipeline = RenderQueue::GetPipeline(packet.sortKey);
+			if (pipeline != boundPipeline)
+			{
+				// Binding a pipeline resets the root parameters, the per pass ones only need binding once after it
+				RHIBindPipeline(m_Data->pipelines[RendererData::queuePipelineNames[pipeline]]);
 				RHIBindParameter("SceneData", m_Data->sceneDataCB);
-				RHIBindParameter("Transform", &transform, sizeof(glm::mat4));
+				RHIBindParameter("DirectionalLights", m_Data->directionalLightsBuffer);
+				RHIBindParameter("PointLights", m_Data->pointLightsBuffer);
+				RHIBindParameter("Instances", m_Data->instanceBuffer);
+				boundPipeline = pipeline;
+				boundMaterial = UINT32_MAX;
+				stats.pipelineBinds++;
+			}
+
+			// Mesh sources share the pages of the geometry buffers, baked ones the buffers of their set
+			if (visibleMesh.meshSource != boundMeshSource)
+			{
+				MeshSource* ms = visibleMesh.meshSource;
+				if (const StaticGeometry::Placement* placement = m_Data->staticGeometry.Find(*ms))
+				{
+					const StaticGeometry::BufferSet& set = m_Data->staticGeometry.GetBufferSets()[placement->bufferSet];
+					bindGeometry(set.vertexFormat, set.positionBuffer, set.vertexBuffer, set.indexBuffer);
+					vertexOffset = placement->vertexOffset;
+					indexOffset = placement->indexOffset;
+				}
+				else
+				{
+					const GeometrySlice& vertices = ms->vertexSlice;
+					bindGeometry(ms->vertexFormat, vertices.buffers[0], vertices.buffers[vertices.streamCount - 1], ms->indexSlice.buffers[0]);
+					vertexOffset = vertices.offset;
+					indexOffset = ms->indexSlice.offset;
+				}
+				boundMeshSource = ms;
+			}
+			uint32_t vertexStart = submesh.vertexStart + vertexOffset;
+
+			const PBRMaterial& material = visibleMesh.meshSource->materials[submesh.material];
+			if (material.id != boundMaterial)
+			{
+				RHIBindParameter("g_AlbedoMap", material.albedoMap);
+				RHIBindParameter("g_NormalMap", material.normalMap);
+				RHIBindParameter("g_AOMap", material.AOMap);
+				RHIBindParameter("g_EmissiveMap", material.emissiveMap);
+				RHIBindParameter("g_MetallicRoughnessMap", material.metallicRoughnessMap);
+				glm::vec4 baseColor = material.baseColor;
+				RHIBindParameter("MaterialData", &baseColor, sizeof(glm::vec4));
+				boundMaterial = material.id;
+				stats.materialBinds++;
+			}
+
+			// SV_InstanceID doesn't include the start instance, so the offset goes in a root constant
+			uint32_t instanceOffset = batch->firstPacket;
+			RHIBindParameter("InstanceOffset", &instanceOffset, sizeof(uint32_t));
+
+			// Compact positions are decoded inside the submesh bounds
+			if (visibleMesh.meshSource->vertexFormat == VertexFormat::kCompact)
+			{
+				glm::vec4 positionRange[2] = { glm::vec4(submesh.bounds.min, 0.0f), glm::vec4(submesh.bounds.max - submesh.bounds.min, 0.0f) };
+				RHIBindParameter("SubmeshData", positionRange, sizeof(positionRange));
+			}
 
-				for (auto& submesh : mesh->submeshes)
+			// Packets culled by meshlet are batches of their own
+			const auto& packetMeshlets = m_Data->packetMeshlets;
+			if (!packetMeshlets.empty() && packetMeshlets[batch->firstPacket].firstRange != UINT32_MAX)
+			{
+				const RendererData::PacketMeshlets& ranges = packetMeshlets[batch->firstPacket];
+				for (uint32_t r = ranges.firstRange; r < ranges.firstRange + ranges.rangeCount; ++r)
 				{
-					RHIBindParameter("g_AlbedoMap", submesh->material.albedoMap);
-					RHIBindParameter("g_NormalMap", submesh->material.normalMap);
-					RHIBindParameter("g_AOMap", submesh->material.AOMap);
-					RHIBindParameter("g_EmissiveMap", submesh->material.emissiveMap);
-					RHIBindParameter("g_MetallicRoughnessMap", submesh->material.metallicRoughnessMap);
-					RHIDrawIndexed(submesh->indexCount, 1, submesh->indexStart);
+					RHIDrawIndexed(m_Data->meshletRanges[r].indexCount, 1, m_Data->meshletRanges[r].indexStart + indexOffset, vertexStart);
+					stats.drawCalls++;
 				}
+				continue;
 			}
+
+			MeshSource::SubmeshLOD lod = visibleMesh.meshSource->GetLOD(submesh, visibleMesh.lod);
+			RHIDrawIndexed(lod.indexCount, batch->packetCount, lod.indexStart + indexOffset, vertexStart);
+			stats.drawCalls++;
 		}
+	}
 
+	void Renderer::DeferredRenderingPass()
+	{
+		// Deferred Base Pass
+		RHIBeginRenderPass(m_Data->deferredBasePass);
+		DrawRenderQueue(RendererData::kQueuePass_DeferredBase, kRenderLayer_Opaque);
+		DrawRenderQueue(RendererData::kQueuePass_DeferredBase, kRenderLayer_Transparent);
 		RHIEndRenderPass(m_Data->deferredBasePass);
 
 		RHIBeginRenderPass(m_Data->deferredLightingPass);
@@ -369,42 +685,9 @@ namespace Eden
 
 	void Renderer::ForwardRenderingPass()
 	{
-		auto entitiesToRender = m_Data->currentScene->GetAllEntitiesWith<MeshComponent>();
-
 		// Forward Pass
 		RHIBeginRenderPass(m_Data->forwardPass);
-		RHIBindPipeline(m_Data->pipelines["Forward Rendering"]);
-		for (auto entity : entitiesToRender)
-		{
-			Entity e = { entity, m_Data->currentScene };
-			MeshSource* ms = e.GetComponent<MeshComponent>().meshSource.Get();
-			if (!ms->bHasMesh)
-				continue;
-			TransformComponent tc = e.GetComponent<TransformComponent>();
-
-			RHIBindVertexBuffer(ms->meshVb);
-			RHIBindIndexBuffer(ms->meshIb);
-			for (auto& mesh : ms->meshes)
-			{
-				auto transform = tc.GetTransform();
-				transform *= mesh->modelMatrix;
-
-				RHIBindParameter("SceneData", m_Data->sceneDataCB);
-				RHIBindParameter("Transform", &transform, sizeof(glm::mat4));
-				RHIBindParameter("DirectionalLights", m_Data->directionalLightsBuffer);
-				RHIBindParameter("PointLights", m_Data->pointLightsBuffer);
-
-				for (auto& submesh : mesh->submeshes)
-				{
-					RHIBindParameter("g_AlbedoMap", submesh->material.albedoMap);
-					RHIBindParameter("g_NormalMap", submesh->material.normalMap);
-					RHIBindParameter("g_AOMap", submesh->material.AOMap);
-					RHIBindParameter("g_EmissiveMap", submesh->material.emissiveMap);
-					RHIBindParameter("g_MetallicRoughnessMap", submesh->material.metallicRoughnessMap);
-					RHIDrawIndexed(submesh->indexCount, 1, submesh->indexStart);
-				}
-			}
-		}
+		DrawRenderQueue(RendererData::kQueuePass_Forward, kRenderLayer_Opaque);
 
 		// Skybox
 		if (m_Data->bIsSkyboxEnabled)
@@ -412,6 +695,9 @@ namespace Eden
 			RHIBindPipeline(m_Data->pipelines["Skybox"]);
 			m_Data->skybox->Render(m_Data->projectionMatrix * glm::mat4(glm::mat3(m_Data->viewMatrix)));
 		}
+
+		// Transparent geometry blends over the skybox
+		DrawRenderQueue(RendererData::kQueuePass_Forward, kRenderLayer_Transparent);
 		RHIEndRenderPass(m_Data->forwardPass);
 	}
 
@@ -467,10 +753,26 @@ namespace Eden
 			m_Data->currentScene->SetScenePath(sceneToLoad);
 		}
 
+		// Meshes and textures of the previous scene that the new one doesn't use, its bake is released before them
+		m_Data->staticGeometry.Clear();
+		MeshAssetRegistry::CollectGarbage();
+		TextureCache::CollectGarbage();
+		if (m_Data->bIsStaticGeometryBaked)
+			BakeStaticGeometry();
+
 		m_Data->currentScene->SetSceneLoaded(true);
 		Application::Get()->ChangeWindowTitle(m_Data->currentScene->GetName());
 	}
 
+	void Renderer::BakeStaticGeometry()
+	{
+		std::vector<const MeshSource*> meshSources;
+		auto view = m_Data->currentScene->GetAllEntitiesWith<MeshComponent>();
+		for (auto entity : view)
+			meshSources.push_back(view.get<MeshComponent>(entity).meshSource.Get());
+		m_Data->staticGeometry.Bake(meshSources);
+	}
+
 	void Renderer::NewScene()
 	{
 		m_Data->currentScene->SetScenePath("");
@@ -533,8 +835,6 @@ namespace Eden
 			m_Data->forwardPass->desc.height = (uint32_t)y;
 			m_Data->sceneComposite->desc.width = (uint32_t)x;
 			m_Data->sceneComposite->desc.height = (uint32_t)y;
-			m_Data->objectPickerPass->desc.width = (uint32_t)x;
-			m_Data->objectPickerPass->desc.height = (uint32_t)y;
 			m_Data->deferredBasePass->desc.width = (uint32_t)x;
 			m_Data->deferredBasePass->desc.height = (uint32_t)y;
 			m_Data->deferredLightingPass->desc.width = (uint32_t)x;
@@ -568,6 +868,49 @@ namespace Eden
 		return m_Data->bIsDeferredEnabled;
 	}
 
+	bool& Renderer::IsFrustumCullingEnabled()
+	{
+		return m_Data->bIsFrustumCullingEnabled;
+	}
+
+	bool& Renderer::IsMeshLODEnabled()
+	{
+		return m_Data->bIsMeshLODEnabled;
+	}
+
+	float& Renderer::GetLODPixelThreshold()
+	{
+		return m_Data->lodPixelThreshold;
+	}
+
+	bool& Renderer::IsMeshletCullingEnabled()
+	{
+		return m_Data->bIsMeshletCullingEnabled;
+	}
+
+	void Renderer::SetStaticGeometryBaked(bool bBaked)
+	{
+		// The buffers of the bake can be in use by the frame being recorded, they change before the next one
+		m_Data->bIsStaticGeometryBaked = bBaked;
+		m_Data->currentScene->AddPreparation([bBaked]()
+		{
+			if (bBaked)
+				BakeStaticGeometry();
+			else
+				m_Data->staticGeometry.Clear();
+		});
+	}
+
+	bool Renderer::IsStaticGeometryBaked()
+	{
+		return m_Data->bIsStaticGeometryBaked;
+	}
+
+	const StaticGeometry& Renderer::GetStaticGeometry()
+	{
+		return m_Data->staticGeometry;
+	}
+
 	void Renderer::SetNewSkybox(const char* path)
 	{
 		m_Data->skybox->SetNewTexture(path);
@@ -583,6 +926,16 @@ namespace Eden
 		return m_Data->renderTimer;
 	}
 
+	const RendererData::CullingStats& Renderer::GetCullingStats()
+	{
+		return m_Data->cullingStats;
+	}
+
+	const RendererData::RenderQueueStats& Renderer::GetRenderQueueStats()
+	{
+		return m_Data->renderQueueStats;
+	}
+
 	glm::mat4 Renderer::GetViewMatrix()
 	{
 		return m_Data->viewMatrix;
@@ -593,11 +946,6 @@ namespace Eden
 		return m_Data->projectionMatrix;
 	}
 	
-	void Renderer::GetPixel(uint32_t x, uint32_t y, glm::vec4& pixel)
-	{
-		RHIReadPixelFromTexture(x, y, m_Data->objectPickerPass->colorAttachments[0], pixel);
-	}
-
 	TextureRef Renderer::GetFinalImage()
 	{
 		return m_Data->sceneComposite->colorAttachments[0];
@@ -7,7 +7,12 @@
 #include "RHI/DynamicRHI.h"
 #include "Core/Camera.h"
 #include "Renderer/Skybox.h"
+#include "Renderer/RenderQueue.h"
+#include "Renderer/MeshLOD.h"
+#include "Renderer/MeshletCulling.h"
+#include "Renderer/StaticGeometry.h"
 #include "Scene/SceneSerializer.h"
+#include "Scene/MeshSource.h"
 
 namespace Eden
 {
@@ -37,6 +42,8 @@ namespace Eden
 		// TODO: probably add these two to the camera
 		glm::mat4 viewMatrix;
 		glm::mat4 projectionMatrix;
+		float nearPlane = 0.1f;
+		float farPlane = 200.0f;
 		SceneData sceneData;
 		BufferRef sceneDataCB;
 		Camera camera;
@@ -48,12 +55,112 @@ namespace Eden
 		// Scene
 		Scene* currentScene = nullptr;
 
+		//==================
+		// Culling
+		//==================
+		// Built once per frame in BeginRender and shared by every geometry pass.
+		// The meshes of an entity are contiguous, so passes only bind buffers when the mesh source changes
+		struct VisibleMesh
+		{
+			entt::entity entity;
+			MeshSource* meshSource;
+			uint32_t firstSubmesh; // range of meshSource->submeshes
+			uint32_t submeshCount;
+			uint32_t lod; // level of detail of every submesh, see MeshSource::GetLOD
+			glm::mat4 transform; // world transform * model matrix of the mesh instance
+		};
+		std::vector<VisibleMesh> visibleMeshes;
+		bool bIsFrustumCullingEnabled = true;
+		bool bIsMeshLODEnabled = true;
+		float lodPixelThreshold = MeshLOD::kDefaultPixelThreshold;
+
+		struct CullingStats
+		{
+			uint32_t visibleEntities = 0;
+			uint32_t culledEntities = 0;
+			uint32_t visibleMeshes = 0;
+			uint32_t culledMeshes = 0; // meshes of visible entities culled with their node bounds
+			uint32_t simplifiedMeshes = 0; // visible meshes drawn with a simplified level of detail
+			float cullingTime = 0.0f; // in milliseconds
+		} cullingStats;
+
+		// Scratch memory used by the culling, kept around to avoid allocating every frame
+		std::vector<entt::entity> cullingEntities;
+		std::vector<Math::AABB> cullingMeshBounds;
+		std::vector<uint8_t> cullingMeshVisibility;
+
+		//==================
+		// Render Queue
+		//==================
+		// Every visible submesh becomes a draw packet, the geometry passes draw their packets in sort key order
+		enum QueuePass : uint8_t
+		{
+			kQueuePass_Forward,
+			kQueuePass_DeferredBase,
+		};
+
+		enum QueuePipeline : uint8_t
+		{
+			kQueuePipeline_ForwardOpaque,
+			kQueuePipeline_ForwardTransparent,
+			kQueuePipeline_DeferredBase,
+			kQueuePipeline_Count
+		};
+		// Every queue pipeline exists once per vertex format, the mesh source picks the variant
+		static constexpr uint32_t kQueuePipelineVariantCount = kQueuePipeline_Count * static_cast<uint32_t>(VertexFormat::kCount);
+		static uint32_t GetQueuePipeline(QueuePipeline pipeline, VertexFormat vertexFormat) { return static_cast<uint32_t>(vertexFormat) * kQueuePipeline_Count + pipeline; }
+		// Keys of the pipelines map, which hashes the pointer, so the pipelines are created with these same strings
+		static constexpr const char* queuePipelineNames[kQueuePipelineVariantCount] = { "Forward Rendering", "Forward Rendering Transparent", "Deferred Base Pass",
+																						"Forward Rendering Compact", "Forward Rendering Transparent Compact", "Deferred Base Pass Compact",
+																						"Forward Rendering Split", "Forward Rendering Transparent Split", "Deferred Base Pass Split" };
+
+		RenderQueue renderQueue;
+
+		// Full detail submeshes with meshlets draw the index ranges of their visible meshlets, every packet on its own.
+		// packetMeshlets is indexed like the sorted packets, the ones with firstRange UINT32_MAX draw the whole submesh.
+		struct PacketMeshlets
+		{
+			uint32_t firstRange; // in meshletRanges
+			uint32_t rangeCount;
+		};
+		bool bIsMeshletCullingEnabled = false;
+		std::vector<PacketMeshlets> packetMeshlets;
+		std::vector<MeshletCulling::IndexRange> meshletRanges;
+
+		// Per instance data of every packet in the render queue, matches InstanceData in Global.hlsli
+		struct InstanceData
+		{
+			glm::mat4 transform;
+			uint32_t objectId;
+			uint32_t padding[3];
+		};
+		std::vector<InstanceData> instances;
+		BufferRef instanceBuffer;
+		uint32_t instanceBufferCapacity = 0;
+
+		struct RenderQueueStats
+		{
+			uint32_t drawCalls = 0; // instanced draws
+			uint32_t instances = 0;
+			uint32_t triangles = 0; // at the level of detail of the visible meshes
+			uint32_t fullDetailTriangles = 0;
+			uint32_t meshlets = 0; // of the packets culled by meshlet
+			uint32_t culledMeshlets = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t meshBinds = 0; // vertex and index buffers, of a geometry buffers page or of a static geometry buffer set
+			uint32_t materialBinds = 0;
+			float buildTime = 0.0f; // in milliseconds, includes the sort
+		} renderQueueStats;
+
+		// Geometry of the scene mesh sources in shared buffers, rebaked when a scene is loaded while it's enabled
+		StaticGeometry staticGeometry;
+		bool bIsStaticGeometryBaked = false;
+
 		// Rendering
 		RenderPassRef forwardPass;
 		RenderPassRef deferredBasePass;
 		RenderPassRef deferredLightingPass;
 		RenderPassRef sceneComposite;
-		RenderPassRef objectPickerPass; // Editor Only
 		BufferRef quadBuffer; // used for passes that render a texture, like scene composite
 		bool bIsDeferredEnabled = false;
 
@@ -81,7 +188,10 @@ namespace Eden
 	private:
 		static void UpdatePointLights();
 		static void UpdateDirectionalLights();
-		static void ObjectPickerPass();
+		static void BakeStaticGeometry();
+		static void CullScene();
+		static void BuildRenderQueue();
+		static void DrawRenderQueue(RendererData::QueuePass pass, RenderLayer layer);
 		static void DeferredRenderingPass();
 		static void ForwardRenderingPass();
 		static void SceneCompositePass();
@@ -108,17 +218,24 @@ namespace Eden
 		static void SetCameraPosition(float x, float y); // this is only used when there's an editor
 		static bool& IsSkyboxEnabled();
 		static bool& IsDeferredRenderingEnabled();
+		static bool& IsFrustumCullingEnabled();
+		static bool& IsMeshLODEnabled();
+		static float& GetLODPixelThreshold();
+		static bool& IsMeshletCullingEnabled();
+		// Bakes or clears the static geometry of the current scene before the next frame
+		static void SetStaticGeometryBaked(bool bBaked);
+		static bool IsStaticGeometryBaked();
+		static const StaticGeometry& GetStaticGeometry();
 		static void SetNewSkybox(const char* path);
 		static RendererData::SceneSettings& GetSceneSettings();
 
 		static GPUTimerRef GetRenderTimer();
+		static const RendererData::CullingStats& GetCullingStats();
+		static const RendererData::RenderQueueStats& GetRenderQueueStats();
 
 		static glm::mat4 GetViewMatrix();
 		static glm::mat4 GetProjectionMatrix();
 
-		// This is used for the object picking, don't use it for anything else, use ReadPixelFromTexture
-		static void GetPixel(uint32_t x, uint32_t y, glm::vec4& pixel);
-
 		static TextureRef GetFinalImage();
 		static TextureRef GetComputeTestOutputImage();
 		static std::unordered_map<const char*, PipelineRef>& GetPipelines();
@@ -10,7 +10,9 @@ namespace Eden
 	{
 		m_ViewProjection = glm::mat4(1.0f);
 
+		// The skybox shader only reads positions, split vertices let it fetch nothing else
 		m_SkyboxCube = std::make_unique<MeshSource>();
+		m_SkyboxCube->vertexFormat = VertexFormat::kSplit;
 		m_SkyboxCube->LoadGLTF("assets/models/basic/cube.glb");
 		m_SkyboxTexture = RHICreateTexture(texturePath, false);
 	}
@@ -30,18 +32,15 @@ namespace Eden
 
 	void Skybox::Render(glm::mat4 viewProjectMatrix)
 	{
-		RHIBindVertexBuffer(m_SkyboxCube->meshVb);
-		RHIBindIndexBuffer(m_SkyboxCube->meshIb);
-		for (auto& mesh : m_SkyboxCube->meshes)
+		RHIBindVertexBuffer(m_SkyboxCube->GetPositionBuffer());
+		RHIBindIndexBuffer(m_SkyboxCube->indexSlice.buffers[0]);
+		m_ViewProjection = viewProjectMatrix;
+
+		RHIBindParameter("SkyboxData", &m_ViewProjection, sizeof(glm::mat4));
+		for (auto& submesh : m_SkyboxCube->submeshes)
 		{
-			m_ViewProjection = viewProjectMatrix;
-
-			RHIBindParameter("SkyboxData", &m_ViewProjection, sizeof(glm::mat4));
-			for (auto& submesh : mesh->submeshes)
-			{
-				RHIBindParameter("g_CubemapTexture", m_SkyboxTexture);
-				RHIDrawIndexed(submesh->indexCount, 1, submesh->indexStart);
-			}
+			RHIBindParameter("g_CubemapTexture", m_SkyboxTexture);
+			RHIDrawIndexed(submesh.indexCount, 1, submesh.indexStart + m_SkyboxCube->indexSlice.offset, submesh.vertexStart + m_SkyboxCube->vertexSlice.offset);
 		}
 	}
 
@@ -0,0 +1,142 @@
+#include "StaticGeometry.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Core/Log.h"
+#include "Profiling/Timer.h"
+#include "Utilities/Utils.h"
+
+namespace Eden
+{
+	static constexpr uint32_t kPositionStride = sizeof(float) * 3;
+
+	void StaticGeometry::Layout(const std::vector<const MeshSource*>& meshSources)
+	{
+		Clear();
+
+		for (const MeshSource* meshSource : meshSources)
+		{
+			const GeometrySlice& vertexSlice = meshSource->vertexSlice;
+			if (!meshSource->bHasMesh || !vertexSlice.IsValid() || !meshSource->indexSlice.IsValid() || m_Placements.count(meshSource->id) > 0)
+				continue;
+
+			// The attribute stream of kSplit is the last one
+			VertexFormat vertexFormat = meshSource->vertexFormat;
+			uint32_t vertexStride = vertexSlice.GetStride(vertexSlice.streamCount - 1);
+			uint32_t indexStride = meshSource->indexSlice.GetStride();
+			uint64_t largestStride = vertexFormat == VertexFormat::kSplit ? std::max(vertexStride, kPositionStride) : vertexStride;
+
+			// The last set of the same layout takes the mesh source while its buffers stay under kMaxBufferSize
+			uint32_t bufferSet = UINT32_MAX;
+			for (size_t i = m_BufferSets.size(); i-- > 0;)
+			{
+				const BufferSet& set = m_BufferSets[i];
+				if (set.vertexFormat != vertexFormat || set.vertexStride != vertexStride || set.indexStride != indexStride)
+					continue;
+
+				bool bFits = (set.vertexCount + static_cast<uint64_t>(meshSource->vertexCount)) * largestStride <= kMaxBufferSize &&
+					(set.indexCount + static_cast<uint64_t>(meshSource->indexCount)) * indexStride <= kMaxBufferSize;
+				if (bFits)
+					bufferSet = static_cast<uint32_t>(i);
+				break;
+			}
+			if (bufferSet == UINT32_MAX)
+			{
+				bufferSet = static_cast<uint32_t>(m_BufferSets.size());
+				BufferSet& set = m_BufferSets.emplace_back();
+				set.vertexFormat = vertexFormat;
+				set.vertexStride = vertexStride;
+				set.indexStride = indexStride;
+			}
+
+			BufferSet& set = m_BufferSets[bufferSet];
+			m_Placements[meshSource->id] = { bufferSet, set.vertexCount, set.indexCount };
+			set.vertexCount += meshSource->vertexCount;
+			set.indexCount += meshSource->indexCount;
+		}
+
+		m_Stats.meshSources = static_cast<uint32_t>(m_Placements.size());
+		m_Stats.bufferSets = static_cast<uint32_t>(m_BufferSets.size());
+		for (const BufferSet& set : m_BufferSets)
+		{
+			uint32_t positionStride = set.vertexFormat == VertexFormat::kSplit ? kPositionStride : 0;
+			m_Stats.vertexBytes += static_cast<uint64_t>(set.vertexCount) * (set.vertexStride + positionStride);
+			m_Stats.indexBytes += static_cast<uint64_t>(set.indexCount) * set.indexStride;
+		}
+	}
+
+	void StaticGeometry::Bake(const std::vector<const MeshSource*>& meshSources)
+	{
+		Timer timer;
+		timer.Record();
+
+		// The copies read the geometry buffers pages of the mesh sources through their mapping
+		std::vector<const MeshSource*> mappedSources;
+		for (const MeshSource* meshSource : meshSources)
+		{
+			const GeometrySlice& vertexSlice = meshSource->vertexSlice;
+			bool bIsMapped = vertexSlice.IsValid() && meshSource->indexSlice.IsValid() && meshSource->indexSlice.buffers[0]->mappedData;
+			for (uint32_t stream = 0; bIsMapped && stream < vertexSlice.streamCount; ++stream)
+				bIsMapped = vertexSlice.buffers[stream]->mappedData != nullptr;
+			if (bIsMapped)
+				mappedSources.push_back(meshSource);
+		}
+		Layout(mappedSources);
+
+		// One set at a time, only its staging copy is alive
+		std::vector<uint8_t> vertices;
+		std::vector<uint8_t> positions;
+		std::vector<uint8_t> indices;
+		for (uint32_t s = 0; s < m_BufferSets.size(); ++s)
+		{
+			BufferSet& set = m_BufferSets[s];
+			bool bSplit = set.vertexFormat == VertexFormat::kSplit;
+			vertices.resize(static_cast<size_t>(set.vertexCount) * set.vertexStride);
+			positions.resize(bSplit ? static_cast<size_t>(set.vertexCount) * kPositionStride : 0);
+			indices.resize(static_cast<size_t>(set.indexCount) * set.indexStride);
+
+			// Duplicates map to the same placement, copying them again writes the same bytes
+			for (const MeshSource* meshSource : mappedSources)
+			{
+				const Placement* placement = Find(*meshSource);
+				if (!placement || placement->bufferSet != s)
+					continue;
+
+				const GeometrySlice& vertexSlice = meshSource->vertexSlice;
+				std::memcpy(&vertices[static_cast<size_t>(placement->vertexOffset) * set.vertexStride], vertexSlice.GetData(vertexSlice.streamCount - 1), static_cast<size_t>(meshSource->vertexCount) * set.vertexStride);
+				if (bSplit)
+					std::memcpy(&positions[static_cast<size_t>(placement->vertexOffset) * kPositionStride], vertexSlice.GetData(0), static_cast<size_t>(meshSource->vertexCount) * kPositionStride);
+				std::memcpy(&indices[static_cast<size_t>(placement->indexOffset) * set.indexStride], meshSource->indexSlice.GetData(), static_cast<size_t>(meshSource->indexCount) * set.indexStride);
+			}
+
+			BufferDesc desc;
+			desc.usage = BufferDesc::Vertex_Index;
+			desc.elementCount = set.vertexCount;
+			desc.stride = set.vertexStride;
+			desc.debugName = "Static Geometry Vertices";
+			set.vertexBuffer = RHICreateBuffer(&desc, vertices.data());
+			if (bSplit)
+			{
+				desc.stride = kPositionStride;
+				desc.debugName = "Static Geometry Positions";
+				set.positionBuffer = RHICreateBuffer(&desc, positions.data());
+			}
+			desc.elementCount = set.indexCount;
+			desc.stride = set.indexStride;
+			desc.debugName = "Static Geometry Indices";
+			set.indexBuffer = RHICreateBuffer(&desc, indices.data());
+		}
+
+		m_Stats.bakeTime = timer.ElapsedMilliseconds();
+		ED_LOG_INFO("Baked {} mesh sources into {} buffer sets in {:.2f}ms, {} of vertices and {} of indices", m_Stats.meshSources, m_Stats.bufferSets,
+			m_Stats.bakeTime, Utils::BytesToString(m_Stats.vertexBytes), Utils::BytesToString(m_Stats.indexBytes));
+	}
+
+	void StaticGeometry::Clear()
+	{
+		m_Placements.clear();
+		m_BufferSets.clear();
+		m_Stats = {};
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "RHI/DynamicRHI.h"
+#include "Scene/MeshSource.h"
+
+namespace Eden
+{
+	/*
+	 * Scene geometry bake, the vertex and index buffers of the mesh sources of a scene copied into a few shared buffer
+	 * sets, one per vertex format and index size. Indices stay relative to their submesh, a baked mesh source draws with
+	 * its vertex and index offsets added to the draw starts, so the passes only bind buffers when the buffer set changes.
+	 * Transforms stay per instance, in the instance buffer, so baked entities can still move and share their meshes.
+	 * Mesh sources keep their slices of the geometry buffers: a bake can be cleared at any time and mesh sources loaded
+	 * after it draw from their slices. A defragmentation of the geometry buffers doesn't move baked geometry.
+	 */
+	class StaticGeometry
+	{
+	public:
+		// Mesh sources go to a new set once a buffer would grow past this, a larger mesh source gets a set of its own
+		static constexpr uint64_t kMaxBufferSize = 256ull * 1024 * 1024;
+
+		struct BufferSet
+		{
+			VertexFormat vertexFormat;
+			uint32_t indexStride; // 2 or 4 bytes
+			uint32_t vertexStride; // of vertexBuffer
+			uint32_t vertexCount = 0;
+			uint32_t indexCount = 0;
+			BufferRef vertexBuffer;
+			BufferRef positionBuffer; // kSplit only, stream 0
+			BufferRef indexBuffer;
+		};
+
+		// Where the buffers of a mesh source are in its set
+		struct Placement
+		{
+			uint32_t bufferSet; // index in GetBufferSets()
+			uint32_t vertexOffset; // added to the vertexStart of the submeshes
+			uint32_t indexOffset; // added to the indexStart of the submeshes, their levels of detail and their meshlets
+		};
+
+		struct Stats
+		{
+			uint32_t meshSources = 0;
+			uint32_t bufferSets = 0;
+			uint64_t vertexBytes = 0; // both streams of kSplit
+			uint64_t indexBytes = 0;
+			float bakeTime = 0.0f; // in milliseconds, the copies and the buffer creation
+		};
+
+		// Places the mesh sources in buffer sets without creating buffers, mesh sources without slices and duplicates are skipped
+		void Layout(const std::vector<const MeshSource*>& meshSources);
+		// Layout, then fills the buffers of every set from the mapped data of the mesh source slices
+		void Bake(const std::vector<const MeshSource*>& meshSources);
+		void Clear();
+		bool IsBaked() const { return !m_Placements.empty(); }
+
+		// nullptr if the mesh source isn't baked
+		const Placement* Find(const MeshSource& meshSource) const
+		{
+			auto it = m_Placements.find(meshSource.id);
+			return it != m_Placements.end() ? &it->second : nullptr;
+		}
+		const std::vector<BufferSet>& GetBufferSets() const { return m_BufferSets; }
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		std::unordered_map<uint32_t, Placement> m_Placements; // by mesh source id, ids aren't reused
+		std::vector<BufferSet> m_BufferSets;
+		Stats m_Stats;
+	};
+}
@@ -0,0 +1,99 @@
+#include "TextureCache.h"
+
+#include <unordered_map>
+
+#include "RHI/DynamicRHI.h"
+
+namespace Eden
+{
+	struct TextureCacheData
+	{
+		std::unordered_map<std::string, TextureRef> textures;
+		TextureRef blackTexture;
+		TextureCacheStats stats;
+	};
+
+	TextureCacheData& TextureCache::GetData()
+	{
+		if (!s_Data)
+			s_Data = enew TextureCacheData();
+		return *s_Data;
+	}
+
+	TextureRef TextureCache::Find(const std::string& key)
+	{
+		auto& data = GetData();
+		auto it = data.textures.find(key);
+		if (it == data.textures.end())
+		{
+			data.stats.misses++;
+			return nullptr;
+		}
+
+		data.stats.hits++;
+		return it->second;
+	}
+
+	void TextureCache::Add(const std::string& key, TextureRef texture)
+	{
+		GetData().textures[key] = texture;
+	}
+
+	TextureRef TextureCache::GetBlackTexture()
+	{
+		auto& data = GetData();
+		if (!data.blackTexture)
+		{
+			uint32_t blackTextureData = 0x00000000;
+			TextureDesc desc = {};
+			desc.data = &blackTextureData;
+			desc.width = 1;
+			desc.height = 1;
+			desc.bIsStorage = false;
+			desc.bGenerateMips = false;
+			desc.debugName = "Black Texture";
+			data.blackTexture = RHICreateTexture(&desc);
+		}
+
+		return data.blackTexture;
+	}
+
+	uint32_t TextureCache::CollectGarbage()
+	{
+		if (!s_Data)
+			return 0;
+
+		uint32_t releasedCount = 0;
+		auto& textures = s_Data->textures;
+		for (auto it = textures.begin(); it != textures.end();)
+		{
+			if (it->second.GetRefCount() == 1)
+			{
+				it = textures.erase(it);
+				releasedCount++;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		return releasedCount;
+	}
+
+	void TextureCache::Shutdown()
+	{
+		edelete s_Data;
+		s_Data = nullptr;
+	}
+
+	uint32_t TextureCache::GetTextureCount()
+	{
+		return s_Data ? static_cast<uint32_t>(s_Data->textures.size()) : 0;
+	}
+
+	const TextureCacheStats& TextureCache::GetStats()
+	{
+		return GetData().stats;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "RHI/DynamicRHI.h"
+
+namespace Eden
+{
+	struct TextureCacheData;
+
+	struct TextureCacheStats
+	{
+		uint32_t hits = 0;
+		uint32_t misses = 0;
+	};
+
+	/*
+	 * Textures created from image files, shared by every material that uses the same image.
+	 * Keys are the normalized path of the image file, or of the file that embeds it followed by the image index.
+	 * Cached textures are never modified. Only used from the main thread.
+	 */
+	class TextureCache
+	{
+	public:
+		// Counts a hit or a miss, returns an invalid texture on a miss
+		static TextureRef Find(const std::string& key);
+		static void Add(const std::string& key, TextureRef texture);
+
+		// 1x1 black texture used when a material has no texture in a slot
+		static TextureRef GetBlackTexture();
+
+		// Releases the textures that only the cache references, returns how many were released
+		static uint32_t CollectGarbage();
+		static void Shutdown();
+
+		static uint32_t GetTextureCount();
+		static const TextureCacheStats& GetStats();
+
+	private:
+		static TextureCacheData& GetData();
+
+	private:
+		inline static TextureCacheData* s_Data = nullptr;
+	};
+}
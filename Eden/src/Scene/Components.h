@@ -1,13 +1,17 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
+#include <entt/entt.hpp>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 
 #include "MeshSource.h"
+#include "MeshAssetRegistry.h"
+#include "Math/DynamicAABBTree.h"
 
 namespace Eden
 {
@@ -31,6 +35,10 @@ namespace Eden
 		glm::vec3 rotation		= glm::vec3(0.0f);
 		glm::vec3 scale			= glm::vec3(1.0f);
 
+		// Must be set every time the values above change, only dirty transforms (and their children) have the world transform recomputed
+		bool bDirty = true;
+
+		// Local transform, relative to the parent
 		glm::mat4 GetTransform()
 		{
 			glm::mat4 t = glm::translate(glm::mat4(1.0f), translation);
@@ -41,19 +49,44 @@ namespace Eden
 		}
 	};
 
+	// Every entity has one, entities without parent are root entities
+	struct RelationshipComponent
+	{
+		entt::entity parent = entt::null;
+		std::vector<entt::entity> children;
+		uint32_t depth = 0;
+	};
+
+	// World transform cached by the "Transform Hierarchy" system, don't modify it directly
+	struct WorldTransformComponent
+	{
+		glm::mat4 transform = glm::mat4(1.0f);
+		bool bUpdated = false; // true if the world transform was recomputed this frame
+	};
+
 	struct MeshComponent
 	{
+		static constexpr int32_t kAllInstances = -1;
+
+		// Shared with every component that loaded the same path, see MeshAssetRegistry
 		SharedPtr<MeshSource> meshSource;
 		std::string meshPath;
+		// Index in meshSource->instances of the only node drawn by this entity, its node transform is in the entity
+		// transform. kAllInstances draws the whole model with the node transforms, see Scene::ExpandMeshInstances
+		int32_t instance = kAllInstances;
+		// Level of detail drawn the last frame by every instance, kept by the renderer for the LOD hysteresis
+		std::vector<uint8_t> instanceLODs;
 
 		MeshComponent()
 		{
 			meshSource = MakeShared<MeshSource>();
 		}
+		// Copies share the mesh source, duplicating an entity doesn't load its mesh again
 		MeshComponent(MeshComponent& component)
 		{
 			meshPath = component.meshPath;
-			meshSource = MakeShared<MeshSource>();
+			meshSource = component.meshSource;
+			instance = component.instance;
 		}
 		MeshComponent(MeshComponent&& component) noexcept = default;
 		MeshComponent& operator=(MeshComponent& other) = default;
@@ -63,8 +96,41 @@ namespace Eden
 		{
 			if (!path.empty())
 				meshPath = path.string();
-			meshSource->LoadGLTF(meshPath);
+			meshSource = MeshAssetRegistry::Load(meshPath);
 		}
+
+		// nullptr when the whole model is drawn or the instance isn't in the mesh source, e.g. the file changed since the scene was saved
+		const MeshSource::MeshInstance* GetInstance() const
+		{
+			if (instance < 0 || static_cast<size_t>(instance) >= meshSource->instances.size())
+				return nullptr;
+			return &meshSource->instances[instance];
+		}
+
+		// Bounds in the space of the entity
+		const Math::AABB& GetLocalBounds() const
+		{
+			static const Math::AABB kEmptyBounds;
+			if (instance == kAllInstances)
+				return meshSource->bounds;
+			const MeshSource::MeshInstance* meshInstance = GetInstance();
+			return meshInstance ? meshSource->meshes[meshInstance->mesh].bounds : kEmptyBounds;
+		}
+	};
+
+	// Added and removed together with the MeshComponent, kept up to date by the "Mesh Bounds" system
+	struct BoundsComponent
+	{
+		Math::AABB worldBounds;
+		Math::BoundingSphere worldBoundingSphere;
+		Math::AABB localBounds; // mesh source bounds used for the last update
+		bool bUpdated = false; // true if the world bounds were recomputed this frame
+	};
+
+	// Added to entities with a mesh or a point light, the scene keeps their proxy in the spatial tree up to date
+	struct SpatialProxyComponent
+	{
+		int32_t proxyId = Math::DynamicAABBTree::kNullNode;
 	};
 
 	struct PointLightComponent
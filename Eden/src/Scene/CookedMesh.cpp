@@ -0,0 +1,115 @@
+#include "CookedMesh.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "Core/Log.h"
+
+namespace Eden::CookedMesh
+{
+	static constexpr size_t kAlignment = 16;
+
+	std::filesystem::path GetCookedPath(const std::filesystem::path& sourcePath)
+	{
+		std::filesystem::path cookedPath = sourcePath;
+		cookedPath += kExtension;
+		return cookedPath;
+	}
+
+	// FNV-1a over 8 byte words, only used to notice that a file changed
+	static uint64_t HashBytes(const uint8_t* data, size_t size, uint64_t hash)
+	{
+		constexpr uint64_t kPrime = 0x100000001B3ull;
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			uint64_t word;
+			memcpy(&word, data + i, sizeof(uint64_t));
+			hash = (hash ^ word) * kPrime;
+		}
+		for (; i < size; ++i)
+			hash = (hash ^ data[i]) * kPrime;
+
+		return (hash ^ size) * kPrime;
+	}
+
+	uint64_t HashFiles(const std::vector<std::filesystem::path>& files)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (auto& path : files)
+		{
+			MappedFile file;
+			if (!file.Open(path))
+				return 0;
+			hash = HashBytes(file.GetData(), file.GetSize(), hash);
+		}
+
+		// 0 means the files couldn't be read
+		return hash != 0 ? hash : 1;
+	}
+
+	const Header* GetHeader(const MappedFile& file)
+	{
+		if (file.GetSize() < sizeof(Header))
+			return nullptr;
+
+		const Header* header = reinterpret_cast<const Header*>(file.GetData());
+		if (header->magic != kMagic || header->version != kVersion)
+			return nullptr;
+
+		return header;
+	}
+
+	std::string GetString(const MappedFile& file, const Blob& blob)
+	{
+		const char* data = GetSection<char>(file, blob);
+		return data ? std::string(data, blob.count) : std::string();
+	}
+
+	Writer::Writer()
+	{
+		// Room for the header, written by Save
+		m_Data.resize(sizeof(Header));
+	}
+
+	uint64_t Writer::AppendBytes(const void* data, size_t size)
+	{
+		size_t offset = (m_Data.size() + kAlignment - 1) & ~(kAlignment - 1);
+		m_Data.resize(offset + size);
+		if (size > 0)
+			memcpy(m_Data.data() + offset, data, size);
+		return offset;
+	}
+
+	bool Writer::Save(const std::filesystem::path& path, const Header& header)
+	{
+		memcpy(m_Data.data(), &header, sizeof(Header));
+
+		std::filesystem::path temporaryPath = path;
+		temporaryPath += ".tmp";
+		bool bWritten = false;
+		{
+			std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(m_Data.data()), m_Data.size());
+			bWritten = file.good();
+		}
+
+		std::error_code error;
+		if (!bWritten)
+		{
+			ED_LOG_WARN("Failed to write the cooked mesh {}", path);
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		std::filesystem::rename(temporaryPath, path, error);
+		if (error)
+		{
+			ED_LOG_WARN("Failed to write the cooked mesh {}: {}", path, error.message());
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Core/MappedFile.h"
+#include "Math/Bounds.h"
+#include "Scene/MeshOptimizer.h"
+
+/*
+ * Cooked mesh files (.emesh), the final vertex and index streams of an imported glTF with its submesh table, levels
+ * of detail, meshlets, bounds, triangle BVHs and material references. Every section is an array of the POD structs below at a 16 byte aligned
+ * offset, so a mapped file is used in place: the streams are uploaded straight from the mapping.
+ * Images aren't decoded in the file, materials reference the external image files or embed the encoded bytes.
+ */
+namespace Eden::CookedMesh
+{
+	constexpr uint32_t kMagic = 0x48534D45; // "EMSH"
+	// Bump when a struct below, VertexData, Meshlet or TriangleBVH nodes change, older files are cooked again
+	constexpr uint32_t kVersion = 7;
+	constexpr const char* kExtension = ".emesh";
+
+	// count elements starting offset bytes from the start of the file
+	struct Section
+	{
+		uint64_t offset = 0;
+		uint64_t count = 0;
+	};
+
+	// Strings and encoded images
+	using Blob = Section;
+
+	struct Header
+	{
+		uint32_t magic = kMagic;
+		uint32_t version = kVersion;
+		uint32_t vertexSize = 0; // sizeof(VertexData)
+		uint32_t materialCount = 0;
+		uint32_t indexSize = 0; // 2 or 4 bytes
+		uint32_t padding = 0;
+		uint64_t sourceHash = 0; // hash of the dependencies, the source file first and its external buffers
+		Math::AABB bounds;
+		Section dependencies; // Blob, paths relative to the source file folder
+		Section vertices; // VertexData
+		Section indices; // uint16_t or uint32_t, relative to the vertexStart of their submesh
+		Section meshes; // Mesh
+		Section instances; // Instance
+		Section submeshes; // Submesh
+		Section lods; // SubmeshLOD
+		Section meshlets; // MeshOptimizer::Meshlet
+		Section meshletVertices; // uint32_t
+		Section meshletTriangles; // uint8_t
+		Section bvhNodes; // TriangleBVH::Node
+		Section bvhTriangles; // TriangleBVH::Triangle
+		Section materials; // Material, indexed like the glTF materials
+		Section images; // Image, indexed like the glTF images
+	};
+
+	// Meshes are shared by the nodes instancing them, their bounds are in vertex space
+	struct Mesh
+	{
+		Math::AABB bounds;
+		uint32_t firstSubmesh;
+		uint32_t submeshCount;
+		uint32_t firstBVHNode;
+		uint32_t bvhNodeCount;
+		uint32_t firstBVHTriangle;
+		uint32_t bvhTriangleCount;
+		uint32_t lodCount;
+		float lodErrors[MeshOptimizer::kMaxLODCount];
+	};
+
+	struct Instance
+	{
+		glm::mat4 modelMatrix;
+		Math::AABB bounds; // node space
+		Blob name;
+		uint32_t mesh;
+	};
+
+	struct Submesh
+	{
+		Math::AABB bounds;
+		uint32_t index;
+		uint32_t vertexStart;
+		uint32_t indexStart;
+		uint32_t indexCount;
+		uint32_t firstLOD;
+		uint32_t lodCount;
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+		int32_t material; // -1 without a material
+	};
+
+	// Simplified level of a submesh, its indices are relative to the vertexStart of the submesh too
+	struct SubmeshLOD
+	{
+		uint32_t indexStart;
+		uint32_t indexCount;
+	};
+
+	// Image indices of every texture slot, -1 for slots without a texture, and the constants of the material
+	struct Material
+	{
+		int32_t albedo;
+		int32_t metallicRoughness;
+		int32_t normal;
+		int32_t AO;
+		int32_t emissive;
+		uint32_t bIsTransparent;
+		glm::vec4 baseColor;
+	};
+
+	struct Image
+	{
+		Blob data; // the URI of external images, the encoded bytes of embedded ones
+		uint32_t bIsExternal;
+		uint32_t padding;
+	};
+
+	// "Sponza.gltf" is cooked next to it, to "Sponza.gltf.emesh"
+	std::filesystem::path GetCookedPath(const std::filesystem::path& sourcePath);
+
+	// Hash of the contents of every file, 0 if one of them can't be read
+	uint64_t HashFiles(const std::vector<std::filesystem::path>& files);
+
+	// Header of a mapped file, nullptr if it isn't a cooked mesh of this version
+	const Header* GetHeader(const MappedFile& file);
+
+	// Elements of a section, nullptr if the section is empty or out of the file
+	template<typename T>
+	const T* GetSection(const MappedFile& file, const Section& section)
+	{
+		if (section.count == 0 || section.offset > file.GetSize() || section.count > (file.GetSize() - section.offset) / sizeof(T))
+			return nullptr;
+		return reinterpret_cast<const T*>(file.GetData() + section.offset);
+	}
+
+	std::string GetString(const MappedFile& file, const Blob& blob);
+
+	// Builds a cooked file in memory, the header is written last
+	class Writer
+	{
+	public:
+		Writer();
+
+		template<typename T>
+		Section Append(const T* data, size_t count)
+		{
+			return { AppendBytes(data, count * sizeof(T)), count };
+		}
+		Blob AppendString(const std::string& string) { return { AppendBytes(string.data(), string.size()), string.size() }; }
+
+		// Writes a temporary file and renames it, a failed save never leaves a partial cooked file behind
+		bool Save(const std::filesystem::path& path, const Header& header);
+
+	private:
+		std::vector<uint8_t> m_Data;
+
+	private:
+		uint64_t AppendBytes(const void* data, size_t size);
+	};
+}
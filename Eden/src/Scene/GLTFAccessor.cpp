@@ -0,0 +1,265 @@
+#include "GLTFAccessor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "Math/SIMD.h"
+
+namespace Eden::GLTF
+{
+	using namespace SIMD;
+
+	BufferSpans GetBufferSpans(const tinygltf::Model& model)
+	{
+		BufferSpans buffers(model.buffers.size());
+		for (size_t i = 0; i < model.buffers.size(); ++i)
+			buffers[i] = { model.buffers[i].data.data(), model.buffers[i].data.size() };
+		return buffers;
+	}
+
+	// Start of the elements inside a buffer view, nullptr if any element would be out of the buffer
+	static const uint8_t* GetElementData(const tinygltf::Model& model, const BufferSpans& buffers, int bufferViewIndex, size_t byteOffset, size_t stride, size_t elementSize, size_t count)
+	{
+		if (bufferViewIndex < 0 || static_cast<size_t>(bufferViewIndex) >= model.bufferViews.size())
+			return nullptr;
+
+		const tinygltf::BufferView& bufferView = model.bufferViews[bufferViewIndex];
+		if (bufferView.buffer < 0 || static_cast<size_t>(bufferView.buffer) >= buffers.size())
+			return nullptr;
+
+		const BufferSpan& buffer = buffers[bufferView.buffer];
+		size_t start = bufferView.byteOffset + byteOffset;
+		if (count > 0 && start + (count - 1) * stride + elementSize > buffer.size)
+			return nullptr;
+
+		return buffer.data + start;
+	}
+
+	template<typename T>
+	static float ToFloat(T value, bool bNormalized)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			return value;
+		}
+		else
+		{
+			if (!bNormalized)
+				return static_cast<float>(value);
+
+			// Normalized signed values map both -max - 1 and -max to -1
+			constexpr float scale = 1.0f / static_cast<float>(std::numeric_limits<T>::max());
+			return std::max(static_cast<float>(value) * scale, -1.0f);
+		}
+	}
+
+	// The component count is a template parameter so the copy of an element compiles to a few moves
+	template<typename T, uint32_t ComponentCount>
+	static void ConvertElements(const uint8_t* source, size_t stride, size_t count, bool bNormalized, uint8_t* out, size_t outStride)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Source elements don't have to be aligned
+			T values[ComponentCount];
+			memcpy(values, source + i * stride, sizeof(values));
+
+			float element[ComponentCount];
+			for (uint32_t c = 0; c < ComponentCount; ++c)
+				element[c] = ToFloat(values[c], bNormalized);
+			memcpy(out + i * outStride, element, sizeof(element));
+		}
+	}
+
+	template<typename T>
+	static void ConvertElements(const uint8_t* source, size_t stride, size_t count, uint32_t componentCount, bool bNormalized, uint8_t* out, size_t outStride)
+	{
+		switch (componentCount)
+		{
+			case 1:		ConvertElements<T, 1>(source, stride, count, bNormalized, out, outStride); break;
+			case 2:		ConvertElements<T, 2>(source, stride, count, bNormalized, out, outStride); break;
+			case 3:		ConvertElements<T, 3>(source, stride, count, bNormalized, out, outStride); break;
+			default:	ConvertElements<T, 4>(source, stride, count, bNormalized, out, outStride); break;
+		}
+	}
+
+	static bool ConvertElements(int componentType, const uint8_t* source, size_t stride, size_t count, uint32_t componentCount, bool bNormalized, uint8_t* out, size_t outStride)
+	{
+		switch (componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_FLOAT:				ConvertElements<float>(source, stride, count, componentCount, bNormalized, out, outStride); return true;
+			case TINYGLTF_COMPONENT_TYPE_BYTE:				ConvertElements<int8_t>(source, stride, count, componentCount, bNormalized, out, outStride); return true;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:		ConvertElements<uint8_t>(source, stride, count, componentCount, bNormalized, out, outStride); return true;
+			case TINYGLTF_COMPONENT_TYPE_SHORT:				ConvertElements<int16_t>(source, stride, count, componentCount, bNormalized, out, outStride); return true;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:	ConvertElements<uint16_t>(source, stride, count, componentCount, bNormalized, out, outStride); return true;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:		ConvertElements<uint32_t>(source, stride, count, componentCount, bNormalized, out, outStride); return true;
+			default:										return false;
+		}
+	}
+
+	static uint32_t ReadIndex(const uint8_t* data, int componentType)
+	{
+		switch (componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+				return *data;
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				uint16_t index;
+				memcpy(&index, data, sizeof(uint16_t));
+				return index;
+			}
+			default:
+			{
+				uint32_t index;
+				memcpy(&index, data, sizeof(uint32_t));
+				return index;
+			}
+		}
+	}
+
+	// Sparse accessors replace some elements, the indices of the elements and their values are stored apart.
+	// writeElement(index, value) is called for every replaced element.
+	template<typename WriteElement>
+	static bool ReadSparse(const tinygltf::Model& model, const BufferSpans& buffers, const tinygltf::Accessor& accessor, size_t elementSize, WriteElement&& writeElement)
+	{
+		size_t sparseCount = static_cast<size_t>(accessor.sparse.count);
+		int indexType = accessor.sparse.indices.componentType;
+		if (indexType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && indexType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT && indexType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+			return false;
+		size_t indexSize = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(indexType)));
+
+		const uint8_t* indices = GetElementData(model, buffers, accessor.sparse.indices.bufferView, accessor.sparse.indices.byteOffset, indexSize, indexSize, sparseCount);
+		const uint8_t* values = GetElementData(model, buffers, accessor.sparse.values.bufferView, accessor.sparse.values.byteOffset, elementSize, elementSize, sparseCount);
+		if (!indices || !values)
+			return false;
+
+		for (size_t s = 0; s < sparseCount; ++s)
+		{
+			uint32_t index = ReadIndex(indices + s * indexSize, indexType);
+			if (index >= accessor.count)
+				return false;
+			writeElement(index, values + s * elementSize);
+		}
+
+		return true;
+	}
+
+	bool ReadFloats(const tinygltf::Model& model, const BufferSpans& buffers, const tinygltf::Accessor& accessor, float* out, size_t outStride, uint32_t componentCount)
+	{
+		int32_t typeComponentCount = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+		int32_t componentSize = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType));
+		// Matrices aren't vertex attributes
+		if (typeComponentCount <= 0 || typeComponentCount > 4 || componentSize <= 0)
+			return false;
+
+		componentCount = std::min(componentCount, static_cast<uint32_t>(typeComponentCount));
+		size_t elementSize = static_cast<size_t>(componentSize) * typeComponentCount;
+		uint8_t* output = reinterpret_cast<uint8_t*>(out);
+
+		if (accessor.bufferView >= 0)
+		{
+			if (static_cast<size_t>(accessor.bufferView) >= model.bufferViews.size())
+				return false;
+
+			int stride = accessor.ByteStride(model.bufferViews[accessor.bufferView]);
+			if (stride <= 0)
+				return false;
+
+			const uint8_t* data = GetElementData(model, buffers, accessor.bufferView, accessor.byteOffset, stride, elementSize, accessor.count);
+			if (!data || !ConvertElements(accessor.componentType, data, stride, accessor.count, componentCount, accessor.normalized, output, outStride))
+				return false;
+		}
+		else
+		{
+			// Without a buffer view every element is zero until the sparse values replace some of them
+			for (size_t i = 0; i < accessor.count; ++i)
+				memset(output + i * outStride, 0, componentCount * sizeof(float));
+		}
+
+		if (!accessor.sparse.isSparse)
+			return true;
+
+		return ReadSparse(model, buffers, accessor, elementSize, [&](uint32_t index, const uint8_t* value)
+		{
+			ConvertElements(accessor.componentType, value, elementSize, 1, componentCount, accessor.normalized, output + index * outStride, outStride);
+		});
+	}
+
+	bool ReadIndices(const tinygltf::Model& model, const BufferSpans& buffers, const tinygltf::Accessor& accessor, uint32_t baseVertex, uint32_t* out)
+	{
+		int componentType = accessor.componentType;
+		if (componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT && componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+			return false;
+
+		// Index buffer views can't have a byteStride, indices are always tightly packed
+		size_t indexSize = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(componentType)));
+		const uint8_t* data = GetElementData(model, buffers, accessor.bufferView, accessor.byteOffset, indexSize, indexSize, accessor.count);
+		if (!data)
+			return false;
+
+		ConvertIndices(data, componentType, accessor.count, baseVertex, out);
+
+		if (!accessor.sparse.isSparse)
+			return true;
+
+		return ReadSparse(model, buffers, accessor, indexSize, [&](uint32_t index, const uint8_t* value)
+		{
+			out[index] = ReadIndex(value, componentType) + baseVertex;
+		});
+	}
+
+	void ConvertIndices(const void* indices, int componentType, size_t count, uint32_t baseVertex, uint32_t* out)
+	{
+		Int4 base = SplatInt(static_cast<int32_t>(baseVertex));
+		int32_t* output = reinterpret_cast<int32_t*>(out);
+		size_t i = 0;
+
+		// 8 indices per iteration, the remaining ones go through the scalar version
+		switch (componentType)
+		{
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			{
+				const uint8_t* source = static_cast<const uint8_t*>(indices);
+				for (; i + 8 <= count; i += 8)
+				{
+					StoreInt(output + i, LoadUInt8(source + i) + base);
+					StoreInt(output + i + 4, LoadUInt8(source + i + 4) + base);
+				}
+				ConvertIndicesScalar(source + i, componentType, count - i, baseVertex, out + i);
+				break;
+			}
+			case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			{
+				const uint16_t* source = static_cast<const uint16_t*>(indices);
+				for (; i + 8 <= count; i += 8)
+				{
+					StoreInt(output + i, LoadUInt16(source + i) + base);
+					StoreInt(output + i + 4, LoadUInt16(source + i + 4) + base);
+				}
+				ConvertIndicesScalar(source + i, componentType, count - i, baseVertex, out + i);
+				break;
+			}
+			default:
+			{
+				const int32_t* source = static_cast<const int32_t*>(indices);
+				for (; i + 8 <= count; i += 8)
+				{
+					StoreInt(output + i, LoadInt(source + i) + base);
+					StoreInt(output + i + 4, LoadInt(source + i + 4) + base);
+				}
+				ConvertIndicesScalar(source + i, componentType, count - i, baseVertex, out + i);
+				break;
+			}
+		}
+	}
+
+	void ConvertIndicesScalar(const void* indices, int componentType, size_t count, uint32_t baseVertex, uint32_t* out)
+	{
+		const uint8_t* source = static_cast<const uint8_t*>(indices);
+		size_t indexSize = static_cast<size_t>(tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(componentType)));
+		for (size_t i = 0; i < count; ++i)
+			out[i] = ReadIndex(source + i * indexSize, componentType) + baseVertex;
+	}
+}
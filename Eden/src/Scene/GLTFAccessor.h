@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <tinygltf/tiny_gltf.h>
+
+/*
+ * Streaming readers for glTF accessors, they convert straight into the caller memory without temporary copies.
+ * Every component type, byteStride, normalized integers and sparse accessors are supported.
+ */
+namespace Eden::GLTF
+{
+	// Bytes of a glTF buffer, either tinygltf::Buffer::data or a memory mapped file
+	struct BufferSpan
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	// Indexed like model.buffers
+	using BufferSpans = std::vector<BufferSpan>;
+
+	// Spans over the buffers tinygltf loaded into the model
+	BufferSpans GetBufferSpans(const tinygltf::Model& model);
+
+	// Reads componentCount floats per element, elements are written outStride bytes apart.
+	// Components the accessor doesn't have are left untouched. Returns false if the accessor can't be read.
+	bool ReadFloats(const tinygltf::Model& model, const BufferSpans& buffers, const tinygltf::Accessor& accessor, float* out, size_t outStride, uint32_t componentCount);
+
+	// Reads unsigned 8, 16 or 32 bit indices and adds baseVertex to every index, out must hold accessor.count indices
+	bool ReadIndices(const tinygltf::Model& model, const BufferSpans& buffers, const tinygltf::Accessor& accessor, uint32_t baseVertex, uint32_t* out);
+
+	// Tightly packed indices of a glTF component type to 32 bit indices with baseVertex added
+	void ConvertIndices(const void* indices, int componentType, size_t count, uint32_t baseVertex, uint32_t* out);
+	void ConvertIndicesScalar(const void* indices, int componentType, size_t count, uint32_t baseVertex, uint32_t* out);
+}
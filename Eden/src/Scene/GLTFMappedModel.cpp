@@ -0,0 +1,252 @@
+#include "GLTFMappedModel.h"
+
+#include <cctype>
+#include <cstring>
+
+#include <tinygltf/json.hpp>
+
+namespace Eden::GLTF
+{
+	// Smallest buffer tinygltf accepts, it decodes to three zero bytes
+	static constexpr const char* kPlaceholderURI = "data:application/octet-stream;base64,AAAA";
+	static constexpr size_t kPlaceholderSize = 3;
+
+	static constexpr uint32_t kGLBMagic = 0x46546C67; // "glTF"
+	static constexpr uint32_t kGLBChunkJSON = 0x4E4F534A; // "JSON"
+	static constexpr uint32_t kGLBChunkBIN = 0x004E4942; // "BIN\0"
+
+	static uint32_t ReadUInt32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(uint32_t));
+		return value;
+	}
+
+	// A GLB is a 12 byte header followed by the JSON chunk and an optional BIN chunk, each with an 8 byte header
+	static bool ReadGLBChunks(const MappedFile& file, BufferSpan& outJSON, BufferSpan& outBIN)
+	{
+		const uint8_t* data = file.GetData();
+		size_t size = file.GetSize();
+		if (size < 20 || ReadUInt32(data) != kGLBMagic || ReadUInt32(data + 8) > size)
+			return false;
+		size = ReadUInt32(data + 8);
+
+		size_t jsonSize = ReadUInt32(data + 12);
+		if (ReadUInt32(data + 16) != kGLBChunkJSON || 20 + jsonSize > size)
+			return false;
+		outJSON = { data + 20, jsonSize };
+
+		// Chunks are 4 byte aligned
+		size_t binChunk = (20 + jsonSize + 3) & ~size_t(3);
+		if (binChunk + 8 <= size && ReadUInt32(data + binChunk + 4) == kGLBChunkBIN)
+		{
+			size_t binSize = ReadUInt32(data + binChunk);
+			if (binChunk + 8 + binSize > size)
+				return false;
+			outBIN = { data + binChunk + 8, binSize };
+		}
+
+		return true;
+	}
+
+	std::string DecodeURI(const std::string& uri)
+	{
+		auto hexValue = [](char c) { return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10; };
+
+		std::string decoded;
+		decoded.reserve(uri.size());
+		for (size_t i = 0; i < uri.size(); ++i)
+		{
+			if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(static_cast<unsigned char>(uri[i + 1])) && isxdigit(static_cast<unsigned char>(uri[i + 2])))
+			{
+				decoded += static_cast<char>(hexValue(uri[i + 1]) * 16 + hexValue(uri[i + 2]));
+				i += 2;
+			}
+			else
+			{
+				decoded += uri[i];
+			}
+		}
+		return decoded;
+	}
+
+	static size_t GetUnsigned(const nlohmann::json& object, const char* key, size_t defaultValue)
+	{
+		auto it = object.find(key);
+		return it != object.end() && it->is_number_unsigned() ? it->get<size_t>() : defaultValue;
+	}
+
+	bool MappedModel::Load(const std::filesystem::path& path, tinygltf::Model& model, std::string& err, std::string& warn, tinygltf::LoadImageDataFunction imageLoader, void* imageUserData)
+	{
+		Release();
+
+		if (!m_File.Open(path))
+		{
+			err = "Failed to map " + path.string();
+			return false;
+		}
+		m_Files.push_back(path);
+
+		BufferSpan json = { m_File.GetData(), m_File.GetSize() };
+		BufferSpan binChunk;
+		bool bIsBinary = m_File.GetSize() >= 4 && ReadUInt32(m_File.GetData()) == kGLBMagic;
+		if (bIsBinary && !ReadGLBChunks(m_File, json, binChunk))
+		{
+			err = "Invalid GLB header in " + path.string();
+			return false;
+		}
+
+		nlohmann::json document = nlohmann::json::parse(json.data, json.data + json.size, nullptr, false);
+		if (document.is_discarded() || !document.is_object())
+		{
+			err = "Failed to parse the JSON of " + path.string();
+			return false;
+		}
+
+		// Buffers that tinygltf would copy are mapped instead: the GLB BIN chunk and external .bin files.
+		// Data URIs are left to tinygltf, they have to be decoded anyway.
+		std::filesystem::path baseDir = path.parent_path();
+		bool bRewritten = false;
+		auto buffers = document.find("buffers");
+		if (buffers != document.end() && buffers->is_array())
+		{
+			for (auto& buffer : *buffers)
+			{
+				BufferSpan span;
+				auto uri = buffer.find("uri");
+				if (uri == buffer.end() || !uri->is_string())
+				{
+					if (bIsBinary && m_Buffers.empty())
+						span = binChunk;
+				}
+				else if (uri->get_ref<const std::string&>().rfind("data:", 0) != 0)
+				{
+					std::filesystem::path bufferPath = baseDir / std::filesystem::u8path(DecodeURI(uri->get<std::string>()));
+					MappedFile& bufferFile = m_BufferFiles.emplace_back();
+					if (bufferFile.Open(bufferPath))
+					{
+						span = { bufferFile.GetData(), bufferFile.GetSize() };
+						m_Files.push_back(bufferPath);
+					}
+				}
+
+				size_t byteLength = GetUnsigned(buffer, "byteLength", 0);
+				if (span.data && buffer.is_object() && byteLength <= span.size)
+				{
+					span.size = byteLength;
+					buffer["uri"] = kPlaceholderURI;
+					buffer["byteLength"] = kPlaceholderSize;
+					bRewritten = true;
+				}
+				else
+				{
+					// tinygltf loads it and reports the errors
+					span = {};
+				}
+				m_Buffers.push_back(span);
+			}
+		}
+
+		// Images in buffer views would be read from the placeholder, they point at a placeholder data URI instead
+		auto images = document.find("images");
+		auto bufferViews = document.find("bufferViews");
+		if (images != document.end() && images->is_array() && bufferViews != document.end() && bufferViews->is_array())
+		{
+			m_ImageViews.resize(images->size());
+			for (size_t i = 0; i < images->size(); ++i)
+			{
+				nlohmann::json& image = (*images)[i];
+				size_t viewIndex = image.is_object() ? GetUnsigned(image, "bufferView", SIZE_MAX) : SIZE_MAX;
+				if (viewIndex >= bufferViews->size() || !(*bufferViews)[viewIndex].is_object())
+					continue;
+
+				const nlohmann::json& bufferView = (*bufferViews)[viewIndex];
+				size_t bufferIndex = GetUnsigned(bufferView, "buffer", SIZE_MAX);
+				size_t byteOffset = GetUnsigned(bufferView, "byteOffset", 0);
+				size_t byteLength = GetUnsigned(bufferView, "byteLength", 0);
+				if (bufferIndex >= m_Buffers.size() || !m_Buffers[bufferIndex].data || byteOffset + byteLength > m_Buffers[bufferIndex].size)
+					continue;
+
+				m_ImageViews[i] = { m_Buffers[bufferIndex].data + byteOffset, byteLength };
+				image.erase("bufferView");
+				image["uri"] = kPlaceholderURI;
+			}
+		}
+
+		m_ImageLoader = imageLoader;
+		m_ImageUserData = imageUserData;
+
+		tinygltf::TinyGLTF loader;
+		loader.SetImageLoader(&MappedModel::LoadImageData, this);
+		bool bLoaded = false;
+		if (bRewritten)
+		{
+			std::string rewrittenJSON = document.dump();
+			bLoaded = loader.LoadASCIIFromString(&model, &err, &warn, rewrittenJSON.c_str(), static_cast<unsigned int>(rewrittenJSON.size()), baseDir.string());
+		}
+		else if (bIsBinary)
+		{
+			bLoaded = loader.LoadBinaryFromMemory(&model, &err, &warn, m_File.GetData(), static_cast<unsigned int>(m_File.GetSize()), baseDir.string());
+		}
+		else
+		{
+			bLoaded = loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char*>(json.data), static_cast<unsigned int>(json.size), baseDir.string());
+		}
+
+		if (!bLoaded)
+		{
+			Release();
+			return false;
+		}
+
+		// The buffers tinygltf loaded itself
+		m_Buffers.resize(model.buffers.size());
+		for (size_t i = 0; i < model.buffers.size(); ++i)
+		{
+			if (!m_Buffers[i].data)
+				m_Buffers[i] = { model.buffers[i].data.data(), model.buffers[i].data.size() };
+		}
+
+		return true;
+	}
+
+	void MappedModel::Release()
+	{
+		m_File.Close();
+		m_BufferFiles.clear();
+		m_Buffers.clear();
+		m_ImageViews.clear();
+		m_Files.clear();
+	}
+
+	size_t MappedModel::GetMappedSize() const
+	{
+		size_t size = m_File.GetSize();
+		for (auto& bufferFile : m_BufferFiles)
+			size += bufferFile.GetSize();
+		return size;
+	}
+
+	BufferSpan MappedModel::GetImageData(int imageIndex) const
+	{
+		if (imageIndex < 0 || static_cast<size_t>(imageIndex) >= m_ImageViews.size())
+			return {};
+		return m_ImageViews[imageIndex];
+	}
+
+	bool MappedModel::LoadImageData(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn, int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData)
+	{
+		MappedModel* mappedModel = static_cast<MappedModel*>(userData);
+		if (static_cast<size_t>(imageIndex) < mappedModel->m_ImageViews.size() && mappedModel->m_ImageViews[imageIndex].data)
+		{
+			const BufferSpan& imageView = mappedModel->m_ImageViews[imageIndex];
+			bytes = imageView.data;
+			size = static_cast<int>(imageView.size);
+		}
+
+		if (!mappedModel->m_ImageLoader)
+			return true;
+
+		return mappedModel->m_ImageLoader(image, imageIndex, err, warn, requiredWidth, requiredHeight, bytes, size, mappedModel->m_ImageUserData);
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <tinygltf/tiny_gltf.h>
+
+#include "Core/MappedFile.h"
+#include "GLTFAccessor.h"
+
+namespace Eden::GLTF
+{
+	// File references in glTF are URIs, "my%20file.bin" is "my file.bin"
+	std::string DecodeURI(const std::string& uri);
+
+	/*
+	 * Loads a .gltf or .glb file without copying its binary buffers.
+	 * The file and its external .bin buffers are memory mapped and tinygltf only parses the JSON: buffers it would copy
+	 * are swapped for a placeholder, accessors are then read straight from the mapped pages through GetBuffers().
+	 * Images stored in buffer views reach the image loader from the mapping too.
+	 */
+	class MappedModel
+	{
+	public:
+		bool Load(const std::filesystem::path& path, tinygltf::Model& model, std::string& err, std::string& warn, tinygltf::LoadImageDataFunction imageLoader, void* imageUserData);
+
+		// Unmaps every file, the buffers must not be read afterwards
+		void Release();
+
+		const BufferSpans& GetBuffers() const { return m_Buffers; }
+		size_t GetMappedSize() const;
+
+		// Encoded bytes of an image stored in a buffer view, empty for external images and data URIs
+		BufferSpan GetImageData(int imageIndex) const;
+
+		// The glTF file and the external buffers it was read from
+		const std::vector<std::filesystem::path>& GetFiles() const { return m_Files; }
+
+	private:
+		MappedFile m_File;
+		std::vector<MappedFile> m_BufferFiles;
+		BufferSpans m_Buffers;
+		BufferSpans m_ImageViews; // images stored in mapped buffer views, indexed like model.images
+		std::vector<std::filesystem::path> m_Files;
+
+		tinygltf::LoadImageDataFunction m_ImageLoader = nullptr;
+		void* m_ImageUserData = nullptr;
+
+	private:
+		// Hands images stored in buffer views to the image loader from the mapping instead of the placeholder
+		static bool LoadImageData(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn, int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData);
+	};
+}
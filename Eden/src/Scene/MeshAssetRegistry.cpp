@@ -0,0 +1,93 @@
+#include "MeshAssetRegistry.h"
+
+#include <unordered_map>
+
+#include "MeshSource.h"
+#include "Core/CommandLine.h"
+#include "Core/Log.h"
+#include "Utilities/Utils.h"
+
+namespace Eden
+{
+	struct MeshAssetRegistryData
+	{
+		std::unordered_map<std::string, SharedPtr<MeshSource>> meshSources;
+		VertexFormat vertexFormat = VertexFormat::kFull;
+	};
+
+	MeshAssetRegistryData& MeshAssetRegistry::GetData()
+	{
+		if (!s_Data)
+		{
+			s_Data = enew MeshAssetRegistryData();
+			// -compact_vertices loads the scene meshes for the compact pipelines, half the vertex memory
+			if (CommandLine::HasArg("compact_vertices"))
+				s_Data->vertexFormat = VertexFormat::kCompact;
+			// -split_vertices keeps the positions in their own stream, for passes that only read them
+			else if (CommandLine::HasArg("split_vertices"))
+				s_Data->vertexFormat = VertexFormat::kSplit;
+		}
+		return *s_Data;
+	}
+
+	// "assets/Models/../models/cube.glb" and "Assets\models\cube.glb" are the same file
+	std::string MeshAssetRegistry::GetKey(const std::filesystem::path& path)
+	{
+		return Utils::NormalizePath(path);
+	}
+
+	SharedPtr<MeshSource> MeshAssetRegistry::Load(const std::filesystem::path& path)
+	{
+		auto& meshSources = GetData().meshSources;
+		std::string key = GetKey(path);
+
+		auto it = meshSources.find(key);
+		if (it != meshSources.end())
+			return it->second;
+
+		SharedPtr<MeshSource> meshSource = MakeShared<MeshSource>();
+		meshSource->vertexFormat = GetData().vertexFormat;
+		meshSource->Load(path);
+
+		// Files that failed to load aren't cached, the next load tries again
+		if (meshSource->bHasMesh)
+			meshSources.emplace(std::move(key), meshSource);
+
+		return meshSource;
+	}
+
+	uint32_t MeshAssetRegistry::CollectGarbage()
+	{
+		if (!s_Data)
+			return 0;
+
+		uint32_t releasedCount = 0;
+		auto& meshSources = s_Data->meshSources;
+		for (auto it = meshSources.begin(); it != meshSources.end();)
+		{
+			if (it->second.GetRefCount() == 1)
+			{
+				ED_LOG_INFO("Releasing unused mesh {}", it->first);
+				it = meshSources.erase(it);
+				releasedCount++;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		return releasedCount;
+	}
+
+	void MeshAssetRegistry::Shutdown()
+	{
+		edelete s_Data;
+		s_Data = nullptr;
+	}
+
+	uint32_t MeshAssetRegistry::GetLoadedCount()
+	{
+		return s_Data ? static_cast<uint32_t>(s_Data->meshSources.size()) : 0;
+	}
+}
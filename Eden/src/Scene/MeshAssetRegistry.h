@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "Core/Memory/SharedPtr.h"
+
+namespace Eden
+{
+	struct MeshSource;
+	struct MeshAssetRegistryData;
+
+	/*
+	 * Loaded mesh sources, keyed by their normalized path.
+	 * Every component that asks for the same file gets the same mesh source, so a file is parsed and uploaded once
+	 * and memory grows with the number of unique meshes, not with the number of entities.
+	 * Mesh sources handed out by the registry are shared and must not be modified or reloaded in place,
+	 * load a different path instead. Only used from the main thread.
+	 */
+	class MeshAssetRegistry
+	{
+	public:
+		// Returns the cached mesh source of the path, loading it the first time
+		static SharedPtr<MeshSource> Load(const std::filesystem::path& path);
+
+		// Releases the mesh sources that only the registry references, returns how many were released
+		static uint32_t CollectGarbage();
+		static void Shutdown();
+
+		static uint32_t GetLoadedCount();
+		static std::string GetKey(const std::filesystem::path& path);
+
+	private:
+		static MeshAssetRegistryData& GetData();
+
+	private:
+		inline static MeshAssetRegistryData* s_Data = nullptr;
+	};
+}
@@ -0,0 +1,1041 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/gtc/packing.hpp>
+
+#include "MeshSource.h"
+
+namespace Eden::MeshOptimizer
+{
+	// Forsyth's scoring, "Linear-Speed Vertex Cache Optimisation"
+	static constexpr uint32_t kScoreCacheSize = 32;
+	static constexpr uint32_t kScoreValenceSize = 32;
+	static constexpr float kLastTriangleScore = 0.75f;
+	static constexpr float kCacheDecayPower = 1.5f;
+	static constexpr float kValenceBoostScale = 2.0f;
+	static constexpr float kValenceBoostPower = 0.5f;
+
+	struct ScoreTables
+	{
+		float cache[kScoreCacheSize];
+		float valence[kScoreValenceSize];
+
+		ScoreTables()
+		{
+			for (uint32_t i = 0; i < kScoreCacheSize; ++i)
+			{
+				// The vertices of the last triangle score the same, whichever way it was wound
+				cache[i] = i < 3 ? kLastTriangleScore : std::pow(1.0f - static_cast<float>(i - 3) / static_cast<float>(kScoreCacheSize - 3), kCacheDecayPower);
+			}
+			valence[0] = 0.0f;
+			for (uint32_t i = 1; i < kScoreValenceSize; ++i)
+				valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+		}
+	};
+
+	// Vertices with few triangles left are boosted so they don't stay around as lone triangles
+	static float GetVertexScore(const ScoreTables& tables, int32_t cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+		score += remainingTriangles < kScoreValenceSize ? tables.valence[remainingTriangles] : kValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+		return score;
+	}
+
+	uint32_t Optimize(VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount, Stats& stats)
+	{
+		bool bIsValid = indexCount % 3 == 0 && std::all_of(indices, indices + indexCount, [vertexCount](uint32_t index) { return index < vertexCount; });
+		size_t sourceCacheMisses = bIsValid ? CountCacheMisses(indices, indexCount, vertexCount) : 0;
+		stats.sourceVertexCount += vertexCount;
+		stats.sourceCacheMisses += sourceCacheMisses;
+		stats.indexCount += indexCount;
+		if (!bIsValid)
+		{
+			stats.vertexCount += vertexCount;
+			return vertexCount;
+		}
+
+		vertexCount = WeldVertices(vertices, vertexCount, indices, indexCount);
+		OptimizeVertexCache(indices, indexCount, vertexCount);
+		OptimizeOverdraw(indices, indexCount, &vertices[0].position.x, sizeof(VertexData), vertexCount);
+		vertexCount = OptimizeVertexFetch(vertices, vertexCount, indices, indexCount);
+
+		stats.vertexCount += vertexCount;
+		stats.cacheMisses += CountCacheMisses(indices, indexCount, vertexCount);
+		return vertexCount;
+	}
+
+	uint32_t WeldVertices(VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount)
+	{
+		std::unordered_map<VertexData, uint32_t> uniqueVertices;
+		uniqueVertices.reserve(vertexCount);
+		std::vector<uint32_t> remap(vertexCount);
+
+		uint32_t uniqueCount = 0;
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			auto [it, bInserted] = uniqueVertices.try_emplace(vertices[v], uniqueCount);
+			if (bInserted)
+				vertices[uniqueCount++] = vertices[v];
+			remap[v] = it->second;
+		}
+
+		for (size_t i = 0; i < indexCount; ++i)
+			indices[i] = remap[indices[i]];
+
+		return uniqueCount;
+	}
+
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+	{
+		static const ScoreTables tables;
+
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+
+		// Triangles of every vertex, the ones not emitted yet are kept first in each list
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+			adjacencyOffsets[indices[i] + 1]++;
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+		std::vector<uint32_t> remainingTriangles(vertexCount);
+		std::vector<uint32_t> adjacency(indexCount);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t v = indices[i];
+			adjacency[adjacencyOffsets[v] + remainingTriangles[v]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			vertexScores[v] = GetVertexScore(tables, -1, remainingTriangles[v]);
+
+		std::vector<float> triangleScores(triangleCount);
+		for (size_t t = 0; t < triangleCount; ++t)
+			triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+		std::vector<uint32_t> output(indexCount);
+		std::vector<bool> emitted(triangleCount, false);
+		uint32_t cache[kScoreCacheSize + 3];
+		uint32_t cacheCount = 0;
+		size_t deadEndCursor = 0;
+
+		size_t bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+		for (size_t outputTriangle = 0; outputTriangle < triangleCount; ++outputTriangle)
+		{
+			// None of the cached vertices has triangles left, the next one in the input order starts over
+			if (bestTriangle == SIZE_MAX)
+			{
+				while (emitted[deadEndCursor])
+					deadEndCursor++;
+				bestTriangle = deadEndCursor;
+			}
+
+			const uint32_t* triangle = &indices[bestTriangle * 3];
+			std::copy(triangle, triangle + 3, &output[outputTriangle * 3]);
+			emitted[bestTriangle] = true;
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				uint32_t v = triangle[k];
+				uint32_t* triangles = &adjacency[adjacencyOffsets[v]];
+				uint32_t* last = triangles + remainingTriangles[v] - 1;
+				*std::find(triangles, last, static_cast<uint32_t>(bestTriangle)) = *last;
+				remainingTriangles[v]--;
+			}
+
+			// The triangle vertices move to the front of the LRU cache, the others are pushed back
+			uint32_t newCache[kScoreCacheSize + 3];
+			uint32_t newCacheCount = 0;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				if (std::find(newCache, newCache + newCacheCount, triangle[k]) == newCache + newCacheCount)
+					newCache[newCacheCount++] = triangle[k];
+			}
+			for (uint32_t c = 0; c < cacheCount; ++c)
+			{
+				if (cache[c] != triangle[0] && cache[c] != triangle[1] && cache[c] != triangle[2])
+					newCache[newCacheCount++] = cache[c];
+			}
+
+			for (uint32_t c = 0; c < newCacheCount; ++c)
+			{
+				uint32_t v = newCache[c];
+				cachePositions[v] = c < kScoreCacheSize ? static_cast<int32_t>(c) : -1;
+				vertexScores[v] = GetVertexScore(tables, cachePositions[v], remainingTriangles[v]);
+			}
+
+			// Only the triangles of the vertices that moved change their score, the best one is among them
+			bestTriangle = SIZE_MAX;
+			float bestScore = -1.0f;
+			for (uint32_t c = 0; c < newCacheCount; ++c)
+			{
+				uint32_t v = newCache[c];
+				const uint32_t* triangles = &adjacency[adjacencyOffsets[v]];
+				for (uint32_t a = 0; a < remainingTriangles[v]; ++a)
+				{
+					uint32_t t = triangles[a];
+					float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+					triangleScores[t] = score;
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = t;
+					}
+				}
+			}
+
+			cacheCount = std::min(newCacheCount, kScoreCacheSize);
+			std::copy(newCache, newCache + cacheCount, cache);
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	struct Cluster
+	{
+		size_t firstTriangle;
+		size_t triangleCount;
+		float sortKey;
+	};
+
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t stride, uint32_t vertexCount, float threshold)
+	{
+		size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+
+		auto readPosition = [&](uint32_t index)
+		{
+			const float* position = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * stride);
+			return glm::vec3(position[0], position[1], position[2]);
+		};
+
+		// FIFO cache simulation, a vertex is cached while less than kFIFOCacheSize misses happened since it was loaded
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = kFIFOCacheSize + 1;
+		auto countMisses = [&](size_t t)
+		{
+			uint32_t misses = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				uint32_t v = indices[t * 3 + k];
+				if (timestamp - cacheTimestamps[v] > kFIFOCacheSize)
+				{
+					cacheTimestamps[v] = timestamp++;
+					misses++;
+				}
+			}
+			return misses;
+		};
+		auto flushCache = [&]() { timestamp += kFIFOCacheSize + 1; };
+
+		// Hard boundaries are where the cache order already starts over, every vertex of the triangle misses
+		std::vector<uint32_t> triangleMisses(triangleCount);
+		std::vector<size_t> hardBoundaries;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			triangleMisses[t] = countMisses(t);
+			if (t == 0 || triangleMisses[t] == 3)
+				hardBoundaries.push_back(t);
+		}
+		hardBoundaries.push_back(triangleCount);
+
+		// Soft boundaries split a cluster once the part before the split has an ACMR close to the one of the whole cluster
+		std::vector<Cluster> clusters;
+		for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+		{
+			size_t first = hardBoundaries[h];
+			size_t end = hardBoundaries[h + 1];
+			size_t clusterMisses = 0;
+			for (size_t t = first; t < end; ++t)
+				clusterMisses += triangleMisses[t];
+			float maxACMR = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - first);
+
+			flushCache();
+			size_t start = first;
+			size_t misses = 0;
+			for (size_t t = first; t < end; ++t)
+			{
+				misses += countMisses(t);
+				if (t + 1 < end && static_cast<float>(misses) / static_cast<float>(t + 1 - start) <= maxACMR)
+				{
+					clusters.push_back({ start, t + 1 - start, 0.0f });
+					start = t + 1;
+					misses = 0;
+					flushCache();
+				}
+			}
+			clusters.push_back({ start, end - start, 0.0f });
+		}
+
+		if (clusters.size() < 2)
+			return;
+
+		// Clusters facing away from the center of the mesh are more likely to occlude the others
+		std::vector<glm::vec3> clusterCenters(clusters.size());
+		std::vector<glm::vec3> clusterNormals(clusters.size());
+		glm::vec3 meshCenter(0.0f);
+		float meshArea = 0.0f;
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			glm::vec3 center(0.0f);
+			glm::vec3 normal(0.0f);
+			float area = 0.0f;
+			for (size_t t = clusters[c].firstTriangle; t < clusters[c].firstTriangle + clusters[c].triangleCount; ++t)
+			{
+				glm::vec3 v0 = readPosition(indices[t * 3]);
+				glm::vec3 v1 = readPosition(indices[t * 3 + 1]);
+				glm::vec3 v2 = readPosition(indices[t * 3 + 2]);
+				glm::vec3 areaNormal = glm::cross(v1 - v0, v2 - v0);
+				float triangleArea = glm::length(areaNormal);
+
+				center += (v0 + v1 + v2) * (triangleArea / 3.0f);
+				normal += areaNormal;
+				area += triangleArea;
+			}
+
+			meshCenter += center;
+			meshArea += area;
+			clusterCenters[c] = area > 0.0f ? center / area : center;
+			float normalLength = glm::length(normal);
+			clusterNormals[c] = normalLength > 0.0f ? normal / normalLength : normal;
+		}
+		if (meshArea > 0.0f)
+			meshCenter /= meshArea;
+
+		for (size_t c = 0; c < clusters.size(); ++c)
+			clusters[c].sortKey = glm::dot(clusterCenters[c] - meshCenter, clusterNormals[c]);
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indexCount);
+		for (const Cluster& cluster : clusters)
+			output.insert(output.end(), indices + cluster.firstTriangle * 3, indices + (cluster.firstTriangle + cluster.triangleCount) * 3);
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	uint32_t OptimizeVertexFetch(VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+		uint32_t usedCount = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t& newIndex = remap[indices[i]];
+			if (newIndex == UINT32_MAX)
+				newIndex = usedCount++;
+			indices[i] = newIndex;
+		}
+
+		std::vector<VertexData> reordered(usedCount);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			if (remap[v] != UINT32_MAX)
+				reordered[remap[v]] = vertices[v];
+		}
+		std::copy(reordered.begin(), reordered.end(), vertices);
+
+		return usedCount;
+	}
+
+	size_t CountCacheMisses(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+	{
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+		size_t misses = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t v = indices[i];
+			if (timestamp - cacheTimestamps[v] > cacheSize)
+			{
+				cacheTimestamps[v] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	// Squared distance to a set of planes, each weighted by the area of its triangle
+	struct Quadric
+	{
+		float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f, a01 = 0.0f, a02 = 0.0f, a12 = 0.0f;
+		float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+		float c = 0.0f;
+		float weight = 0.0f;
+
+		void AddPlane(const glm::vec3& normal, float distance, float planeWeight)
+		{
+			glm::vec3 n = normal * planeWeight;
+			a00 += n.x * normal.x;
+			a11 += n.y * normal.y;
+			a22 += n.z * normal.z;
+			a01 += n.x * normal.y;
+			a02 += n.x * normal.z;
+			a12 += n.y * normal.z;
+			b0 += n.x * distance;
+			b1 += n.y * distance;
+			b2 += n.z * distance;
+			c += planeWeight * distance * distance;
+			weight += planeWeight;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a00 += other.a00;
+			a11 += other.a11;
+			a22 += other.a22;
+			a01 += other.a01;
+			a02 += other.a02;
+			a12 += other.a12;
+			b0 += other.b0;
+			b1 += other.b1;
+			b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// Average over the planes
+		float GetError(const glm::vec3& p) const
+		{
+			if (weight <= 0.0f)
+				return 0.0f;
+
+			float q = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z + 2.0f * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+					  2.0f * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+			return std::max(q, 0.0f) / weight;
+		}
+	};
+
+	// Vertices are classified on the welded positions, the vertices of a seam are the two sides of one position
+	enum class CollapseKind : uint8_t
+	{
+		Manifold, // collapses onto any neighbor
+		Seam, // collapses along the seam, together with the vertex on the other side
+		Locked,
+	};
+
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		uint32_t seamFrom; // the other side of a seam collapse, UINT32_MAX for the other collapses
+		uint32_t seamTo;
+		float cost; // squared relative error
+	};
+
+	// A collapse is rejected when it turns one of the remaining triangles more than this, cos(75 degrees)
+	static constexpr float kMinCollapseNormalDot = 0.25f;
+
+	static uint64_t MakeEdgeKey(uint32_t a, uint32_t b)
+	{
+		return static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+	}
+
+	size_t Simplify(const VertexData* vertices, uint32_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float targetError,
+		uint32_t* outIndices, float* outError, const SimplifyOptions& options)
+	{
+		std::copy(indices, indices + indexCount, outIndices);
+		if (outError)
+			*outError = 0.0f;
+
+		bool bIsValid = indexCount % 3 == 0 && std::all_of(indices, indices + indexCount, [vertexCount](uint32_t index) { return index < vertexCount; });
+		if (!bIsValid || indexCount <= targetIndexCount)
+			return indexCount;
+
+		// Positions relative to the bounds of the used vertices, the errors don't depend on the size of the mesh
+		std::vector<bool> usedVertices(vertexCount, false);
+		glm::vec3 boundsMin(FLT_MAX);
+		glm::vec3 boundsMax(-FLT_MAX);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			usedVertices[indices[i]] = true;
+			boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+			boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+		}
+		glm::vec3 extent = boundsMax - boundsMin;
+		float size = std::max(std::max(extent.x, extent.y), extent.z);
+		if (size <= 0.0f)
+			return indexCount;
+
+		std::vector<glm::vec3> positions(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			positions[v] = (vertices[v].position - boundsMin) / size;
+
+		// Vertices sharing a position are the sides of a seam, the two sides of a simple seam are twins
+		std::unordered_map<glm::vec3, uint32_t> uniquePositions;
+		uniquePositions.reserve(vertexCount);
+		std::vector<uint32_t> positionIds(vertexCount, UINT32_MAX);
+		std::vector<uint32_t> positionVertexCounts;
+		std::vector<uint32_t> positionFirstVertices;
+		std::vector<uint32_t> seamTwins(vertexCount, UINT32_MAX);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			if (!usedVertices[v])
+				continue;
+
+			auto [it, bInserted] = uniquePositions.try_emplace(vertices[v].position, static_cast<uint32_t>(positionVertexCounts.size()));
+			if (bInserted)
+			{
+				positionVertexCounts.push_back(0);
+				positionFirstVertices.push_back(v);
+			}
+			uint32_t p = it->second;
+			positionIds[v] = p;
+			if (++positionVertexCounts[p] == 2)
+			{
+				seamTwins[v] = positionFirstVertices[p];
+				seamTwins[positionFirstVertices[p]] = v;
+			}
+		}
+
+		// Sorted so the triangles sharing an edge are next to each other
+		std::vector<uint64_t> edges;
+		edges.reserve(indexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (size_t k = 0; k < 3; ++k)
+			{
+				uint32_t a = positionIds[indices[i + k]];
+				uint32_t b = positionIds[indices[i + (k + 1) % 3]];
+				if (a != b)
+					edges.push_back(MakeEdgeKey(a, b));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		// Edges of more than two triangles keep their vertices, so do open edges and the seams reaching them
+		std::vector<bool> lockedPositions(positionVertexCounts.size(), false);
+		for (size_t e = 0; e < edges.size();)
+		{
+			size_t count = 1;
+			while (e + count < edges.size() && edges[e + count] == edges[e])
+				count++;
+			for (uint32_t p : { static_cast<uint32_t>(edges[e] >> 32), static_cast<uint32_t>(edges[e] & UINT32_MAX) })
+			{
+				if (count > 2 || (count == 1 && (options.bLockBorders || positionVertexCounts[p] > 1)))
+					lockedPositions[p] = true;
+			}
+			e += count;
+		}
+
+		std::vector<bool> lockedVertices(vertexCount, true);
+		for (uint32_t v = 0; v < vertexCount; ++v)
+		{
+			if (usedVertices[v])
+				lockedVertices[v] = lockedPositions[positionIds[v]];
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			const glm::vec3& p0 = positions[indices[i]];
+			glm::vec3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+			float length = glm::length(normal);
+			if (length <= 0.0f)
+				continue;
+
+			normal /= length;
+			float distance = -glm::dot(normal, p0);
+			for (size_t k = 0; k < 3; ++k)
+				quadrics[indices[i + k]].AddPlane(normal, distance, length * 0.5f);
+		}
+
+		size_t triangleCount = indexCount / 3;
+		size_t targetTriangleCount = targetIndexCount / 3;
+		float errorLimit = targetError * targetError;
+		float maxError = 0.0f;
+
+		std::vector<uint64_t> vertexEdges;
+		vertexEdges.reserve(indexCount);
+		std::vector<uint32_t> openEdgeCounts(vertexCount);
+		std::vector<uint32_t> openNeighbors(vertexCount * 2); // the first two open edges of every vertex
+		std::vector<CollapseKind> kinds(vertexCount);
+		std::vector<Collapse> bestCollapses(vertexCount);
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<uint32_t> adjacencyCounts(vertexCount);
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<bool> touchedVertices(vertexCount);
+
+		auto getCost = [&](uint32_t from, uint32_t to)
+		{
+			Quadric quadric = quadrics[from];
+			quadric.Add(quadrics[to]);
+			const VertexData& fromVertex = vertices[from];
+			const VertexData& toVertex = vertices[to];
+			glm::vec3 normalDelta = fromVertex.normal - toVertex.normal;
+			glm::vec2 uvDelta = fromVertex.uv - toVertex.uv;
+			glm::vec3 edge = positions[from] - positions[to];
+			float attributeError = options.normalWeight * glm::dot(normalDelta, normalDelta) + options.uvWeight * glm::dot(uvDelta, uvDelta);
+			return quadric.GetError(positions[to]) + attributeError * glm::dot(edge, edge);
+		};
+
+		// Triangles using both vertices disappear, the others move their corner to the kept vertex
+		auto checkCollapse = [&](uint32_t from, uint32_t to, uint32_t& removedTriangles)
+		{
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a)
+			{
+				const uint32_t* triangle = &outIndices[adjacency[a] * 3];
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				{
+					removedTriangles++;
+					continue;
+				}
+
+				glm::vec3 corners[3];
+				glm::vec3 movedCorners[3];
+				for (size_t k = 0; k < 3; ++k)
+				{
+					corners[k] = positions[triangle[k]];
+					movedCorners[k] = positions[triangle[k] == from ? to : triangle[k]];
+				}
+				glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+				glm::vec3 movedNormal = glm::cross(movedCorners[1] - movedCorners[0], movedCorners[2] - movedCorners[0]);
+				if (glm::dot(normal, movedNormal) <= kMinCollapseNormalDot * glm::length(normal) * glm::length(movedNormal))
+					return false;
+			}
+			return true;
+		};
+
+		auto applyCollapse = [&](uint32_t from, uint32_t to)
+		{
+			remap[from] = to;
+			quadrics[to].Add(quadrics[from]);
+			for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; ++a)
+			{
+				const uint32_t* triangle = &outIndices[adjacency[a] * 3];
+				touchedVertices[triangle[0]] = touchedVertices[triangle[1]] = touchedVertices[triangle[2]] = true;
+			}
+		};
+
+		// Every pass collapses the cheapest edges whose neighborhoods don't overlap, so each collapse is checked against
+		// the triangles it actually changes, then the triangles are remapped and the degenerate ones dropped
+		while (triangleCount > targetTriangleCount)
+		{
+			// Edges of a single triangle in vertex space are the open edges of the mesh and the edges along seams
+			vertexEdges.clear();
+			for (size_t i = 0; i < triangleCount * 3; i += 3)
+			{
+				for (size_t k = 0; k < 3; ++k)
+					vertexEdges.push_back(MakeEdgeKey(outIndices[i + k], outIndices[i + (k + 1) % 3]));
+			}
+			std::sort(vertexEdges.begin(), vertexEdges.end());
+			std::fill(openEdgeCounts.begin(), openEdgeCounts.end(), 0);
+			for (size_t e = 0; e < vertexEdges.size();)
+			{
+				size_t count = 1;
+				while (e + count < vertexEdges.size() && vertexEdges[e + count] == vertexEdges[e])
+					count++;
+				if (count == 1)
+				{
+					uint32_t a = static_cast<uint32_t>(vertexEdges[e] >> 32);
+					uint32_t b = static_cast<uint32_t>(vertexEdges[e] & UINT32_MAX);
+					for (auto [v, neighbor] : { std::make_pair(a, b), std::make_pair(b, a) })
+					{
+						if (openEdgeCounts[v] < 2)
+							openNeighbors[v * 2 + openEdgeCounts[v]] = neighbor;
+						openEdgeCounts[v]++;
+					}
+				}
+				e += count;
+			}
+
+			// A seam vertex and its twin each have the two open edges of the seam, seam ends and corners stay
+			for (uint32_t v = 0; v < vertexCount; ++v)
+			{
+				uint32_t twin = seamTwins[v];
+				if (lockedVertices[v])
+					kinds[v] = CollapseKind::Locked;
+				else if (positionVertexCounts[positionIds[v]] == 1)
+					kinds[v] = openEdgeCounts[v] == 0 || !options.bLockBorders ? CollapseKind::Manifold : CollapseKind::Locked;
+				else if (positionVertexCounts[positionIds[v]] == 2 && openEdgeCounts[v] == 2 && openEdgeCounts[twin] == 2)
+					kinds[v] = CollapseKind::Seam;
+				else
+					kinds[v] = CollapseKind::Locked;
+			}
+
+			// The cheapest collapse of every vertex, the others are tried again in the next passes
+			for (uint32_t v = 0; v < vertexCount; ++v)
+				bestCollapses[v] = { v, v, UINT32_MAX, UINT32_MAX, FLT_MAX };
+			for (size_t i = 0; i < triangleCount * 3; i += 3)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					// Edges of a vertex without open edges are in two triangles, each one adds them once
+					uint32_t a = outIndices[i + k];
+					uint32_t b = outIndices[i + (k + 1) % 3];
+					if (a > b && (kinds[a] == CollapseKind::Manifold || kinds[b] == CollapseKind::Manifold))
+						continue;
+
+					for (auto [from, to] : { std::make_pair(a, b), std::make_pair(b, a) })
+					{
+						if (kinds[from] == CollapseKind::Manifold)
+						{
+							float cost = getCost(from, to);
+							if (cost < bestCollapses[from].cost)
+								bestCollapses[from] = { from, to, UINT32_MAX, UINT32_MAX, cost };
+							continue;
+						}
+						if (kinds[from] != CollapseKind::Seam || (openNeighbors[from * 2] != to && openNeighbors[from * 2 + 1] != to))
+							continue;
+
+						// The other side moves along its own open edge to the same position, to the same vertex at the end of a seam
+						uint32_t seamFrom = seamTwins[from];
+						uint32_t seamTo = UINT32_MAX;
+						for (uint32_t n = 0; n < 2; ++n)
+						{
+							if (positionIds[openNeighbors[seamFrom * 2 + n]] == positionIds[to])
+								seamTo = openNeighbors[seamFrom * 2 + n];
+						}
+						if (seamTo == UINT32_MAX)
+							continue;
+
+						float cost = getCost(from, to) + getCost(seamFrom, seamTo);
+						if (cost < bestCollapses[from].cost)
+							bestCollapses[from] = { from, to, seamFrom, seamTo, cost };
+					}
+				}
+			}
+
+			collapses.clear();
+			for (const Collapse& collapse : bestCollapses)
+			{
+				if (collapse.cost <= errorLimit)
+					collapses.push_back(collapse);
+			}
+			if (collapses.empty())
+				break;
+			std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+			std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+			for (size_t i = 0; i < triangleCount * 3; ++i)
+				adjacencyOffsets[outIndices[i] + 1]++;
+			for (uint32_t v = 0; v < vertexCount; ++v)
+				adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+			adjacency.resize(triangleCount * 3);
+			std::fill(adjacencyCounts.begin(), adjacencyCounts.end(), 0);
+			for (size_t i = 0; i < triangleCount * 3; ++i)
+			{
+				uint32_t v = outIndices[i];
+				adjacency[adjacencyOffsets[v] + adjacencyCounts[v]++] = static_cast<uint32_t>(i / 3);
+			}
+
+			for (uint32_t v = 0; v < vertexCount; ++v)
+				remap[v] = v;
+			std::fill(touchedVertices.begin(), touchedVertices.end(), false);
+
+			size_t remainingTriangles = triangleCount;
+			bool bCollapsed = false;
+			for (const Collapse& collapse : collapses)
+			{
+				if (remainingTriangles <= targetTriangleCount)
+					break;
+				if (touchedVertices[collapse.from] || touchedVertices[collapse.to])
+					continue;
+
+				bool bIsSeam = collapse.seamFrom != UINT32_MAX;
+				if (bIsSeam && (touchedVertices[collapse.seamFrom] || touchedVertices[collapse.seamTo]))
+					continue;
+
+				uint32_t removedTriangles = 0;
+				if (!checkCollapse(collapse.from, collapse.to, removedTriangles) || (bIsSeam && !checkCollapse(collapse.seamFrom, collapse.seamTo, removedTriangles)))
+					continue;
+
+				applyCollapse(collapse.from, collapse.to);
+				if (bIsSeam)
+					applyCollapse(collapse.seamFrom, collapse.seamTo);
+				maxError = std::max(maxError, collapse.cost);
+				remainingTriangles -= std::min<size_t>(removedTriangles, remainingTriangles);
+				bCollapsed = true;
+			}
+			if (!bCollapsed)
+				break;
+
+			size_t writtenIndices = 0;
+			for (size_t i = 0; i < triangleCount * 3; i += 3)
+			{
+				uint32_t a = remap[outIndices[i]];
+				uint32_t b = remap[outIndices[i + 1]];
+				uint32_t c = remap[outIndices[i + 2]];
+				if (a == b || b == c || c == a)
+					continue;
+
+				outIndices[writtenIndices++] = a;
+				outIndices[writtenIndices++] = b;
+				outIndices[writtenIndices++] = c;
+			}
+			triangleCount = writtenIndices / 3;
+		}
+
+		if (outError)
+			*outError = std::sqrt(maxError);
+		return triangleCount * 3;
+	}
+
+	// Levels that don't get under this fraction of the previous triangle count aren't worth their memory
+	static constexpr float kMinLODReduction = 0.85f;
+
+	uint32_t GenerateLODs(const VertexData* vertices, uint32_t vertexCount, const uint32_t* indices, size_t indexCount, std::vector<uint32_t>& outIndices, LODLevel* outLevels)
+	{
+		bool bIsValid = indexCount % 3 == 0 && std::all_of(indices, indices + indexCount, [vertexCount](uint32_t index) { return index < vertexCount; });
+		if (!bIsValid)
+			return 0;
+
+		// Each level is simplified from the previous one, its error is at most the sum of the errors of the steps
+		std::vector<uint32_t> sourceIndices(indices, indices + indexCount);
+		std::vector<uint32_t> levelIndices(indexCount);
+		float error = 0.0f;
+		uint32_t levelCount = 0;
+		while (levelCount + 1 < kMaxLODCount)
+		{
+			size_t targetIndexCount = sourceIndices.size() / 6 * 3;
+			if (targetIndexCount == 0)
+				break;
+
+			float levelError = 0.0f;
+			size_t levelIndexCount = Simplify(vertices, vertexCount, sourceIndices.data(), sourceIndices.size(), targetIndexCount, 1.0f, levelIndices.data(), &levelError);
+			if (levelIndexCount == 0 || static_cast<float>(levelIndexCount) > kMinLODReduction * static_cast<float>(sourceIndices.size()))
+				break;
+
+			OptimizeVertexCache(levelIndices.data(), levelIndexCount, vertexCount);
+			error += levelError;
+			outLevels[levelCount++] = { static_cast<uint32_t>(outIndices.size()), static_cast<uint32_t>(levelIndexCount), error };
+			outIndices.insert(outIndices.end(), levelIndices.begin(), levelIndices.begin() + levelIndexCount);
+			sourceIndices.assign(levelIndices.begin(), levelIndices.begin() + levelIndexCount);
+		}
+
+		return levelCount;
+	}
+
+	// Facing against sharing vertices when growing a meshlet, a triangle facing away from it costs like two new vertices
+	static constexpr float kMeshletConeWeight = 1.0f;
+	// Meshlets whose triangles spread wider than this around the axis, cos(84 degrees), are never backfacing
+	static constexpr float kMinMeshletConeDot = 0.1f;
+	static constexpr uint8_t kNoLocalVertex = 0xFF;
+	static_assert(kMaxMeshletVertices < kNoLocalVertex, "Local vertex indices are stored in a byte");
+
+	uint32_t BuildMeshlets(const VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount,
+		std::vector<Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles)
+	{
+		bool bIsValid = indexCount % 3 == 0 && std::all_of(indices, indices + indexCount, [vertexCount](uint32_t index) { return index < vertexCount; });
+		if (!bIsValid || indexCount == 0)
+			return 0;
+
+		uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+		std::vector<glm::vec3> triangleNormals(triangleCount, glm::vec3(0.0f));
+		for (uint32_t t = 0; t < triangleCount; ++t)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3]].position;
+			glm::vec3 normal = glm::cross(vertices[indices[t * 3 + 1]].position - p0, vertices[indices[t * 3 + 2]].position - p0);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+				triangleNormals[t] = normal / length;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+			adjacencyOffsets[indices[i] + 1]++;
+		for (uint32_t v = 0; v < vertexCount; ++v)
+			adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+		std::vector<uint32_t> adjacency(indexCount);
+		std::vector<uint32_t> adjacencyCounts(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+			adjacency[adjacencyOffsets[indices[i]] + adjacencyCounts[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<bool> emittedTriangles(triangleCount, false);
+		std::vector<uint32_t> candidateMeshlets(triangleCount, UINT32_MAX); // the last meshlet that had the triangle as a candidate
+		std::vector<uint8_t> localVertices(vertexCount, kNoLocalVertex);
+		std::vector<uint32_t> candidates;
+		std::vector<uint32_t> meshletIndices;
+		meshletIndices.reserve(indexCount);
+
+		auto countNewVertices = [&](uint32_t triangle)
+		{
+			uint32_t count = 0;
+			for (uint32_t k = 0; k < 3; ++k)
+				count += localVertices[indices[triangle * 3 + k]] == kNoLocalVertex ? 1 : 0;
+			return count;
+		};
+
+		uint32_t meshletCount = 0;
+		uint32_t nextSeed = 0;
+		while (true)
+		{
+			while (nextSeed < triangleCount && emittedTriangles[nextSeed])
+				nextSeed++;
+			if (nextSeed == triangleCount)
+				break;
+
+			Meshlet meshlet = {};
+			meshlet.vertexOffset = static_cast<uint32_t>(outMeshletVertices.size());
+			meshlet.triangleOffset = static_cast<uint32_t>(outMeshletTriangles.size() / 3);
+			meshlet.indexStart = static_cast<uint32_t>(meshletIndices.size());
+			glm::vec3 normalSum(0.0f);
+			candidates.clear();
+
+			uint32_t triangle = nextSeed;
+			while (triangle != UINT32_MAX)
+			{
+				// The other triangles of the new vertices become candidates
+				emittedTriangles[triangle] = true;
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					uint32_t v = indices[triangle * 3 + k];
+					if (localVertices[v] == kNoLocalVertex)
+					{
+						localVertices[v] = static_cast<uint8_t>(meshlet.vertexCount++);
+						outMeshletVertices.push_back(v);
+						for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; ++a)
+						{
+							uint32_t neighbor = adjacency[a];
+							if (!emittedTriangles[neighbor] && candidateMeshlets[neighbor] != meshletCount)
+							{
+								candidateMeshlets[neighbor] = meshletCount;
+								candidates.push_back(neighbor);
+							}
+						}
+					}
+					outMeshletTriangles.push_back(localVertices[v]);
+					meshletIndices.push_back(v);
+				}
+				normalSum += triangleNormals[triangle];
+				if (++meshlet.triangleCount == kMaxMeshletTriangles)
+					break;
+
+				// The cheapest candidate that still fits, emitted ones are dropped on the way
+				float axisLength = glm::length(normalSum);
+				glm::vec3 axis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f);
+				float bestCost = FLT_MAX;
+				size_t best = candidates.size();
+				for (size_t c = 0; c < candidates.size();)
+				{
+					uint32_t candidate = candidates[c];
+					if (emittedTriangles[candidate])
+					{
+						candidates[c] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+
+					uint32_t newVertices = countNewVertices(candidate);
+					if (meshlet.vertexCount + newVertices <= kMaxMeshletVertices)
+					{
+						float cost = static_cast<float>(newVertices) + kMeshletConeWeight * (1.0f - glm::dot(triangleNormals[candidate], axis));
+						if (cost < bestCost)
+						{
+							bestCost = cost;
+							best = c;
+						}
+					}
+					++c;
+				}
+
+				triangle = UINT32_MAX;
+				if (best < candidates.size())
+				{
+					triangle = candidates[best];
+					candidates[best] = candidates.back();
+					candidates.pop_back();
+				}
+				else if (candidates.empty())
+				{
+					// Small disconnected parts share a meshlet with the next triangles in order, which are close in cache order
+					while (nextSeed < triangleCount && emittedTriangles[nextSeed])
+						nextSeed++;
+					if (nextSeed < triangleCount && meshlet.vertexCount + countNewVertices(nextSeed) <= kMaxMeshletVertices)
+						triangle = nextSeed;
+				}
+			}
+
+			// Bounds of the vertices, the cone covers every triangle normal around their average
+			Math::AABB bounds;
+			for (uint32_t v = meshlet.vertexOffset; v < meshlet.vertexOffset + meshlet.vertexCount; ++v)
+			{
+				const glm::vec3& position = vertices[outMeshletVertices[v]].position;
+				bounds.min = glm::min(bounds.min, position);
+				bounds.max = glm::max(bounds.max, position);
+				localVertices[outMeshletVertices[v]] = kNoLocalVertex;
+			}
+			meshlet.center = bounds.GetCenter();
+			for (uint32_t v = meshlet.vertexOffset; v < meshlet.vertexOffset + meshlet.vertexCount; ++v)
+				meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, vertices[outMeshletVertices[v]].position));
+
+			float axisLength = glm::length(normalSum);
+			float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+			meshlet.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+			for (uint32_t i = meshlet.indexStart; axisLength > 0.0f && i < meshlet.indexStart + meshlet.triangleCount * 3; i += 3)
+			{
+				const glm::vec3& p0 = vertices[meshletIndices[i]].position;
+				glm::vec3 normal = glm::cross(vertices[meshletIndices[i + 1]].position - p0, vertices[meshletIndices[i + 2]].position - p0);
+				float length = glm::length(normal);
+				if (length > 0.0f)
+					minDot = std::min(minDot, glm::dot(normal / length, meshlet.coneAxis));
+			}
+			meshlet.coneCutoff = minDot < kMinMeshletConeDot ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+
+			outMeshlets.push_back(meshlet);
+			meshletCount++;
+		}
+
+		std::copy(meshletIndices.begin(), meshletIndices.end(), indices);
+		return meshletCount;
+	}
+
+	// https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/, zero normals encode to +z
+	static glm::vec2 OctahedronEncode(const glm::vec3& normal)
+	{
+		float length = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+		if (length == 0.0f)
+			return glm::vec2(0.0f);
+
+		glm::vec3 n = normal / length;
+		if (n.z >= 0.0f)
+			return glm::vec2(n.x, n.y);
+
+		glm::vec2 signs(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+		return (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signs;
+	}
+
+	void EncodeCompactVertices(const VertexData* vertices, size_t vertexCount, const Math::AABB& bounds, CompactVertexData* outVertices)
+	{
+		glm::vec3 extent = bounds.max - bounds.min;
+		glm::vec3 inverseExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f, extent.y > 0.0f ? 1.0f / extent.y : 0.0f, extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			const VertexData& vertex = vertices[v];
+			glm::vec3 position = glm::clamp((vertex.position - bounds.min) * inverseExtent, 0.0f, 1.0f);
+
+			CompactVertexData& compactVertex = outVertices[v];
+			compactVertex.positionXY = glm::packUnorm2x16(glm::vec2(position.x, position.y));
+			compactVertex.positionZ = glm::packUnorm2x16(glm::vec2(position.z, 0.0f));
+			compactVertex.normal = glm::packSnorm2x16(OctahedronEncode(vertex.normal));
+			compactVertex.uv = glm::packHalf2x16(vertex.uv);
+		}
+	}
+
+	void SplitVertexStreams(const VertexData* vertices, size_t vertexCount, float* outPositions, VertexAttributes* outAttributes)
+	{
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			const VertexData& vertex = vertices[v];
+			outPositions[v * 3 + 0] = vertex.position.x;
+			outPositions[v * 3 + 1] = vertex.position.y;
+			outPositions[v * 3 + 2] = vertex.position.z;
+			outAttributes[v] = { vertex.uv, vertex.normal };
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Math/Bounds.h"
+
+namespace Eden
+{
+	struct VertexData;
+	struct CompactVertexData;
+	struct VertexAttributes;
+}
+
+/*
+ * Import time optimizations of the triangles of one primitive, the indices are local to its vertices.
+ * Duplicated vertices are welded, triangles are ordered for the post transform vertex cache (Forsyth) then in clusters
+ * for less overdraw (Sander et al.), and vertices are finally stored in the order the triangles first use them.
+ * Vertices can then be encoded to the compact vertex format or split in a position and an attribute stream.
+ * Simplified levels of detail reuse the vertices of the full detail triangles, only their indices are new.
+ * Meshlets split the full detail triangles in small clusters with culling bounds, for cluster culling and mesh shaders.
+ */
+namespace Eden::MeshOptimizer
+{
+	// FIFO cache used to estimate the ACMR, close to the post transform cache of current GPUs
+	constexpr uint32_t kFIFOCacheSize = 16;
+	// Levels of detail of a primitive, the full detail one included
+	constexpr uint32_t kMaxLODCount = 5;
+	// Meshlet limits, the common mesh shader limits with the triangles rounded so the local indices fill 4 byte words
+	constexpr uint32_t kMaxMeshletVertices = 64;
+	constexpr uint32_t kMaxMeshletTriangles = 124;
+
+	// Totals over every optimized primitive of an import
+	struct Stats
+	{
+		size_t sourceVertexCount = 0;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		size_t sourceCacheMisses = 0;
+		size_t cacheMisses = 0;
+		size_t lodIndexCount = 0; // indices of every simplified level
+		float lodTime = 0.0f; // in milliseconds
+		size_t meshletCount = 0;
+		float meshletTime = 0.0f; // in milliseconds
+
+		// Average cache miss ratio, transformed vertices per triangle: 3 without any reuse, around 0.5 for a regular grid
+		float GetSourceACMR() const { return indexCount > 0 ? 3.0f * static_cast<float>(sourceCacheMisses) / static_cast<float>(indexCount) : 0.0f; }
+		float GetACMR() const { return indexCount > 0 ? 3.0f * static_cast<float>(cacheMisses) / static_cast<float>(indexCount) : 0.0f; }
+	};
+
+	// Runs every step below, returns the new vertex count. Triangle lists with an index out of the vertices are left as they are.
+	uint32_t Optimize(VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount, Stats& stats);
+
+	// Keeps the first of the vertices comparing equal, returns the unique vertex count, they are moved to the front
+	uint32_t WeldVertices(VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount);
+
+	void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+
+	// Sorts clusters of cache ordered triangles so the ones facing out of the mesh are drawn first.
+	// Clusters are split while their ACMR stays under threshold times the ACMR of the input.
+	void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t stride, uint32_t vertexCount, float threshold = 1.05f);
+
+	// Vertices in the order of first use, unused ones are dropped. Returns the new vertex count.
+	uint32_t OptimizeVertexFetch(VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount);
+
+	size_t CountCacheMisses(const uint32_t* indices, size_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kFIFOCacheSize);
+
+	// Quantizes the positions inside bounds, the ones out of it are clamped. Normals are octahedral encoded, uvs are half floats.
+	void EncodeCompactVertices(const VertexData* vertices, size_t vertexCount, const Math::AABB& bounds, CompactVertexData* outVertices);
+
+	struct SimplifyOptions
+	{
+		// Attribute differences count like position errors of the collapsed edge length times the weight
+		float normalWeight = 0.25f;
+		float uvWeight = 0.25f;
+		// Vertices on open edges stay in place, the edges shared with other primitives don't crack.
+		// Seams between two sets of attributes (uv and hard normal seams) only collapse along themselves, both sides
+		// together, and the vertices where more than two sets meet are always kept.
+		bool bLockBorders = true;
+	};
+
+	// Quadric error simplification (Garland and Heckbert) by collapsing edges onto one of their vertices, the
+	// triangles keep using the input vertices. Stops at targetIndexCount or when the next collapse would go over
+	// targetError. Errors are relative to the largest side of the bounds of the used vertices.
+	// outIndices needs room for indexCount indices, returns the index count written to it.
+	size_t Simplify(const VertexData* vertices, uint32_t vertexCount, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float targetError,
+		uint32_t* outIndices, float* outError = nullptr, const SimplifyOptions& options = {});
+
+	struct LODLevel
+	{
+		uint32_t indexStart; // in the indices of GenerateLODs
+		uint32_t indexCount;
+		float error; // relative like the Simplify errors
+	};
+
+	// Chain of simplified levels, each with about half the triangles of the previous one and ordered for the vertex
+	// cache. Stops early when a level keeps more than 85% of the triangles of the previous one.
+	// Indices of the levels are appended to outIndices, returns the level count, up to kMaxLODCount - 1.
+	uint32_t GenerateLODs(const VertexData* vertices, uint32_t vertexCount, const uint32_t* indices, size_t indexCount, std::vector<uint32_t>& outIndices, LODLevel* outLevels);
+
+	// Triangles of a primitive sharing at most kMaxMeshletVertices vertices, with the bounds used to cull them
+	struct Meshlet
+	{
+		glm::vec3 center; // bounding sphere, vertex space
+		float radius;
+		glm::vec3 coneAxis; // average facing of the triangles
+		float coneCutoff; // sine of the angle between the axis and its furthest triangle normal, 1 when the cone can't cull
+		uint32_t vertexOffset; // in the meshlet vertices, which index the primitive vertices
+		uint32_t triangleOffset; // in the meshlet triangles, 3 local vertex indices per triangle
+		uint32_t indexStart; // its triangles are also contiguous in the indices, in the same order
+		uint32_t vertexCount;
+		uint32_t triangleCount;
+		uint32_t padding[3];
+	};
+
+	// Every triangle of a meshlet faces away from a viewer at viewPosition, in the space of the meshlet bounds
+	inline bool IsBackfacing(const Meshlet& meshlet, const glm::vec3& viewPosition)
+	{
+		glm::vec3 direction = meshlet.center - viewPosition;
+		return glm::dot(direction, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(direction) + meshlet.radius;
+	}
+
+	// Grows meshlets from adjacent triangles, preferring the ones that add the fewest vertices and face like the meshlet.
+	// The indices are reordered so every meshlet is a contiguous range of them, the meshlets follow the order of the
+	// triangles they start from. Meshlets are appended to outMeshlets, with their local vertices and triangles.
+	// Returns the meshlet count, 0 for triangle lists with an index out of the vertices, which are left as they are.
+	uint32_t BuildMeshlets(const VertexData* vertices, uint32_t vertexCount, uint32_t* indices, size_t indexCount,
+		std::vector<Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles);
+
+	// outPositions are 3 floats per vertex, without padding
+	void SplitVertexStreams(const VertexData* vertices, size_t vertexCount, float* outPositions, VertexAttributes* outAttributes);
+}
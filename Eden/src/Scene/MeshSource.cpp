@@ -1,4 +1,9 @@
 #include "MeshSource.h"
+// Included before the tinygltf implementation, including tiny_gltf.h after it would define it twice
+#include "GLTFMappedModel.h"
+
+#include <algorithm>
+#include <atomic>
 
 #include <stb/stb_image.h>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -15,13 +20,37 @@
 #include "Core/Log.h"
 #include "Core/Base.h"
 #include "Core/Assertions.h"
+#include "Core/JobSystem.h"
 #include "RHI/DynamicRHI.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/TextureCache.h"
+#include "Renderer/ImageDecoder.h"
+#include "Scene/CookedMesh.h"
+#include "Scene/MeshOptimizer.h"
+#include "Profiling/Timer.h"
+#include "Math/BatchTransform.h"
+#include "Utilities/Utils.h"
 
 namespace Eden
 {
+	// Ids start at 1, 0 is the id of default constructed materials and mesh sources
+	static std::atomic<uint32_t> s_NextMeshSourceId{ 1 };
+	static std::atomic<uint32_t> s_NextMaterialId{ 1 };
+
+	void MeshSource::Load(std::filesystem::path file)
+	{
+		std::filesystem::path sourceFile = file;
+		if (file.extension() == CookedMesh::kExtension)
+			sourceFile.replace_extension();
+
+		if (LoadCooked(CookedMesh::GetCookedPath(sourceFile), sourceFile))
+			return;
+
+		LoadGLTF(sourceFile, true);
+	}
+
 	// Based on Sascha Willems gltfloading.cpp
-	void MeshSource::LoadGLTF(std::filesystem::path file)
+	void MeshSource::LoadGLTF(std::filesystem::path file, bool bCook /*= false*/)
 	{
 		// Destroy the current mesh source
 		if (bHasMesh)
@@ -32,16 +61,22 @@ namespace Eden
 		desc.elementCount = 1;
 		desc.stride = sizeof(glm::mat4);
 
+		m_ImportPath = file;
+		m_ImageTextures.clear();
+		m_EncodedImages.clear();
+		m_TexturesCreated = 0;
+		m_TexturesReused = 0;
+		m_OptimizeStats = {};
+
+		// The file and its buffers are mapped, accessors are converted from the mapped pages
 		tinygltf::Model gltfModel;
-		tinygltf::TinyGLTF loader;
+		GLTF::MappedModel mappedModel;
 		std::string err;
 		std::string warn;
 		bool bIsGLTFModelValid = false;
 
-		if (file.extension() == ".gltf")
-			bIsGLTFModelValid = loader.LoadASCIIFromFile(&gltfModel, &err, &warn, file.string());
-		else if (file.extension() == ".glb")
-			bIsGLTFModelValid = loader.LoadBinaryFromFile(&gltfModel, &err, &warn, file.string());
+		if (file.extension() == ".gltf" || file.extension() == ".glb")
+			bIsGLTFModelValid = mappedModel.Load(file, gltfModel, err, warn, &MeshSource::LoadCachedImageData, this);
 
 		ED_LOG_INFO("Starting {} file loading", file);
 
@@ -52,18 +87,15 @@ namespace Eden
 			ED_LOG_ERROR("{}", err.c_str());
 
 		ensureMsg(bIsGLTFModelValid, "Failed to parse GLTF Model!");
-
-
-		uint32_t blackTextureData = 0x00000000;
-		TextureDesc blackDesc = {};
-		blackDesc.data = &blackTextureData;
-		blackDesc.width = 1;
-		blackDesc.height = 1;
-		blackDesc.bIsStorage = false;
-		blackDesc.bGenerateMips = false;
+		m_Buffers = mappedModel.GetBuffers();
+		id = s_NextMeshSourceId++;
+		m_FirstMaterialId = s_NextMaterialId.fetch_add(static_cast<uint32_t>(gltfModel.materials.size()));
+		m_GLTFMeshes.assign(gltfModel.meshes.size(), -1);
+		m_GLTFMaterials.assign(gltfModel.materials.size() + 1, -1);
+		m_ImageTextures.resize(gltfModel.images.size());
+		DecodeImages(gltfModel);
 
 		const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
-		m_BlackTexture = RHICreateTexture(&blackDesc);
 
 		std::vector<VertexData> vertices;
 		std::vector<uint32_t> indices;
@@ -76,150 +108,648 @@ namespace Eden
 		vertexCount = static_cast<uint32_t>(vertices.size());
 		indexCount = static_cast<uint32_t>(indices.size());
 
-		BufferDesc vbDesc;
-		vbDesc.elementCount = vertexCount;
-		vbDesc.stride = sizeof(VertexData);
-		vbDesc.usage = BufferDesc::Vertex_Index;
-		meshVb = RHICreateBuffer(&vbDesc, vertices.data());
-
-		BufferDesc ibDesc;
-		ibDesc.elementCount = indexCount;
-		ibDesc.stride = sizeof(uint32_t);
-		ibDesc.usage = BufferDesc::Vertex_Index;
-		meshIb = RHICreateBuffer(&ibDesc, indices.data());
+		for (auto& instance : instances)
+			bounds.Merge(instance.bounds);
+		boundingSphere = Math::BoundingSphere::FromAABB(bounds);
+		m_GLTFMeshes.clear();
+		m_GLTFMaterials.clear();
+
+		CreateVertexBuffer(vertices.data());
+
+		// Indices are relative to their submesh, its vertexStart is the base vertex of the draws, so they only need
+		// 32 bits when a single primitive has more than 65536 vertices
+		std::vector<uint16_t> indices16;
+		if (!indices.empty() && *std::max_element(indices.begin(), indices.end()) <= UINT16_MAX)
+		{
+			indices16.resize(indices.size());
+			for (size_t i = 0; i < indices.size(); ++i)
+				indices16[i] = static_cast<uint16_t>(indices[i]);
+		}
+		uint32_t indexStride = indices16.empty() ? sizeof(uint32_t) : sizeof(uint16_t);
+		const void* indexData = indices16.empty() ? static_cast<const void*>(indices.data()) : indices16.data();
+
+		GeometryStream indexStream = { indexStride, indexData };
+		GeometryBuffers::Allocate(&indexStream, 1, indexCount, indexSlice);
 		bHasMesh = true;
 
+		if (bCook)
+			Cook(gltfModel, mappedModel, vertices, indexData, indexStride);
+
+		// Everything was converted and uploaded, the mapped pages aren't needed anymore
+		size_t mappedSize = mappedModel.GetMappedSize();
+		m_Buffers.clear();
+		mappedModel.Release();
+
 		ED_LOG_INFO("	{} nodes were loaded!", gltfModel.nodes.size());
-		ED_LOG_INFO("	{} meshes were loaded!", gltfModel.meshes.size());
+		ED_LOG_INFO("	{} meshes were loaded, drawn by {} nodes", meshes.size(), instances.size());
 		ED_LOG_INFO("	{} textures were loaded!", gltfModel.textures.size());
+		ED_LOG_INFO("	{} textures were created, {} were reused", m_TexturesCreated, m_TexturesReused);
 		ED_LOG_INFO("	{} materials were loaded!", gltfModel.materials.size());
-		ED_LOG_INFO("   {} vertices were loaded!", vertexCount);
+		ED_LOG_INFO("	{} vertices were loaded, {} before welding, {} {} bit indices", vertexCount, m_OptimizeStats.sourceVertexCount, indexCount, indexStride * 8);
+		for (uint32_t stream = 0; stream < vertexSlice.streamCount; ++stream)
+			ED_LOG_INFO("	{} vertex stream {}, {} bytes per vertex", Utils::BytesToString(static_cast<uint64_t>(vertexCount) * vertexSlice.GetStride(stream)), stream, vertexSlice.GetStride(stream));
+		ED_LOG_INFO("	ACMR {:.3f} as exported, {:.3f} optimized ({} entry FIFO cache)", m_OptimizeStats.GetSourceACMR(), m_OptimizeStats.GetACMR(), MeshOptimizer::kFIFOCacheSize);
+		ED_LOG_INFO("	{} indices of simplified levels of detail, generated in {:.2f}ms", m_OptimizeStats.lodIndexCount, m_OptimizeStats.lodTime);
+		ED_LOG_INFO("	{} meshlets, built in {:.2f}ms", m_OptimizeStats.meshletCount, m_OptimizeStats.meshletTime);
+		ED_LOG_INFO("	{} of buffers were read from mapped files", Utils::BytesToString(mappedSize));
+
+		// The materials keep the textures they use
+		m_ImageTextures.clear();
+	}
+
+	void MeshSource::CreateVertexBuffer(const VertexData* vertices)
+	{
+		if (vertexFormat == VertexFormat::kFull)
+		{
+			GeometryStream stream = { sizeof(VertexData), vertices };
+			GeometryBuffers::Allocate(&stream, 1, vertexCount, vertexSlice);
+			return;
+		}
+
+		if (vertexFormat == VertexFormat::kSplit)
+		{
+			std::vector<float> positions(vertexCount * 3);
+			std::vector<VertexAttributes> attributes(vertexCount);
+			MeshOptimizer::SplitVertexStreams(vertices, vertexCount, positions.data(), attributes.data());
+
+			GeometryStream streams[] = { { sizeof(float) * 3, positions.data() }, { sizeof(VertexAttributes), attributes.data() } };
+			GeometryBuffers::Allocate(streams, 2, vertexCount, vertexSlice);
+			return;
+		}
+
+		// Every submesh owns the vertices from its vertexStart to the next one, they are quantized inside its bounds
+		std::vector<const Submesh*> drawnSubmeshes;
+		for (auto& submesh : submeshes)
+		{
+			if (submesh.indexCount > 0)
+				drawnSubmeshes.push_back(&submesh);
+		}
+		std::sort(drawnSubmeshes.begin(), drawnSubmeshes.end(), [](const Submesh* a, const Submesh* b) { return a->vertexStart < b->vertexStart; });
+
+		std::vector<CompactVertexData> compactVertices(vertexCount, CompactVertexData{});
+		for (size_t s = 0; s < drawnSubmeshes.size(); ++s)
+		{
+			uint32_t vertexStart = drawnSubmeshes[s]->vertexStart;
+			uint32_t vertexEnd = s + 1 < drawnSubmeshes.size() ? drawnSubmeshes[s + 1]->vertexStart : vertexCount;
+			MeshOptimizer::EncodeCompactVertices(vertices + vertexStart, vertexEnd - vertexStart, drawnSubmeshes[s]->bounds, &compactVertices[vertexStart]);
+		}
+
+		GeometryStream stream = { sizeof(CompactVertexData), compactVertices.data() };
+		GeometryBuffers::Allocate(&stream, 1, vertexCount, vertexSlice);
 	}
 
 	void MeshSource::Destroy()
 	{
+		GeometryBuffers::Free(vertexSlice);
+		GeometryBuffers::Free(indexSlice);
 		meshes.clear();
+		submeshes.clear();
+		lods.clear();
+		meshlets.clear();
+		meshletVertices.clear();
+		meshletTriangles.clear();
+		materials.clear();
+		triangleBVHs.clear();
+		instances.clear();
+		instanceNames.clear();
+		bounds = {};
+		boundingSphere = {};
+	}
+
+	bool MeshSource::LoadCooked(const std::filesystem::path& cookedFile, const std::filesystem::path& sourceFile)
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(cookedFile, error))
+			return false;
+
+		Timer timer;
+		timer.Record();
+
+		MappedFile file;
+		const CookedMesh::Header* header = file.Open(cookedFile) ? CookedMesh::GetHeader(file) : nullptr;
+		if (!header || header->vertexSize != sizeof(VertexData))
+		{
+			ED_LOG_INFO("{} was cooked by another version, importing {} again", cookedFile, sourceFile);
+			return false;
+		}
+
+		// The source only has to match when it's there, cooked files can be shipped without it
+		std::filesystem::path sourceFolder = sourceFile.parent_path();
+		if (std::filesystem::exists(sourceFile, error))
+		{
+			const CookedMesh::Blob* dependencies = CookedMesh::GetSection<CookedMesh::Blob>(file, header->dependencies);
+			std::vector<std::filesystem::path> dependencyFiles;
+			for (uint64_t i = 0; dependencies && i < header->dependencies.count; ++i)
+				dependencyFiles.emplace_back(sourceFolder / std::filesystem::u8path(CookedMesh::GetString(file, dependencies[i])));
+
+			if (dependencyFiles.empty() || CookedMesh::HashFiles(dependencyFiles) != header->sourceHash)
+			{
+				ED_LOG_INFO("{} changed since it was cooked, importing it again", sourceFile);
+				return false;
+			}
+		}
+
+		const VertexData* cookedVertices = CookedMesh::GetSection<VertexData>(file, header->vertices);
+		const void* cookedIndices = header->indexSize == sizeof(uint16_t) ? static_cast<const void*>(CookedMesh::GetSection<uint16_t>(file, header->indices)) :
+									header->indexSize == sizeof(uint32_t) ? CookedMesh::GetSection<uint32_t>(file, header->indices) : nullptr;
+		const CookedMesh::Mesh* cookedMeshes = CookedMesh::GetSection<CookedMesh::Mesh>(file, header->meshes);
+		const CookedMesh::Instance* cookedInstances = CookedMesh::GetSection<CookedMesh::Instance>(file, header->instances);
+		const CookedMesh::Submesh* cookedSubmeshes = CookedMesh::GetSection<CookedMesh::Submesh>(file, header->submeshes);
+		const CookedMesh::SubmeshLOD* cookedLODs = CookedMesh::GetSection<CookedMesh::SubmeshLOD>(file, header->lods);
+		const MeshOptimizer::Meshlet* cookedMeshlets = CookedMesh::GetSection<MeshOptimizer::Meshlet>(file, header->meshlets);
+		const uint32_t* cookedMeshletVertices = CookedMesh::GetSection<uint32_t>(file, header->meshletVertices);
+		const uint8_t* cookedMeshletTriangles = CookedMesh::GetSection<uint8_t>(file, header->meshletTriangles);
+		const Math::TriangleBVH::Node* bvhNodes = CookedMesh::GetSection<Math::TriangleBVH::Node>(file, header->bvhNodes);
+		const Math::TriangleBVH::Triangle* bvhTriangles = CookedMesh::GetSection<Math::TriangleBVH::Triangle>(file, header->bvhTriangles);
+		const CookedMesh::Material* cookedMaterials = CookedMesh::GetSection<CookedMesh::Material>(file, header->materials);
+		const CookedMesh::Image* cookedImages = CookedMesh::GetSection<CookedMesh::Image>(file, header->images);
+
+		// Every table is checked against the others, a truncated or corrupted file is imported again
+		auto isValidSection = [](const void* data, const CookedMesh::Section& section) { return data || section.count == 0; };
+		bool bIsValid = cookedVertices && cookedIndices && cookedMeshes && cookedInstances && isValidSection(cookedSubmeshes, header->submeshes) && isValidSection(cookedLODs, header->lods) &&
+						isValidSection(cookedMeshlets, header->meshlets) && isValidSection(cookedMeshletVertices, header->meshletVertices) &&
+						isValidSection(cookedMeshletTriangles, header->meshletTriangles) && isValidSection(bvhNodes, header->bvhNodes) && isValidSection(bvhTriangles, header->bvhTriangles) &&
+						isValidSection(cookedMaterials, header->materials) && isValidSection(cookedImages, header->images) &&
+						header->materials.count == header->materialCount && header->vertices.count <= UINT32_MAX && header->indices.count <= UINT32_MAX;
+		auto isValidImage = [&](int32_t image) { return image < static_cast<int64_t>(header->images.count); };
+		for (uint64_t m = 0; bIsValid && m < header->materials.count; ++m)
+		{
+			const CookedMesh::Material& material = cookedMaterials[m];
+			bIsValid = isValidImage(material.albedo) && isValidImage(material.metallicRoughness) && isValidImage(material.normal) && isValidImage(material.AO) && isValidImage(material.emissive);
+		}
+		for (uint64_t s = 0; bIsValid && s < header->submeshes.count; ++s)
+		{
+			const CookedMesh::Submesh& submesh = cookedSubmeshes[s];
+			bIsValid = submesh.vertexStart <= header->vertices.count && static_cast<uint64_t>(submesh.indexStart) + submesh.indexCount <= header->indices.count &&
+					   static_cast<uint64_t>(submesh.firstLOD) + submesh.lodCount <= header->lods.count &&
+					   static_cast<uint64_t>(submesh.firstMeshlet) + submesh.meshletCount <= header->meshlets.count && submesh.material < static_cast<int64_t>(header->materials.count);
+		}
+		for (uint64_t l = 0; bIsValid && l < header->lods.count; ++l)
+			bIsValid = static_cast<uint64_t>(cookedLODs[l].indexStart) + cookedLODs[l].indexCount <= header->indices.count;
+		for (uint64_t m = 0; bIsValid && m < header->meshlets.count; ++m)
+		{
+			const MeshOptimizer::Meshlet& meshlet = cookedMeshlets[m];
+			bIsValid = meshlet.vertexCount <= MeshOptimizer::kMaxMeshletVertices && meshlet.triangleCount <= MeshOptimizer::kMaxMeshletTriangles &&
+					   static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount <= header->meshletVertices.count &&
+					   (static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount) * 3 <= header->meshletTriangles.count &&
+					   static_cast<uint64_t>(meshlet.indexStart) + meshlet.triangleCount * 3 <= header->indices.count;
+		}
+		for (uint64_t m = 0; bIsValid && m < header->meshes.count; ++m)
+		{
+			const CookedMesh::Mesh& mesh = cookedMeshes[m];
+			bIsValid = static_cast<uint64_t>(mesh.firstSubmesh) + mesh.submeshCount <= header->submeshes.count &&
+					   static_cast<uint64_t>(mesh.firstBVHNode) + mesh.bvhNodeCount <= header->bvhNodes.count &&
+					   static_cast<uint64_t>(mesh.firstBVHTriangle) + mesh.bvhTriangleCount <= header->bvhTriangles.count &&
+					   mesh.lodCount > 0 && mesh.lodCount <= MeshOptimizer::kMaxLODCount;
+		}
+		for (uint64_t i = 0; bIsValid && i < header->instances.count; ++i)
+			bIsValid = cookedInstances[i].mesh < header->meshes.count;
+		if (!bIsValid)
+		{
+			ED_LOG_WARN("{} is corrupted, importing {} again", cookedFile, sourceFile);
+			return false;
+		}
+
+		if (bHasMesh)
+			Destroy();
+
+		m_ImportPath = sourceFile;
+		m_ImageTextures.clear();
+		m_EncodedImages.clear();
+		m_TexturesCreated = 0;
+		m_TexturesReused = 0;
+		id = s_NextMeshSourceId++;
+		m_FirstMaterialId = s_NextMaterialId.fetch_add(header->materialCount);
+		vertexCount = static_cast<uint32_t>(header->vertices.count);
+		indexCount = static_cast<uint32_t>(header->indices.count);
+
+		// Only the images the materials use are read and decoded, like the import they go through the texture cache first
+		tinygltf::Model imageModel;
+		imageModel.images.resize(header->images.count);
+		m_ImageTextures.resize(header->images.count);
+		m_EncodedImages.resize(header->images.count);
+		std::vector<bool> usedImages(header->images.count);
+		for (uint64_t s = 0; s < header->submeshes.count; ++s)
+		{
+			if (cookedSubmeshes[s].material < 0)
+				continue;
+
+			const CookedMesh::Material& material = cookedMaterials[cookedSubmeshes[s].material];
+			for (int32_t image : { material.albedo, material.metallicRoughness, material.normal, material.AO, material.emissive })
+			{
+				if (image >= 0)
+					usedImages[image] = true;
+			}
+		}
+
+		for (int32_t i = 0; i < static_cast<int32_t>(header->images.count); ++i)
+		{
+			if (!usedImages[i])
+				continue;
+
+			const CookedMesh::Image& cookedImage = cookedImages[i];
+			tinygltf::Image& gltfImage = imageModel.images[i];
+			if (cookedImage.bIsExternal)
+				gltfImage.uri = CookedMesh::GetString(file, cookedImage.data);
+
+			if (TextureRef texture = TextureCache::Find(GetImageKey(gltfImage, i)))
+			{
+				m_ImageTextures[i] = texture;
+				continue;
+			}
+
+			// Images that can't be read stay empty, LoadImage replaces them with a black texture
+			if (cookedImage.bIsExternal)
+			{
+				MappedFile imageFile;
+				if (imageFile.Open(sourceFolder / std::filesystem::u8path(GLTF::DecodeURI(gltfImage.uri))))
+					m_EncodedImages[i].assign(imageFile.GetData(), imageFile.GetData() + imageFile.GetSize());
+			}
+			else if (const uint8_t* imageData = CookedMesh::GetSection<uint8_t>(file, cookedImage.data))
+			{
+				m_EncodedImages[i].assign(imageData, imageData + cookedImage.data.count);
+			}
+		}
+		DecodeImages(imageModel);
+
+		auto loadTexture = [&](int32_t image) { return image >= 0 ? LoadImage(imageModel, image) : TextureCache::GetBlackTexture(); };
+		m_GLTFMaterials.assign(header->materials.count + 1, -1);
+		submeshes.resize(header->submeshes.count);
+		for (uint64_t s = 0; s < header->submeshes.count; ++s)
+		{
+			const CookedMesh::Submesh& cookedSubmesh = cookedSubmeshes[s];
+			Submesh& submesh = submeshes[s];
+			submesh.bounds = cookedSubmesh.bounds;
+			submesh.vertexStart = cookedSubmesh.vertexStart;
+			submesh.indexStart = cookedSubmesh.indexStart;
+			submesh.indexCount = cookedSubmesh.indexCount;
+			submesh.firstLOD = cookedSubmesh.firstLOD;
+			submesh.lodCount = cookedSubmesh.lodCount;
+			submesh.firstMeshlet = cookedSubmesh.firstMeshlet;
+			submesh.meshletCount = cookedSubmesh.meshletCount;
+
+			// Cooked materials are indexed like the glTF ones, the default material takes the last slot
+			int32_t& materialIndex = m_GLTFMaterials[cookedSubmesh.material >= 0 ? cookedSubmesh.material : header->materials.count];
+			if (materialIndex < 0)
+			{
+				materialIndex = static_cast<int32_t>(materials.size());
+				PBRMaterial& material = materials.emplace_back();
+				const CookedMesh::Material* cookedMaterial = cookedSubmesh.material >= 0 ? &cookedMaterials[cookedSubmesh.material] : nullptr;
+				if (cookedMaterial)
+				{
+					material.id = m_FirstMaterialId + static_cast<uint32_t>(cookedSubmesh.material);
+					material.bIsTransparent = cookedMaterial->bIsTransparent != 0;
+					material.baseColor = cookedMaterial->baseColor;
+				}
+				material.albedoMap = loadTexture(cookedMaterial ? cookedMaterial->albedo : -1);
+				material.metallicRoughnessMap = loadTexture(cookedMaterial ? cookedMaterial->metallicRoughness : -1);
+				material.normalMap = loadTexture(cookedMaterial ? cookedMaterial->normal : -1);
+				material.AOMap = loadTexture(cookedMaterial ? cookedMaterial->AO : -1);
+				material.emissiveMap = loadTexture(cookedMaterial ? cookedMaterial->emissive : -1);
+			}
+			submesh.material = static_cast<uint32_t>(materialIndex);
+		}
+		m_GLTFMaterials.clear();
+
+		lods.resize(header->lods.count);
+		for (uint64_t l = 0; l < header->lods.count; ++l)
+			lods[l] = { cookedLODs[l].indexStart, cookedLODs[l].indexCount };
+		meshlets.assign(cookedMeshlets, cookedMeshlets + header->meshlets.count);
+		meshletVertices.assign(cookedMeshletVertices, cookedMeshletVertices + header->meshletVertices.count);
+		meshletTriangles.assign(cookedMeshletTriangles, cookedMeshletTriangles + header->meshletTriangles.count);
+
+		meshes.resize(header->meshes.count);
+		triangleBVHs.resize(header->meshes.count);
+		for (uint64_t m = 0; m < header->meshes.count; ++m)
+		{
+			const CookedMesh::Mesh& cookedMesh = cookedMeshes[m];
+			Mesh& mesh = meshes[m];
+			mesh = { cookedMesh.bounds, cookedMesh.firstSubmesh, cookedMesh.submeshCount, cookedMesh.lodCount };
+			std::copy(cookedMesh.lodErrors, cookedMesh.lodErrors + MeshOptimizer::kMaxLODCount, mesh.lodErrors);
+			if (cookedMesh.bvhNodeCount > 0)
+				triangleBVHs[m].Assign(bvhNodes + cookedMesh.firstBVHNode, cookedMesh.bvhNodeCount, bvhTriangles + cookedMesh.firstBVHTriangle, cookedMesh.bvhTriangleCount);
+		}
+
+		instances.resize(header->instances.count);
+		instanceNames.resize(header->instances.count);
+		for (uint64_t i = 0; i < header->instances.count; ++i)
+		{
+			instances[i] = { cookedInstances[i].modelMatrix, cookedInstances[i].bounds, cookedInstances[i].mesh };
+			instanceNames[i] = CookedMesh::GetString(file, cookedInstances[i].name);
+		}
+
+		bounds = header->bounds;
+		boundingSphere = Math::BoundingSphere::FromAABB(bounds);
+
+		// Uploaded straight from the mapped file, compact vertices are encoded from it
+		CreateVertexBuffer(cookedVertices);
+
+		GeometryStream indexStream = { header->indexSize, cookedIndices };
+		GeometryBuffers::Allocate(&indexStream, 1, indexCount, indexSlice);
+		bHasMesh = true;
+
+		ED_LOG_INFO("Loaded cooked {} in {:.2f}ms", cookedFile, timer.ElapsedMilliseconds());
+		ED_LOG_INFO("	{} meshes drawn by {} nodes, {} vertices, {} textures were created, {} were reused", meshes.size(), instances.size(), vertexCount, m_TexturesCreated, m_TexturesReused);
+
+		m_ImageTextures.clear();
+		return true;
+	}
+
+	static int32_t GetTextureImage(const tinygltf::Model& gltfModel, int textureIndex)
+	{
+		if (textureIndex < 0 || static_cast<size_t>(textureIndex) >= gltfModel.textures.size())
+			return -1;
+		return gltfModel.textures[textureIndex].source;
+	}
+
+	void MeshSource::Cook(const tinygltf::Model& gltfModel, const GLTF::MappedModel& mappedModel, const std::vector<VertexData>& vertices, const void* indexData, uint32_t indexStride) const
+	{
+		Timer timer;
+		timer.Record();
+
+		CookedMesh::Writer writer;
+		CookedMesh::Header header;
+		header.vertexSize = sizeof(VertexData);
+		header.materialCount = static_cast<uint32_t>(gltfModel.materials.size());
+		header.indexSize = indexStride;
+		header.bounds = bounds;
+
+		// Dependencies are relative to the source, the cooked file stays valid when the folder moves
+		std::filesystem::path sourceFolder = m_ImportPath.parent_path();
+		std::vector<CookedMesh::Blob> dependencies;
+		for (auto& dependency : mappedModel.GetFiles())
+		{
+			std::filesystem::path relativePath = sourceFolder.empty() ? dependency : dependency.lexically_relative(sourceFolder);
+			dependencies.emplace_back(writer.AppendString(relativePath.generic_u8string()));
+		}
+		header.sourceHash = CookedMesh::HashFiles(mappedModel.GetFiles());
+
+		// External images are referenced by URI, embedded ones are copied encoded
+		std::vector<CookedMesh::Image> images(gltfModel.images.size());
+		for (size_t i = 0; i < gltfModel.images.size(); ++i)
+		{
+			GLTF::BufferSpan imageData = mappedModel.GetImageData(static_cast<int>(i));
+			if (!gltfModel.images[i].uri.empty())
+			{
+				images[i].data = writer.AppendString(gltfModel.images[i].uri);
+				images[i].bIsExternal = 1;
+			}
+			else if (imageData.data)
+			{
+				images[i].data = writer.Append(imageData.data, imageData.size);
+			}
+			else
+			{
+				ED_LOG_WARN("Image {} of {} is a data URI, it isn't cooked", i, m_ImportPath);
+				return;
+			}
+		}
+
+		std::vector<CookedMesh::Material> cookedMaterials(gltfModel.materials.size());
+		for (size_t m = 0; m < gltfModel.materials.size(); ++m)
+		{
+			const tinygltf::Material& gltfMaterial = gltfModel.materials[m];
+			auto baseColorTexture = gltfMaterial.values.find("baseColorTexture");
+			auto metallicRoughnessTexture = gltfMaterial.values.find("metallicRoughnessTexture");
+
+			CookedMesh::Material& material = cookedMaterials[m];
+			material.albedo = baseColorTexture != gltfMaterial.values.end() ? GetTextureImage(gltfModel, baseColorTexture->second.TextureIndex()) : -1;
+			material.metallicRoughness = metallicRoughnessTexture != gltfMaterial.values.end() ? GetTextureImage(gltfModel, metallicRoughnessTexture->second.TextureIndex()) : -1;
+			material.normal = GetTextureImage(gltfModel, gltfMaterial.normalTexture.index);
+			material.AO = GetTextureImage(gltfModel, gltfMaterial.occlusionTexture.index);
+			material.emissive = GetTextureImage(gltfModel, gltfMaterial.emissiveTexture.index);
+			material.bIsTransparent = gltfMaterial.alphaMode == "BLEND" ? 1 : 0;
+			auto baseColorFactor = gltfMaterial.values.find("baseColorFactor");
+			material.baseColor = baseColorFactor != gltfMaterial.values.end() ? glm::vec4(glm::make_vec4(baseColorFactor->second.ColorFactor().data())) : glm::vec4(1.0f);
+		}
+
+		std::vector<CookedMesh::Mesh> cookedMeshes;
+		std::vector<CookedMesh::Instance> cookedInstances;
+		std::vector<CookedMesh::Submesh> cookedSubmeshes;
+		std::vector<Math::TriangleBVH::Node> bvhNodes;
+		std::vector<Math::TriangleBVH::Triangle> bvhTriangles;
+		for (size_t m = 0; m < meshes.size(); ++m)
+		{
+			const Mesh& mesh = meshes[m];
+			auto& nodes = triangleBVHs[m].GetNodes();
+			auto& triangles = triangleBVHs[m].GetTriangles();
+			CookedMesh::Mesh& cookedMesh = cookedMeshes.emplace_back();
+			cookedMesh = { mesh.bounds, mesh.firstSubmesh, mesh.submeshCount,
+				static_cast<uint32_t>(bvhNodes.size()), static_cast<uint32_t>(nodes.size()), static_cast<uint32_t>(bvhTriangles.size()), static_cast<uint32_t>(triangles.size()), mesh.lodCount };
+			std::copy(mesh.lodErrors, mesh.lodErrors + MeshOptimizer::kMaxLODCount, cookedMesh.lodErrors);
+			bvhNodes.insert(bvhNodes.end(), nodes.begin(), nodes.end());
+			bvhTriangles.insert(bvhTriangles.end(), triangles.begin(), triangles.end());
+		}
+		for (uint32_t s = 0; s < submeshes.size(); ++s)
+		{
+			const Submesh& submesh = submeshes[s];
+			uint32_t materialId = materials[submesh.material].id;
+			int32_t material = materialId >= m_FirstMaterialId ? static_cast<int32_t>(materialId - m_FirstMaterialId) : -1;
+			cookedSubmeshes.push_back({ submesh.bounds, s, submesh.vertexStart, submesh.indexStart, submesh.indexCount, submesh.firstLOD, submesh.lodCount,
+				submesh.firstMeshlet, submesh.meshletCount, material });
+		}
+		std::vector<CookedMesh::SubmeshLOD> cookedLODs;
+		for (auto& lod : lods)
+			cookedLODs.push_back({ lod.indexStart, lod.indexCount });
+		for (size_t i = 0; i < instances.size(); ++i)
+			cookedInstances.push_back({ instances[i].modelMatrix, instances[i].bounds, writer.AppendString(instanceNames[i]), instances[i].mesh });
+
+		header.dependencies = writer.Append(dependencies.data(), dependencies.size());
+		header.vertices = writer.Append(vertices.data(), vertices.size());
+		if (indexStride == sizeof(uint16_t))
+			header.indices = writer.Append(static_cast<const uint16_t*>(indexData), indexCount);
+		else
+			header.indices = writer.Append(static_cast<const uint32_t*>(indexData), indexCount);
+		header.meshes = writer.Append(cookedMeshes.data(), cookedMeshes.size());
+		header.instances = writer.Append(cookedInstances.data(), cookedInstances.size());
+		header.submeshes = writer.Append(cookedSubmeshes.data(), cookedSubmeshes.size());
+		header.lods = writer.Append(cookedLODs.data(), cookedLODs.size());
+		header.meshlets = writer.Append(meshlets.data(), meshlets.size());
+		header.meshletVertices = writer.Append(meshletVertices.data(), meshletVertices.size());
+		header.meshletTriangles = writer.Append(meshletTriangles.data(), meshletTriangles.size());
+		header.bvhNodes = writer.Append(bvhNodes.data(), bvhNodes.size());
+		header.bvhTriangles = writer.Append(bvhTriangles.data(), bvhTriangles.size());
+		header.materials = writer.Append(cookedMaterials.data(), cookedMaterials.size());
+		header.images = writer.Append(images.data(), images.size());
+
+		std::filesystem::path cookedFile = CookedMesh::GetCookedPath(m_ImportPath);
+		if (header.sourceHash != 0 && writer.Save(cookedFile, header))
+			ED_LOG_INFO("	Cooked {} in {:.2f}ms", cookedFile, timer.ElapsedMilliseconds());
 	}
 	
-	void MeshSource::LoadMesh(tinygltf::Model& gltfModel, const tinygltf::Node& gltfNode, glm::mat4& modelMatrix, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
+	uint32_t MeshSource::LoadMesh(tinygltf::Model& gltfModel, int32_t gltfMeshIndex, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices)
 	{
-		SharedPtr<Mesh> mesh = MakeShared<Mesh>();
-		mesh->modelMatrix = modelMatrix;
+		Mesh mesh;
+		mesh.firstSubmesh = static_cast<uint32_t>(submeshes.size());
+		mesh.submeshCount = 0;
+		size_t meshIndexStart = indices.size();
 	
-		const auto& gltfMesh = gltfModel.meshes[gltfNode.mesh];
+		const auto& gltfMesh = gltfModel.meshes[gltfMeshIndex];
 		for (size_t p = 0; p < gltfMesh.primitives.size(); ++p)
 		{
-			SharedPtr<Mesh::SubMesh> submesh = MakeShared<Mesh::SubMesh>();
+			Submesh submesh;
 			auto& gltfPrimitive = gltfMesh.primitives[p];
-			submesh->vertexStart = (uint32_t)vertices.size();
-			submesh->indexStart = (uint32_t)indices.size();
-			submesh->indexCount = 0;
+			submesh.vertexStart = (uint32_t)vertices.size();
+			submesh.indexStart = (uint32_t)indices.size();
+			submesh.indexCount = 0;
 	
 			// Vertices
+			auto positionAttribute = gltfPrimitive.attributes.find("POSITION");
+			if (positionAttribute == gltfPrimitive.attributes.end())
 			{
-				const float* positionBuffer = nullptr;
-				const float* normalsBuffer = nullptr;
-				const float* uvsBuffer = nullptr;
-				size_t vertexCount = 0;
-	
-				// Get buffer data for vertex normals
-				if (gltfPrimitive.attributes.find("POSITION") != gltfPrimitive.attributes.end())
-				{
-					const tinygltf::Accessor& accessor = gltfModel.accessors[gltfPrimitive.attributes.find("POSITION")->second];
-					const tinygltf::BufferView& view = gltfModel.bufferViews[accessor.bufferView];
-					positionBuffer = reinterpret_cast<const float*>(&(gltfModel.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-					vertexCount = accessor.count;
-				}
-	
-				// Get buffer data for vertex normals
-				if (gltfPrimitive.attributes.find("NORMAL") != gltfPrimitive.attributes.end())
-				{
-					const tinygltf::Accessor& accessor = gltfModel.accessors[gltfPrimitive.attributes.find("NORMAL")->second];
-					const tinygltf::BufferView& view = gltfModel.bufferViews[accessor.bufferView];
-					normalsBuffer = reinterpret_cast<const float*>(&(gltfModel.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-				}
-	
-				// Get buffer data for vertex texture coordinates
-				// glTF supports multiple sets, we only load the first one
-				if (gltfPrimitive.attributes.find("TEXCOORD_0") != gltfPrimitive.attributes.end())
-				{
-					const tinygltf::Accessor& accessor = gltfModel.accessors[gltfPrimitive.attributes.find("TEXCOORD_0")->second];
-					const tinygltf::BufferView& view = gltfModel.bufferViews[accessor.bufferView];
-					uvsBuffer = reinterpret_cast<const float*>(&(gltfModel.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-				}
-	
-				for (size_t v = 0; v < vertexCount; ++v)
-				{
-					VertexData newVert = {};
-	
-					newVert.position = glm::make_vec3(&positionBuffer[v * 3]);
-					newVert.normal = glm::normalize(glm::vec3(normalsBuffer ? glm::make_vec3(&normalsBuffer[v * 3]) : glm::vec3(0.0f)));
-					newVert.uv = uvsBuffer ? glm::make_vec2(&uvsBuffer[v * 2]) : glm::vec2(0.0f);
-	
-					if (gltfModel.materials[gltfPrimitive.material].values.find("baseColorFactor") != gltfModel.materials[gltfPrimitive.material].values.end())
-						newVert.color = glm::make_vec4(gltfModel.materials[gltfPrimitive.material].values["baseColorFactor"].ColorFactor().data());
-					else
-						newVert.color = glm::vec4(1.0f);
-	
-					vertices.emplace_back(newVert);
-				}
+				ED_LOG_WARN("Primitive {} of mesh '{}' has no positions, skipping it", p, gltfMesh.name);
+				continue;
 			}
-	
-			// Indices
+
+			const tinygltf::Accessor& positionAccessor = gltfModel.accessors[positionAttribute->second];
+			size_t primitiveVertexCount = positionAccessor.count;
+
+			// Attributes are read straight into place, the ones the primitive doesn't have stay zero
+			vertices.resize(submesh.vertexStart + primitiveVertexCount, VertexData{});
+			VertexData* primitiveVertices = &vertices[submesh.vertexStart];
+
+			if (!GLTF::ReadFloats(gltfModel, m_Buffers, positionAccessor, &primitiveVertices->position.x, sizeof(VertexData), 3))
+				ED_LOG_ERROR("Failed to read the positions of mesh '{}'", gltfMesh.name);
+
+			// glTF requires unit length normals, they aren't normalized again
+			auto normalAttribute = gltfPrimitive.attributes.find("NORMAL");
+			if (normalAttribute != gltfPrimitive.attributes.end())
+				GLTF::ReadFloats(gltfModel, m_Buffers, gltfModel.accessors[normalAttribute->second], &primitiveVertices->normal.x, sizeof(VertexData), 3);
+
+			// glTF supports multiple sets, we only load the first one
+			auto uvAttribute = gltfPrimitive.attributes.find("TEXCOORD_0");
+			if (uvAttribute != gltfPrimitive.attributes.end())
+				GLTF::ReadFloats(gltfModel, m_Buffers, gltfModel.accessors[uvAttribute->second], &primitiveVertices->uv.x, sizeof(VertexData), 2);
+
+			// glTF requires min/max on positions, but not every exporter writes them
+			if (positionAccessor.minValues.size() == 3 && positionAccessor.maxValues.size() == 3 && !positionAccessor.sparse.isSparse)
+			{
+				submesh.bounds.min = glm::vec3(glm::make_vec3(positionAccessor.minValues.data()));
+				submesh.bounds.max = glm::vec3(glm::make_vec3(positionAccessor.maxValues.data()));
+			}
+			else
+			{
+				submesh.bounds = Math::ComputeAABB(&primitiveVertices->position.x, primitiveVertexCount, sizeof(VertexData));
+			}
+
+			// Indices, primitives without indices draw their vertices in order
+			if (gltfPrimitive.indices >= 0)
 			{
 				const tinygltf::Accessor& accessor = gltfModel.accessors[gltfPrimitive.indices];
-				const tinygltf::BufferView& bufferView = gltfModel.bufferViews[accessor.bufferView];
-				const tinygltf::Buffer& buffer = gltfModel.buffers[bufferView.buffer];
-	
-				submesh->indexCount += static_cast<uint32_t>(accessor.count);
-	
-				// glTF supports different component types of indices
-				switch (accessor.componentType)
+				indices.resize(submesh.indexStart + accessor.count);
+				if (!GLTF::ReadIndices(gltfModel, m_Buffers, accessor, 0, &indices[submesh.indexStart]))
 				{
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
-					{
-						uint32_t* buf = enew uint32_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint32_t));
-						for (size_t index = 0; index < accessor.count; index++)
-							indices.emplace_back(buf[index] + submesh->vertexStart);
-						edelete[] buf;
-						break;
-					}
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
-					{
-						uint16_t* buf = enew uint16_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint16_t));
-						for (size_t index = 0; index < accessor.count; index++)
-							indices.emplace_back(buf[index] + submesh->vertexStart);
-						edelete[] buf;
-						break;
-					}
-					case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
-					{
-						uint8_t* buf = enew uint8_t[accessor.count];
-						memcpy(buf, &buffer.data[accessor.byteOffset + bufferView.byteOffset], accessor.count * sizeof(uint8_t));
-						for (size_t index = 0; index < accessor.count; index++)
-							indices.emplace_back(buf[index] + submesh->vertexStart);
-						edelete[] buf;
-						break;
-					}
-					default:
-						ED_LOG_ERROR("Index component type {} not supported!");
+					ED_LOG_ERROR("Index component type {} of mesh '{}' not supported!", accessor.componentType, gltfMesh.name);
+					indices.resize(submesh.indexStart);
 				}
 			}
+			else
+			{
+				indices.resize(submesh.indexStart + primitiveVertexCount);
+				for (size_t v = 0; v < primitiveVertexCount; ++v)
+					indices[submesh.indexStart + v] = static_cast<uint32_t>(v);
+			}
+			submesh.indexCount = static_cast<uint32_t>(indices.size()) - submesh.indexStart;
+
+			// Welded and reordered for the vertex cache, overdraw and vertex fetch, strips and fans keep their order
+			if (submesh.indexCount > 0 && gltfPrimitive.mode == TINYGLTF_MODE_TRIANGLES)
+			{
+				uint32_t optimizedVertexCount = MeshOptimizer::Optimize(primitiveVertices, static_cast<uint32_t>(primitiveVertexCount), &indices[submesh.indexStart], submesh.indexCount, m_OptimizeStats);
+				vertices.resize(submesh.vertexStart + optimizedVertexCount);
+
+				// Meshlets reorder the triangles into their clusters, the levels of detail below don't depend on the order
+				Timer meshletTimer;
+				meshletTimer.Record();
+				submesh.firstMeshlet = static_cast<uint32_t>(meshlets.size());
+				submesh.meshletCount = MeshOptimizer::BuildMeshlets(&vertices[submesh.vertexStart], optimizedVertexCount, &indices[submesh.indexStart], submesh.indexCount, meshlets, meshletVertices, meshletTriangles);
+				for (uint32_t m = submesh.firstMeshlet; m < submesh.firstMeshlet + submesh.meshletCount; ++m)
+					meshlets[m].indexStart += submesh.indexStart;
+				m_OptimizeStats.meshletCount += submesh.meshletCount;
+				m_OptimizeStats.meshletTime += meshletTimer.ElapsedMilliseconds();
+
+				// Simplified levels follow the full detail indices and use the same vertices
+				Timer lodTimer;
+				lodTimer.Record();
+				std::vector<uint32_t> lodIndices;
+				MeshOptimizer::LODLevel levels[MeshOptimizer::kMaxLODCount - 1];
+				uint32_t levelCount = MeshOptimizer::GenerateLODs(&vertices[submesh.vertexStart], optimizedVertexCount, &indices[submesh.indexStart], submesh.indexCount, lodIndices, levels);
+
+				glm::vec3 extent = submesh.bounds.max - submesh.bounds.min;
+				float size = std::max(std::max(extent.x, extent.y), extent.z);
+				submesh.firstLOD = static_cast<uint32_t>(lods.size());
+				submesh.lodCount = levelCount;
+				for (uint32_t l = 0; l < levelCount; ++l)
+					lods.push_back({ static_cast<uint32_t>(indices.size()) + levels[l].indexStart, levels[l].indexCount });
+				indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+				// The mesh draws every submesh at the same level, the ones with fewer levels at their coarsest
+				for (uint32_t l = 1; levelCount > 0 && l < MeshOptimizer::kMaxLODCount; ++l)
+					mesh.lodErrors[l] = std::max(mesh.lodErrors[l], levels[std::min(l, levelCount) - 1].error * size);
+				mesh.lodCount = std::max(mesh.lodCount, levelCount + 1);
+				m_OptimizeStats.lodIndexCount += lodIndices.size();
+				m_OptimizeStats.lodTime += lodTimer.ElapsedMilliseconds();
+			}
 	
 			// Load materials
-			LoadMaterial(gltfModel, gltfPrimitive, submesh->material);
+			submesh.material = GetMaterial(gltfModel, gltfPrimitive.material);
 	
-			mesh->submeshes.emplace_back(submesh);
+			mesh.bounds.Merge(submesh.bounds);
+			submeshes.emplace_back(submesh);
+			mesh.submeshCount++;
 		}
 	
+		Math::TriangleBVH triangleBVH;
+		if (indices.size() > meshIndexStart)
+		{
+			// Indices are relative to their submesh, the BVH is built over every submesh with indices into all the vertices
+			std::vector<uint32_t> meshIndices;
+			meshIndices.reserve(indices.size() - meshIndexStart);
+			for (uint32_t s = mesh.firstSubmesh; s < mesh.firstSubmesh + mesh.submeshCount; ++s)
+			{
+				const Submesh& submesh = submeshes[s];
+				for (uint32_t i = submesh.indexStart; i < submesh.indexStart + submesh.indexCount; ++i)
+					meshIndices.push_back(submesh.vertexStart + indices[i]);
+			}
+			triangleBVH.Build(&vertices[0].position.x, sizeof(VertexData), meshIndices.data(), meshIndices.size());
+		}
 		meshes.emplace_back(mesh);
+		triangleBVHs.emplace_back(std::move(triangleBVH));
+		return static_cast<uint32_t>(meshes.size() - 1);
+	}
+
+	uint32_t MeshSource::GetMaterial(tinygltf::Model& gltfModel, int32_t gltfMaterialIndex)
+	{
+		// Primitives that share a glTF material share the entry, the default material takes the last slot
+		int32_t& materialIndex = m_GLTFMaterials[gltfMaterialIndex >= 0 ? static_cast<size_t>(gltfMaterialIndex) : gltfModel.materials.size()];
+		if (materialIndex >= 0)
+			return static_cast<uint32_t>(materialIndex);
+
+		materialIndex = static_cast<int32_t>(materials.size());
+		PBRMaterial& material = materials.emplace_back();
+		if (gltfMaterialIndex >= 0)
+		{
+			LoadMaterial(gltfModel, gltfMaterialIndex, material);
+		}
+		else
+		{
+			material.albedoMap = TextureCache::GetBlackTexture();
+			material.metallicRoughnessMap = TextureCache::GetBlackTexture();
+			material.normalMap = TextureCache::GetBlackTexture();
+			material.AOMap = TextureCache::GetBlackTexture();
+			material.emissiveMap = TextureCache::GetBlackTexture();
+		}
+		return static_cast<uint32_t>(materialIndex);
 	}
 
-	void MeshSource::LoadMaterial(tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive, PBRMaterial& material)
+	void MeshSource::LoadMaterial(tinygltf::Model& gltfModel, int32_t gltfMaterialIndex, PBRMaterial& material)
 	{
-		auto& gltfMaterial = gltfModel.materials[gltfPrimitive.material];
+		auto& gltfMaterial = gltfModel.materials[gltfMaterialIndex];
+		material.id = m_FirstMaterialId + static_cast<uint32_t>(gltfMaterialIndex);
+		material.bIsTransparent = gltfMaterial.alphaMode == "BLEND";
+		auto baseColorFactor = gltfMaterial.values.find("baseColorFactor");
+		if (baseColorFactor != gltfMaterial.values.end())
+			material.baseColor = glm::make_vec4(baseColorFactor->second.ColorFactor().data());
+
 		// Albedo
 		if (gltfMaterial.values.find("baseColorTexture") != gltfMaterial.values.end())
 		{
@@ -230,7 +760,7 @@ namespace Eden
 		}
 		else
 		{
-			material.albedoMap = m_BlackTexture;
+			material.albedoMap = TextureCache::GetBlackTexture();
 		}
 
 		// Metallic = r, Roughness = g
@@ -243,7 +773,7 @@ namespace Eden
 		}
 		else
 		{
-			material.metallicRoughnessMap = m_BlackTexture;
+			material.metallicRoughnessMap = TextureCache::GetBlackTexture();
 		}
 
 		// Normal
@@ -256,7 +786,7 @@ namespace Eden
 		}
 		else
 		{
-			material.normalMap = m_BlackTexture;
+			material.normalMap = TextureCache::GetBlackTexture();
 		}
 
 		// AO
@@ -269,7 +799,7 @@ namespace Eden
 		}
 		else
 		{
-			material.AOMap = m_BlackTexture;
+			material.AOMap = TextureCache::GetBlackTexture();
 		}
 	
 		// Emissive
@@ -282,7 +812,7 @@ namespace Eden
 		}
 		else
 		{
-			material.emissiveMap = m_BlackTexture;
+			material.emissiveMap = TextureCache::GetBlackTexture();
 		}
 	}
 
@@ -319,53 +849,127 @@ namespace Eden
 			modelMatrix *= glm::mat4(glm::make_mat4x4(gltfNode.matrix.data()));
 		}
 
-		if (gltfNode.mesh >= 0)
-			LoadMesh(gltfModel, gltfNode, modelMatrix, vertices, indices);
+		// Nodes instancing the same glTF mesh share its vertices, indices and BVH
+		if (gltfNode.mesh >= 0 && static_cast<size_t>(gltfNode.mesh) < m_GLTFMeshes.size())
+		{
+			int32_t& meshIndex = m_GLTFMeshes[gltfNode.mesh];
+			if (meshIndex < 0)
+				meshIndex = static_cast<int32_t>(LoadMesh(gltfModel, gltfNode.mesh, vertices, indices));
+
+			MeshInstance instance;
+			instance.mesh = static_cast<uint32_t>(meshIndex);
+			instance.modelMatrix = modelMatrix;
+			const Math::AABB& meshBounds = meshes[instance.mesh].bounds;
+			if (meshBounds.IsValid())
+				instance.bounds = Math::TransformAABB(meshBounds, modelMatrix);
+			instances.emplace_back(instance);
+			instanceNames.emplace_back(!gltfNode.name.empty() ? gltfNode.name : gltfModel.meshes[gltfNode.mesh].name);
+		}
 
 		for (size_t childIndex = 0; childIndex < gltfNode.children.size(); ++childIndex)
 			LoadNode(gltfModel, gltfModel.nodes[gltfNode.children[childIndex]], &modelMatrix, vertices, indices);
 	}
 
-	TextureRef MeshSource::LoadImage(tinygltf::Model& gltfModel, int32_t imageIndex)
+	// External images are keyed by their own file, so glTF files sharing an image share the texture
+	std::string MeshSource::GetImageKey(const tinygltf::Image& gltfImage, int32_t imageIndex) const
 	{
-		tinygltf::Image& gltfImage = gltfModel.images[imageIndex];
+		if (!gltfImage.uri.empty())
+			return Utils::NormalizePath(m_ImportPath.parent_path() / gltfImage.uri);
+
+		return Utils::NormalizePath(m_ImportPath) + "#image" + std::to_string(imageIndex);
+	}
+
+	bool MeshSource::LoadCachedImageData(tinygltf::Image* gltfImage, const int imageIndex, std::string* err, std::string* warn, int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData)
+	{
+		MeshSource* meshSource = static_cast<MeshSource*>(userData);
+		TextureRef texture = TextureCache::Find(meshSource->GetImageKey(*gltfImage, imageIndex));
+		if (texture)
+		{
+			if (meshSource->m_ImageTextures.size() <= static_cast<size_t>(imageIndex))
+				meshSource->m_ImageTextures.resize(static_cast<size_t>(imageIndex) + 1);
+			meshSource->m_ImageTextures[imageIndex] = texture;
+			return true;
+		}
 
-		unsigned char* buffer;
-		bool bDeleteBuffer = false;
+		// Decoding is deferred to DecodeImages, where every image of the file is decoded in parallel
+		if (meshSource->m_EncodedImages.size() <= static_cast<size_t>(imageIndex))
+			meshSource->m_EncodedImages.resize(static_cast<size_t>(imageIndex) + 1);
+		meshSource->m_EncodedImages[imageIndex].assign(bytes, bytes + size);
+		return true;
+	}
+
+	void MeshSource::DecodeImages(tinygltf::Model& gltfModel)
+	{
+		Timer timer;
+		timer.Record();
 
-		if (gltfImage.component == 3)
+		std::vector<uint32_t> pendingImages;
+		for (uint32_t i = 0; i < m_EncodedImages.size() && i < gltfModel.images.size(); ++i)
 		{
-			uint64_t bufferSize = gltfImage.width * gltfImage.height * 4;
-			buffer = enew unsigned char[bufferSize];
-			unsigned char* rgba = buffer;
-			unsigned char* rgb = &gltfImage.image[0];
+			if (!m_EncodedImages[i].empty())
+				pendingImages.emplace_back(i);
+		}
 
-			for (size_t i = 0; i < gltfImage.width * gltfImage.height; ++i)
+		// One image per job, their sizes are too different for bigger batches to balance well
+		JobSystem::ParallelFor(static_cast<uint32_t>(pendingImages.size()), 1, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t p = begin; p < end; ++p)
 			{
-				memcpy(rgba, rgb, sizeof(unsigned char) * 3);
-				rgba += 4;
-				rgb += 3;
+				uint32_t imageIndex = pendingImages[p];
+				const std::vector<uint8_t>& encodedImage = m_EncodedImages[imageIndex];
+
+				// Images that fail to decode stay empty, LoadImage replaces them with a black texture
+				DecodedImage decodedImage;
+				if (!DecodeImageRGBA8(encodedImage.data(), encodedImage.size(), decodedImage))
+					continue;
+
+				tinygltf::Image& gltfImage = gltfModel.images[imageIndex];
+				gltfImage.image = std::move(decodedImage.pixels);
+				gltfImage.width = static_cast<int>(decodedImage.width);
+				gltfImage.height = static_cast<int>(decodedImage.height);
+				gltfImage.component = 4;
+				gltfImage.bits = 8;
+				gltfImage.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
 			}
+		});
+
+		m_EncodedImages.clear();
+		if (!pendingImages.empty())
+			ED_LOG_INFO("	{} images were decoded in {:.2f}ms", pendingImages.size(), timer.ElapsedMilliseconds());
+	}
 
-			bDeleteBuffer = true;
+	TextureRef MeshSource::LoadImage(tinygltf::Model& gltfModel, int32_t imageIndex)
+	{
+		bIsTextured = true;
+		TextureRef& cachedTexture = m_ImageTextures[imageIndex];
+		if (cachedTexture)
+		{
+			m_TexturesReused++;
+			return cachedTexture;
 		}
-		else
+
+		tinygltf::Image& gltfImage = gltfModel.images[imageIndex];
+		if (gltfImage.image.empty())
 		{
-			buffer = &gltfImage.image[0];
+			ED_LOG_WARN("Image {} of {} has no data, using a black texture", imageIndex, m_ImportPath);
+			cachedTexture = TextureCache::GetBlackTexture();
+			return cachedTexture;
 		}
 
-		bIsTextured = true;
+		// DecodeImages already expanded every image to RGBA
 		TextureDesc desc = {};
-		desc.data = buffer;
+		desc.data = gltfImage.image.data();
 		desc.width = gltfImage.width;
 		desc.height = gltfImage.height;
 		desc.bIsStorage = false;
 		desc.debugName = gltfImage.name;
-		TextureRef texture = RHICreateTexture(&desc);
+		cachedTexture = RHICreateTexture(&desc);
+		TextureCache::Add(GetImageKey(gltfImage, imageIndex), cachedTexture);
+		m_TexturesCreated++;
 
-		if (bDeleteBuffer)
-			edelete buffer;
+		// The texture has its own copy of the pixels
+		gltfImage.image = {};
 
-		return texture;
+		return cachedTexture;
 	}
 }
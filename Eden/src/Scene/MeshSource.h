@@ -1,8 +1,13 @@
 #pragma once
 
 #include "RHI/DynamicRHI.h"
+#include "Renderer/GeometryBuffers.h"
+#include "Math/Bounds.h"
+#include "Math/TriangleBVH.h"
 
+#include <algorithm>
 #include <functional>
+#include <string>
 #include <vector>
 #include <filesystem>
 
@@ -12,14 +17,22 @@
 
 #include <tinygltf/tiny_gltf.h>
 
+#include "GLTFAccessor.h"
+#include "MeshOptimizer.h"
+
+namespace Eden::GLTF
+{
+	class MappedModel;
+}
+
 namespace Eden
 {
+	// VertexFormat::kFull, matches VertexInput in Global.hlsli
 	struct VertexData
 	{
 		glm::vec3 position;
 		glm::vec2 uv;
 		glm::vec3 normal;
-		glm::vec4 color;
 
 		bool operator==(const VertexData& other) const
 		{
@@ -27,6 +40,22 @@ namespace Eden
 		}
 	};
 
+	// VertexFormat::kCompact, decoded by DecodeVertex in Global.hlsli
+	struct CompactVertexData
+	{
+		uint32_t positionXY; // 16 bit unorm each, inside the bounds of the submesh
+		uint32_t positionZ; // the high 16 bits are unused
+		uint32_t normal; // octahedral, 16 bit snorm each
+		uint32_t uv; // half floats
+	};
+
+	// VertexFormat::kSplit, the attribute stream, positions are a tightly packed glm::vec3 stream
+	struct VertexAttributes
+	{
+		glm::vec2 uv;
+		glm::vec3 normal;
+	};
+
 	struct PBRMaterial
 	{
 		TextureRef albedoMap;
@@ -34,34 +63,92 @@ namespace Eden
 		TextureRef AOMap;
 		TextureRef emissiveMap;
 		TextureRef metallicRoughnessMap; // r = metallic, g = roughness
+		glm::vec4 baseColor = glm::vec4(1.0f); // used without an albedo map
+		uint32_t id = 0; // unique per loaded material, used to sort and batch draws
+		bool bIsTransparent = false; // glTF BLEND alpha mode
 	};
 
+	/*
+	 * Meshes, submeshes and instances are flat arrays of POD records that reference each other by index, the passes
+	 * walk them linearly. Materials are in their own table, shared by the submeshes using the same glTF material.
+	 */
 	struct MeshSource
 	{
+		struct Submesh
+		{
+			Math::AABB bounds; // vertex space
+			uint32_t vertexStart; // base vertex of the draws, indices are relative to it
+			uint32_t indexStart; // full detail triangles
+			uint32_t indexCount;
+			uint32_t material; // index in materials
+			uint32_t firstLOD = 0; // in lods, the simplified levels of the submesh from level 1
+			uint32_t lodCount = 0;
+			uint32_t firstMeshlet = 0; // in meshlets, they split the full detail triangles
+			uint32_t meshletCount = 0;
+		};
+
+		// Indices of a simplified level, they use the vertices of their submesh
+		struct SubmeshLOD
+		{
+			uint32_t indexStart;
+			uint32_t indexCount;
+		};
+
+		// One per glTF mesh, shared by every node that instances it
 		struct Mesh
 		{
-			struct SubMesh
-			{
-				PBRMaterial material;
-				uint32_t vertexStart;
-				uint32_t indexStart;
-				uint32_t indexCount;
-			};
-
-			std::vector<SharedPtr<SubMesh>> submeshes;
+			Math::AABB bounds; // vertex space bounds of every submesh
+			uint32_t firstSubmesh; // in submeshes
+			uint32_t submeshCount;
+			uint32_t lodCount = 1; // levels of detail, the full detail one included
+			float lodErrors[MeshOptimizer::kMaxLODCount] = {}; // vertex space, the largest error of a submesh at each level
+		};
+
+		// One per glTF node with a mesh
+		struct MeshInstance
+		{
 			glm::mat4 modelMatrix = glm::mat4(1.0f);
+			Math::AABB bounds; // node space, includes the modelMatrix
+			uint32_t mesh = 0; // index in meshes
 		};
 
+		uint32_t id = 0; // unique per loaded mesh source, used to sort and batch draws
 		uint32_t vertexCount;
 		uint32_t indexCount;
-		BufferRef meshVb;
-		BufferRef meshIb;
-		std::vector<SharedPtr<Mesh>> meshes;
+		GeometrySlice vertexSlice; // in vertexFormat, kSplit has the positions in stream 0. Draws add its offset to the vertexStart of the submeshes.
+		GeometrySlice indexSlice; // draws add its offset to the indexStart of the submeshes, their levels of detail and their meshlets
+		VertexFormat vertexFormat = VertexFormat::kFull; // set before loading
+		std::vector<Mesh> meshes;
+		std::vector<Submesh> submeshes; // the submeshes of a mesh are contiguous, their index is unique inside the mesh source
+		std::vector<SubmeshLOD> lods; // simplified levels of every submesh
+		std::vector<MeshOptimizer::Meshlet> meshlets; // indexStart is in the index buffer like indexStart of the submeshes
+		std::vector<uint32_t> meshletVertices; // relative to the vertexStart of their submesh
+		std::vector<uint8_t> meshletTriangles;
+		std::vector<PBRMaterial> materials; // the ones the submeshes use, in order of first use
+		std::vector<Math::TriangleBVH> triangleBVHs; // vertex space triangles of every mesh, indexed like meshes, used for ray casts
+		std::vector<MeshInstance> instances; // drawn in this order, the instances of one mesh batch into one draw
+		std::vector<std::string> instanceNames; // of the node, or of its mesh for unnamed nodes, indexed like instances
+		Math::AABB bounds; // Bounds of every instance, in the space of the entity that owns the mesh source
+		Math::BoundingSphere boundingSphere;
 		bool bHasMesh = false;
 		bool bIsTextured = false;
 
+		// Indices drawn for a level of detail of a mesh, submeshes with fewer levels draw their coarsest one
+		SubmeshLOD GetLOD(const Submesh& submesh, uint32_t lod) const
+		{
+			if (lod == 0 || submesh.lodCount == 0)
+				return { submesh.indexStart, submesh.indexCount };
+			return lods[submesh.firstLOD + std::min(lod, submesh.lodCount) - 1];
+		}
+
+		// Stream of the shaders that only read POSITION, which leads every full vertex. Not valid for kCompact.
+		BufferRef GetPositionBuffer() const { return vertexSlice.buffers[0]; }
+
 		MeshSource() = default;
-		void LoadGLTF(std::filesystem::path file);
+		// Loads the cooked mesh of the file when it's up to date, imports the glTF and cooks it otherwise.
+		// .emesh files can be loaded directly, they are only checked against their source when it exists.
+		void Load(std::filesystem::path file);
+		void LoadGLTF(std::filesystem::path file, bool bCook = false);
 		void Destroy();
 
 		~MeshSource()
@@ -70,13 +157,34 @@ namespace Eden
 		}
 
 	private:
-		TextureRef m_BlackTexture;
+		uint32_t m_FirstMaterialId = 0;
+		std::vector<int32_t> m_GLTFMeshes; // index in meshes of every glTF mesh, -1 until a node uses it
+		std::vector<int32_t> m_GLTFMaterials; // index in materials of every glTF material then of the default one, -1 until a submesh uses it
+
+		// Import state, textures of the glTF images indexed like gltfModel.images, shared by every material slot using them
+		std::filesystem::path m_ImportPath;
+		GLTF::BufferSpans m_Buffers; // glTF buffers, mapped from the file until the mesh buffers are uploaded
+		std::vector<TextureRef> m_ImageTextures;
+		std::vector<std::vector<uint8_t>> m_EncodedImages; // image files read by tinygltf, decoded by DecodeImages
+		uint32_t m_TexturesCreated = 0;
+		uint32_t m_TexturesReused = 0;
+		MeshOptimizer::Stats m_OptimizeStats;
 
 	private:
-		void LoadMaterial(tinygltf::Model& gltfModel, const tinygltf::Primitive& gltfPrimitive, PBRMaterial& material);
+		// Index in materials of a glTF material, loaded on first use. -1 is the default material.
+		uint32_t GetMaterial(tinygltf::Model& gltfModel, int32_t gltfMaterialIndex);
+		void LoadMaterial(tinygltf::Model& gltfModel, int32_t gltfMaterialIndex, PBRMaterial& material);
 		TextureRef LoadImage(tinygltf::Model& gltfModel, int32_t imageIndex);
+		std::string GetImageKey(const tinygltf::Image& gltfImage, int32_t imageIndex) const;
+		void DecodeImages(tinygltf::Model& gltfModel);
+		// tinygltf image loader, images already in the TextureCache are skipped and the others are kept encoded for DecodeImages
+		static bool LoadCachedImageData(tinygltf::Image* gltfImage, const int imageIndex, std::string* err, std::string* warn, int requiredWidth, int requiredHeight, const unsigned char* bytes, int size, void* userData);
+		bool LoadCooked(const std::filesystem::path& cookedFile, const std::filesystem::path& sourceFile);
+		void Cook(const tinygltf::Model& gltfModel, const GLTF::MappedModel& mappedModel, const std::vector<VertexData>& vertices, const void* indexData, uint32_t indexStride) const;
+		void CreateVertexBuffer(const VertexData* vertices);
 		void LoadNode(tinygltf::Model& gltfModel, const tinygltf::Node& gltfNode, const glm::mat4* parentMatrix, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices);
-		void LoadMesh(tinygltf::Model& gltfModel, const tinygltf::Node& gltfNode, glm::mat4& modelMatrix, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices);
+		// Returns the index of the new mesh in meshes
+		uint32_t LoadMesh(tinygltf::Model& gltfModel, int32_t gltfMeshIndex, std::vector<VertexData>& vertices, std::vector<uint32_t>& indices);
 	};
 }
 
@@ -1,18 +1,100 @@
 #include "Scene.h"
+
+#include <algorithm>
+
 #include "Entity.h"
 #include "Components.h"
+#include "Math/Math.h"
+#include "Math/BatchTransform.h"
 
 namespace Eden
 {
-	Scene::~Scene()
+	Scene::Scene()
 	{
-		auto entities = GetAllEntitiesWith<MeshComponent>();
-		for (auto entityId : entities)
+		// Sorting the hierarchy reorders these pools, so it is declared as a write on all of them
+		RegisterSystem("Transform Hierarchy", Reads<>(), Writes<RelationshipComponent, TransformComponent, WorldTransformComponent>(), [](Scene* scene)
 		{
-			Entity meshEntity = { entityId, this };
-			meshEntity.GetComponent<MeshComponent>().meshSource->Destroy();
-		}
+			scene->UpdateWorldTransforms();
+		});
+
+		// Entities with a mesh always have bounds
+		m_Registry.on_construct<MeshComponent>().connect<&entt::registry::emplace_or_replace<BoundsComponent>>();
+		m_Registry.on_destroy<MeshComponent>().connect<&entt::registry::remove<BoundsComponent>>();
+
+		RegisterSystem("Mesh Bounds", Reads<MeshComponent, WorldTransformComponent>(), Writes<BoundsComponent>(), [](Scene* scene)
+		{
+			scene->ParallelEach<MeshComponent, WorldTransformComponent, BoundsComponent>([](entt::entity, MeshComponent& mc, WorldTransformComponent& worldTransform, BoundsComponent& bounds)
+			{
+				// Only update when the entity moved or the mesh source changed
+				const Math::AABB& localBounds = mc.GetLocalBounds();
+				bounds.bUpdated = worldTransform.bUpdated || bounds.localBounds != localBounds;
+				if (!bounds.bUpdated)
+					return;
+
+				bounds.localBounds = localBounds;
+				if (!localBounds.IsValid())
+				{
+					bounds.worldBounds = {};
+					bounds.worldBoundingSphere = {};
+					return;
+				}
+
+				const glm::mat4& transform = worldTransform.transform;
+				bounds.worldBounds = Math::TransformAABB(localBounds, transform);
+
+				// The sphere of a single instance is only needed here, it isn't stored per mesh
+				const Math::BoundingSphere localSphere = mc.instance == MeshComponent::kAllInstances ? mc.meshSource->boundingSphere : Math::BoundingSphere::FromAABB(localBounds);
+				float maxScale = glm::sqrt(glm::max(glm::max(glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+															 glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1]))),
+															 glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2]))));
+				bounds.worldBoundingSphere.center = glm::vec3(transform * glm::vec4(localSphere.center, 1.0f));
+				bounds.worldBoundingSphere.radius = localSphere.radius * maxScale;
+			});
+		});
+
+		// The light components keep a copy of the transform that is uploaded to the GPU
+		RegisterSystem("Point Light Sync", Reads<WorldTransformComponent>(), Writes<PointLightComponent>(), [](Scene* scene)
+		{
+			scene->ParallelEach<WorldTransformComponent, PointLightComponent>([](entt::entity, WorldTransformComponent& worldTransform, PointLightComponent& light)
+			{
+				light.position = glm::vec4(glm::vec3(worldTransform.transform[3]), 1.0f);
+			});
+		});
+
+		// Runs after the systems above, it reads the bounds and light positions they write
+		RegisterSystem("Spatial Tree", Reads<BoundsComponent, PointLightComponent>(), Writes<SpatialProxyComponent>(), [](Scene* scene)
+		{
+			scene->UpdateSpatialTree();
+		});
+
+		// Entities with a mesh or a point light are kept in the spatial tree
+		m_Registry.on_construct<MeshComponent>().connect<&entt::registry::get_or_emplace<SpatialProxyComponent>>();
+		m_Registry.on_construct<PointLightComponent>().connect<&entt::registry::get_or_emplace<SpatialProxyComponent>>();
+		m_Registry.on_destroy<BoundsComponent>().connect<&Scene::OnSpatialSourceDestroyed>(this);
+		m_Registry.on_destroy<PointLightComponent>().connect<&Scene::OnSpatialSourceDestroyed>(this);
+		m_Registry.on_destroy<SpatialProxyComponent>().connect<&Scene::OnSpatialProxyDestroyed>(this);
+
+		// The rotation of the entity is the light direction, a parented light turns with the world rotation of its parent
+		RegisterSystem("Directional Light Sync", Reads<TransformComponent, RelationshipComponent, WorldTransformComponent>(), Writes<DirectionalLightComponent>(), [](Scene* scene)
+		{
+			auto worldTransforms = scene->m_Registry.view<const WorldTransformComponent>();
+			scene->ParallelEach<TransformComponent, RelationshipComponent, DirectionalLightComponent>([&worldTransforms](entt::entity, TransformComponent& transform, RelationshipComponent& relationship, DirectionalLightComponent& light)
+			{
+				glm::vec3 direction = transform.rotation;
+				if (relationship.parent != entt::null)
+				{
+					const glm::mat4& parentTransform = worldTransforms.get<const WorldTransformComponent>(relationship.parent).transform;
+					glm::mat3 parentRotation = glm::mat3(glm::normalize(glm::vec3(parentTransform[0])), glm::normalize(glm::vec3(parentTransform[1])), glm::normalize(glm::vec3(parentTransform[2])));
+					direction = parentRotation * direction;
+				}
+				light.direction = glm::vec4(direction, 1.0f);
+			});
+		});
+	}
 
+	Scene::~Scene()
+	{
+		// Mesh sources are shared with the MeshAssetRegistry, they are released when no scene uses them anymore
 		m_Preparations.clear();
 	}
 
@@ -22,19 +104,37 @@ namespace Eden
 		auto& tag = entity.AddComponent<TagComponent>();
 		tag.tag = name.empty() ? "Empty Entity" : name;
 		entity.AddComponent<TransformComponent>();
+		entity.AddComponent<RelationshipComponent>();
+		entity.AddComponent<WorldTransformComponent>();
+		m_bHierarchyChanged = true;
 
 		return entity;
 	}
 
 	void Scene::DeleteEntity(Entity& entity)
 	{
-		m_Registry.destroy(entity);
+		// Children are deleted with their parent
+		SetParent(entity, {}, false);
+		DestroyEntityHierarchy(entity);
 		m_SelectedEntity = static_cast<entt::entity>((uint32_t)(m_SelectedEntity) - 1);
+		m_bHierarchyChanged = true;
+	}
+
+	void Scene::DestroyEntityHierarchy(entt::entity entity)
+	{
+		auto children = m_Registry.get<RelationshipComponent>(entity).children;
+		for (auto child : children)
+			DestroyEntityHierarchy(child);
+
+		m_Registry.destroy(entity);
 	}
 
 	void Scene::Clear()
 	{
-		m_Registry.clear<TransformComponent>();
+		// Destroys every entity, the destroy signals remove their spatial proxies from the tree
+		m_Registry.clear();
+		m_SelectedEntity = entt::null;
+		m_bHierarchyChanged = true;
 	}
 
 	size_t Scene::Size()
@@ -85,6 +185,177 @@ namespace Eden
 		m_SelectedEntity = entity;
 	}
 
+	void Scene::UpdateSystems()
+	{
+		m_SystemScheduler.Run(this);
+	}
+
+	std::vector<SceneSystem>& Scene::GetSystems()
+	{
+		return m_SystemScheduler.GetSystems();
+	}
+
+	// Distance where the light contribution drops below 1/256, the shader attenuation is intensity * color / distance^2
+	static float GetInfluenceRadius(const PointLightComponent& light)
+	{
+		float maxColor = glm::max(glm::max(light.color.r, light.color.g), light.color.b);
+		return glm::sqrt(glm::max(maxColor * light.intensity, 0.0f) * 256.0f);
+	}
+
+	void Scene::UpdateSpatialTree()
+	{
+		// New proxies are created together at the end, loading a scene creates all of them in the same frame
+		std::vector<std::pair<entt::entity, Math::AABB>> newProxies;
+		auto refreshProxy = [&](entt::entity entity, SpatialProxyComponent& proxy)
+		{
+			Math::AABB bounds = GetSpatialBounds(entity);
+			if (!bounds.IsValid())
+			{
+				if (proxy.proxyId != Math::DynamicAABBTree::kNullNode)
+				{
+					m_SpatialTree.DestroyProxy(proxy.proxyId);
+					proxy.proxyId = Math::DynamicAABBTree::kNullNode;
+				}
+			}
+			else if (proxy.proxyId == Math::DynamicAABBTree::kNullNode)
+			{
+				newProxies.emplace_back(entity, bounds);
+			}
+			else
+			{
+				m_SpatialTree.MoveProxy(proxy.proxyId, bounds);
+			}
+		};
+
+		for (auto entity : m_SpatialRefreshQueue)
+		{
+			if (m_Registry.valid(entity) && m_Registry.all_of<SpatialProxyComponent>(entity))
+				refreshProxy(entity, m_Registry.get<SpatialProxyComponent>(entity));
+		}
+		m_SpatialRefreshQueue.clear();
+
+		// Loading a mesh source also changes the bounds, so this picks up new meshes too
+		m_Registry.view<BoundsComponent>().each([&](entt::entity entity, BoundsComponent& bounds)
+		{
+			if (bounds.bUpdated)
+				refreshProxy(entity, m_Registry.get<SpatialProxyComponent>(entity));
+		});
+
+		// There are only a few lights and the intensity can change without notice, so they are always refreshed
+		m_Registry.view<PointLightComponent, SpatialProxyComponent>().each([&](entt::entity entity, PointLightComponent&, SpatialProxyComponent& proxy)
+		{
+			refreshProxy(entity, proxy);
+		});
+
+		if (newProxies.empty())
+			return;
+
+		// An entity with a mesh and a light can be added twice
+		std::sort(newProxies.begin(), newProxies.end(), [](auto& a, auto& b) { return a.first < b.first; });
+		newProxies.erase(std::unique(newProxies.begin(), newProxies.end(), [](auto& a, auto& b) { return a.first == b.first; }), newProxies.end());
+
+		std::vector<Math::AABB> bounds(newProxies.size());
+		std::vector<uint32_t> userData(newProxies.size());
+		std::vector<int32_t> proxyIds(newProxies.size());
+		for (size_t i = 0; i < newProxies.size(); ++i)
+		{
+			bounds[i] = newProxies[i].second;
+			userData[i] = entt::to_integral(newProxies[i].first);
+		}
+
+		m_SpatialTree.CreateProxies(bounds.data(), userData.data(), newProxies.size(), proxyIds.data());
+		for (size_t i = 0; i < newProxies.size(); ++i)
+			m_Registry.get<SpatialProxyComponent>(newProxies[i].first).proxyId = proxyIds[i];
+	}
+
+	Entity Scene::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* outDistance /*= nullptr*/)
+	{
+		entt::entity closestEntity = entt::null;
+		float closestDistance = maxDistance;
+		glm::vec3 inverseDirection = 1.0f / direction;
+
+		// Directions are not normalized when moved to local space, so distances along the ray stay the same in every space
+		m_SpatialTree.RayCast(origin, direction, maxDistance, [&](uint32_t userData)
+		{
+			entt::entity entity = static_cast<entt::entity>(userData);
+			auto* mc = m_Registry.try_get<MeshComponent>(entity);
+			if (!mc || !mc->meshSource || !mc->meshSource->bHasMesh)
+				return closestDistance;
+
+			float distance;
+			const auto& bounds = m_Registry.get<BoundsComponent>(entity);
+			if (!Math::DynamicAABBTree::RayIntersects(bounds.worldBounds, origin, inverseDirection, closestDistance, distance))
+				return closestDistance;
+
+			glm::mat4 inverseWorldTransform = glm::inverse(m_Registry.get<WorldTransformComponent>(entity).transform);
+			glm::vec3 entityOrigin = glm::vec3(inverseWorldTransform * glm::vec4(origin, 1.0f));
+			glm::vec3 entityDirection = glm::vec3(inverseWorldTransform * glm::vec4(direction, 0.0f));
+			glm::vec3 entityInverseDirection = 1.0f / entityDirection;
+
+			// The node transform of a single instance is already in the world transform
+			if (mc->instance != MeshComponent::kAllInstances)
+			{
+				const MeshSource::MeshInstance* instance = mc->GetInstance();
+				if (instance && mc->meshSource->triangleBVHs[instance->mesh].RayCast(entityOrigin, entityDirection, closestDistance, distance))
+				{
+					closestDistance = distance;
+					closestEntity = entity;
+				}
+				return closestDistance;
+			}
+
+			for (auto& instance : mc->meshSource->instances)
+			{
+				if (!Math::DynamicAABBTree::RayIntersects(instance.bounds, entityOrigin, entityInverseDirection, closestDistance, distance))
+					continue;
+
+				glm::mat4 inverseModelMatrix = glm::inverse(instance.modelMatrix);
+				glm::vec3 meshOrigin = glm::vec3(inverseModelMatrix * glm::vec4(entityOrigin, 1.0f));
+				glm::vec3 meshDirection = glm::vec3(inverseModelMatrix * glm::vec4(entityDirection, 0.0f));
+				if (mc->meshSource->triangleBVHs[instance.mesh].RayCast(meshOrigin, meshDirection, closestDistance, distance))
+				{
+					closestDistance = distance;
+					closestEntity = entity;
+				}
+			}
+
+			return closestDistance;
+		});
+
+		if (outDistance && closestEntity != entt::null)
+			*outDistance = closestDistance;
+		return { closestEntity, this };
+	}
+
+	Math::AABB Scene::GetSpatialBounds(entt::entity entity)
+	{
+		Math::AABB bounds;
+		if (auto* meshBounds = m_Registry.try_get<BoundsComponent>(entity))
+			bounds.Merge(meshBounds->worldBounds);
+
+		if (auto* light = m_Registry.try_get<PointLightComponent>(entity))
+		{
+			glm::vec3 radius = glm::vec3(GetInfluenceRadius(*light));
+			glm::vec3 position = glm::vec3(light->position);
+			bounds.Merge({ position - radius, position + radius });
+		}
+
+		return bounds;
+	}
+
+	void Scene::OnSpatialSourceDestroyed(entt::registry&, entt::entity entity)
+	{
+		// The component is still attached during the signal, the proxy is refreshed on the next update
+		m_SpatialRefreshQueue.emplace_back(entity);
+	}
+
+	void Scene::OnSpatialProxyDestroyed(entt::registry& registry, entt::entity entity)
+	{
+		int32_t proxyId = registry.get<SpatialProxyComponent>(entity).proxyId;
+		if (proxyId != Math::DynamicAABBTree::kNullNode)
+			m_SpatialTree.DestroyProxy(proxyId);
+	}
+
 	Entity Scene::DuplicateEntity(Entity entity)
 	{
 		std::string name = entity.GetComponent<TagComponent>().tag;
@@ -93,7 +364,193 @@ namespace Eden
 		entity.CopyComponentIfExists<MeshComponent>(newEntity);
 		entity.CopyComponentIfExists<PointLightComponent>(newEntity);
 		entity.CopyComponentIfExists<DirectionalLightComponent>(newEntity);
+		newEntity.GetComponent<TransformComponent>().bDirty = true;
+
+		// The duplicated entity is a sibling of the original one
+		Entity parent = GetParent(entity);
+		if (parent)
+			SetParent(newEntity, parent, false);
 
 		return newEntity;
 	}
+
+	bool Scene::ExpandMeshInstances(Entity entity)
+	{
+		auto* mc = m_Registry.try_get<MeshComponent>(entity);
+		if (!mc || mc->instance != MeshComponent::kAllInstances || !mc->meshSource->bHasMesh)
+			return false;
+
+		// Creating the children can move the component, the copy keeps the mesh source alive until they share it
+		MeshComponent model = *mc;
+		const std::string modelName = entity.GetComponent<TagComponent>().tag;
+		const MeshSource& meshSource = *model.meshSource;
+		for (size_t i = 0; i < meshSource.instances.size(); ++i)
+		{
+			const MeshSource::MeshInstance& instance = meshSource.instances[i];
+			const std::string& instanceName = meshSource.instanceNames[i];
+			Entity child = CreateEntity(!instanceName.empty() ? instanceName : modelName + " " + std::to_string(i));
+
+			// Node matrices with shear can't be stored in the transform component, they lose it
+			auto& tc = child.GetComponent<TransformComponent>();
+			Math::DecomposeTransform(instance.modelMatrix, tc.translation, tc.rotation, tc.scale);
+
+			auto& childMc = child.AddComponent<MeshComponent>(model);
+			childMc.instance = static_cast<int32_t>(i);
+			SetParent(child, entity, false);
+		}
+
+		// The entity stays as the root of the model, moving it moves every node
+		entity.RemoveComponent<MeshComponent>();
+		return true;
+	}
+
+	void Scene::SetParent(Entity entity, Entity parent, bool bKeepWorldTransform /*= true*/)
+	{
+		auto& relationship = entity.GetComponent<RelationshipComponent>();
+		entt::entity newParent = parent ? static_cast<entt::entity>(parent) : entt::null;
+		if (relationship.parent == newParent)
+			return;
+
+		// Don't allow an entity to be parented to itself or to one of its children
+		for (entt::entity current = newParent; current != entt::null; current = m_Registry.get<RelationshipComponent>(current).parent)
+		{
+			if (current == static_cast<entt::entity>(entity))
+			{
+				ED_LOG_WARN("Can't parent '{}' to one of its children!", entity.GetComponent<TagComponent>().tag);
+				return;
+			}
+		}
+
+		glm::mat4 worldTransform = entity.GetComponent<WorldTransformComponent>().transform;
+
+		if (relationship.parent != entt::null)
+		{
+			auto& siblings = m_Registry.get<RelationshipComponent>(relationship.parent).children;
+			siblings.erase(std::remove(siblings.begin(), siblings.end(), static_cast<entt::entity>(entity)), siblings.end());
+		}
+
+		relationship.parent = newParent;
+		uint32_t depth = 0;
+		if (newParent != entt::null)
+		{
+			auto& parentRelationship = m_Registry.get<RelationshipComponent>(newParent);
+			parentRelationship.children.emplace_back(entity);
+			depth = parentRelationship.depth + 1;
+		}
+		UpdateHierarchyDepth(entity, depth);
+
+		if (bKeepWorldTransform)
+			SetWorldTransform(entity, worldTransform);
+		entity.GetComponent<TransformComponent>().bDirty = true;
+
+		m_bHierarchyChanged = true;
+	}
+
+	Entity Scene::GetParent(Entity entity)
+	{
+		return { entity.GetComponent<RelationshipComponent>().parent, this };
+	}
+
+	void Scene::SetWorldTransform(Entity entity, const glm::mat4& worldTransform)
+	{
+		glm::mat4 localTransform = worldTransform;
+		Entity parent = GetParent(entity);
+		if (parent)
+			localTransform = glm::inverse(parent.GetComponent<WorldTransformComponent>().transform) * worldTransform;
+
+		auto& tc = entity.GetComponent<TransformComponent>();
+		Math::DecomposeTransform(localTransform, tc.translation, tc.rotation, tc.scale);
+		tc.bDirty = true;
+	}
+
+	void Scene::UpdateHierarchyDepth(entt::entity entity, uint32_t depth)
+	{
+		auto& relationship = m_Registry.get<RelationshipComponent>(entity);
+		relationship.depth = depth;
+		for (auto child : relationship.children)
+			UpdateHierarchyDepth(child, depth + 1);
+	}
+
+	void Scene::RebuildHierarchyOrder()
+	{
+		// Sorting the pools by depth keeps every level contiguous in memory, in the same order as m_HierarchyOrder
+		m_Registry.sort<RelationshipComponent>([](const RelationshipComponent& lhs, const RelationshipComponent& rhs) { return lhs.depth < rhs.depth; });
+		m_Registry.sort<TransformComponent, RelationshipComponent>();
+		m_Registry.sort<WorldTransformComponent, RelationshipComponent>();
+
+		auto view = m_Registry.view<RelationshipComponent>();
+		m_HierarchyOrder.assign(view.begin(), view.end());
+
+		m_HierarchyLevelOffsets.clear();
+		for (uint32_t i = 0; i < m_HierarchyOrder.size(); ++i)
+		{
+			uint32_t depth = view.get<RelationshipComponent>(m_HierarchyOrder[i]).depth;
+			while (m_HierarchyLevelOffsets.size() <= depth)
+				m_HierarchyLevelOffsets.emplace_back(i);
+		}
+		m_HierarchyLevelOffsets.emplace_back(static_cast<uint32_t>(m_HierarchyOrder.size()));
+
+		m_bHierarchyChanged = false;
+	}
+
+	void Scene::UpdateWorldTransforms()
+	{
+		if (m_bHierarchyChanged)
+			RebuildHierarchyOrder();
+
+		auto& relationships = m_Registry.storage<RelationshipComponent>();
+		auto& transforms = m_Registry.storage<TransformComponent>();
+		auto& worldTransforms = m_Registry.storage<WorldTransformComponent>();
+
+		// Breadth-first, every entity of a level only depends on the level before it
+		for (size_t level = 0; level + 1 < m_HierarchyLevelOffsets.size(); ++level)
+		{
+			uint32_t levelStart = m_HierarchyLevelOffsets[level];
+			uint32_t levelSize = m_HierarchyLevelOffsets[level + 1] - levelStart;
+			JobSystem::ParallelFor(levelSize, 1024, [&](uint32_t begin, uint32_t end)
+			{
+				// The local transforms that need updating are gathered into SoA and composed in one SIMD batch
+				thread_local std::vector<uint32_t> updatedEntities;
+				thread_local Math::TransformSoA localTransforms;
+				thread_local std::vector<glm::mat4> localMatrices;
+				updatedEntities.clear();
+				localTransforms.Clear();
+
+				for (uint32_t i = levelStart + begin; i < levelStart + end; ++i)
+				{
+					entt::entity entity = m_HierarchyOrder[i];
+					auto& relationship = relationships.get(entity);
+					auto& transform = transforms.get(entity);
+					auto& worldTransform = worldTransforms.get(entity);
+
+					bool bParentUpdated = relationship.parent != entt::null && worldTransforms.get(relationship.parent).bUpdated;
+					worldTransform.bUpdated = transform.bDirty || bParentUpdated;
+					if (!worldTransform.bUpdated)
+						continue;
+
+					updatedEntities.emplace_back(i);
+					localTransforms.Add(transform.translation, transform.rotation, transform.scale);
+					transform.bDirty = false;
+				}
+
+				if (updatedEntities.empty())
+					return;
+
+				localMatrices.resize(updatedEntities.size());
+				Math::ComposeTransforms(localTransforms, localMatrices.data());
+
+				for (size_t u = 0; u < updatedEntities.size(); ++u)
+				{
+					entt::entity entity = m_HierarchyOrder[updatedEntities[u]];
+					entt::entity parent = relationships.get(entity).parent;
+					auto& worldTransform = worldTransforms.get(entity);
+
+					if (parent != entt::null)
+						worldTransform.transform = Math::MultiplyTransform(worldTransforms.get(parent).transform, localMatrices[u]);
+					else
+						worldTransform.transform = localMatrices[u];
+				}
+			});
+		}
+	}
 }
@@ -2,8 +2,15 @@
 
 #include <entt/entt.hpp>
 #include <filesystem>
+#include <functional>
 #include <vector>
 
+#include <glm/glm.hpp>
+
+#include "Core/JobSystem.h"
+#include "Math/DynamicAABBTree.h"
+#include "SystemScheduler.h"
+
 namespace Eden
 {
 	class Entity;
@@ -13,6 +20,9 @@ namespace Eden
 		friend class Entity;
 		friend class SceneSerializer;
 
+		// Declared before the registry so they outlive it, the registry signals use them
+		Math::DynamicAABBTree m_SpatialTree;
+		std::vector<entt::entity> m_SpatialRefreshQueue; // entities that lost a mesh or a point light
 
 		entt::registry m_Registry;
 		std::string m_Name = "Untitled";
@@ -25,9 +35,15 @@ namespace Eden
 		 */
 		std::vector<std::function<void()>> m_Preparations;
 		entt::entity m_SelectedEntity = entt::null;
+		SystemScheduler m_SystemScheduler;
+
+		// Entities sorted by hierarchy depth, rebuilt only when the hierarchy changes
+		std::vector<entt::entity> m_HierarchyOrder;
+		std::vector<uint32_t> m_HierarchyLevelOffsets; // first index of every depth level in m_HierarchyOrder
+		bool m_bHierarchyChanged = true;
 
 	public:
-		Scene() = default;
+		Scene();
 		~Scene();
 
 		Entity CreateEntity(const std::string_view name = "");
@@ -57,6 +73,55 @@ namespace Eden
 		}
 
 		Entity DuplicateEntity(Entity entity);
+		// Import option for large models: the entity drawing a whole model gets a child per node drawing only that node,
+		// with the node transform and bounds, sharing the mesh source. Returns false if the entity doesn't draw a whole model
+		bool ExpandMeshInstances(Entity entity);
+
+		// Passing an invalid parent makes the entity a root entity
+		void SetParent(Entity entity, Entity parent, bool bKeepWorldTransform = true);
+		Entity GetParent(Entity entity);
+		// Sets the local transform so that the entity ends up with the given world transform
+		void SetWorldTransform(Entity entity, const glm::mat4& worldTransform);
+		// Recomputes the world transform of dirty entities and their children, parents are always updated before children
+		void UpdateWorldTransforms();
+
+		// Systems run every frame after the preparations, see SystemScheduler
+		template<typename... ReadComponents, typename... WriteComponents>
+		void RegisterSystem(const std::string& name, Reads<ReadComponents...> reads, Writes<WriteComponents...> writes, SystemFunction function)
+		{
+			m_SystemScheduler.Register(name, reads, writes, function);
+		}
+
+		void UpdateSystems();
+		std::vector<SceneSystem>& GetSystems();
+
+		// World space bounds of every mesh and point light, the user data of a proxy is the entity id
+		const Math::DynamicAABBTree& GetSpatialTree() const { return m_SpatialTree; }
+		// Inserts, moves and removes the proxies of the entities whose bounds changed this frame
+		void UpdateSpatialTree();
+		// Closest mesh hit by the ray, tested against the triangles. Returns an invalid entity when nothing is hit
+		Entity RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* outDistance = nullptr);
+
+		// Calls func(entity, components...) for every entity with the given components, split across the job system workers
+		template<typename... Components, typename Func>
+		void ParallelEach(Func func, uint32_t minBatchSize = 256)
+		{
+			auto view = m_Registry.view<Components...>();
+			std::vector<entt::entity> entities(view.begin(), view.end());
+			JobSystem::ParallelFor(static_cast<uint32_t>(entities.size()), minBatchSize, [&](uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; ++i)
+					func(entities[i], view.template get<Components>(entities[i])...);
+			});
+		}
+
+	private:
+		void RebuildHierarchyOrder();
+		void UpdateHierarchyDepth(entt::entity entity, uint32_t depth);
+		void DestroyEntityHierarchy(entt::entity entity);
+		Math::AABB GetSpatialBounds(entt::entity entity);
+		void OnSpatialSourceDestroyed(entt::registry& registry, entt::entity entity);
+		void OnSpatialProxyDestroyed(entt::registry& registry, entt::entity entity);
 	};
 }
 
@@ -131,6 +131,10 @@ namespace Eden
 		auto entities = data["Entities"];
 		if (entities)
 		{
+			// The stored ids are only used to restore the hierarchy, parents might be serialized after their children
+			std::unordered_map<uint32_t, Entity> deserializedEntities;
+			std::vector<std::pair<Entity, uint32_t>> entitiesParents;
+
 			for (auto entity : entities)
 			{
 				uint32_t id = entity["Entity"].as<uint32_t>();
@@ -141,6 +145,11 @@ namespace Eden
 					name = tagComponent["Tag"].as<std::string>();
 
 				Entity deserializedEntity = m_Scene->CreateEntity(name);
+				deserializedEntities[id] = deserializedEntity;
+
+				auto parent = entity["Parent"];
+				if (parent)
+					entitiesParents.emplace_back(deserializedEntity, parent.as<uint32_t>());
 
 				auto transform_component = entity["TransformComponent"];
 				if (transform_component)
@@ -157,6 +166,9 @@ namespace Eden
 				{
 					auto& mc = deserializedEntity.AddComponent<MeshComponent>();
 					mc.meshPath = meshComponent["File Path"].as<std::string>();
+					// Only the entities of an expanded model have an instance
+					if (auto instance = meshComponent["Instance"])
+						mc.instance = instance.as<int32_t>();
 				}
 
 				auto pointLightComponent = entity["PointLightComponent"];
@@ -180,6 +192,18 @@ namespace Eden
 					dl.intensity = directional_lightComponent["Intensity"].as<float>();
 				}
 			}
+
+			for (auto& [child, parentId] : entitiesParents)
+			{
+				if (deserializedEntities.find(parentId) == deserializedEntities.end())
+				{
+					ED_LOG_WARN("Parent of entity '{}' was not found!", child.GetComponent<TagComponent>().tag);
+					continue;
+				}
+
+				// The serialized transform is already relative to the parent
+				m_Scene->SetParent(child, deserializedEntities[parentId], false);
+			}
 		}
 
 		return true;
@@ -190,6 +214,10 @@ namespace Eden
 		out << YAML::BeginMap; // Entity
 		out << YAML::Key << "Entity" << YAML::Value << entity.GetID();
 
+		Entity parent = m_Scene->GetParent(entity);
+		if (parent)
+			out << YAML::Key << "Parent" << YAML::Value << parent.GetID();
+
 		if (entity.HasComponent<TagComponent>())
 		{
 			out << YAML::Key << "TagComponent";
@@ -221,6 +249,8 @@ namespace Eden
 
 			auto& mc = entity.GetComponent<MeshComponent>();
 			out << YAML::Key << "File Path" << YAML::Value << mc.meshPath;
+			if (mc.instance != MeshComponent::kAllInstances)
+				out << YAML::Key << "Instance" << YAML::Value << mc.instance;
 
 			out << YAML::EndMap; // MeshComponent
 		}
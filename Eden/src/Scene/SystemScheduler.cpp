@@ -0,0 +1,92 @@
+#include "SystemScheduler.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "Core/JobSystem.h"
+#include "Profiling/Timer.h"
+
+namespace Eden
+{
+	static bool Intersects(const std::vector<entt::id_type>& first, const std::vector<entt::id_type>& second)
+	{
+		for (auto& component : first)
+		{
+			if (std::find(second.begin(), second.end(), component) != second.end())
+				return true;
+		}
+
+		return false;
+	}
+
+	bool SystemScheduler::Conflicts(const SceneSystem& first, const SceneSystem& second)
+	{
+		return Intersects(first.writes, second.reads) ||
+			   Intersects(first.writes, second.writes) ||
+			   Intersects(first.reads, second.writes);
+	}
+
+	void SystemScheduler::BuildDependencyGraph()
+	{
+		size_t systemCount = m_Systems.size();
+		m_Dependents.assign(systemCount, {});
+		m_DependencyCounts.assign(systemCount, 0);
+
+		// Only earlier systems can be a dependency, this keeps registration order for conflicting systems
+		for (uint32_t i = 0; i < systemCount; ++i)
+		{
+			if (!m_Systems[i].bEnabled)
+				continue;
+
+			for (uint32_t j = i + 1; j < systemCount; ++j)
+			{
+				if (!m_Systems[j].bEnabled)
+					continue;
+
+				if (Conflicts(m_Systems[i], m_Systems[j]))
+				{
+					m_Dependents[i].emplace_back(j);
+					m_DependencyCounts[j]++;
+				}
+			}
+		}
+	}
+
+	void SystemScheduler::Run(Scene* scene)
+	{
+		if (m_Systems.empty())
+			return;
+
+		BuildDependencyGraph();
+
+		size_t systemCount = m_Systems.size();
+		std::unique_ptr<std::atomic<uint32_t>[]> remainingDependencies(new std::atomic<uint32_t>[systemCount]);
+		for (size_t i = 0; i < systemCount; ++i)
+			remainingDependencies[i] = m_DependencyCounts[i];
+
+		JobCounter counter;
+		std::function<void(uint32_t)> runSystem = [&](uint32_t index)
+		{
+			SceneSystem& system = m_Systems[index];
+
+			Timer timer;
+			timer.Record();
+			system.function(scene);
+			system.lastExecutionTime = timer.ElapsedMilliseconds();
+
+			for (uint32_t dependent : m_Dependents[index])
+			{
+				if (remainingDependencies[dependent].fetch_sub(1) == 1)
+					JobSystem::Execute([&runSystem, dependent]() { runSystem(dependent); }, &counter);
+			}
+		};
+
+		for (uint32_t i = 0; i < systemCount; ++i)
+		{
+			if (m_Systems[i].bEnabled && m_DependencyCounts[i] == 0)
+				JobSystem::Execute([&runSystem, i]() { runSystem(i); }, &counter);
+		}
+
+		JobSystem::Wait(&counter);
+	}
+}
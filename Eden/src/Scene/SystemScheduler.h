@@ -0,0 +1,62 @@
+#pragma once
+
+#include <entt/entt.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Eden
+{
+	class Scene;
+
+	// Used to declare which components a system reads and writes when registering it
+	template<typename... Components> struct Reads {};
+	template<typename... Components> struct Writes {};
+
+	using SystemFunction = std::function<void(Scene* scene)>;
+
+	struct SceneSystem
+	{
+		std::string name;
+		std::vector<entt::id_type> reads;
+		std::vector<entt::id_type> writes;
+		SystemFunction function;
+		bool bEnabled = true;
+		float lastExecutionTime = 0.0f; // in milliseconds
+	};
+
+	/*
+	 * Runs the scene systems every frame.
+	 * The dependency graph is built from the declared component access: a system depends on every
+	 * system registered before it that writes a component it reads or writes, or that reads a component
+	 * it writes. Systems without dependencies between them run concurrently on the job system.
+	 * Systems must not create or destroy entities/components, use scene preparations for that.
+	 */
+	class SystemScheduler
+	{
+		std::vector<SceneSystem> m_Systems;
+
+		// Dependency graph, rebuilt every frame
+		std::vector<std::vector<uint32_t>> m_Dependents;
+		std::vector<uint32_t> m_DependencyCounts;
+
+	public:
+		template<typename... ReadComponents, typename... WriteComponents>
+		void Register(const std::string& name, Reads<ReadComponents...>, Writes<WriteComponents...>, SystemFunction function)
+		{
+			SceneSystem& system = m_Systems.emplace_back();
+			system.name = name;
+			system.reads = { entt::type_id<ReadComponents>().hash()... };
+			system.writes = { entt::type_id<WriteComponents>().hash()... };
+			system.function = function;
+		}
+
+		void Run(Scene* scene);
+
+		std::vector<SceneSystem>& GetSystems() { return m_Systems; }
+
+	private:
+		void BuildDependencyGraph();
+		static bool Conflicts(const SceneSystem& first, const SceneSystem& second);
+	};
+}
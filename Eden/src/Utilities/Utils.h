@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
 #include <string>
 #include <windows.h>
 #include <stringapiset.h>
@@ -27,6 +30,19 @@ namespace Eden::Utils
 		return std::string(buffer);
 	}
 
+	// Absolute, lexically normal path with forward slashes, lowercase on Windows since paths are case insensitive there.
+	// Two paths to the same file give the same string, used as cache keys.
+	inline std::string NormalizePath(const std::filesystem::path& path)
+	{
+		std::error_code error;
+		std::filesystem::path absolutePath = std::filesystem::absolute(path, error);
+		std::string normalized = (error ? path : absolutePath).lexically_normal().generic_string();
+#ifdef ED_PLATFORM_WINDOWS
+		std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+		return normalized;
+	}
+
 	inline void StringConvert(const std::string& from, std::wstring& to)
 	{
 		int num = MultiByteToWideChar(CP_UTF8, 0, from.c_str(), -1, NULL, 0);